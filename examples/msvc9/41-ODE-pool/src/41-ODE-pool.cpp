@@ -340,6 +340,9 @@ int main(int argc, char* argv[])
     ODEWorld->setAngularDamping(0.00002);
     ODEWorld->setLinearDamping(0.00002);
 
+    // reuse the contacts of balls resting on the table between steps
+    ODEWorld->setUseContactCache(true);
+
     // create three ODE objects that are automatically added to the ODE world
     ODEBody0 = new cODEGenericBody(ODEWorld);
     ODEBody1 = new cODEGenericBody(ODEWorld);
@@ -576,6 +579,10 @@ int main(int argc, char* argv[])
     // simulation in now running
     simulationRunning = true;
 
+    // compute the ODE simulation in its own thread at 1 kHz, so that
+    // steps with many contacts do not delay the haptics loop
+    ODEWorld->startSimulation(0.001);
+
     // create a thread which starts the main haptics rendering loop
     cThread* hapticsThread = new cThread();
     hapticsThread->set(updateHaptics, CHAI_THREAD_PRIORITY_HAPTICS);
@@ -657,6 +664,9 @@ void close(void)
     // wait for graphics and haptics loops to terminate
     while (!simulationFinished) { cSleepMs(100); }
 
+    // stop the ODE simulation thread
+    ODEWorld->stopSimulation();
+
     // close haptic device
     tool->stop();
 }
@@ -812,7 +822,8 @@ void updateHaptics(void)
         simClock.reset();
         simClock.start();
 
-        // update simulation
+        // update simulation. While the ODE simulation thread is running, this
+        // only sets the bodies to their poses interpolated by the thread
         ODEWorld->updateDynamics(nextSimInterval);
     }
     
@@ -568,7 +568,6 @@ void updateGraphics(void)
 {
     // update mesh of deformable model
     defWorld->updateSkins();
-    defObject->computeAllNormals(true);
 
     // render world
     camera->renderView(displayW, displayH);
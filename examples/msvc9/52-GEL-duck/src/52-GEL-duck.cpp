@@ -148,6 +148,11 @@ double radius;
 // stiffness properties between the haptic device tool and the model (GEM)
 double stiffness;
 
+// mass-points in contact with the haptic device tool, and their distances;
+// sized to the number of mass-points so that no contact is ever dropped
+vector<unsigned int> contactVertices;
+vector<double> contactDistances;
+
 
 //---------------------------------------------------------------------------
 // DECLARED FUNCTIONS
@@ -225,10 +230,9 @@ bool createSkeletonMesh(cGELMesh *a_object, char *a_filename, char *a_filenameHi
     Haptic feedback is performed by computing at every integration step the
     interaction between the cursor (large sphere) with each mass-point or
     skeleton node composing the physical models of each respective body.
-    The approach is not optimal for large models and will need to be improved
-    in the future. However, performing point location on deformable bodies
-    is a non trivial problem since the collision structure needs to be
-    continuously updated as the body deforms.
+    For the mass-point model, the tetrahedral index of the body, which is
+    refitted as the body deforms, returns the only mass-points close enough
+    to the cursor to be in contact with it.
 */
 //===========================================================================
 
@@ -767,8 +771,18 @@ bool createTetGenMesh(cGELMesh *a_object, char *a_filename,  char *a_filenameHig
                     springs.insert(pair<int,int>(min(v0,v1), max(v0,v1)));
                 }
             }
+
+            // store the tetrahedron for point location
+            for (int i = 0; i < 4; ++i) {
+                cVertex* v = a_object->getVertex(output.tetrahedronlist[ti+i]);
+                a_object->m_tetrahedra.push_back(v->m_tag);
+            }
         }
 
+        // build the tetrahedral index, refitted at each simulation step
+        a_object->m_useTetrahedralIndex = true;
+        a_object->updateTetrahedralIndex();
+
         // create a spring on each tetrahedral edge we found in the output
         cGELLinearSpring::default_kSpringElongation = 40.0; // 0.55;
         for (set< pair<int,int> >::iterator it = springs.begin(); it != springs.end(); ++it)
@@ -1073,7 +1087,6 @@ void updateGraphics(void)
 {
     // update mesh of deformable model
     defWorld->updateSkins();
-    defObject->computeAllNormals(true);
     ground->computeAllNormals(true);
 
     // render world
@@ -1165,7 +1178,36 @@ void updateHaptics(void)
 		{
 			cGELMesh *nextItem = *i;
 
-			if (nextItem->m_useMassParticleModel)
+			if (nextItem->m_useMassParticleModel && nextItem->m_useTetrahedralIndex)
+			{
+				// every mass-point may be in contact
+				unsigned int numVertices = (unsigned int)nextItem->m_gelVertices.size();
+				if (contactVertices.size() < numVertices)
+				{
+					contactVertices.resize(numVertices);
+					contactDistances.resize(numVertices);
+				}
+
+				// only mass-points closer than the sum of the radii are in contact
+				unsigned int numContacts = 0;
+				if (numVertices > 0)
+				{
+					numContacts = nextItem->findNearestParticles(pos, numVertices, deviceRadius + radius,
+					                                             &contactVertices[0], &contactDistances[0]);
+				}
+				for (unsigned int k=0; k<numContacts; k++)
+				{
+					cGELMassParticle* particle = nextItem->m_gelVertices[contactVertices[k]].m_massParticle;
+					cVector3d f = computeForce(pos, deviceRadius, particle->m_pos, radius, stiffness);
+					if (f.lengthsq() > 0)
+					{
+						cVector3d tmpfrc = cNegate(f);
+						particle->setExternalForce(tmpfrc);
+					}
+					force.add(cMul(1.0, f));
+				}
+			}
+			else if (nextItem->m_useMassParticleModel)
 			{
 				int numVertices = nextItem->m_gelVertices.size();
 				for (int i=0; i<numVertices; i++)
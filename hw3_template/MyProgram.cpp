@@ -76,7 +76,6 @@ cMesh* object[4];
 
 // label to show estimate of haptic update rate
 cLabel* rateLabel;
-double rateEstimate = 0;
 
 // normal line
 cShapeLine* normalLine = 0;
@@ -84,11 +83,17 @@ cShapeLine* normalLine = 0;
 // label to show position of haptic device
 cLabel* positionLabel = 0;
 
+// labels to show the timing of the stages of the haptics loop
+vector<cLabel*> profilerLabels;
+
+// clock time of the last update of the profiler labels
+double profilerUpdateTime = 0;
+
 // status of the main simulation haptics loop
 bool simulationRunning = false;
 
-// has exited haptics simulation thread
-bool simulationFinished = false;
+// fixed rate loop running the haptics simulation
+cHapticLoop* hapticsLoop;
 
 //---------------------------------------------------------------------------
 // DECLARED FUNCTIONS
@@ -112,8 +117,8 @@ cMesh* createObject();
 // main graphics callback
 void updateGraphics(void);
 
-// main haptics loop
-void updateHaptics(void);
+// main haptics loop, called at every tick of the haptics loop
+void updateHaptics(void* a_data);
 
 //===========================================================================
 /*
@@ -189,6 +194,16 @@ int main(int argc, char* argv[])
     positionLabel->setPos(8,8,0);
     camera->m_front_2Dscene.addChild(positionLabel);
 
+    // create labels that show the timing of the haptics loop, one per
+    // stage; press 'p' to start or stop profiling
+    for (int i=0; i<CHAI_PROFILER_NUM_STAGES; i++)
+    {
+        cLabel* label = new cLabel();
+        label->setPos(8, 56 + 16 * (CHAI_PROFILER_NUM_STAGES - 1 - i), 0);
+        camera->m_front_2Dscene.addChild(label);
+        profilerLabels.push_back(label);
+    }
+
     //-----------------------------------------------------------------------
     // HAPTIC DEVICES / TOOLS
     //-----------------------------------------------------------------------
@@ -340,9 +355,10 @@ int main(int argc, char* argv[])
     // simulation in now running
     simulationRunning = true;
 
-    // create a thread which starts the main haptics rendering loop
-    cThread* hapticsThread = new cThread();
-    hapticsThread->set(updateHaptics, CHAI_THREAD_PRIORITY_HAPTICS);
+    // create a thread which runs the main haptics rendering loop at 1 kHz
+    hapticsLoop = new cHapticLoop();
+    hapticsLoop->setFrequency(1000.0);
+    hapticsLoop->start(updateHaptics, NULL);
 
     // start the main graphics rendering loop
     glutMainLoop();
@@ -377,6 +393,19 @@ void keySelect(unsigned char key, int x, int y)
         // exit application
         exit(0);
     }
+
+    // start or stop profiling the haptics loop
+    if (key == 'p')
+    {
+        cProfiler::setEnabled(!cProfiler::isEnabled());
+    }
+
+    // save the recent timing of the haptics loop
+    if (key == 's')
+    {
+        cProfiler::saveCSV("haptics_profile.csv");
+        cProfiler::saveChromeTrace("haptics_profile.json");
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -404,8 +433,8 @@ void close(void)
     // stop the simulation
     simulationRunning = false;
 
-    // wait for graphics and haptics loops to terminate
-    while (!simulationFinished) { cSleepMs(100); }
+    // wait for the haptics loop to terminate
+    hapticsLoop->stop();
 
     // close the haptic devices
     tool->stop();
@@ -472,14 +501,32 @@ cMesh* createObject()
 void updateGraphics(void)
 {
 
-    // update the label with the haptic refresh rate
+    // update the label with the haptic refresh rate and timing
     char buffer[256];
-    sprintf(buffer, "haptic rate: %.0lf Hz", rateEstimate);
+    cHapticLoopStatistics hapticsStatistics = hapticsLoop->getStatistics();
+    sprintf(buffer, "haptic rate: %.0lf Hz,  max jitter: %.0lf us,  overruns: %u",
+            hapticsStatistics.m_rate, 1e6 * hapticsStatistics.m_maxJitter, hapticsStatistics.m_numOverruns);
     rateLabel->m_string = buffer;
 
+    // update the labels with the timing of the haptics loop twice a second
+    double time = cHapticLoop::getClockSeconds();
+    if (time - profilerUpdateTime > 0.5)
+    {
+        vector<string> lines;
+        cProfiler::getReport(lines);
+        for (unsigned int i=0; i<profilerLabels.size(); i++)
+        {
+            profilerLabels[i]->m_string = (i < lines.size()) ? lines[i] : "";
+        }
+        profilerUpdateTime = time;
+    }
+
+    // read the latest state of the tool published by the haptics thread
+    const cGeneric3dofPointerState& toolState = tool->getState();
+
     // update position of tool
-    cVector3d toolLocalPos = tool->getDeviceLocalPos();
-    cVector3d toolPos = tool->getDeviceGlobalPos();
+    cVector3d toolLocalPos = toolState.m_deviceLocalPos;
+    cVector3d toolPos = toolState.m_deviceGlobalPos;
     sprintf(buffer, "global pos: (%.4lf, %.4lf, %.4lf),  local pos: (%.4lf, %.4lf, %.4lf)", toolPos.x, toolPos.y, toolPos.z, toolLocalPos.x, toolLocalPos.y, toolLocalPos.z );
     positionLabel->m_string = buffer;
 
@@ -493,8 +540,8 @@ void updateGraphics(void)
       }
     }
     double scale = 0.1;
-    normalLine->m_pointA = tool->getProxyGlobalPos();
-    normalLine->m_pointB = tool->getProxyGlobalPos() + scale*tool->m_proxyPointForceModel->getNormalForce();
+    normalLine->m_pointA = toolState.m_proxyGlobalPos;
+    normalLine->m_pointB = toolState.m_proxyGlobalPos + scale*toolState.m_normalForce;
 
     // render world
     camera->renderView(displayW, displayH);
@@ -516,41 +563,19 @@ void updateGraphics(void)
 
 //---------------------------------------------------------------------------
 
-void updateHaptics(void)
+void updateHaptics(void* a_data)
 {
-    // a clock to estimate the haptic simulation loop update rate
-    cPrecisionClock pclock;
-    pclock.setTimeoutPeriodSeconds(1.0);
-    pclock.start(true);
-    int counter = 0;
-
-    // main haptic simulation loop
-    while(simulationRunning)
-    {
-        // compute global reference frames for each object
-        world->computeGlobalPositions(true);
-
-        // update position and orientation of tool
-        tool->updatePose();
+    // compute global reference frames for each object
+    world->computeGlobalPositions(true);
 
-        // compute interaction forces
-        tool->computeInteractionForces();
+    // update position and orientation of tool
+    tool->updatePose();
 
-        // send forces to device
-        tool->applyForces();
+    // compute interaction forces
+    tool->computeInteractionForces();
 
-        // estimate the refresh rate
-        ++counter;
-        if (pclock.timeoutOccurred()) {
-            pclock.stop();
-            rateEstimate = counter;
-            counter = 0;
-            pclock.start(true);
-        }
-    }
-    
-    // exit haptics thread
-    simulationFinished = true;
+    // send forces to device
+    tool->applyForces();
 }
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,725 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CGELContactModel.h"
+#include "CGELMesh.h"
+#include <algorithm>
+#include <map>
+//---------------------------------------------------------------------------
+using std::map;
+using std::pair;
+//---------------------------------------------------------------------------
+//! Number of sizes stored per object to detect changes of the model.
+#define CHAI_GEL_CONTACT_MESH_SIZES 6
+
+//! Distance below which the direction between two spheres is undefined.
+#define CHAI_GEL_CONTACT_MIN_DISTANCE 0.0000001
+
+//! Searches over fewer spheres or triangles than this are always computed on the calling thread.
+#define CHAI_GEL_CONTACT_PARALLEL_MIN_ELEMENTS 1024
+
+//! Number of tasks created for each thread when searching in parallel.
+#define CHAI_GEL_CONTACT_TASKS_PER_THREAD 4
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Return the models used by an object, as a set of flags.
+
+    \fn       unsigned int getMeshFlags(cGELMesh* a_mesh)
+    \param    a_mesh  Deformable object.
+    \return   Return the flags of the object.
+*/
+//===========================================================================
+static unsigned int getMeshFlags(cGELMesh* a_mesh)
+{
+    return ((a_mesh->m_useSkeletonModel ? 1 : 0) |
+            (a_mesh->m_useMassParticleModel ? 2 : 0) |
+            (a_mesh->m_useSelfContact ? 4 : 0));
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cGELContactModel.
+
+    \fn       cGELContactModel::cGELContactModel()
+*/
+//===========================================================================
+cGELContactModel::cGELContactModel()
+{
+    m_maxRadius = 0.0;
+    m_threadPool = NULL;
+    m_taskContacts = NULL;
+    m_taskFunction = NULL;
+    m_taskCount = 0;
+    m_numTasks = 0;
+    m_numContacts = 0;
+    m_connectionOffsets.push_back(0);
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELContactModel.
+
+    \fn       cGELContactModel::~cGELContactModel()
+*/
+//===========================================================================
+cGELContactModel::~cGELContactModel()
+{
+}
+
+
+//===========================================================================
+/*!
+    Find the contacts between the spheres and triangles of the objects
+    using contacts, and add their forces to the skeleton nodes and mass
+    particles. Called between the computation of the internal forces and
+    the integration of each simulation step, while the mass particle
+    models are held in their particle systems.
+
+    \fn       void cGELContactModel::computeForces(const vector<cGELMesh*>& a_meshes,
+                                                 const double a_stiffness,
+                                                 const double a_damping)
+    \param    a_meshes  Deformable objects of the world.
+    \param    a_stiffness  Force per unit of penetration depth.
+    \param    a_damping  Force per unit of velocity along the normal.
+*/
+//===========================================================================
+void cGELContactModel::computeForces(const vector<cGELMesh*>& a_meshes,
+                                     const double a_stiffness,
+                                     const double a_damping)
+{
+    if (isModified(a_meshes))
+    {
+        build(a_meshes);
+    }
+
+    m_numContacts = 0;
+    if (m_spherePos.empty()) { return; }
+
+    readSpheres();
+    if (m_maxRadius <= 0.0) { return; }
+
+    // cells are large enough for touching spheres to lie in neighbouring cells
+    m_hash.setCellSize(2.0 * m_maxRadius);
+    m_hash.update(m_spherePos);
+
+    // search contacts
+    run(&cGELContactModel::findSphereContacts,
+        (unsigned int)m_spherePos.size(), m_sphereContacts);
+    run(&cGELContactModel::findTriangleContacts,
+        (unsigned int)m_triangleSpheres.size() / 3, m_triangleContacts);
+
+    // apply forces in a fixed order
+    applyContacts(m_sphereContacts, a_stiffness, a_damping);
+    applyContacts(m_triangleContacts, a_stiffness, a_damping);
+}
+
+
+//===========================================================================
+/*!
+    Compare the objects using contacts with those from which the model was
+    built.
+
+    \fn       bool cGELContactModel::isModified(const vector<cGELMesh*>& a_meshes) const
+    \param    a_meshes  Deformable objects of the world.
+    \return   Return \b true if the model must be built again.
+*/
+//===========================================================================
+bool cGELContactModel::isModified(const vector<cGELMesh*>& a_meshes) const
+{
+    unsigned int index = 0;
+    unsigned int numMeshes = (unsigned int)a_meshes.size();
+    for (unsigned int i=0; i<numMeshes; i++)
+    {
+        cGELMesh* mesh = a_meshes[i];
+        if (!mesh->m_useContacts) { continue; }
+
+        if ((index >= m_meshes.size()) || (m_meshes[index] != mesh)) { return (true); }
+
+        const unsigned int* sizes = &m_meshSizes[CHAI_GEL_CONTACT_MESH_SIZES * index];
+        if ((sizes[0] != getMeshFlags(mesh)) ||
+            (sizes[1] != mesh->m_nodes.size()) ||
+            (sizes[2] != mesh->m_gelVertices.size()) ||
+            (sizes[3] != mesh->m_linearSprings.size()) ||
+            (sizes[4] != mesh->m_links.size()) ||
+            (sizes[5] != mesh->getNumTriangles()))
+        {
+            return (true);
+        }
+        index++;
+    }
+
+    return (index != m_meshes.size());
+}
+
+
+//===========================================================================
+/*!
+    Collect the spheres and triangles of the objects using contacts, and
+    the spheres connected by springs or links within each object.
+
+    \fn       void cGELContactModel::build(const vector<cGELMesh*>& a_meshes)
+    \param    a_meshes  Deformable objects of the world.
+*/
+//===========================================================================
+void cGELContactModel::build(const vector<cGELMesh*>& a_meshes)
+{
+    m_meshes.clear();
+    m_meshSizes.clear();
+    m_sphereMesh.clear();
+    m_sphereNode.clear();
+    m_sphereParticle.clear();
+    m_sphereSelfContact.clear();
+    m_triangleSpheres.clear();
+
+    vector< pair<unsigned int, unsigned int> > connections;
+    vector<unsigned int> triangles;
+
+    unsigned int numMeshes = (unsigned int)a_meshes.size();
+    for (unsigned int i=0; i<numMeshes; i++)
+    {
+        cGELMesh* mesh = a_meshes[i];
+        if (!mesh->m_useContacts) { continue; }
+
+        unsigned int meshIndex = (unsigned int)m_meshes.size();
+        m_meshes.push_back(mesh);
+        m_meshSizes.push_back(getMeshFlags(mesh));
+        m_meshSizes.push_back((unsigned int)mesh->m_nodes.size());
+        m_meshSizes.push_back((unsigned int)mesh->m_gelVertices.size());
+        m_meshSizes.push_back((unsigned int)mesh->m_linearSprings.size());
+        m_meshSizes.push_back((unsigned int)mesh->m_links.size());
+        m_meshSizes.push_back(mesh->getNumTriangles());
+        unsigned char selfContact = mesh->m_useSelfContact ? 1 : 0;
+
+        // a sphere for each skeleton node
+        if (mesh->m_useSkeletonModel)
+        {
+            map<cGELSkeletonNode*, unsigned int> nodes;
+            list<cGELSkeletonNode*>::iterator j;
+            for(j = mesh->m_nodes.begin(); j != mesh->m_nodes.end(); ++j)
+            {
+                nodes[*j] = (unsigned int)m_sphereMesh.size();
+                m_sphereMesh.push_back(meshIndex);
+                m_sphereNode.push_back(*j);
+                m_sphereParticle.push_back(0);
+                m_sphereSelfContact.push_back(selfContact);
+            }
+
+            list<cGELSkeletonLink*>::iterator k;
+            for(k = mesh->m_links.begin(); k != mesh->m_links.end(); ++k)
+            {
+                map<cGELSkeletonNode*, unsigned int>::iterator node0 = nodes.find((*k)->m_node0);
+                map<cGELSkeletonNode*, unsigned int>::iterator node1 = nodes.find((*k)->m_node1);
+                if ((node0 != nodes.end()) && (node1 != nodes.end()))
+                {
+                    connections.push_back(pair<unsigned int, unsigned int>(node0->second, node1->second));
+                }
+            }
+        }
+
+        // a sphere for each mass particle, and the triangles joining them
+        if (mesh->m_useMassParticleModel)
+        {
+            unsigned int first = (unsigned int)m_sphereMesh.size();
+            unsigned int numVertices = (unsigned int)mesh->m_gelVertices.size();
+            map<cGELMassParticle*, unsigned int> particles;
+            for (unsigned int j=0; j<numVertices; j++)
+            {
+                particles[mesh->m_gelVertices[j].m_massParticle] = first + j;
+                m_sphereMesh.push_back(meshIndex);
+                m_sphereNode.push_back(NULL);
+                m_sphereParticle.push_back(j);
+                m_sphereSelfContact.push_back(selfContact);
+            }
+
+            list<cGELLinearSpring*>::iterator k;
+            for(k = mesh->m_linearSprings.begin(); k != mesh->m_linearSprings.end(); ++k)
+            {
+                map<cGELMassParticle*, unsigned int>::iterator node0 = particles.find((*k)->m_node0);
+                map<cGELMassParticle*, unsigned int>::iterator node1 = particles.find((*k)->m_node1);
+                if ((node0 != particles.end()) && (node1 != particles.end()))
+                {
+                    connections.push_back(pair<unsigned int, unsigned int>(node0->second, node1->second));
+                }
+            }
+
+            mesh->getSurfaceTriangles(triangles);
+            unsigned int numIndices = (unsigned int)triangles.size();
+            for (unsigned int j=0; j<numIndices; j++)
+            {
+                m_triangleSpheres.push_back(first + triangles[j]);
+            }
+        }
+    }
+
+    unsigned int numSpheres = (unsigned int)m_sphereMesh.size();
+    m_spherePos.resize(numSpheres);
+    m_sphereVel.resize(numSpheres);
+    m_sphereRadius.resize(numSpheres);
+
+    // store the connections of each sphere, in both directions
+    unsigned int numConnections = (unsigned int)connections.size();
+    m_connectionOffsets.assign(numSpheres + 1, 0);
+    for (unsigned int i=0; i<numConnections; i++)
+    {
+        m_connectionOffsets[connections[i].first + 1]++;
+        m_connectionOffsets[connections[i].second + 1]++;
+    }
+    for (unsigned int i=0; i<numSpheres; i++)
+    {
+        m_connectionOffsets[i+1] += m_connectionOffsets[i];
+    }
+    m_connections.resize(2 * numConnections);
+    vector<unsigned int> offsets(m_connectionOffsets.begin(), m_connectionOffsets.end() - 1);
+    for (unsigned int i=0; i<numConnections; i++)
+    {
+        m_connections[offsets[connections[i].first]++] = connections[i].second;
+        m_connections[offsets[connections[i].second]++] = connections[i].first;
+    }
+    for (unsigned int i=0; i<numSpheres; i++)
+    {
+        std::sort(m_connections.begin() + m_connectionOffsets[i],
+                  m_connections.begin() + m_connectionOffsets[i+1]);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Check whether two spheres are connected by a spring or a link.
+
+    \fn       bool cGELContactModel::isConnected(const unsigned int a_sphere0,
+                                               const unsigned int a_sphere1) const
+    \param    a_sphere0  Index of the first sphere.
+    \param    a_sphere1  Index of the second sphere.
+    \return   Return \b true if the spheres are connected.
+*/
+//===========================================================================
+bool cGELContactModel::isConnected(const unsigned int a_sphere0,
+                                   const unsigned int a_sphere1) const
+{
+    if (m_connectionOffsets[a_sphere0] == m_connectionOffsets[a_sphere0+1]) { return (false); }
+
+    const unsigned int* first = &m_connections[0] + m_connectionOffsets[a_sphere0];
+    const unsigned int* last = &m_connections[0] + m_connectionOffsets[a_sphere0+1];
+    return (std::binary_search(first, last, a_sphere1));
+}
+
+
+//===========================================================================
+/*!
+    Check whether two spheres have a contact, with the same test as
+    findSphereContacts().
+
+    \fn       bool cGELContactModel::isSphereContact(const unsigned int a_sphere0,
+                                                   const unsigned int a_sphere1) const
+    \param    a_sphere0  Index of the first sphere.
+    \param    a_sphere1  Index of the second sphere.
+    \return   Return \b true if the spheres have a contact.
+*/
+//===========================================================================
+bool cGELContactModel::isSphereContact(const unsigned int a_sphere0,
+                                       const unsigned int a_sphere1) const
+{
+    if ((m_sphereRadius[a_sphere0] <= 0.0) || (m_sphereRadius[a_sphere1] <= 0.0)) { return (false); }
+
+    // spheres of an object
+    if (m_sphereMesh[a_sphere0] == m_sphereMesh[a_sphere1])
+    {
+        if (!m_sphereSelfContact[a_sphere0] || isConnected(a_sphere0, a_sphere1)) { return (false); }
+    }
+
+    double sum = m_sphereRadius[a_sphere0] + m_sphereRadius[a_sphere1];
+    double distanceSq = cDistanceSq(m_spherePos[a_sphere0], m_spherePos[a_sphere1]);
+    if (distanceSq >= sum * sum) { return (false); }
+
+    return (sqrt(distanceSq) >= CHAI_GEL_CONTACT_MIN_DISTANCE);
+}
+
+
+//===========================================================================
+/*!
+    Read the position, velocity and radius of each sphere from the skeleton
+    nodes and the particle systems, and find the largest radius.
+
+    \fn       void cGELContactModel::readSpheres()
+*/
+//===========================================================================
+void cGELContactModel::readSpheres()
+{
+    m_maxRadius = 0.0;
+    unsigned int numSpheres = (unsigned int)m_spherePos.size();
+    for (unsigned int i=0; i<numSpheres; i++)
+    {
+        cGELSkeletonNode* node = m_sphereNode[i];
+        if (node != NULL)
+        {
+            m_spherePos[i] = node->m_pos;
+            m_sphereVel[i] = node->m_vel;
+            m_sphereRadius[i] = node->m_radius;
+        }
+        else
+        {
+            cGELMesh* mesh = m_meshes[m_sphereMesh[i]];
+            m_spherePos[i] = mesh->m_particleSystem.getPosition(m_sphereParticle[i]);
+            m_sphereVel[i] = mesh->m_particleSystem.getVelocity(m_sphereParticle[i]);
+            m_sphereRadius[i] = mesh->m_contactRadius;
+        }
+        m_maxRadius = cMax(m_maxRadius, m_sphereRadius[i]);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Split a range of spheres or triangles into tasks, and execute a search
+    over the range of each task on the thread pool. Small ranges are
+    searched by a single task on the calling thread. Returns when all tasks
+    have completed.
+
+    \fn       void cGELContactModel::run(void (cGELContactModel::*a_function)(unsigned int, unsigned int, vector<cGELContact>&),
+                                         unsigned int a_count,
+                                         vector< vector<cGELContact> >& a_contacts)
+    \param    a_function  Function searching a range of spheres or triangles.
+    \param    a_count  Number of spheres or triangles.
+    \param    a_contacts  Returned contacts found by each task.
+*/
+//===========================================================================
+void cGELContactModel::run(void (cGELContactModel::*a_function)(unsigned int, unsigned int, vector<cGELContact>&),
+                           unsigned int a_count,
+                           vector< vector<cGELContact> >& a_contacts)
+{
+    unsigned int numTasks = 1;
+    if ((m_threadPool != NULL) && (a_count >= CHAI_GEL_CONTACT_PARALLEL_MIN_ELEMENTS))
+    {
+        numTasks = cMin((m_threadPool->getNumThreads() + 1) * CHAI_GEL_CONTACT_TASKS_PER_THREAD,
+                        a_count);
+    }
+
+    // keep the storage of earlier steps
+    if (a_contacts.size() < numTasks) { a_contacts.resize(numTasks); }
+    for (unsigned int i=0; i<a_contacts.size(); i++)
+    {
+        a_contacts[i].clear();
+    }
+    if (a_count == 0) { return; }
+
+    if (numTasks == 1)
+    {
+        (this->*a_function)(0, a_count, a_contacts[0]);
+        return;
+    }
+
+    m_taskFunction = a_function;
+    m_taskCount = a_count;
+    m_numTasks = numTasks;
+    m_taskContacts = &a_contacts;
+
+    m_threadPool->run(runTask, this, m_numTasks);
+}
+
+
+//===========================================================================
+/*!
+    Execute the search given to run() over the range of a task. Called by
+    the threads of the pool.
+
+    \fn       void cGELContactModel::runTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELContactModel.
+    \param    a_task  Index of the task.
+*/
+//===========================================================================
+void cGELContactModel::runTask(void* a_data, unsigned int a_task)
+{
+    cGELContactModel* model = (cGELContactModel*)a_data;
+
+    // the first tasks take one more element when the count does not divide evenly
+    unsigned int size = model->m_taskCount / model->m_numTasks;
+    unsigned int remainder = model->m_taskCount % model->m_numTasks;
+    unsigned int first = a_task * size + cMin(a_task, remainder);
+    unsigned int last = first + size + ((a_task < remainder) ? 1 : 0);
+
+    (model->*(model->m_taskFunction))(first, last, (*model->m_taskContacts)[a_task]);
+}
+
+
+//===========================================================================
+/*!
+    Find the contacts of each sphere of a range with the spheres of higher
+    index, searching the 27 cells around the cell of the sphere.
+
+    \fn       void cGELContactModel::findSphereContacts(unsigned int a_first,
+                                                      unsigned int a_last,
+                                                      vector<cGELContact>& a_contacts)
+    \param    a_first  Index of the first sphere.
+    \param    a_last  Index following the last sphere.
+    \param    a_contacts  Contacts found, in the order of the spheres.
+*/
+//===========================================================================
+void cGELContactModel::findSphereContacts(unsigned int a_first,
+                                          unsigned int a_last,
+                                          vector<cGELContact>& a_contacts)
+{
+    cGELContact contact;
+    contact.m_triangle = false;
+    contact.m_weights[0] = contact.m_weights[1] = contact.m_weights[2] = 0.0;
+
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        double radius = m_sphereRadius[i];
+        if (radius <= 0.0) { continue; }
+
+        const cVector3d& pos = m_spherePos[i];
+        const int* cell = m_hash.getCell(i);
+        int neighbour[3];
+        for (neighbour[0]=cell[0]-1; neighbour[0]<=cell[0]+1; neighbour[0]++)
+        for (neighbour[1]=cell[1]-1; neighbour[1]<=cell[1]+1; neighbour[1]++)
+        for (neighbour[2]=cell[2]-1; neighbour[2]<=cell[2]+1; neighbour[2]++)
+        {
+            unsigned int j = m_hash.getFirstPoint(neighbour);
+            for (; j != CHAI_GEL_HASH_END; j = m_hash.getNextPoint(j))
+            {
+                // each pair is found once, from its sphere of lower index
+                if ((j <= i) || (m_sphereRadius[j] <= 0.0)) { continue; }
+                if (!m_hash.isInCell(j, neighbour)) { continue; }
+
+                // spheres of an object
+                if (m_sphereMesh[j] == m_sphereMesh[i])
+                {
+                    if (!m_sphereSelfContact[i] || isConnected(i, j)) { continue; }
+                }
+
+                double sum = radius + m_sphereRadius[j];
+                cVector3d offset = cSub(pos, m_spherePos[j]);
+                double distanceSq = offset.lengthsq();
+                if (distanceSq >= sum * sum) { continue; }
+
+                double distance = sqrt(distanceSq);
+                if (distance < CHAI_GEL_CONTACT_MIN_DISTANCE) { continue; }
+
+                contact.m_sphere = i;
+                contact.m_other = j;
+                offset.mulr(1.0 / distance, contact.m_normal);
+                contact.m_depth = sum - distance;
+                a_contacts.push_back(contact);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Find the contacts of each triangle of a range with the spheres, searching
+    the cells covered by the box of the triangle enlarged by the largest
+    radius. A sphere nearest to a vertex of the triangle is skipped if it
+    has a contact with the sphere of this vertex, which already pushes
+    them apart.
+
+    \fn       void cGELContactModel::findTriangleContacts(unsigned int a_first,
+                                                        unsigned int a_last,
+                                                        vector<cGELContact>& a_contacts)
+    \param    a_first  Index of the first triangle.
+    \param    a_last  Index following the last triangle.
+    \param    a_contacts  Contacts found, in the order of the triangles.
+*/
+//===========================================================================
+void cGELContactModel::findTriangleContacts(unsigned int a_first,
+                                            unsigned int a_last,
+                                            vector<cGELContact>& a_contacts)
+{
+    cGELContact contact;
+    contact.m_triangle = true;
+
+    for (unsigned int t=a_first; t<a_last; t++)
+    {
+        const unsigned int* vertices = &m_triangleSpheres[3*t];
+        const cVector3d& p0 = m_spherePos[vertices[0]];
+        const cVector3d& p1 = m_spherePos[vertices[1]];
+        const cVector3d& p2 = m_spherePos[vertices[2]];
+        unsigned int mesh = m_sphereMesh[vertices[0]];
+        bool selfContact = (m_sphereSelfContact[vertices[0]] != 0);
+
+        // cells covered by the enlarged box of the triangle
+        cVector3d boxMin(cMin(p0.x, cMin(p1.x, p2.x)) - m_maxRadius,
+                         cMin(p0.y, cMin(p1.y, p2.y)) - m_maxRadius,
+                         cMin(p0.z, cMin(p1.z, p2.z)) - m_maxRadius);
+        cVector3d boxMax(cMax(p0.x, cMax(p1.x, p2.x)) + m_maxRadius,
+                         cMax(p0.y, cMax(p1.y, p2.y)) + m_maxRadius,
+                         cMax(p0.z, cMax(p1.z, p2.z)) + m_maxRadius);
+        int cellMin[3], cellMax[3];
+        m_hash.computeCell(boxMin, cellMin);
+        m_hash.computeCell(boxMax, cellMax);
+
+        int cell[3];
+        for (cell[0]=cellMin[0]; cell[0]<=cellMax[0]; cell[0]++)
+        for (cell[1]=cellMin[1]; cell[1]<=cellMax[1]; cell[1]++)
+        for (cell[2]=cellMin[2]; cell[2]<=cellMax[2]; cell[2]++)
+        {
+            unsigned int j = m_hash.getFirstPoint(cell);
+            for (; j != CHAI_GEL_HASH_END; j = m_hash.getNextPoint(j))
+            {
+                double radius = m_sphereRadius[j];
+                if (radius <= 0.0) { continue; }
+                if (!m_hash.isInCell(j, cell)) { continue; }
+
+                // spheres of the object of the triangle
+                if (m_sphereMesh[j] == mesh)
+                {
+                    if (!selfContact) { continue; }
+                    if ((j == vertices[0]) || (j == vertices[1]) || (j == vertices[2])) { continue; }
+                    if (isConnected(j, vertices[0]) ||
+                        isConnected(j, vertices[1]) ||
+                        isConnected(j, vertices[2])) { continue; }
+                }
+
+                const cVector3d& pos = m_spherePos[j];
+                cVector3d point = cProjectPointOnTriangle(pos, p0, p1, p2, contact.m_weights);
+                cVector3d offset = cSub(pos, point);
+                double distanceSq = offset.lengthsq();
+                if (distanceSq >= radius * radius) { continue; }
+
+                // the nearest point is a vertex which the sphere already touches
+                bool vertexContact = false;
+                for (int k=0; k<3; k++)
+                {
+                    if ((contact.m_weights[k] == 1.0) && isSphereContact(j, vertices[k]))
+                    {
+                        vertexContact = true;
+                    }
+                }
+                if (vertexContact) { continue; }
+
+                double distance = sqrt(distanceSq);
+                if (distance >= CHAI_GEL_CONTACT_MIN_DISTANCE)
+                {
+                    offset.mulr(1.0 / distance, contact.m_normal);
+                }
+                else
+                {
+                    // a sphere centered on the triangle is pushed along its normal
+                    cVector3d normal = cCross(cSub(p1, p0), cSub(p2, p0));
+                    double length = normal.length();
+                    if (length < CHAI_GEL_CONTACT_MIN_DISTANCE) { continue; }
+                    normal.mulr(1.0 / length, contact.m_normal);
+                }
+
+                contact.m_sphere = j;
+                contact.m_other = t;
+                contact.m_depth = radius - distance;
+                a_contacts.push_back(contact);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Apply the force of each contact found by the tasks of run(), in the
+    order of the tasks. The force is proportional to the penetration
+    depth, damped by the relative velocity along the normal, and never
+    pulls the sphere towards the other sphere or the triangle. The force on
+    a triangle is shared by its vertices according to the barycentric
+    coordinates of the contact point.
+
+    \fn       void cGELContactModel::applyContacts(const vector< vector<cGELContact> >& a_contacts,
+                                                 const double a_stiffness,
+                                                 const double a_damping)
+    \param    a_contacts  Contacts found by each task.
+    \param    a_stiffness  Force per unit of penetration depth.
+    \param    a_damping  Force per unit of velocity along the normal.
+*/
+//===========================================================================
+void cGELContactModel::applyContacts(const vector< vector<cGELContact> >& a_contacts,
+                                     const double a_stiffness,
+                                     const double a_damping)
+{
+    unsigned int numTasks = (unsigned int)a_contacts.size();
+    for (unsigned int i=0; i<numTasks; i++)
+    {
+        const vector<cGELContact>& contacts = a_contacts[i];
+        unsigned int numContacts = (unsigned int)contacts.size();
+        m_numContacts += numContacts;
+
+        for (unsigned int j=0; j<numContacts; j++)
+        {
+            const cGELContact& contact = contacts[j];
+
+            // velocity of the sphere relative to the other sphere or to the contact point
+            cVector3d velocity = m_sphereVel[contact.m_sphere];
+            if (contact.m_triangle)
+            {
+                const unsigned int* vertices = &m_triangleSpheres[3*contact.m_other];
+                for (int k=0; k<3; k++)
+                {
+                    velocity.sub(cMul(contact.m_weights[k], m_sphereVel[vertices[k]]));
+                }
+            }
+            else
+            {
+                velocity.sub(m_sphereVel[contact.m_other]);
+            }
+
+            double magnitude = a_stiffness * contact.m_depth -
+                               a_damping * cDot(velocity, contact.m_normal);
+            if (magnitude <= 0.0) { continue; }
+
+            cVector3d force = cMul(magnitude, contact.m_normal);
+            addForce(contact.m_sphere, force);
+
+            if (contact.m_triangle)
+            {
+                const unsigned int* vertices = &m_triangleSpheres[3*contact.m_other];
+                for (int k=0; k<3; k++)
+                {
+                    cVector3d share = cMul(-contact.m_weights[k], force);
+                    addForce(vertices[k], share);
+                }
+            }
+            else
+            {
+                cVector3d reaction = cNegate(force);
+                addForce(contact.m_other, reaction);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add a force to the skeleton node or mass particle of a sphere.
+
+    \fn       void cGELContactModel::addForce(const unsigned int a_sphere,
+                                            cVector3d& a_force)
+    \param    a_sphere  Index of the sphere.
+    \param    a_force  Force.
+*/
+//===========================================================================
+void cGELContactModel::addForce(const unsigned int a_sphere,
+                                cVector3d& a_force)
+{
+    cGELSkeletonNode* node = m_sphereNode[a_sphere];
+    if (node != NULL)
+    {
+        node->addForce(a_force);
+    }
+    else
+    {
+        m_meshes[m_sphereMesh[a_sphere]]->m_particleSystem.addForce(m_sphereParticle[a_sphere], a_force);
+    }
+}
@@ -0,0 +1,280 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CGELContactModelH
+#define CGELContactModelH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include "CGELSpatialHash.h"
+#include "CGELSkeletonNode.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+class cGELMesh;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CGELContactModel.h
+
+    \brief
+    <b> GEL Module </b> \n
+    Contacts Between Deformable Objects.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cGELContact
+    \ingroup    GEL
+
+    \brief
+    cGELContact is a contact found by a cGELContactModel, between a sphere
+    and another sphere or a surface triangle.
+*/
+//===========================================================================
+struct cGELContact
+{
+    //! Index of the sphere.
+    unsigned int m_sphere;
+
+    //! Index of the other sphere, or of the triangle.
+    unsigned int m_other;
+
+    //! If \b true, the sphere touches a triangle.
+    bool m_triangle;
+
+    //! Direction in which the force is applied to the sphere.
+    cVector3d m_normal;
+
+    //! Penetration depth.
+    double m_depth;
+
+    //! Barycentric coordinates of the contact point on the triangle.
+    double m_weights[3];
+};
+
+
+//===========================================================================
+/*!
+    \class      cGELContactModel
+    \ingroup    GEL
+
+    \brief
+    cGELContactModel computes penalty forces between the deformable objects
+    of a cGELWorld, and within an object if it allows self contact. \n
+
+    Skeleton nodes and the mass particles of objects using contacts are
+    spheres, of radius cGELSkeletonNode::m_radius and
+    cGELMesh::m_contactRadius respectively. Surface triangles of objects
+    using the mass particle model join three of their particles. A sphere
+    touches another sphere or a triangle when it is closer than its
+    radius, or the sum of the radii. The force pushes them apart in
+    proportion to the penetration depth, and is damped by their relative
+    velocity along the normal of the contact. \n
+
+    The spheres are sorted into a cGELSpatialHash of cells twice as large
+    as the largest radius, updated incrementally at each simulation step.
+    A sphere is tested against the spheres of the 27 cells around it, and
+    a triangle against the spheres of the cells covered by its box. Both
+    searches are split between the threads of a cThreadPool. Contacts are
+    then applied in the order of the spheres and triangles, so that results
+    do not depend on the number of threads. \n
+
+    Within an object, spheres connected by a spring or link do not touch,
+    nor does a triangle touch the spheres of its vertices or those connected
+    to them. Radii should be smaller than half the rest length of springs,
+    so that particles sliding along the surface do not catch on it. A
+    sphere whose nearest point on a triangle is a vertex, with which it
+    already has a sphere contact, does not touch the triangle, so that the
+    force is not applied twice. \n
+
+    Positions of all objects are expressed in the frame of the world.
+*/
+//===========================================================================
+class cGELContactModel
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELContactModel.
+    cGELContactModel();
+
+    //! Destructor of cGELContactModel.
+    ~cGELContactModel();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Find contacts between objects and add their forces to the nodes and particles.
+    void computeForces(const vector<cGELMesh*>& a_meshes,
+                       const double a_stiffness,
+                       const double a_damping);
+
+    //! Get the number of contacts found by the last call to computeForces().
+    unsigned int getNumContacts() const { return (m_numContacts); }
+
+    //! Get the number of spheres.
+    unsigned int getNumSpheres() const { return ((unsigned int)m_spherePos.size()); }
+
+    //! Get the spatial hash of the spheres.
+    const cGELSpatialHash& getSpatialHash() const { return (m_hash); }
+
+    //! Set the thread pool used on large models, or NULL to compute on the calling thread only.
+    void setThreadPool(cThreadPool* a_threadPool) { m_threadPool = a_threadPool; }
+
+    //! Get the thread pool used on large models.
+    cThreadPool* getThreadPool() const { return (m_threadPool); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Return \b true if objects, nodes, particles, springs, links or triangles have changed since the model was built.
+    bool isModified(const vector<cGELMesh*>& a_meshes) const;
+
+    //! Collect the spheres, triangles and connections of the objects using contacts.
+    void build(const vector<cGELMesh*>& a_meshes);
+
+    //! Return \b true if two spheres are connected.
+    bool isConnected(const unsigned int a_sphere0, const unsigned int a_sphere1) const;
+
+    //! Return \b true if two spheres have a contact, as found by findSphereContacts().
+    bool isSphereContact(const unsigned int a_sphere0, const unsigned int a_sphere1) const;
+
+    //! Read the position, velocity and radius of each sphere.
+    void readSpheres();
+
+    //! Split a range of spheres or triangles into tasks and execute them on the thread pool.
+    void run(void (cGELContactModel::*a_function)(unsigned int, unsigned int, vector<cGELContact>&),
+             unsigned int a_count,
+             vector< vector<cGELContact> >& a_contacts);
+
+    //! Execute a task of run(). Called by the threads of the pool.
+    static void runTask(void* a_data, unsigned int a_task);
+
+    //! Find the contacts of a range of spheres with the spheres following them.
+    void findSphereContacts(unsigned int a_first, unsigned int a_last,
+                            vector<cGELContact>& a_contacts);
+
+    //! Find the contacts of a range of triangles with the spheres.
+    void findTriangleContacts(unsigned int a_first, unsigned int a_last,
+                              vector<cGELContact>& a_contacts);
+
+    //! Apply the forces of the contacts found by the tasks of run().
+    void applyContacts(const vector< vector<cGELContact> >& a_contacts,
+                       const double a_stiffness,
+                       const double a_damping);
+
+    //! Add a force to a sphere.
+    void addForce(const unsigned int a_sphere, cVector3d& a_force);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - OBJECTS:
+    //-----------------------------------------------------------------------
+
+    //! Objects from which the model was built.
+    vector<cGELMesh*> m_meshes;
+
+    //! Models, numbers of nodes, particles, springs, links and triangles of each object when the model was built.
+    vector<unsigned int> m_meshSizes;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - SPHERES:
+    //-----------------------------------------------------------------------
+
+    //! Object of each sphere.
+    vector<unsigned int> m_sphereMesh;
+
+    //! Skeleton node of each sphere, or NULL for a particle.
+    vector<cGELSkeletonNode*> m_sphereNode;
+
+    //! Index of the particle of each sphere in the particle system of its object.
+    vector<unsigned int> m_sphereParticle;
+
+    //! Position of each sphere.
+    vector<cVector3d> m_spherePos;
+
+    //! Velocity of each sphere.
+    vector<cVector3d> m_sphereVel;
+
+    //! Radius of each sphere.
+    vector<double> m_sphereRadius;
+
+    //! If nonzero, the object of the sphere allows self contact.
+    vector<unsigned char> m_sphereSelfContact;
+
+    //! Offset of the first connection of each sphere in m_connections, followed by the size of m_connections.
+    vector<unsigned int> m_connectionOffsets;
+
+    //! Spheres connected to each sphere, by increasing index.
+    vector<unsigned int> m_connections;
+
+    //! Spatial hash of the spheres.
+    cGELSpatialHash m_hash;
+
+    //! Largest radius of the spheres.
+    double m_maxRadius;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - TRIANGLES:
+    //-----------------------------------------------------------------------
+
+    //! Spheres of the vertices of each triangle, three per triangle.
+    vector<unsigned int> m_triangleSpheres;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - THREADS:
+    //-----------------------------------------------------------------------
+
+    //! Thread pool used on large models.
+    cThreadPool* m_threadPool;
+
+    //! Contacts between spheres found by each task.
+    vector< vector<cGELContact> > m_sphereContacts;
+
+    //! Contacts between spheres and triangles found by each task.
+    vector< vector<cGELContact> > m_triangleContacts;
+
+    //! Contacts found by the tasks of run().
+    vector< vector<cGELContact> >* m_taskContacts;
+
+    //! Function executed by the tasks of run().
+    void (cGELContactModel::*m_taskFunction)(unsigned int, unsigned int, vector<cGELContact>&);
+
+    //! Number of spheres or triangles processed by run().
+    unsigned int m_taskCount;
+
+    //! Number of tasks of run().
+    unsigned int m_numTasks;
+
+    //! Number of contacts found by the last call to computeForces().
+    unsigned int m_numContacts;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
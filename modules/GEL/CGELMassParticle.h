@@ -72,6 +72,12 @@ class cGELMassParticle
         m_externalForce = a_force;
     }
 
+    //! Get external force applied to mass particle.
+    inline const cVector3d& getExternalForce() const
+    {
+        return (m_externalForce);
+    }
+
     //! Compute next position.
     inline void computeNextPose(double a_timeInterval)
     {
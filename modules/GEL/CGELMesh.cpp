@@ -13,8 +13,172 @@
 //---------------------------------------------------------------------------
 #include "CGELMesh.h"
 //---------------------------------------------------------------------------
+#include "CGELSkeletonIndex.h"
 #include "chai3d.h"
+#include <map>
 //---------------------------------------------------------------------------
+using std::map;
+//---------------------------------------------------------------------------
+//! Maximum number of skeleton nodes and links to which a vertex is attached.
+#define CHAI_GEL_MAX_INFLUENCES 8
+
+//! Meshes with fewer vertices than this are connected to the skeleton on the calling thread.
+#define CHAI_GEL_PARALLEL_CONNECT_MIN_VERTICES 1024
+
+//! Number of tasks created for each thread when connecting vertices in parallel.
+#define CHAI_GEL_PARALLEL_CONNECT_TASKS_PER_THREAD 4
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cGELMeshConnection
+    \ingroup    GEL
+
+    \brief
+    cGELMeshConnection holds the parameters of a call to
+    cGELMesh::connectVerticesToSkeleton(), shared by the tasks of the
+    thread pool.
+*/
+//===========================================================================
+struct cGELMeshConnection
+{
+    //! Deformable mesh.
+    cGELMesh* m_mesh;
+
+    //! Index of the skeleton of the mesh.
+    cGELSkeletonIndex* m_index;
+
+    //! If \b true, vertices are only connected to nodes.
+    bool m_connectToNodesOnly;
+
+    //! Number of nodes or links to which each vertex is connected.
+    unsigned int m_numInfluences;
+
+    //! Number of tasks.
+    unsigned int m_numTasks;
+};
+
+
+//===========================================================================
+/*!
+    Compute the position of a point in the frame of a skeleton node or
+    link.
+
+    \fn       cVector3d computeSkeletonPos(const cVector3d& a_pos,
+                                  const cGELSkeletonNode* a_node,
+                                  const cGELSkeletonLink* a_link)
+    \param    a_pos  Position of the point.
+    \param    a_node  Skeleton node, or NULL.
+    \param    a_link  Skeleton link, if \e a_node is NULL.
+    \return   Return the position of the point in the frame of the node or link.
+*/
+//===========================================================================
+static cVector3d computeSkeletonPos(const cVector3d& a_pos,
+                                    const cGELSkeletonNode* a_node,
+                                    const cGELSkeletonLink* a_link)
+{
+    if (a_node != NULL)
+    {
+        cVector3d posRel = cSub(a_pos, a_node->m_pos);
+        return (cMul(cTrans(a_node->m_rot), posRel));
+    }
+    else
+    {
+        cMatrix3d rot;
+        rot.setCol( a_link->m_A0,
+                    a_link->m_B0,
+                    a_link->m_wLink01);
+        cVector3d posRel = cSub(a_pos, a_link->m_node0->m_pos);
+        return (cMul(cInv(rot), posRel));
+    }
+}
+
+
+//===========================================================================
+/*!
+    Connect the vertices of a task to the nearest skeleton nodes or links.
+    Called by the threads of a cThreadPool. \n
+
+    A vertex connected to several nodes or links gives each of them a
+    weight which decreases with its distance, and reaches zero at the
+    distance of the next nearest node or link, so that weights vary
+    continuously over the surface.
+
+    \fn       void connectVertices(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELMeshConnection.
+    \param    a_task  Index of the task.
+*/
+//===========================================================================
+static void connectVertices(void* a_data, unsigned int a_task)
+{
+    cGELMeshConnection* connection = (cGELMeshConnection*)a_data;
+    vector<cGELVertex>& vertices = connection->m_mesh->m_gelVertices;
+    unsigned int numVertices = (unsigned int)vertices.size();
+    unsigned int first = (unsigned int)(((double)numVertices * a_task) / connection->m_numTasks);
+    unsigned int last = (unsigned int)(((double)numVertices * (a_task + 1)) / connection->m_numTasks);
+
+    // one more result than influences gives the distance at which weights reach zero
+    cGELSkeletonIndexResult results[CHAI_GEL_MAX_INFLUENCES + 1];
+    unsigned int maxResults = connection->m_numInfluences;
+    if (maxResults > 1) { maxResults++; }
+
+    for (unsigned int i=first; i<last; i++)
+    {
+        // get current deformable vertex
+        cGELVertex* curVertex = &vertices[i];
+        curVertex->m_influences.clear();
+
+        // get current vertex position
+        cVector3d pos = curVertex->m_vertex->getPos();
+
+        // search for the nearest nodes and links
+        unsigned int numResults = connection->m_index->findNearest(pos,
+                                                                   maxResults,
+                                                                   !connection->m_connectToNodesOnly,
+                                                                   results);
+        if (numResults == 0) { continue; }
+
+        // attach vertex to nearest node or link
+        curVertex->m_node = results[0].m_node;
+        curVertex->m_link = results[0].m_link;
+        curVertex->m_massParticle->m_pos = computeSkeletonPos(pos, results[0].m_node, results[0].m_link);
+
+        if (connection->m_numInfluences < 2) { continue; }
+
+        // weights of the nearest nodes and links
+        unsigned int numInfluences = cMin(numResults, connection->m_numInfluences);
+        double range = 2.0 * results[numResults-1].m_distance;
+        if (numResults > numInfluences)
+        {
+            range = results[numInfluences].m_distance;
+        }
+
+        double sum = 0.0;
+        curVertex->m_influences.resize(numInfluences);
+        for (unsigned int j=0; j<numInfluences; j++)
+        {
+            cGELVertexInfluence& influence = curVertex->m_influences[j];
+            influence.m_node = results[j].m_node;
+            influence.m_link = results[j].m_link;
+            influence.m_pos = computeSkeletonPos(pos, results[j].m_node, results[j].m_link);
+            influence.m_weight = 0.0;
+            if (range > 0.0)
+            {
+                double w = 1.0 - results[j].m_distance / range;
+                influence.m_weight = w * w;
+            }
+            sum += influence.m_weight;
+        }
+
+        // normalize weights; equally distant nodes and links share the vertex
+        for (unsigned int j=0; j<numInfluences; j++)
+        {
+            cGELVertexInfluence& influence = curVertex->m_influences[j];
+            influence.m_weight = (sum > 0.0) ? (influence.m_weight / sum) : (1.0 / numInfluences);
+        }
+    }
+}
+
 
 //===========================================================================
 /*!
@@ -29,6 +193,10 @@ void cGELMesh::initialise()
     m_showMassParticleModel = false;
     m_useSkeletonModel = false;
     m_useMassParticleModel = false;
+    m_useTetrahedralIndex = false;
+    m_useContacts = false;
+    m_useSelfContact = false;
+    m_contactRadius = 0.0;
 }
 
 
@@ -52,12 +220,7 @@ void cGELMesh::clearForces()
     }
     if (m_useMassParticleModel)
     {
-        vector<cGELVertex>::iterator i;
-
-        for(i = m_gelVertices.begin(); i != m_gelVertices.end(); ++i)
-        {
-            i->m_massParticle->clearForces();
-        }
+        m_particleSystem.clearForces();
     }
 }
 
@@ -112,12 +275,7 @@ void cGELMesh::computeForces()
     }
     if (m_useMassParticleModel)
     {
-        list<cGELLinearSpring*>::iterator i;
-
-        for(i = m_linearSprings.begin(); i != m_linearSprings.end(); ++i)
-        {
-            (*i)->computeForces();
-        }
+        m_particleSystem.computeForces();
     }
 }
 
@@ -141,13 +299,42 @@ void cGELMesh::computeNextPose(double a_timeInterval)
     }
     if (m_useMassParticleModel)
     {
-        vector<cGELVertex>::iterator i;
+        m_particleSystem.computeNextPose(a_timeInterval);
+    }
+}
 
-        for(i = m_gelVertices.begin(); i != m_gelVertices.end(); ++i)
+
+//===========================================================================
+/*!
+    Compute next pose of each node. Mass particles are integrated by
+    implicit Euler (see cGELParticleSystem::computeNextPoseImplicit());
+    skeleton nodes are integrated by explicit Euler.
+
+    \fn      void cGELMesh::computeNextPoseImplicit(double a_timeInterval,
+                                                   double a_tolerance,
+                                                   unsigned int a_maxIterations)
+    \param   a_timeInterval  Time step.
+    \param   a_tolerance  Relative residual at which the solver stops.
+    \param   a_maxIterations  Maximum number of solver iterations.
+*/
+//===========================================================================
+void cGELMesh::computeNextPoseImplicit(double a_timeInterval,
+                                       double a_tolerance,
+                                       unsigned int a_maxIterations)
+{
+    if (m_useSkeletonModel)
+    {
+        list<cGELSkeletonNode*>::iterator i;
+
+        for(i = m_nodes.begin(); i != m_nodes.end(); ++i)
         {
-            i->m_massParticle->computeNextPose(a_timeInterval);
+            (*i)->computeNextPose(a_timeInterval);
         }
     }
+    if (m_useMassParticleModel)
+    {
+        m_particleSystem.computeNextPoseImplicit(a_timeInterval, a_tolerance, a_maxIterations);
+    }
 }
 
 
@@ -171,12 +358,7 @@ void cGELMesh::applyNextPose()
     }
     if (m_useMassParticleModel)
     {
-        vector<cGELVertex>::iterator i;
-
-        for(i = m_gelVertices.begin(); i != m_gelVertices.end(); ++i)
-        {
-            i->m_massParticle->applyNextPose();
-        }
+        m_particleSystem.applyNextPose();
     }
 }
 
@@ -247,6 +429,21 @@ void cGELMesh::render(const int a_renderMode)
 }
 
 
+//===========================================================================
+/*!
+    A deformable mesh may be reordered by a render queue unless its
+    skeleton or mass particle model is rendered.
+
+    \fn       bool cGELMesh::isRenderSortable() const
+    \return   Return \b true if the mesh only renders its triangles.
+*/
+//===========================================================================
+bool cGELMesh::isRenderSortable() const
+{
+    return (cMesh::isRenderSortable() && (!m_showSkeletonModel) && (!m_showMassParticleModel));
+}
+
+
 //===========================================================================
 /*!
     Build dynamic vertices for deformable mesh
@@ -258,6 +455,8 @@ void cGELMesh::buildVertices()
 {
     // clear all deformable vertices
     m_gelVertices.clear();
+    m_particleSystem.clear();
+    m_skin.invalidate();
 
     // get number of vertices
     int numVertices = getNumVertices(true);
@@ -280,95 +479,120 @@ void cGELMesh::buildVertices()
 
 //===========================================================================
 /*!
-    Connect each vertex to nearest node.
+    Connect each vertex to the nearest skeleton node or link. Nodes and
+    links are sorted into a cGELSkeletonIndex, and vertices are connected
+    in parallel on large meshes. \n
+
+    With \e a_numInfluences greater than one, each vertex is also attached
+    to that many of the nearest nodes or links, and its position blends
+    their motion (see updateVertexPosition()), which smooths the skin
+    between nodes.
 
-    \fn     void cGELMesh::connectVerticesToSkeleton(bool a_connectToNodesOnly)
+    \fn     void cGELMesh::connectVerticesToSkeleton(bool a_connectToNodesOnly,
+                                                    unsigned int a_numInfluences)
     \param  a_connectToNodesOnly  if \b true, then skin is only connected to nodes.
                 otherwise skin shall be connected to links too.
+    \param  a_numInfluences  Number of nodes or links to which each vertex
+                is attached, at most CHAI_GEL_MAX_INFLUENCES.
 */
 //===========================================================================
-void cGELMesh::connectVerticesToSkeleton(bool a_connectToNodesOnly)
+void cGELMesh::connectVerticesToSkeleton(bool a_connectToNodesOnly,
+                                         unsigned int a_numInfluences)
 {
     // get number of vertices
-    int numVertices = m_gelVertices.size();
+    unsigned int numVertices = (unsigned int)m_gelVertices.size();
+    if (numVertices == 0) { return; }
+
+    // sort skeleton into a grid
+    cGELSkeletonIndex index;
+    index.build(m_nodes, m_links);
+
+    cGELMeshConnection connection;
+    connection.m_mesh = this;
+    connection.m_index = &index;
+    connection.m_connectToNodesOnly = a_connectToNodesOnly;
+    connection.m_numInfluences = cClamp(a_numInfluences, 1u, (unsigned int)CHAI_GEL_MAX_INFLUENCES);
+    connection.m_numTasks = 1;
 
     // for each deformable vertex we search for the nearest sphere or link
-    for (int i=0; i<numVertices; i++)
+    cThreadPool* threadPool = cThreadPool::getDefaultThreadPool();
+    unsigned int numThreads = (threadPool != NULL) ? threadPool->getNumThreads() : 0;
+    if ((numThreads > 0) && (numVertices >= CHAI_GEL_PARALLEL_CONNECT_MIN_VERTICES))
     {
-        // get current deformable vertex
-        cGELVertex* curVertex = &m_gelVertices[i];
+        connection.m_numTasks = (numThreads + 1) * CHAI_GEL_PARALLEL_CONNECT_TASKS_PER_THREAD;
+        threadPool->run(connectVertices, &connection, connection.m_numTasks);
+    }
+    else
+    {
+        connectVertices(&connection, 0);
+    }
 
-        // get current vertex position
-        cVector3d pos = curVertex->m_vertex->getPos();
+    // bindings of the skin have changed
+    m_skin.invalidate();
+}
 
-        // initialize constant
-        double min_distance = 99999999999999999.0;
-        cGELSkeletonNode* nearest_node = NULL;
-        cGELSkeletonLink* nearest_link = NULL;
 
-        // search for the nearest node
-		list<cGELSkeletonNode*>::iterator itr;
-        for(itr = m_nodes.begin(); itr != m_nodes.end(); ++itr)
-        {
-            cGELSkeletonNode* nextNode = *itr;
-            double distance = cDistance(pos, nextNode->m_pos);
-            if (distance < min_distance)
-            {
-                min_distance = distance;
-                nearest_node = nextNode;
-                nearest_link = NULL;
-            }
-        }
+//===========================================================================
+/*!
+    Update position of vertices connected to skeleton, or to their mass
+    particle, and recompute their normals (see cGELSkin). The collision
+    detector of the mesh, if any, is refitted to the new positions. Ranges
+    of modified vertices are passed to the vertex buffer objects of the
+    mesh and its children, and cleared from the skin.
 
-        // search for the nearest link if any
-        if (!a_connectToNodesOnly)
-        {
-            list<cGELSkeletonLink*>::iterator j;
-            for(j = m_links.begin(); j != m_links.end(); ++j)
-            {
-                cGELSkeletonLink* nextLink = *j;
-                double angle0 = cAngle(nextLink->m_wLink01, cSub(pos, nextLink->m_node0->m_pos));
-                double angle1 = cAngle(nextLink->m_wLink10, cSub(pos, nextLink->m_node1->m_pos));
-
-                if ((angle0 < (CHAI_PI / 2.0)) && (angle1 < (CHAI_PI / 2.0)))
-                {
-                    cVector3d p = cProjectPointOnLine(pos,
-                                                      nextLink->m_node0->m_pos,
-                                                      nextLink->m_wLink01);
-
-                    double distance = cDistance(pos, p);
-
-                    if (distance < min_distance)
-                    {
-                        min_distance = distance;
-                        nearest_node = NULL;
-                        nearest_link = nextLink;
-                    }
-                }
-            }
-        }
+    \fn       void cGELMesh::updateVertexPosition()
+*/
+//===========================================================================
+void cGELMesh::updateVertexPosition()
+{
+    // update vertices and normals of the skin
+    m_skin.update(this);
+
+    // copy only the modified vertices on the next rendering
+    unsigned int offset = 0;
+    markSkinModified(this, offset);
+    m_skin.clearDirtyRanges();
+
+    // fit collision tree to the new vertex positions
+    refitCollisionDetector(false);
+}
 
-        // attach vertex to nearest node if it exists
-        if (nearest_node != NULL)
+
+//===========================================================================
+/*!
+    Mark the vertices of a mesh modified by the last update of the skin.
+    Vertices of the skin are those of the mesh followed by those of its
+    children, in the order of cMesh::getVertex().
+
+    \fn       void cGELMesh::markSkinModified(cMesh* a_mesh, unsigned int& a_offset)
+    \param    a_mesh  Mesh, this one or one of its children.
+    \param    a_offset  Index in the skin of the first vertex of the mesh,
+                        moved past the vertices of the mesh and its children.
+*/
+//===========================================================================
+void cGELMesh::markSkinModified(cMesh* a_mesh, unsigned int& a_offset)
+{
+    unsigned int numVertices = a_mesh->getNumVertices(false);
+    const vector<cGELSkinRange>& ranges = m_skin.getDirtyRanges();
+    unsigned int numRanges = (unsigned int)ranges.size();
+    for (unsigned int i=0; i<numRanges; i++)
+    {
+        unsigned int first = cMax(ranges[i].m_first, a_offset);
+        unsigned int last = cMin(ranges[i].m_first + ranges[i].m_count, a_offset + numVertices);
+        if (first < last)
         {
-            curVertex->m_node = nearest_node;
-            curVertex->m_link = NULL;
-            cVector3d posRel = cSub(pos, nearest_node->m_pos);
-            curVertex->m_massParticle->m_pos = cMul(cTrans(nearest_node->m_rot), posRel);
+            a_mesh->markVerticesModified(first - a_offset, last - first);
         }
+    }
+    a_offset += numVertices;
 
-        // attach vertex to nearest link if it exists
-        else if (nearest_link != NULL)
+    unsigned int numChildren = a_mesh->getNumChildren();
+    for (unsigned int i=0; i<numChildren; i++)
+    {
+        cMesh* child = dynamic_cast<cMesh*>(a_mesh->getChild(i));
+        if (child != NULL)
         {
-            curVertex->m_node = NULL;
-            curVertex->m_link = nearest_link;
-
-            cMatrix3d rot;
-            rot.setCol( nearest_link->m_A0,
-                        nearest_link->m_B0,
-                        nearest_link->m_wLink01);
-            cVector3d posRel = cSub(pos, nearest_link->m_node0->m_pos);
-            curVertex->m_massParticle->m_pos = cMul(cInv(rot), posRel);
+            markSkinModified(child, a_offset);
         }
     }
 }
@@ -376,66 +600,248 @@ void cGELMesh::connectVerticesToSkeleton(bool a_connectToNodesOnly)
 
 //===========================================================================
 /*!
-    Update position of vertices connected to skeleton.
-
-    \fn       void cGELMesh::updateVertexPosition()
+    Rebuild the particle system from the mass particles of the deformable
+    vertices and from the linear springs. This must be called after linear
+    springs are removed or connected to other particles, but not after
+    their constants are modified, which are read at every step. It is
+    called by readParticles() when vertices or springs have been added.
+    Particles of springs which do not belong to a vertex of this mesh are
+    held in place.
+
+    \fn       void cGELMesh::updateParticleSystem()
 */
 //===========================================================================
-void cGELMesh::updateVertexPosition()
+void cGELMesh::updateParticleSystem()
 {
-    if (m_useSkeletonModel)
+    m_particleSystem.clear();
+
+    // add the mass particle of each deformable vertex
+    map<cGELMassParticle*, unsigned int> indices;
+    int numVertices = m_gelVertices.size();
+    for (int i=0; i<numVertices; i++)
     {
-        // get number of vertices
-        int numVertices = m_gelVertices.size();
+        cGELMassParticle* particle = m_gelVertices[i].m_massParticle;
+        indices[particle] = m_particleSystem.addParticle(particle);
+    }
 
-        // for each deformable vertex, update its position
-        for (int i=0; i<numVertices; i++)
-        {
-            // get current deformable vertex
-            cGELVertex* curVertex = &m_gelVertices[i];
+    // add springs, connecting them to their particles by index
+    list<cGELLinearSpring*>::iterator i;
+    for(i = m_linearSprings.begin(); i != m_linearSprings.end(); ++i)
+    {
+        cGELLinearSpring* spring = *i;
+        cGELMassParticle* nodes[2] = { spring->m_node0, spring->m_node1 };
+        unsigned int index[2];
 
-            // the vertex is attached to an node
-            if (curVertex->m_node != NULL)
+        for (int k=0; k<2; k++)
+        {
+            map<cGELMassParticle*, unsigned int>::iterator j = indices.find(nodes[k]);
+            if (j != indices.end())
             {
-                cVector3d newPos;
-                curVertex->m_node->m_rot.mulr(curVertex->m_massParticle->m_pos, newPos);
-                newPos.add(curVertex->m_node->m_pos);
-                curVertex->m_vertex->setPos(newPos);
+                index[k] = j->second;
             }
-
-            else if (curVertex->m_link != NULL)
+            else
             {
-                cVector3d newPos;
-                curVertex->m_link->m_node0->m_pos.addr(curVertex->m_massParticle->m_pos.z * curVertex->m_link->m_wLink01, newPos);
-                newPos.add(curVertex->m_massParticle->m_pos.x * curVertex->m_link->m_wA0);
-                newPos.add(curVertex->m_massParticle->m_pos.y * curVertex->m_link->m_wB0);
+                index[k] = m_particleSystem.addParticle(nodes[k], false);
+                indices[nodes[k]] = index[k];
+            }
+        }
 
+        m_particleSystem.addSpring(spring, index[0], index[1]);
+    }
+}
 
-                //curVertex->node->m_rot.mulr(curVertex->pos, newPos);
-                //newPos.add(curVertex->node->m_pos);
-                curVertex->m_vertex->setPos(newPos);
-            }
+
+//===========================================================================
+/*!
+    Copy the state of the mass particles into the particle system. The mass
+    particle model is simulated in the particle system by clearForces(),
+    computeForces(), computeNextPose() and applyNextPose(), between calls
+    to readParticles() and writeParticles().
+
+    \fn       void cGELMesh::readParticles()
+*/
+//===========================================================================
+void cGELMesh::readParticles()
+{
+    if (m_useMassParticleModel)
+    {
+        // rebuild particle system if vertices or springs have been added
+        if ((m_particleSystem.getNumParticles() < m_gelVertices.size()) ||
+            (m_particleSystem.getNumSprings() != m_linearSprings.size()))
+        {
+            updateParticleSystem();
         }
+
+        m_particleSystem.readParticles();
     }
+}
+
+
+//===========================================================================
+/*!
+    Copy positions and velocities of the particle system back to the mass
+    particles.
 
+    \fn       void cGELMesh::writeParticles()
+*/
+//===========================================================================
+void cGELMesh::writeParticles()
+{
     if (m_useMassParticleModel)
     {
-        // get number of vertices
-        int numVertices = m_gelVertices.size();
+        m_particleSystem.writeParticles();
+    }
+}
+
 
-        // for each deformable vertex, update its position
-        for (int i=0; i<numVertices; i++)
+//===========================================================================
+/*!
+    Get the allocated triangles of the mesh joining deformable vertices,
+    which form the surface of the body. Triangles of child meshes are not
+    included.
+
+    \fn       void cGELMesh::getSurfaceTriangles(vector<unsigned int>& a_triangles) const
+    \param    a_triangles  Returned indices in m_gelVertices of the vertices
+              of each triangle, three per triangle.
+*/
+//===========================================================================
+void cGELMesh::getSurfaceTriangles(vector<unsigned int>& a_triangles) const
+{
+    a_triangles.clear();
+
+    unsigned int numVertices = (unsigned int)m_gelVertices.size();
+    unsigned int numTriangles = (unsigned int)m_triangles.size();
+    for (unsigned int i=0; i<numTriangles; i++)
+    {
+        const cTriangle& triangle = m_triangles[i];
+        if ((triangle.m_allocated) &&
+            (triangle.m_indexVertex0 < numVertices) &&
+            (triangle.m_indexVertex1 < numVertices) &&
+            (triangle.m_indexVertex2 < numVertices))
         {
-            // get current deformable vertex
-            cGELVertex* curVertex = &m_gelVertices[i];
+            a_triangles.push_back(triangle.m_indexVertex0);
+            a_triangles.push_back(triangle.m_indexVertex1);
+            a_triangles.push_back(triangle.m_indexVertex2);
+        }
+    }
+}
 
-            // the vertex is attached to an node
-            if (curVertex->m_massParticle != NULL)
-            {
-                curVertex->m_vertex->setPos(curVertex->m_massParticle->m_pos);
-            }
+
+//===========================================================================
+/*!
+    Bring the tetrahedral index up to date with the deformable vertices,
+    which are placed at their mass particle when the mass particle model
+    is used. The index is built again when vertices or tetrahedra have
+    been added, and otherwise refitted. Changes to the surface triangles
+    require \e a_rebuild to be \b true.
+
+    \fn       void cGELMesh::updateTetrahedralIndex(bool a_rebuild)
+    \param    a_rebuild  If \b true, the index is built again.
+*/
+//===========================================================================
+void cGELMesh::updateTetrahedralIndex(bool a_rebuild)
+{
+    // get positions of deformable vertices
+    unsigned int numVertices = (unsigned int)m_gelVertices.size();
+    m_indexPositions.resize(numVertices);
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        const cGELVertex& vertex = m_gelVertices[i];
+        if (m_useMassParticleModel && (vertex.m_massParticle != NULL))
+        {
+            m_indexPositions[i] = vertex.m_massParticle->m_pos;
+        }
+        else
+        {
+            m_indexPositions[i] = vertex.m_vertex->m_localPos;
         }
     }
+
+    if (a_rebuild ||
+        (m_tetrahedralIndex.getNumVertices() != numVertices) ||
+        (4 * m_tetrahedralIndex.getNumTetrahedra() != m_tetrahedra.size()))
+    {
+        vector<unsigned int> triangles;
+        getSurfaceTriangles(triangles);
+        m_tetrahedralIndex.build(m_indexPositions, m_tetrahedra, triangles);
+    }
+    else
+    {
+        m_tetrahedralIndex.refit(m_indexPositions);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Find the tetrahedron of the body containing a point, given in the
+    frame of the mesh (see cGELTetrahedralIndex::findTetrahedron()).
+
+    \fn       int cGELMesh::findTetrahedron(const cVector3d& a_point,
+                                          double* a_weights) const
+    \param    a_point  Point.
+    \param    a_weights  If not NULL, returns the barycentric coordinates
+              of the point with respect to the four vertices.
+    \return   Return the index of the tetrahedron in m_tetrahedra divided
+              by four, or -1 if the point is outside the body.
+*/
+//===========================================================================
+int cGELMesh::findTetrahedron(const cVector3d& a_point,
+                              double* a_weights) const
+{
+    return (m_tetrahedralIndex.findTetrahedron(a_point, a_weights));
+}
+
+
+//===========================================================================
+/*!
+    Find the closest point of the surface of the body to a point, given
+    in the frame of the mesh.
+
+    \fn       bool cGELMesh::findClosestSurfacePoint(const cVector3d& a_point,
+                                                   cVector3d& a_closestPoint,
+                                                   unsigned int& a_triangle) const
+    \param    a_point  Point.
+    \param    a_closestPoint  Returned closest point of the surface.
+    \param    a_triangle  Returned index of the surface triangle, in the
+              order of the allocated triangles of the mesh.
+    \return   Return \b false if the body has no surface triangles.
+*/
+//===========================================================================
+bool cGELMesh::findClosestSurfacePoint(const cVector3d& a_point,
+                                       cVector3d& a_closestPoint,
+                                       unsigned int& a_triangle) const
+{
+    return (m_tetrahedralIndex.findClosestSurfacePoint(a_point, a_closestPoint, a_triangle));
 }
 
 
+//===========================================================================
+/*!
+    Find the deformable vertices nearest to a point, given in the frame of
+    the mesh, within a maximum distance. Haptic forces between a tool and
+    the mass particles only need to be computed for these vertices.
+
+    \fn       unsigned int cGELMesh::findNearestParticles(const cVector3d& a_point,
+                                                        const unsigned int a_maxResults,
+                                                        const double a_maxDistance,
+                                                        unsigned int* a_vertices,
+                                                        double* a_distances) const
+    \param    a_point  Point.
+    \param    a_maxResults  Maximum number of vertices returned.
+    \param    a_maxDistance  Maximum distance of the vertices returned.
+    \param    a_vertices  Returned indices in m_gelVertices, by increasing distance.
+    \param    a_distances  Returned distance of each vertex.
+    \return   Return the number of vertices found.
+*/
+//===========================================================================
+unsigned int cGELMesh::findNearestParticles(const cVector3d& a_point,
+                                            const unsigned int a_maxResults,
+                                            const double a_maxDistance,
+                                            unsigned int* a_vertices,
+                                            double* a_distances) const
+{
+    return (m_tetrahedralIndex.findNearestVertices(a_point, a_maxResults, a_maxDistance,
+                                                   a_vertices, a_distances));
+}
+
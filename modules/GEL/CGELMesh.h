@@ -18,6 +18,9 @@
 #include "CGELSkeletonLink.h"
 #include "CGELLinearSpring.h"
 #include "CGELVertex.h"
+#include "CGELParticleSystem.h"
+#include "CGELSkin.h"
+#include "CGELTetrahedralIndex.h"
 #include "chai3d.h"
 #include <typeinfo>
 #include <vector>
@@ -43,7 +46,23 @@ using std::vector;
 
     \brief      
     cGELMesh inherits from cMesh and integrate a skeleton model for 
-    deformation simulation.
+    deformation simulation. \n
+
+    The vertices of the mesh are updated by a cGELSkin, which also
+    recomputes their normals and tracks which vertices must be copied to
+    the graphics card again. \n
+
+    The mass particles of the vertices and the linear springs are
+    simulated in a cGELParticleSystem. A spring only applies its force to
+    the vertices of the mesh which lists it: its other particle is held in
+    place by this mesh. A spring joining the vertices of two meshes must
+    therefore be listed by both meshes, so that each pulls on its own
+    vertex. \n
+
+    Bodies made of tetrahedra list them in m_tetrahedra. When
+    m_useTetrahedralIndex is set, a cGELTetrahedralIndex follows the
+    vertices as the body deforms, to locate the haptic tool in the body
+    without testing every element.
 */
 //===========================================================================
 class cGELMesh : public cMesh
@@ -69,12 +88,22 @@ class cGELMesh : public cMesh
     //! Build dynamic vertices for deformable mesh.
     void buildVertices();
 
-    //! Connect each vertex to skeleton.
-    void connectVerticesToSkeleton(bool a_connectToNodesOnly);
+    //! Connect each vertex to the nearest skeleton node or link, or to several of the nearest.
+    void connectVerticesToSkeleton(bool a_connectToNodesOnly,
+                                   unsigned int a_numInfluences = 1);
 
-    //! Update position of vertices connected to skeleton.
+    //! Update position and normal of vertices connected to skeleton or to mass particles.
     void updateVertexPosition();
 
+    //! Rebuild the particle system from the deformable vertices and linear springs.
+    void updateParticleSystem();
+
+    //! Copy the state of the mass particles into the particle system.
+    void readParticles();
+
+    //! Copy the state of the particle system back to the mass particles.
+    void writeParticles();
+
     //! Clear forces.
     void clearForces();
 
@@ -87,12 +116,41 @@ class cGELMesh : public cMesh
     //! Compute next pose.
     void computeNextPose(double iTimeInterval);
 
+    //! Compute next pose, integrating the mass particle model by implicit Euler.
+    void computeNextPoseImplicit(double a_timeInterval,
+                                 double a_tolerance,
+                                 unsigned int a_maxIterations);
+
     //! Apply new computed pose.
     void applyNextPose();
 
     //! Render deformable mesh.
     virtual void render(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL);
 
+    //! Return \b true if a render queue may reorder this mesh, which must not render its models.
+    virtual bool isRenderSortable() const;
+
+    //! Get the indices of the deformable vertices of each triangle of the mesh, three per triangle.
+    void getSurfaceTriangles(vector<unsigned int>& a_triangles) const;
+
+    //! Build or refit the tetrahedral index to the current positions of the vertices.
+    void updateTetrahedralIndex(bool a_rebuild = false);
+
+    //! Find the tetrahedron containing a point, and optionally the barycentric coordinates of the point.
+    int findTetrahedron(const cVector3d& a_point, double* a_weights = NULL) const;
+
+    //! Find the closest point of the surface of the body to a point.
+    bool findClosestSurfacePoint(const cVector3d& a_point,
+                                 cVector3d& a_closestPoint,
+                                 unsigned int& a_triangle) const;
+
+    //! Find the deformable vertices nearest to a point within a maximum distance, by increasing distance.
+    unsigned int findNearestParticles(const cVector3d& a_point,
+                                      const unsigned int a_maxResults,
+                                      const double a_maxDistance,
+                                      unsigned int* a_vertices,
+                                      double* a_distances) const;
+
 
 	//-----------------------------------------------------------------------
     // MEMBERS:
@@ -110,6 +168,18 @@ class cGELMesh : public cMesh
     //! List of deformable vertices.
     vector<cGELVertex> m_gelVertices;
 
+    //! Packed storage of the mass particles and linear springs.
+    cGELParticleSystem m_particleSystem;
+
+    //! Packed vertices, updated by updateVertexPosition().
+    cGELSkin m_skin;
+
+    //! Indices of the deformable vertices of each tetrahedron, four per tetrahedron.
+    vector<unsigned int> m_tetrahedra;
+
+    //! Index over the tetrahedra, surface triangles and deformable vertices.
+    cGELTetrahedralIndex m_tetrahedralIndex;
+
     //! If \b true then display skeleton.
     bool m_showSkeletonModel;
 
@@ -122,6 +192,18 @@ class cGELMesh : public cMesh
     //! Use vertex mass particle model.
     bool m_useMassParticleModel;
 
+    //! If \b true, the tetrahedral index is refitted after each simulation step.
+    bool m_useTetrahedralIndex;
+
+    //! If \b true, the nodes and particles of the mesh touch those of other meshes (see cGELContactModel).
+    bool m_useContacts;
+
+    //! If \b true, the nodes and particles of the mesh also touch each other.
+    bool m_useSelfContact;
+
+    //! Radius of the mass particles in contacts.
+    double m_contactRadius;
+
 
   private:
 
@@ -131,6 +213,17 @@ class cGELMesh : public cMesh
 
     //! Initialize deformable mesh.
     void initialise();
+
+    //! Mark the vertices of a mesh and its children modified by the skin, from a vertex offset.
+    void markSkinModified(cMesh* a_mesh, unsigned int& a_offset);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Positions of the deformable vertices given to the tetrahedral index.
+    vector<cVector3d> m_indexPositions;
 };
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,1191 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CGELParticleSystem.h"
+//---------------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CHAI_GEL_USE_SSE2
+#include <emmintrin.h>
+#endif
+//---------------------------------------------------------------------------
+//! Length below which a spring applies no force.
+#define CHAI_GEL_SPRING_MIN_LENGTH 0.000001
+
+//! Systems with fewer springs than this are always computed on the calling thread.
+#define CHAI_GEL_PARALLEL_MIN_SPRINGS 4096
+
+//! Number of tasks created for each thread when computing in parallel.
+#define CHAI_GEL_PARALLEL_TASKS_PER_THREAD 4
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cGELParticleSystem.
+
+    \fn       cGELParticleSystem::cGELParticleSystem()
+*/
+//===========================================================================
+cGELParticleSystem::cGELParticleSystem()
+{
+    m_numSolverIterations = 0;
+    m_solverResidual = 0.0;
+    m_threadPool = NULL;
+    m_taskFunction = NULL;
+    m_taskCount = 0;
+    m_numTasks = 0;
+    m_taskInput = NULL;
+    m_taskOutput = NULL;
+    m_taskScale = 0.0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELParticleSystem. Particles and springs are not deleted.
+
+    \fn       cGELParticleSystem::~cGELParticleSystem()
+*/
+//===========================================================================
+cGELParticleSystem::~cGELParticleSystem()
+{
+}
+
+
+//===========================================================================
+/*!
+    Remove all particles and springs.
+
+    \fn       void cGELParticleSystem::clear()
+*/
+//===========================================================================
+void cGELParticleSystem::clear()
+{
+    m_particles.clear();
+    m_owned.clear();
+    m_fixed.clear();
+    m_mass.clear();
+    m_damping.clear();
+    for (int k=0; k<3; k++)
+    {
+        m_pos[k].clear();
+        m_nextPos[k].clear();
+        m_vel[k].clear();
+        m_force[k].clear();
+        m_externalForce[k].clear();
+        m_gravityForce[k].clear();
+    }
+    m_springs.clear();
+    m_springIndex[0].clear();
+    m_springIndex[1].clear();
+    m_springStiffness.clear();
+    m_springLength0.clear();
+    for (int k=0; k<3; k++)
+    {
+        m_springForce[k].clear();
+        m_deltaVel[k].clear();
+        m_residual[k].clear();
+        m_direction[k].clear();
+        m_product[k].clear();
+        m_preconditioner[k].clear();
+    }
+    for (int k=0; k<6; k++)
+    {
+        m_springStiffnessMatrix[k].clear();
+    }
+    m_particleSpringOffsets.clear();
+    m_particleSprings.clear();
+}
+
+
+//===========================================================================
+/*!
+    Add a mass particle to the system. Its state is read by
+    readParticles().
+
+    \fn       unsigned int cGELParticleSystem::addParticle(cGELMassParticle* a_particle,
+                                                         bool a_owned)
+    \param    a_particle  Mass particle.
+    \param    a_owned  If \b false, the particle is held in place and its
+              position is not written back by writeParticles().
+    \return   Return the index of the particle.
+*/
+//===========================================================================
+unsigned int cGELParticleSystem::addParticle(cGELMassParticle* a_particle, bool a_owned)
+{
+    m_particles.push_back(a_particle);
+    m_owned.push_back(a_owned ? 1 : 0);
+    m_fixed.push_back(1);
+    m_mass.push_back(0.0);
+    m_damping.push_back(0.0);
+    for (int k=0; k<3; k++)
+    {
+        m_pos[k].push_back(0.0);
+        m_nextPos[k].push_back(0.0);
+        m_vel[k].push_back(0.0);
+        m_force[k].push_back(0.0);
+        m_externalForce[k].push_back(0.0);
+        m_gravityForce[k].push_back(0.0);
+    }
+
+    return ((unsigned int)m_particles.size() - 1);
+}
+
+
+//===========================================================================
+/*!
+    Add a linear spring between two particles of the system. Its spring
+    constant and initial length are read by readParticles().
+
+    \fn       void cGELParticleSystem::addSpring(cGELLinearSpring* a_spring,
+                                                 unsigned int a_index0,
+                                                 unsigned int a_index1)
+    \param    a_spring  Linear spring.
+    \param    a_index0  Index of node 0 of the spring.
+    \param    a_index1  Index of node 1 of the spring.
+*/
+//===========================================================================
+void cGELParticleSystem::addSpring(cGELLinearSpring* a_spring,
+                                   unsigned int a_index0,
+                                   unsigned int a_index1)
+{
+    m_springs.push_back(a_spring);
+    m_springIndex[0].push_back(a_index0);
+    m_springIndex[1].push_back(a_index1);
+    m_springStiffness.push_back(a_spring->m_kSpringElongation);
+    m_springLength0.push_back(a_spring->m_length0);
+    for (int k=0; k<3; k++)
+    {
+        m_springForce[k].push_back(0.0);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Copy the position, velocity, external force and physical properties of
+    each mass particle, and the spring constant and initial length of each
+    spring, into the system.
+
+    \fn       void cGELParticleSystem::readParticles()
+*/
+//===========================================================================
+void cGELParticleSystem::readParticles()
+{
+    unsigned int numSprings = (unsigned int)m_springs.size();
+    for (unsigned int i=0; i<numSprings; i++)
+    {
+        const cGELLinearSpring* spring = m_springs[i];
+        m_springStiffness[i] = spring->m_kSpringElongation;
+        m_springLength0[i] = spring->m_length0;
+    }
+
+    unsigned int numParticles = (unsigned int)m_particles.size();
+    if (numParticles == 0) { return; }
+
+    double* pos[3] = { &m_pos[0][0], &m_pos[1][0], &m_pos[2][0] };
+    double* vel[3] = { &m_vel[0][0], &m_vel[1][0], &m_vel[2][0] };
+    double* externalForce[3] = { &m_externalForce[0][0], &m_externalForce[1][0], &m_externalForce[2][0] };
+    double* gravityForce[3] = { &m_gravityForce[0][0], &m_gravityForce[1][0], &m_gravityForce[2][0] };
+
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        const cGELMassParticle* particle = m_particles[i];
+        const cVector3d& force = particle->getExternalForce();
+        double mass = particle->m_mass;
+
+        m_fixed[i] = (particle->m_fixed || !m_owned[i]) ? 1 : 0;
+        m_mass[i] = mass;
+        m_damping[i] = -particle->m_kDampingPos * mass;
+        for (int k=0; k<3; k++)
+        {
+            pos[k][i] = particle->m_pos[k];
+            vel[k][i] = particle->m_vel[k];
+            externalForce[k][i] = force[k];
+            gravityForce[k][i] = particle->m_useGravity ? particle->m_gravity[k] * mass : 0.0;
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Copy the position, next position and velocity of each owned particle
+    back to its mass particle.
+
+    \fn       void cGELParticleSystem::writeParticles()
+*/
+//===========================================================================
+void cGELParticleSystem::writeParticles()
+{
+    unsigned int numParticles = (unsigned int)m_particles.size();
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        if (!m_owned[i]) { continue; }
+
+        cGELMassParticle* particle = m_particles[i];
+        for (int k=0; k<3; k++)
+        {
+            particle->m_pos[k] = m_pos[k][i];
+            particle->m_nextPos[k] = m_nextPos[k][i];
+            particle->m_vel[k] = m_vel[k][i];
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Clear forces. Particles subject to gravity start with their weight.
+
+    \fn       void cGELParticleSystem::clearForces()
+*/
+//===========================================================================
+void cGELParticleSystem::clearForces()
+{
+    for (int k=0; k<3; k++)
+    {
+        m_force[k] = m_gravityForce[k];
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the force of each spring and add it to its two particles. \n
+
+    Spring forces are first computed into an array, two springs at a time
+    when SSE2 is available, and then added to the particles in the order
+    of the springs, so that results do not depend on the code path. On
+    large systems, both stages are split between the threads of the pool.
+
+    \fn       void cGELParticleSystem::computeForces()
+*/
+//===========================================================================
+void cGELParticleSystem::computeForces()
+{
+    unsigned int numSprings = (unsigned int)m_springLength0.size();
+    if (numSprings == 0) { return; }
+
+    if (useThreadPool())
+    {
+        run(&cGELParticleSystem::computeSpringForces, numSprings);
+
+        m_taskOutput = m_force;
+        run(&cGELParticleSystem::gatherSpringForces, (unsigned int)m_particles.size());
+    }
+    else
+    {
+        computeSpringForces(0, numSprings);
+        addSpringForces(m_force);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the force applied by each spring of a range on its node 0.
+
+    \fn       void cGELParticleSystem::computeSpringForces(unsigned int a_first,
+                                                           unsigned int a_last)
+    \param    a_first  Index of the first spring.
+    \param    a_last  Index following the last spring.
+*/
+//===========================================================================
+void cGELParticleSystem::computeSpringForces(unsigned int a_first,
+                                             unsigned int a_last)
+{
+    const unsigned int* index0 = &m_springIndex[0][0];
+    const unsigned int* index1 = &m_springIndex[1][0];
+    const double* stiffness = &m_springStiffness[0];
+    const double* length0 = &m_springLength0[0];
+    const double* posX = &m_pos[0][0];
+    const double* posY = &m_pos[1][0];
+    const double* posZ = &m_pos[2][0];
+    double* springForceX = &m_springForce[0][0];
+    double* springForceY = &m_springForce[1][0];
+    double* springForceZ = &m_springForce[2][0];
+
+    unsigned int i = a_first;
+
+#if defined(CHAI_GEL_USE_SSE2)
+    const __m128d minLength = _mm_set1_pd(CHAI_GEL_SPRING_MIN_LENGTH);
+    for (; i+1<a_last; i+=2)
+    {
+        unsigned int a0 = index0[i];
+        unsigned int a1 = index0[i+1];
+        unsigned int b0 = index1[i];
+        unsigned int b1 = index1[i+1];
+
+        // link from node 0 to node 1
+        __m128d dx = _mm_sub_pd(_mm_set_pd(posX[b1], posX[b0]), _mm_set_pd(posX[a1], posX[a0]));
+        __m128d dy = _mm_sub_pd(_mm_set_pd(posY[b1], posY[b0]), _mm_set_pd(posY[a1], posY[a0]));
+        __m128d dz = _mm_sub_pd(_mm_set_pd(posZ[b1], posZ[b0]), _mm_set_pd(posZ[a1], posZ[a0]));
+        __m128d length = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+                                                           _mm_mul_pd(dy, dy)),
+                                                _mm_mul_pd(dz, dz)));
+
+        // elongation force divided by length, zero if distance too small
+        __m128d f = _mm_mul_pd(_mm_loadu_pd(&stiffness[i]),
+                               _mm_sub_pd(length, _mm_loadu_pd(&length0[i])));
+        __m128d scale = _mm_and_pd(_mm_cmpgt_pd(length, minLength), _mm_div_pd(f, length));
+
+        _mm_storeu_pd(&springForceX[i], _mm_mul_pd(scale, dx));
+        _mm_storeu_pd(&springForceY[i], _mm_mul_pd(scale, dy));
+        _mm_storeu_pd(&springForceZ[i], _mm_mul_pd(scale, dz));
+    }
+#endif
+
+    for (; i<a_last; i++)
+    {
+        unsigned int a = index0[i];
+        unsigned int b = index1[i];
+
+        // link from node 0 to node 1
+        double dx = posX[b] - posX[a];
+        double dy = posY[b] - posY[a];
+        double dz = posZ[b] - posZ[a];
+        double length = sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+        // if distance too small, no forces are applied
+        double scale = 0.0;
+        if (length > CHAI_GEL_SPRING_MIN_LENGTH)
+        {
+            scale = (stiffness[i] * (length - length0[i])) / length;
+        }
+
+        springForceX[i] = scale * dx;
+        springForceY[i] = scale * dy;
+        springForceZ[i] = scale * dz;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute next position of each particle by Euler integration.
+
+    \fn       void cGELParticleSystem::computeNextPose(double a_timeInterval)
+    \param    a_timeInterval  Time step.
+*/
+//===========================================================================
+void cGELParticleSystem::computeNextPose(double a_timeInterval)
+{
+    unsigned int numParticles = (unsigned int)m_particles.size();
+    if (numParticles == 0) { return; }
+
+    for (int k=0; k<3; k++)
+    {
+        double* pos = &m_pos[k][0];
+        double* nextPos = &m_nextPos[k][0];
+        double* vel = &m_vel[k][0];
+        double* force = &m_force[k][0];
+        const double* externalForce = &m_externalForce[k][0];
+
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            if (!m_fixed[i])
+            {
+                // Euler double integration for position
+                force[i] += vel[i] * m_damping[i];
+                double acc = (force[i] + externalForce[i]) / m_mass[i];
+                vel[i] = vel[i] + a_timeInterval * acc;
+                nextPos[i] = pos[i] + a_timeInterval * vel[i];
+            }
+            else
+            {
+                nextPos[i] = pos[i];
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute next position of each particle by implicit (backward) Euler
+    integration. The velocity change \e dv of each particle solves
+
+    (M - h D - h^2 K) dv = h (f + h K v)
+
+    where \e h is the time step, \e M the masses, \e D the damping
+    matrix, \e K the stiffness matrix of the springs and \e f the forces
+    computed by computeForces(). The system is symmetric positive definite
+    and is solved by a conjugate gradient preconditioned by its diagonal,
+    starting from the velocity change of the previous step. Fixed
+    particles do not move. Large time steps remain stable with stiff
+    springs.
+
+    \fn       void cGELParticleSystem::computeNextPoseImplicit(double a_timeInterval,
+                                                              double a_tolerance,
+                                                              unsigned int a_maxIterations)
+    \param    a_timeInterval  Time step.
+    \param    a_tolerance  Residual at which the solver stops, relative to
+              the right hand side.
+    \param    a_maxIterations  Maximum number of solver iterations.
+*/
+//===========================================================================
+void cGELParticleSystem::computeNextPoseImplicit(double a_timeInterval,
+                                                 double a_tolerance,
+                                                 unsigned int a_maxIterations)
+{
+    m_numSolverIterations = 0;
+    m_solverResidual = 0.0;
+
+    unsigned int numParticles = (unsigned int)m_particles.size();
+    if (numParticles == 0) { return; }
+
+    // allocate solver data
+    if (m_deltaVel[0].size() != numParticles)
+    {
+        for (int k=0; k<3; k++)
+        {
+            m_deltaVel[k].assign(numParticles, 0.0);
+            m_residual[k].assign(numParticles, 0.0);
+            m_direction[k].assign(numParticles, 0.0);
+            m_product[k].assign(numParticles, 0.0);
+            m_preconditioner[k].assign(numParticles, 0.0);
+        }
+    }
+
+    double h = a_timeInterval;
+    computeJacobian(h);
+
+    double* x[3] = { &m_deltaVel[0][0], &m_deltaVel[1][0], &m_deltaVel[2][0] };
+    double* r[3] = { &m_residual[0][0], &m_residual[1][0], &m_residual[2][0] };
+    double* p[3] = { &m_direction[0][0], &m_direction[1][0], &m_direction[2][0] };
+    double* q[3] = { &m_product[0][0], &m_product[1][0], &m_product[2][0] };
+    const double* d[3] = { &m_preconditioner[0][0], &m_preconditioner[1][0], &m_preconditioner[2][0] };
+
+    //-----------------------------------------------------------------------
+    // RIGHT HAND SIDE:
+    //-----------------------------------------------------------------------
+    // product of the stiffness matrix by the velocities, in the search
+    // direction; fixed particles do not move
+    for (int k=0; k<3; k++)
+    {
+        const double* vel = &m_vel[k][0];
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            if (m_fixed[i])
+            {
+                x[k][i] = 0.0;
+                q[k][i] = 0.0;
+            }
+            else
+            {
+                q[k][i] = vel[i];
+            }
+            p[k][i] = 0.0;
+        }
+    }
+
+    multiplyStiffness(m_product, m_direction, -1.0);
+
+    // initial residual, from the velocity change of the previous step
+    multiply(m_deltaVel, m_product, h);
+
+    double normRhs = 0.0;
+    double normResidual = 0.0;
+    double rz = 0.0;
+    for (int k=0; k<3; k++)
+    {
+        const double* vel = &m_vel[k][0];
+        const double* force = &m_force[k][0];
+        const double* externalForce = &m_externalForce[k][0];
+
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            double rhs = 0.0;
+            if (!m_fixed[i])
+            {
+                double f = force[i] + externalForce[i] + m_damping[i] * vel[i];
+                rhs = h * (f + h * p[k][i]);
+            }
+            normRhs += rhs * rhs;
+
+            double ri = rhs - q[k][i];
+            r[k][i] = ri;
+            p[k][i] = d[k][i] * ri;
+            normResidual += ri * ri;
+            rz += ri * p[k][i];
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    // CONJUGATE GRADIENT:
+    //-----------------------------------------------------------------------
+    double tolerance = a_tolerance * a_tolerance * normRhs;
+    while ((normResidual > tolerance) && (m_numSolverIterations < a_maxIterations))
+    {
+        multiply(m_direction, m_product, h);
+
+        double pq = 0.0;
+        for (int k=0; k<3; k++)
+        {
+            for (unsigned int i=0; i<numParticles; i++)
+            {
+                pq += p[k][i] * q[k][i];
+            }
+        }
+        if (pq <= 0.0) { break; }
+
+        // update solution and residual
+        double alpha = rz / pq;
+        double rzNext = 0.0;
+        normResidual = 0.0;
+        for (int k=0; k<3; k++)
+        {
+            for (unsigned int i=0; i<numParticles; i++)
+            {
+                x[k][i] += alpha * p[k][i];
+                double ri = r[k][i] - alpha * q[k][i];
+                r[k][i] = ri;
+                normResidual += ri * ri;
+                rzNext += ri * d[k][i] * ri;
+            }
+        }
+
+        // update search direction
+        double beta = rzNext / rz;
+        rz = rzNext;
+        for (int k=0; k<3; k++)
+        {
+            for (unsigned int i=0; i<numParticles; i++)
+            {
+                p[k][i] = d[k][i] * r[k][i] + beta * p[k][i];
+            }
+        }
+
+        m_numSolverIterations++;
+    }
+
+    if (normRhs > 0.0)
+    {
+        m_solverResidual = sqrt(normResidual / normRhs);
+    }
+
+    //-----------------------------------------------------------------------
+    // INTEGRATION:
+    //-----------------------------------------------------------------------
+    for (int k=0; k<3; k++)
+    {
+        double* pos = &m_pos[k][0];
+        double* nextPos = &m_nextPos[k][0];
+        double* vel = &m_vel[k][0];
+
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            if (!m_fixed[i])
+            {
+                vel[i] = vel[i] + x[k][i];
+                nextPos[i] = pos[i] + h * vel[i];
+            }
+            else
+            {
+                nextPos[i] = pos[i];
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the stiffness matrix of each spring from the current positions,
+    and the inverse of the diagonal of the matrix of the implicit step.
+    The stiffness across the spring is clamped at zero for compressed
+    springs, so that the matrix remains positive definite.
+
+    \fn       void cGELParticleSystem::computeJacobian(double a_timeInterval)
+    \param    a_timeInterval  Time step.
+*/
+//===========================================================================
+void cGELParticleSystem::computeJacobian(double a_timeInterval)
+{
+    unsigned int numParticles = (unsigned int)m_particles.size();
+    unsigned int numSprings = (unsigned int)m_springLength0.size();
+    double h2 = a_timeInterval * a_timeInterval;
+
+    double* diagonal[3] = { &m_preconditioner[0][0], &m_preconditioner[1][0], &m_preconditioner[2][0] };
+
+    // diagonal of the mass and damping terms
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        double d = m_mass[i] - a_timeInterval * m_damping[i];
+        diagonal[0][i] = d;
+        diagonal[1][i] = d;
+        diagonal[2][i] = d;
+    }
+
+    // stiffness matrix of each spring, added to the diagonal of its two
+    // particles in the order of the springs
+    if (numSprings > 0)
+    {
+        if (m_springStiffnessMatrix[0].size() != numSprings)
+        {
+            for (int k=0; k<6; k++)
+            {
+                m_springStiffnessMatrix[k].assign(numSprings, 0.0);
+            }
+        }
+
+        if (useThreadPool())
+        {
+            run(&cGELParticleSystem::computeSpringMatrices, numSprings);
+
+            m_taskOutput = m_preconditioner;
+            m_taskScale = h2;
+            run(&cGELParticleSystem::gatherSpringDiagonals, numParticles);
+        }
+        else
+        {
+            computeSpringMatrices(0, numSprings);
+
+            const unsigned int* index0 = &m_springIndex[0][0];
+            const unsigned int* index1 = &m_springIndex[1][0];
+            const double* xx = &m_springStiffnessMatrix[0][0];
+            const double* yy = &m_springStiffnessMatrix[3][0];
+            const double* zz = &m_springStiffnessMatrix[5][0];
+
+            for (unsigned int j=0; j<numSprings; j++)
+            {
+                unsigned int a = index0[j];
+                unsigned int b = index1[j];
+                diagonal[0][a] += h2 * xx[j];
+                diagonal[1][a] += h2 * yy[j];
+                diagonal[2][a] += h2 * zz[j];
+                diagonal[0][b] += h2 * xx[j];
+                diagonal[1][b] += h2 * yy[j];
+                diagonal[2][b] += h2 * zz[j];
+            }
+        }
+    }
+
+    // invert diagonal; fixed particles are excluded from the system
+    for (int k=0; k<3; k++)
+    {
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            double d = diagonal[k][i];
+            diagonal[k][i] = (!m_fixed[i] && (d > 0.0)) ? (1.0 / d) : 0.0;
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the stiffness matrix of each spring of a range from the current
+    positions. The stiffness across the spring is clamped at zero for
+    compressed springs.
+
+    \fn       void cGELParticleSystem::computeSpringMatrices(unsigned int a_first,
+                                                             unsigned int a_last)
+    \param    a_first  Index of the first spring.
+    \param    a_last  Index following the last spring.
+*/
+//===========================================================================
+void cGELParticleSystem::computeSpringMatrices(unsigned int a_first,
+                                               unsigned int a_last)
+{
+    const unsigned int* index0 = &m_springIndex[0][0];
+    const unsigned int* index1 = &m_springIndex[1][0];
+    const double* posX = &m_pos[0][0];
+    const double* posY = &m_pos[1][0];
+    const double* posZ = &m_pos[2][0];
+    double* xx = &m_springStiffnessMatrix[0][0];
+    double* xy = &m_springStiffnessMatrix[1][0];
+    double* xz = &m_springStiffnessMatrix[2][0];
+    double* yy = &m_springStiffnessMatrix[3][0];
+    double* yz = &m_springStiffnessMatrix[4][0];
+    double* zz = &m_springStiffnessMatrix[5][0];
+
+    for (unsigned int j=a_first; j<a_last; j++)
+    {
+        unsigned int a = index0[j];
+        unsigned int b = index1[j];
+        double dx = posX[b] - posX[a];
+        double dy = posY[b] - posY[a];
+        double dz = posZ[b] - posZ[a];
+        double length = sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+        // if distance too small, the spring has no stiffness
+        double axial = 0.0;
+        double transverse = 0.0;
+        if (length > CHAI_GEL_SPRING_MIN_LENGTH)
+        {
+            double k = m_springStiffness[j];
+            double invLength = 1.0 / length;
+            transverse = cMax(0.0, k * (1.0 - m_springLength0[j] * invLength));
+            axial = (k - transverse) * invLength * invLength;
+        }
+
+        xx[j] = axial * dx * dx + transverse;
+        xy[j] = axial * dx * dy;
+        xz[j] = axial * dx * dz;
+        yy[j] = axial * dy * dy + transverse;
+        yz[j] = axial * dy * dz;
+        zz[j] = axial * dz * dz + transverse;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Multiply a vector of velocity changes by the matrix of the implicit
+    step. Entries of fixed particles are set to zero.
+
+    \fn       void cGELParticleSystem::multiply(vector<double>* a_x,
+                                                vector<double>* a_y,
+                                                double a_timeInterval)
+    \param    a_x  Coordinates of the vector to multiply.
+    \param    a_y  Coordinates of the result.
+    \param    a_timeInterval  Time step.
+*/
+//===========================================================================
+void cGELParticleSystem::multiply(vector<double>* a_x,
+                                  vector<double>* a_y,
+                                  double a_timeInterval)
+{
+    unsigned int numParticles = (unsigned int)m_particles.size();
+
+    const double* x[3] = { &a_x[0][0], &a_x[1][0], &a_x[2][0] };
+    double* y[3] = { &a_y[0][0], &a_y[1][0], &a_y[2][0] };
+
+    // mass and damping terms
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        double diagonal = m_mass[i] - a_timeInterval * m_damping[i];
+        y[0][i] = diagonal * x[0][i];
+        y[1][i] = diagonal * x[1][i];
+        y[2][i] = diagonal * x[2][i];
+    }
+
+    // stiffness terms
+    multiplyStiffness(a_x, a_y, a_timeInterval * a_timeInterval);
+
+    // fixed particles are excluded from the system
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        if (m_fixed[i])
+        {
+            y[0][i] = 0.0;
+            y[1][i] = 0.0;
+            y[2][i] = 0.0;
+        }
+    }
+}
+
+//===========================================================================
+/*!
+    Add the product of the stiffness matrix of each spring by the
+    difference of a vector between its node 0 and its node 1, scaled, to
+    node 0 of the spring, and subtract it from node 1, in the order of the
+    springs. On large systems, the products are computed, and then added
+    to the particles, by the threads of the pool.
+
+    \fn       void cGELParticleSystem::multiplyStiffness(vector<double>* a_x,
+                                                         vector<double>* a_y,
+                                                         double a_scale)
+    \param    a_x  Coordinates of the vector to multiply.
+    \param    a_y  Coordinates of the result, to which the product is added.
+    \param    a_scale  Scale factor of the product.
+*/
+//===========================================================================
+void cGELParticleSystem::multiplyStiffness(vector<double>* a_x,
+                                           vector<double>* a_y,
+                                           double a_scale)
+{
+    unsigned int numSprings = (unsigned int)m_springLength0.size();
+    if (numSprings == 0) { return; }
+
+    if (useThreadPool())
+    {
+        m_taskInput = a_x;
+        m_taskScale = a_scale;
+        run(&cGELParticleSystem::computeSpringProducts, numSprings);
+
+        m_taskOutput = a_y;
+        run(&cGELParticleSystem::gatherSpringForces, (unsigned int)m_particles.size());
+        return;
+    }
+
+    const double* x[3] = { &a_x[0][0], &a_x[1][0], &a_x[2][0] };
+    double* y[3] = { &a_y[0][0], &a_y[1][0], &a_y[2][0] };
+    const unsigned int* index0 = &m_springIndex[0][0];
+    const unsigned int* index1 = &m_springIndex[1][0];
+    const double* xx = &m_springStiffnessMatrix[0][0];
+    const double* xy = &m_springStiffnessMatrix[1][0];
+    const double* xz = &m_springStiffnessMatrix[2][0];
+    const double* yy = &m_springStiffnessMatrix[3][0];
+    const double* yz = &m_springStiffnessMatrix[4][0];
+    const double* zz = &m_springStiffnessMatrix[5][0];
+
+    // products of consecutive springs sharing node 0 are summed without
+    // storing the result of that node in between
+    unsigned int j = 0;
+    while (j < numSprings)
+    {
+        unsigned int a = index0[j];
+        double ax = x[0][a];
+        double ay = x[1][a];
+        double az = x[2][a];
+        double sumX = y[0][a];
+        double sumY = y[1][a];
+        double sumZ = y[2][a];
+
+        for (; (j<numSprings) && (index0[j] == a); j++)
+        {
+            unsigned int b = index1[j];
+            double dx = ax - x[0][b];
+            double dy = ay - x[1][b];
+            double dz = az - x[2][b];
+            double fx = a_scale * (xx[j] * dx + xy[j] * dy + xz[j] * dz);
+            double fy = a_scale * (xy[j] * dx + yy[j] * dy + yz[j] * dz);
+            double fz = a_scale * (xz[j] * dx + yz[j] * dy + zz[j] * dz);
+            sumX += fx;
+            sumY += fy;
+            sumZ += fz;
+            y[0][b] -= fx;
+            y[1][b] -= fy;
+            y[2][b] -= fz;
+        }
+
+        y[0][a] = sumX;
+        y[1][a] = sumY;
+        y[2][a] = sumZ;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add the force computed for each spring to its node 0 and subtract it
+    from its node 1, in the order of the springs. The forces of
+    consecutive springs sharing the same node 0 are summed without storing
+    the force of that node in between.
+
+    \fn       void cGELParticleSystem::addSpringForces(vector<double>* a_force)
+    \param    a_force  Coordinates of the forces of the particles.
+*/
+//===========================================================================
+void cGELParticleSystem::addSpringForces(vector<double>* a_force)
+{
+    unsigned int numSprings = (unsigned int)m_springLength0.size();
+    if (numSprings == 0) { return; }
+
+    const unsigned int* index0 = &m_springIndex[0][0];
+    const unsigned int* index1 = &m_springIndex[1][0];
+    const double* springForceX = &m_springForce[0][0];
+    const double* springForceY = &m_springForce[1][0];
+    const double* springForceZ = &m_springForce[2][0];
+    double* forceX = &a_force[0][0];
+    double* forceY = &a_force[1][0];
+    double* forceZ = &a_force[2][0];
+
+    unsigned int i = 0;
+    while (i < numSprings)
+    {
+        unsigned int a = index0[i];
+        double fx = forceX[a];
+        double fy = forceY[a];
+        double fz = forceZ[a];
+
+        for (; (i<numSprings) && (index0[i] == a); i++)
+        {
+            unsigned int b = index1[i];
+            fx += springForceX[i];
+            fy += springForceY[i];
+            fz += springForceZ[i];
+            forceX[b] -= springForceX[i];
+            forceY[b] -= springForceY[i];
+            forceZ[b] -= springForceZ[i];
+        }
+
+        forceX[a] = fx;
+        forceY[a] = fy;
+        forceZ[a] = fz;
+    }
+}
+
+
+
+//===========================================================================
+/*!
+    Update positions with new computed values.
+
+    \fn       void cGELParticleSystem::applyNextPose()
+*/
+//===========================================================================
+void cGELParticleSystem::applyNextPose()
+{
+    for (int k=0; k<3; k++)
+    {
+        m_pos[k] = m_nextPos[k];
+    }
+}
+
+
+//===========================================================================
+/*!
+    Return \b true if the system is large enough to split the computations
+    over its springs between the threads of the pool, in which case the
+    list of springs of each particle is also brought up to date.
+
+    \fn       bool cGELParticleSystem::useThreadPool()
+    \return   Return \b true if the thread pool is used.
+*/
+//===========================================================================
+bool cGELParticleSystem::useThreadPool()
+{
+    if ((m_threadPool == NULL) ||
+        (m_threadPool->getNumThreads() == 0) ||
+        (m_springLength0.size() < CHAI_GEL_PARALLEL_MIN_SPRINGS))
+    {
+        return (false);
+    }
+
+    // rebuild lists if particles or springs have been added
+    if ((m_particleSpringOffsets.size() != m_particles.size() + 1) ||
+        (m_particleSprings.size() != 2 * m_springLength0.size()))
+    {
+        updateParticleSprings();
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Build the list of springs of each particle. Springs are listed in
+    increasing order, so that the forces of a particle are added by
+    gatherSpringForces() in the same order as by addSpringForces().
+
+    \fn       void cGELParticleSystem::updateParticleSprings()
+*/
+//===========================================================================
+void cGELParticleSystem::updateParticleSprings()
+{
+    unsigned int numParticles = (unsigned int)m_particles.size();
+    unsigned int numSprings = (unsigned int)m_springLength0.size();
+
+    // count springs of each particle
+    m_particleSpringOffsets.assign(numParticles + 1, 0);
+    for (unsigned int j=0; j<numSprings; j++)
+    {
+        m_particleSpringOffsets[m_springIndex[0][j] + 1]++;
+        m_particleSpringOffsets[m_springIndex[1][j] + 1]++;
+    }
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        m_particleSpringOffsets[i + 1] += m_particleSpringOffsets[i];
+    }
+
+    // list springs in order
+    vector<unsigned int> next(m_particleSpringOffsets.begin(), m_particleSpringOffsets.end() - 1);
+    m_particleSprings.resize(2 * numSprings);
+    for (unsigned int j=0; j<numSprings; j++)
+    {
+        m_particleSprings[next[m_springIndex[0][j]]++] = 2 * j;
+        m_particleSprings[next[m_springIndex[1][j]]++] = 2 * j + 1;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Split a range of springs or particles into tasks, and execute a
+    function over the range of each task on the thread pool. Returns when
+    all tasks have completed.
+
+    \fn       void cGELParticleSystem::run(void (cGELParticleSystem::*a_function)(unsigned int, unsigned int),
+                                           unsigned int a_count)
+    \param    a_function  Function computing a range of springs or particles.
+    \param    a_count  Number of springs or particles.
+*/
+//===========================================================================
+void cGELParticleSystem::run(void (cGELParticleSystem::*a_function)(unsigned int, unsigned int),
+                             unsigned int a_count)
+{
+    if (a_count == 0) { return; }
+
+    m_taskFunction = a_function;
+    m_taskCount = a_count;
+    m_numTasks = cMin((m_threadPool->getNumThreads() + 1) * CHAI_GEL_PARALLEL_TASKS_PER_THREAD,
+                      a_count);
+
+    m_threadPool->run(runTask, this, m_numTasks);
+}
+
+
+//===========================================================================
+/*!
+    Execute the function given to run() over the range of a task. Called
+    by the threads of the pool.
+
+    \fn       void cGELParticleSystem::runTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELParticleSystem.
+    \param    a_task  Index of the task.
+*/
+//===========================================================================
+void cGELParticleSystem::runTask(void* a_data, unsigned int a_task)
+{
+    cGELParticleSystem* system = (cGELParticleSystem*)a_data;
+
+    // the first tasks take one more element when the count does not divide evenly
+    unsigned int size = system->m_taskCount / system->m_numTasks;
+    unsigned int remainder = system->m_taskCount % system->m_numTasks;
+    unsigned int first = a_task * size + cMin(a_task, remainder);
+    unsigned int last = first + size + ((a_task < remainder) ? 1 : 0);
+
+    (system->*(system->m_taskFunction))(first, last);
+}
+
+
+//===========================================================================
+/*!
+    Compute the product of the stiffness matrix of each spring of a range
+    by the difference of the input vector of run() between its node 0 and
+    its node 1, scaled by the scale factor of run(). Products are stored
+    in place of the spring forces.
+
+    \fn       void cGELParticleSystem::computeSpringProducts(unsigned int a_first,
+                                                             unsigned int a_last)
+    \param    a_first  Index of the first spring.
+    \param    a_last  Index following the last spring.
+*/
+//===========================================================================
+void cGELParticleSystem::computeSpringProducts(unsigned int a_first,
+                                               unsigned int a_last)
+{
+    const double* x[3] = { &m_taskInput[0][0], &m_taskInput[1][0], &m_taskInput[2][0] };
+    const unsigned int* index0 = &m_springIndex[0][0];
+    const unsigned int* index1 = &m_springIndex[1][0];
+    const double* xx = &m_springStiffnessMatrix[0][0];
+    const double* xy = &m_springStiffnessMatrix[1][0];
+    const double* xz = &m_springStiffnessMatrix[2][0];
+    const double* yy = &m_springStiffnessMatrix[3][0];
+    const double* yz = &m_springStiffnessMatrix[4][0];
+    const double* zz = &m_springStiffnessMatrix[5][0];
+    double* productX = &m_springForce[0][0];
+    double* productY = &m_springForce[1][0];
+    double* productZ = &m_springForce[2][0];
+    double scale = m_taskScale;
+
+    for (unsigned int j=a_first; j<a_last; j++)
+    {
+        unsigned int a = index0[j];
+        unsigned int b = index1[j];
+        double dx = x[0][a] - x[0][b];
+        double dy = x[1][a] - x[1][b];
+        double dz = x[2][a] - x[2][b];
+        productX[j] = scale * (xx[j] * dx + xy[j] * dy + xz[j] * dz);
+        productY[j] = scale * (xy[j] * dx + yy[j] * dy + yz[j] * dz);
+        productZ[j] = scale * (xz[j] * dx + yz[j] * dy + zz[j] * dz);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add the force of each spring of the particles of a range to the
+    output vector of run(), for the particles which are node 0 of the
+    spring, or subtract it, for the particles which are node 1. Springs
+    are read in order, so that each particle sums the same values in the
+    same order as addSpringForces().
+
+    \fn       void cGELParticleSystem::gatherSpringForces(unsigned int a_first,
+                                                          unsigned int a_last)
+    \param    a_first  Index of the first particle.
+    \param    a_last  Index following the last particle.
+*/
+//===========================================================================
+void cGELParticleSystem::gatherSpringForces(unsigned int a_first,
+                                            unsigned int a_last)
+{
+    const unsigned int* offsets = &m_particleSpringOffsets[0];
+    const unsigned int* springs = &m_particleSprings[0];
+    const double* springForceX = &m_springForce[0][0];
+    const double* springForceY = &m_springForce[1][0];
+    const double* springForceZ = &m_springForce[2][0];
+    double* forceX = &m_taskOutput[0][0];
+    double* forceY = &m_taskOutput[1][0];
+    double* forceZ = &m_taskOutput[2][0];
+
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        double fx = forceX[i];
+        double fy = forceY[i];
+        double fz = forceZ[i];
+
+        for (unsigned int e=offsets[i]; e<offsets[i+1]; e++)
+        {
+            unsigned int j = springs[e] >> 1;
+            if (springs[e] & 1)
+            {
+                fx -= springForceX[j];
+                fy -= springForceY[j];
+                fz -= springForceZ[j];
+            }
+            else
+            {
+                fx += springForceX[j];
+                fy += springForceY[j];
+                fz += springForceZ[j];
+            }
+        }
+
+        forceX[i] = fx;
+        forceY[i] = fy;
+        forceZ[i] = fz;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add the diagonal of the stiffness matrix of each spring of the
+    particles of a range, scaled by the scale factor of run(), to the
+    output vector of run(). Springs are read in order.
+
+    \fn       void cGELParticleSystem::gatherSpringDiagonals(unsigned int a_first,
+                                                             unsigned int a_last)
+    \param    a_first  Index of the first particle.
+    \param    a_last  Index following the last particle.
+*/
+//===========================================================================
+void cGELParticleSystem::gatherSpringDiagonals(unsigned int a_first,
+                                               unsigned int a_last)
+{
+    const unsigned int* offsets = &m_particleSpringOffsets[0];
+    const unsigned int* springs = &m_particleSprings[0];
+    const double* xx = &m_springStiffnessMatrix[0][0];
+    const double* yy = &m_springStiffnessMatrix[3][0];
+    const double* zz = &m_springStiffnessMatrix[5][0];
+    double* diagonalX = &m_taskOutput[0][0];
+    double* diagonalY = &m_taskOutput[1][0];
+    double* diagonalZ = &m_taskOutput[2][0];
+    double scale = m_taskScale;
+
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        for (unsigned int e=offsets[i]; e<offsets[i+1]; e++)
+        {
+            unsigned int j = springs[e] >> 1;
+            diagonalX[i] += scale * xx[j];
+            diagonalY[i] += scale * yy[j];
+            diagonalZ[i] += scale * zz[j];
+        }
+    }
+}
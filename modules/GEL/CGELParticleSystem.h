@@ -0,0 +1,317 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CGELParticleSystemH
+#define CGELParticleSystemH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include "CGELMassParticle.h"
+#include "CGELLinearSpring.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CGELParticleSystem.h
+
+    \brief
+    <b> GEL Module </b> \n
+    Packed Mass Particle and Linear Spring Storage.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cGELParticleSystem
+    \ingroup    GEL
+
+    \brief
+    cGELParticleSystem stores the state of a set of mass particles and
+    linear springs in contiguous arrays, one array per coordinate, with
+    springs referring to their particles by index. \n
+
+    The cGELMassParticle and cGELLinearSpring objects remain the interface
+    to the model: readParticles() copies the state of the particles into
+    the arrays before a simulation step, and writeParticles() copies the
+    new positions and velocities back afterwards. Particles added with
+    \e a_owned set to \b false are held in place and never written to.
+    readParticles() also reads the spring constant and initial length of
+    each spring, so that they may be modified between steps. \n
+
+    Positions are integrated either by explicit Euler, with
+    computeNextPose(), or by implicit Euler, with computeNextPoseImplicit(),
+    which remains stable for stiff springs and large time steps. \n
+
+    On large systems, the computations over the springs are split between
+    the threads of a cThreadPool. Each thread computes the force of a range
+    of springs, and then adds the forces of a range of particles, reading
+    the springs of each particle in the order of the springs. Every force
+    is thus summed in the same order as on a single thread, and results do
+    not depend on the number of threads.
+*/
+//===========================================================================
+class cGELParticleSystem
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELParticleSystem.
+    cGELParticleSystem();
+
+    //! Destructor of cGELParticleSystem.
+    ~cGELParticleSystem();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Remove all particles and springs.
+    void clear();
+
+    //! Add a mass particle and return its index.
+    unsigned int addParticle(cGELMassParticle* a_particle, bool a_owned = true);
+
+    //! Add a linear spring between two particles given by index.
+    void addSpring(cGELLinearSpring* a_spring,
+                   unsigned int a_index0,
+                   unsigned int a_index1);
+
+    //! Get the number of particles.
+    unsigned int getNumParticles() const { return ((unsigned int)m_particles.size()); }
+
+    //! Get the number of springs.
+    unsigned int getNumSprings() const { return ((unsigned int)m_springLength0.size()); }
+
+    //! Get the position of a particle.
+    cVector3d getPosition(const unsigned int a_index) const
+        { return (cVector3d(m_pos[0][a_index], m_pos[1][a_index], m_pos[2][a_index])); }
+
+    //! Get the velocity of a particle.
+    cVector3d getVelocity(const unsigned int a_index) const
+        { return (cVector3d(m_vel[0][a_index], m_vel[1][a_index], m_vel[2][a_index])); }
+
+    //! Add a force to a particle, until forces are next cleared.
+    void addForce(const unsigned int a_index, const cVector3d& a_force)
+        { m_force[0][a_index] += a_force.x; m_force[1][a_index] += a_force.y; m_force[2][a_index] += a_force.z; }
+
+    //! Copy the state of the mass particles and the constants of the springs into the system.
+    void readParticles();
+
+    //! Copy positions and velocities back to the owned mass particles.
+    void writeParticles();
+
+    //! Clear forces.
+    void clearForces();
+
+    //! Compute spring forces.
+    void computeForces();
+
+    //! Compute next position of each particle by explicit Euler integration.
+    void computeNextPose(double a_timeInterval);
+
+    //! Compute next position of each particle by implicit Euler integration.
+    void computeNextPoseImplicit(double a_timeInterval,
+                                 double a_tolerance,
+                                 unsigned int a_maxIterations);
+
+    //! Get the number of solver iterations of the last implicit step.
+    unsigned int getNumSolverIterations() const { return (m_numSolverIterations); }
+
+    //! Get the relative residual of the solution of the last implicit step.
+    double getSolverResidual() const { return (m_solverResidual); }
+
+    //! Update positions with new computed values.
+    void applyNextPose();
+
+    //! Set the thread pool used on large systems, or NULL to compute on the calling thread only.
+    void setThreadPool(cThreadPool* a_threadPool) { m_threadPool = a_threadPool; }
+
+    //! Get the thread pool used on large systems.
+    cThreadPool* getThreadPool() const { return (m_threadPool); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Compute the stiffness matrix of each spring and the preconditioner of the implicit step.
+    void computeJacobian(double a_timeInterval);
+
+    //! Multiply a vector by the matrix of the implicit step.
+    void multiply(vector<double>* a_x, vector<double>* a_y, double a_timeInterval);
+
+    //! Add the product of the spring stiffness matrices by a vector to another vector.
+    void multiplyStiffness(vector<double>* a_x, vector<double>* a_y, double a_scale);
+
+    //! Add the force computed for each spring to its two particles.
+    void addSpringForces(vector<double>* a_force);
+
+    //! Return \b true if the computations over the springs are split between the threads of the pool.
+    bool useThreadPool();
+
+    //! Build the list of springs of each particle.
+    void updateParticleSprings();
+
+    //! Split a range of springs or particles into tasks and execute them on the thread pool.
+    void run(void (cGELParticleSystem::*a_function)(unsigned int, unsigned int),
+             unsigned int a_count);
+
+    //! Execute a task of run(). Called by the threads of the pool.
+    static void runTask(void* a_data, unsigned int a_task);
+
+    //! Compute the force of a range of springs.
+    void computeSpringForces(unsigned int a_first, unsigned int a_last);
+
+    //! Compute the stiffness matrix of a range of springs.
+    void computeSpringMatrices(unsigned int a_first, unsigned int a_last);
+
+    //! Compute the product of the stiffness matrix of a range of springs by the difference of the input vector of run().
+    void computeSpringProducts(unsigned int a_first, unsigned int a_last);
+
+    //! Add the forces of their springs to a range of particles of the output vector of run().
+    void gatherSpringForces(unsigned int a_first, unsigned int a_last);
+
+    //! Add the stiffness of their springs to the diagonal of a range of particles of the output vector of run().
+    void gatherSpringDiagonals(unsigned int a_first, unsigned int a_last);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - PARTICLES:
+    //-----------------------------------------------------------------------
+
+    //! Mass particles, by index.
+    vector<cGELMassParticle*> m_particles;
+
+    //! If nonzero, the particle is written back by writeParticles().
+    vector<unsigned char> m_owned;
+
+    //! If nonzero, the particle does not move.
+    vector<unsigned char> m_fixed;
+
+    //! Mass of each particle.
+    vector<double> m_mass;
+
+    //! Damping factor of each particle, equal to minus damping times mass.
+    vector<double> m_damping;
+
+    //! Coordinates of position.
+    vector<double> m_pos[3];
+
+    //! Coordinates of next position computed.
+    vector<double> m_nextPos[3];
+
+    //! Coordinates of velocity.
+    vector<double> m_vel[3];
+
+    //! Coordinates of current force being applied.
+    vector<double> m_force[3];
+
+    //! Coordinates of external force.
+    vector<double> m_externalForce[3];
+
+    //! Coordinates of gravity force, to which forces are cleared.
+    vector<double> m_gravityForce[3];
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - SPRINGS:
+    //-----------------------------------------------------------------------
+
+    //! Linear springs.
+    vector<cGELLinearSpring*> m_springs;
+
+    //! Index of node 0 and node 1 of each spring.
+    vector<unsigned int> m_springIndex[2];
+
+    //! Linear spring constant of each spring.
+    vector<double> m_springStiffness;
+
+    //! Initial length of each spring.
+    vector<double> m_springLength0;
+
+    //! Coordinates of the force applied by each spring on its node 0, or of the product computed by computeSpringProducts().
+    vector<double> m_springForce[3];
+
+    //! Stiffness matrix of each spring, as its xx, xy, xz, yy, yz and zz entries.
+    vector<double> m_springStiffnessMatrix[6];
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - IMPLICIT INTEGRATION:
+    //-----------------------------------------------------------------------
+
+    //! Coordinates of velocity change of the last implicit step, used as initial guess of the next.
+    vector<double> m_deltaVel[3];
+
+    //! Coordinates of residual of the solver.
+    vector<double> m_residual[3];
+
+    //! Coordinates of search direction of the solver.
+    vector<double> m_direction[3];
+
+    //! Coordinates of product of the search direction by the matrix.
+    vector<double> m_product[3];
+
+    //! Inverse of the diagonal of the matrix, by coordinate.
+    vector<double> m_preconditioner[3];
+
+    //! Number of solver iterations of the last implicit step.
+    unsigned int m_numSolverIterations;
+
+    //! Relative residual of the solution of the last implicit step.
+    double m_solverResidual;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - THREADS:
+    //-----------------------------------------------------------------------
+
+    //! Thread pool used on large systems.
+    cThreadPool* m_threadPool;
+
+    //! Offset of the first spring of each particle in m_particleSprings, followed by the size of m_particleSprings.
+    vector<unsigned int> m_particleSpringOffsets;
+
+    //! Springs of each particle in the order of the springs, as twice the index of the spring plus the node of the particle.
+    vector<unsigned int> m_particleSprings;
+
+    //! Function executed by the tasks of run().
+    void (cGELParticleSystem::*m_taskFunction)(unsigned int, unsigned int);
+
+    //! Number of springs or particles processed by run().
+    unsigned int m_taskCount;
+
+    //! Number of tasks of run().
+    unsigned int m_numTasks;
+
+    //! Input vector of the tasks of run().
+    vector<double>* m_taskInput;
+
+    //! Output vector of the tasks of run().
+    vector<double>* m_taskOutput;
+
+    //! Scale factor of the tasks of run().
+    double m_taskScale;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,515 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CGELSkeletonIndex.h"
+//---------------------------------------------------------------------------
+//! Average number of nodes and links per cell of the grid.
+#define CHAI_GEL_SKELETON_INDEX_ELEMENTS_PER_CELL 2.0
+
+//! Maximum number of cells of the grid along each axis.
+#define CHAI_GEL_SKELETON_INDEX_MAX_CELLS 128
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cGELSkeletonIndex.
+
+    \fn       cGELSkeletonIndex::cGELSkeletonIndex()
+*/
+//===========================================================================
+cGELSkeletonIndex::cGELSkeletonIndex()
+{
+    m_min.zero();
+    m_cellSize = 1.0;
+    m_numCells[0] = 0;
+    m_numCells[1] = 0;
+    m_numCells[2] = 0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELSkeletonIndex.
+
+    \fn       cGELSkeletonIndex::~cGELSkeletonIndex()
+*/
+//===========================================================================
+cGELSkeletonIndex::~cGELSkeletonIndex()
+{
+}
+
+
+//===========================================================================
+/*!
+    Build the grid from the current positions of a list of nodes and a
+    list of links. The size of the cells is chosen so that each cell holds
+    about CHAI_GEL_SKELETON_INDEX_ELEMENTS_PER_CELL elements. A node is
+    stored in the cell containing its center; a link is stored in every
+    cell overlapping the bounding box of its two nodes.
+
+    \fn       void cGELSkeletonIndex::build(const list<cGELSkeletonNode*>& a_nodes,
+                                            const list<cGELSkeletonLink*>& a_links)
+    \param    a_nodes  Nodes of the skeleton.
+    \param    a_links  Links of the skeleton.
+*/
+//===========================================================================
+void cGELSkeletonIndex::build(const list<cGELSkeletonNode*>& a_nodes,
+                              const list<cGELSkeletonLink*>& a_links)
+{
+    m_nodes.assign(a_nodes.begin(), a_nodes.end());
+    m_links.assign(a_links.begin(), a_links.end());
+    m_cellOffsets.clear();
+    m_cellElements.clear();
+    m_numCells[0] = 0;
+    m_numCells[1] = 0;
+    m_numCells[2] = 0;
+
+    unsigned int numNodes = (unsigned int)m_nodes.size();
+    unsigned int numLinks = (unsigned int)m_links.size();
+    unsigned int numElements = numNodes + numLinks;
+    if (numElements == 0) { return; }
+
+    //-----------------------------------------------------------------------
+    // GRID SIZE:
+    //-----------------------------------------------------------------------
+    cVector3d boxMin(CHAI_LARGE, CHAI_LARGE, CHAI_LARGE);
+    cVector3d boxMax(-CHAI_LARGE, -CHAI_LARGE, -CHAI_LARGE);
+    for (int k=0; k<3; k++)
+    {
+        for (unsigned int i=0; i<numNodes; i++)
+        {
+            boxMin[k] = cMin(boxMin[k], m_nodes[i]->m_pos[k]);
+            boxMax[k] = cMax(boxMax[k], m_nodes[i]->m_pos[k]);
+        }
+        for (unsigned int i=0; i<numLinks; i++)
+        {
+            boxMin[k] = cMin(boxMin[k], cMin(m_links[i]->m_node0->m_pos[k], m_links[i]->m_node1->m_pos[k]));
+            boxMax[k] = cMax(boxMax[k], cMax(m_links[i]->m_node0->m_pos[k], m_links[i]->m_node1->m_pos[k]));
+        }
+    }
+
+    cVector3d size = cSub(boxMax, boxMin);
+    double maxSize = cMax(size.x, cMax(size.y, size.z));
+
+    m_min = boxMin;
+    m_cellSize = 1.0;
+    if (maxSize > 0.0)
+    {
+        // sizes of the box in increasing order
+        double s0 = size.x;
+        double s1 = size.y;
+        double s2 = size.z;
+        if (s0 > s1) { cSwap(s0, s1); }
+        if (s1 > s2) { cSwap(s1, s2); }
+        if (s0 > s1) { cSwap(s0, s1); }
+
+        // cells of flat or thin skeletons are sized over their largest sides only
+        double cellVolume = CHAI_GEL_SKELETON_INDEX_ELEMENTS_PER_CELL / (double)numElements;
+        m_cellSize = pow(s0 * s1 * s2 * cellVolume, 1.0 / 3.0);
+        if (s0 <= m_cellSize)
+        {
+            m_cellSize = sqrt(s1 * s2 * cellVolume);
+            if (s1 <= m_cellSize)
+            {
+                m_cellSize = s2 * cellVolume;
+            }
+        }
+        m_cellSize = cMax(m_cellSize, maxSize / (double)CHAI_GEL_SKELETON_INDEX_MAX_CELLS);
+    }
+    for (int k=0; k<3; k++)
+    {
+        m_numCells[k] = (int)ceil(size[k] / m_cellSize);
+        m_numCells[k] = cClamp(m_numCells[k], 1, CHAI_GEL_SKELETON_INDEX_MAX_CELLS);
+    }
+
+    // make sure that the cells cover the skeleton despite rounding
+    for (int k=0; k<3; k++)
+    {
+        if (m_numCells[k] * m_cellSize < size[k])
+        {
+            m_cellSize = (1.0 + CHAI_SMALL) * size[k] / m_numCells[k];
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    // CELL ELEMENTS:
+    //-----------------------------------------------------------------------
+    // range of cells of each element
+    vector<int> cellMin[3];
+    vector<int> cellMax[3];
+    for (int k=0; k<3; k++)
+    {
+        cellMin[k].resize(numElements);
+        cellMax[k].resize(numElements);
+        for (unsigned int i=0; i<numNodes; i++)
+        {
+            cellMin[k][i] = getCell(m_nodes[i]->m_pos[k], k);
+            cellMax[k][i] = cellMin[k][i];
+        }
+        for (unsigned int i=0; i<numLinks; i++)
+        {
+            int cell0 = getCell(m_links[i]->m_node0->m_pos[k], k);
+            int cell1 = getCell(m_links[i]->m_node1->m_pos[k], k);
+            cellMin[k][numNodes + i] = cMin(cell0, cell1);
+            cellMax[k][numNodes + i] = cMax(cell0, cell1);
+        }
+    }
+
+    // count elements of each cell, then list them in order
+    unsigned int numCells = m_numCells[0] * m_numCells[1] * m_numCells[2];
+    m_cellOffsets.assign(numCells + 1, 0);
+    for (int pass=0; pass<2; pass++)
+    {
+        for (unsigned int i=0; i<numElements; i++)
+        {
+            for (int z=cellMin[2][i]; z<=cellMax[2][i]; z++)
+            {
+                for (int y=cellMin[1][i]; y<=cellMax[1][i]; y++)
+                {
+                    for (int x=cellMin[0][i]; x<=cellMax[0][i]; x++)
+                    {
+                        unsigned int cell = (z * m_numCells[1] + y) * m_numCells[0] + x;
+                        if (pass == 0)
+                        {
+                            m_cellOffsets[cell + 1]++;
+                        }
+                        else
+                        {
+                            m_cellElements[m_cellOffsets[cell]++] = i;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (unsigned int c=0; c<numCells; c++)
+            {
+                m_cellOffsets[c + 1] += m_cellOffsets[c];
+            }
+            m_cellElements.resize(m_cellOffsets[numCells]);
+        }
+    }
+
+    // the second pass moved each offset to the start of the next cell
+    for (unsigned int c=numCells; c>0; c--)
+    {
+        m_cellOffsets[c] = m_cellOffsets[c - 1];
+    }
+    m_cellOffsets[0] = 0;
+}
+
+
+//===========================================================================
+/*!
+    Find the nodes, and optionally the links, nearest to a point. Cells
+    are searched in rings of increasing size around the cell of the point,
+    until no cell left can hold an element nearer than the results found.
+
+    \fn       unsigned int cGELSkeletonIndex::findNearest(const cVector3d& a_point,
+                                                          const unsigned int a_maxResults,
+                                                          const bool a_includeLinks,
+                                                          cGELSkeletonIndexResult* a_results) const
+    \param    a_point  Query point.
+    \param    a_maxResults  Maximum number of results.
+    \param    a_includeLinks  If \b false, only nodes are returned.
+    \param    a_results  Array of at least \e a_maxResults results, sorted
+              by increasing distance.
+    \return   Return the number of results.
+*/
+//===========================================================================
+unsigned int cGELSkeletonIndex::findNearest(const cVector3d& a_point,
+                                            const unsigned int a_maxResults,
+                                            const bool a_includeLinks,
+                                            cGELSkeletonIndexResult* a_results) const
+{
+    if ((a_maxResults == 0) || (m_cellOffsets.size() == 0)) { return (0); }
+
+    unsigned int numNodes = (unsigned int)m_nodes.size();
+    unsigned int numResults = 0;
+
+    int center[3];
+    for (int k=0; k<3; k++)
+    {
+        center[k] = getCell(a_point[k], k);
+    }
+
+    for (int r=0; ; r++)
+    {
+        int lo[3], hi[3];
+        for (int k=0; k<3; k++)
+        {
+            lo[k] = cMax(center[k] - r, 0);
+            hi[k] = cMin(center[k] + r, m_numCells[k] - 1);
+        }
+
+        //-------------------------------------------------------------------
+        // TEST THE CELLS OF THE RING:
+        //-------------------------------------------------------------------
+        for (int z=lo[2]; z<=hi[2]; z++)
+        {
+            for (int y=lo[1]; y<=hi[1]; y++)
+            {
+                // inside the ring, only the first and last cells of the row are new
+                bool inside = (cAbs(y - center[1]) != r) && (cAbs(z - center[2]) != r);
+                int step = (inside && (r > 0)) ? (2 * r) : 1;
+
+                for (int x=center[0]-r; x<=center[0]+r; x+=step)
+                {
+                    if ((x < lo[0]) || (x > hi[0])) { continue; }
+
+                    // skip cells farther than the last result
+                    if (numResults == a_maxResults)
+                    {
+                        int cellIndex[3] = { x, y, z };
+                        double distanceSq = 0.0;
+                        for (int k=0; k<3; k++)
+                        {
+                            double cellMin = m_min[k] + cellIndex[k] * m_cellSize;
+                            double d = cMax(cellMin - a_point[k], a_point[k] - (cellMin + m_cellSize));
+                            if (d > 0.0)
+                            {
+                                distanceSq += d * d;
+                            }
+                        }
+
+                        double distance = a_results[numResults-1].m_distance;
+                        if (distanceSq > (distance * distance * (1.0 + CHAI_SMALL) + CHAI_SMALL * CHAI_SMALL))
+                        {
+                            continue;
+                        }
+                    }
+
+                    unsigned int cell = (z * m_numCells[1] + y) * m_numCells[0] + x;
+                    for (unsigned int e=m_cellOffsets[cell]; e<m_cellOffsets[cell+1]; e++)
+                    {
+                        unsigned int index = m_cellElements[e];
+
+                        cGELSkeletonIndexResult result;
+                        result.m_index = index;
+                        if (index < numNodes)
+                        {
+                            result.m_node = m_nodes[index];
+                            result.m_link = NULL;
+                            result.m_distance = cDistance(a_point, result.m_node->m_pos);
+                        }
+                        else
+                        {
+                            if (!a_includeLinks) { continue; }
+                            result.m_node = NULL;
+                            result.m_link = m_links[index - numNodes];
+
+                            // skip links whose bounding box is farther than the last result
+                            if (numResults == a_maxResults)
+                            {
+                                double distance = a_results[numResults-1].m_distance;
+                                if (computeLinkBoxDistanceSq(a_point, result.m_link) >
+                                    (distance * distance * (1.0 + CHAI_SMALL) + CHAI_SMALL * CHAI_SMALL))
+                                {
+                                    continue;
+                                }
+                            }
+
+                            result.m_distance = computeLinkDistance(a_point, result.m_link);
+                        }
+
+                        // ignore elements farther than the last result
+                        if ((numResults == a_maxResults) &&
+                            ((result.m_distance > a_results[numResults-1].m_distance) ||
+                             ((result.m_distance == a_results[numResults-1].m_distance) &&
+                              (result.m_index > a_results[numResults-1].m_index))))
+                        {
+                            continue;
+                        }
+
+                        // the distance to a link is only defined between its nodes
+                        if ((result.m_link != NULL) && !isBetweenNodes(a_point, result.m_link))
+                        {
+                            continue;
+                        }
+
+                        // links may be stored in several cells of the ring
+                        bool found = false;
+                        for (unsigned int i=0; i<numResults; i++)
+                        {
+                            if (a_results[i].m_index == index) { found = true; break; }
+                        }
+                        if (found) { continue; }
+
+                        // insert result by distance, then by index
+                        unsigned int i = cMin(numResults, a_maxResults - 1);
+                        while ((i > 0) &&
+                               ((a_results[i-1].m_distance > result.m_distance) ||
+                                ((a_results[i-1].m_distance == result.m_distance) &&
+                                 (a_results[i-1].m_index > result.m_index))))
+                        {
+                            a_results[i] = a_results[i-1];
+                            i--;
+                        }
+                        a_results[i] = result;
+                        if (numResults < a_maxResults) { numResults++; }
+                    }
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------
+        // DISTANCE TO THE CELLS LEFT:
+        //-------------------------------------------------------------------
+        // the cells left lie beyond a face of the cells searched, and
+        // within the grid along the other axes
+        double boundSq = CHAI_LARGE;
+        for (int k=0; k<3; k++)
+        {
+            double faceSq = CHAI_LARGE;
+            if (lo[k] > 0)
+            {
+                double d = a_point[k] - (m_min[k] + lo[k] * m_cellSize);
+                faceSq = cMin(faceSq, d * d);
+            }
+            if (hi[k] < m_numCells[k] - 1)
+            {
+                double d = (m_min[k] + (hi[k] + 1) * m_cellSize) - a_point[k];
+                faceSq = cMin(faceSq, d * d);
+            }
+            if (faceSq == CHAI_LARGE) { continue; }
+
+            for (int j=0; j<3; j++)
+            {
+                if (j == k) { continue; }
+                double d = cMax(m_min[j] - a_point[j],
+                                a_point[j] - (m_min[j] + m_numCells[j] * m_cellSize));
+                if (d > 0.0)
+                {
+                    faceSq += d * d;
+                }
+            }
+            boundSq = cMin(boundSq, faceSq);
+        }
+
+        // all cells have been searched
+        if (boundSq == CHAI_LARGE) { break; }
+
+        // no cell left can hold a nearer element
+        if (numResults == a_maxResults)
+        {
+            double distance = a_results[numResults-1].m_distance;
+            if ((distance * distance * (1.0 + CHAI_SMALL) + CHAI_SMALL * CHAI_SMALL) < boundSq)
+            {
+                break;
+            }
+        }
+    }
+
+    return (numResults);
+}
+
+
+//===========================================================================
+/*!
+    Compute the distance from a point to the line through the nodes of a
+    link.
+
+    \fn       double cGELSkeletonIndex::computeLinkDistance(const cVector3d& a_point,
+                                                            const cGELSkeletonLink* a_link) const
+    \param    a_point  Query point.
+    \param    a_link  Skeleton link.
+    \return   Return the distance.
+*/
+//===========================================================================
+double cGELSkeletonIndex::computeLinkDistance(const cVector3d& a_point,
+                                             const cGELSkeletonLink* a_link) const
+{
+    cVector3d p = cProjectPointOnLine(a_point,
+                                      a_link->m_node0->m_pos,
+                                      a_link->m_wLink01);
+
+    return (cDistance(a_point, p));
+}
+
+
+//===========================================================================
+/*!
+    Check if a point projects onto a link between its two nodes, that is,
+    if the angles between the link and the point, seen from each node, are
+    both acute.
+
+    \fn       bool cGELSkeletonIndex::isBetweenNodes(const cVector3d& a_point,
+                                                     const cGELSkeletonLink* a_link) const
+    \param    a_point  Query point.
+    \param    a_link  Skeleton link.
+    \return   Return \b true if the point projects between the nodes.
+*/
+//===========================================================================
+bool cGELSkeletonIndex::isBetweenNodes(const cVector3d& a_point,
+                                       const cGELSkeletonLink* a_link) const
+{
+    double angle0 = cAngle(a_link->m_wLink01, cSub(a_point, a_link->m_node0->m_pos));
+    double angle1 = cAngle(a_link->m_wLink10, cSub(a_point, a_link->m_node1->m_pos));
+
+    return ((angle0 < (CHAI_PI / 2.0)) && (angle1 < (CHAI_PI / 2.0)));
+}
+
+
+//===========================================================================
+/*!
+    Compute the square of the distance from a point to the bounding box of
+    the two nodes of a link, which is never larger than the distance
+    computed by computeLinkDistance() for points between the nodes.
+
+    \fn       double cGELSkeletonIndex::computeLinkBoxDistanceSq(const cVector3d& a_point,
+                                                               const cGELSkeletonLink* a_link) const
+    \param    a_point  Query point.
+    \param    a_link  Skeleton link.
+    \return   Return the square of the distance.
+*/
+//===========================================================================
+double cGELSkeletonIndex::computeLinkBoxDistanceSq(const cVector3d& a_point,
+                                                   const cGELSkeletonLink* a_link) const
+{
+    const cVector3d& pos0 = a_link->m_node0->m_pos;
+    const cVector3d& pos1 = a_link->m_node1->m_pos;
+
+    double distanceSq = 0.0;
+    for (int k=0; k<3; k++)
+    {
+        double d = cMax(cMin(pos0[k], pos1[k]) - a_point[k], a_point[k] - cMax(pos0[k], pos1[k]));
+        if (d > 0.0)
+        {
+            distanceSq += d * d;
+        }
+    }
+
+    return (distanceSq);
+}
+
+
+//===========================================================================
+/*!
+    Get the index of the cell containing a coordinate along an axis.
+    Coordinates outside of the grid belong to the nearest cell.
+
+    \fn       int cGELSkeletonIndex::getCell(const double a_value, const int a_axis) const
+    \param    a_value  Coordinate.
+    \param    a_axis  Axis (0, 1 or 2).
+    \return   Return the index of the cell.
+*/
+//===========================================================================
+int cGELSkeletonIndex::getCell(const double a_value, const int a_axis) const
+{
+    double cell = floor((a_value - m_min[a_axis]) / m_cellSize);
+    if (cell < 0.0) { return (0); }
+    if (cell >= (double)(m_numCells[a_axis] - 1)) { return (m_numCells[a_axis] - 1); }
+    return ((int)cell);
+}
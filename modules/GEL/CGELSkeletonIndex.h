@@ -0,0 +1,170 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CGELSkeletonIndexH
+#define CGELSkeletonIndexH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include "CGELSkeletonNode.h"
+#include "CGELSkeletonLink.h"
+#include <vector>
+#include <list>
+//---------------------------------------------------------------------------
+using std::vector;
+using std::list;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CGELSkeletonIndex.h
+
+    \brief
+    <b> GEL Module </b> \n
+    Uniform Grid over Skeleton Nodes and Links.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cGELSkeletonIndexResult
+    \ingroup    GEL
+
+    \brief
+    cGELSkeletonIndexResult is a skeleton node or link found by a query of
+    a cGELSkeletonIndex, with its distance to the query point.
+*/
+//===========================================================================
+struct cGELSkeletonIndexResult
+{
+    //! Skeleton node, or NULL if the result is a link.
+    cGELSkeletonNode* m_node;
+
+    //! Skeleton link, or NULL if the result is a node.
+    cGELSkeletonLink* m_link;
+
+    //! Distance from the query point.
+    double m_distance;
+
+    //! Index of the node, or number of nodes plus index of the link, used to order results at equal distance.
+    unsigned int m_index;
+};
+
+
+//===========================================================================
+/*!
+    \class      cGELSkeletonIndex
+    \ingroup    GEL
+
+    \brief
+    cGELSkeletonIndex sorts the nodes and links of a skeleton into a
+    uniform grid, to find the nodes and links nearest to a point. \n
+
+    The distance to a node is the distance to its center. The distance to
+    a link is the distance to the line through its nodes, and is only
+    defined where the point projects between the two nodes. Results at
+    equal distance are ordered as the nodes and links in their lists,
+    nodes first, so that the nearest result is the one found by testing
+    every node and then every link. \n
+
+    The grid stores the positions of the nodes when build() is called, and
+    must be built again after the skeleton moves. Queries do not modify
+    the index and may be run from several threads at once.
+*/
+//===========================================================================
+class cGELSkeletonIndex
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELSkeletonIndex.
+    cGELSkeletonIndex();
+
+    //! Destructor of cGELSkeletonIndex.
+    ~cGELSkeletonIndex();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the grid over a list of nodes and a list of links.
+    void build(const list<cGELSkeletonNode*>& a_nodes,
+               const list<cGELSkeletonLink*>& a_links);
+
+    //! Find the nodes, and optionally the links, nearest to a point, by increasing distance.
+    unsigned int findNearest(const cVector3d& a_point,
+                             const unsigned int a_maxResults,
+                             const bool a_includeLinks,
+                             cGELSkeletonIndexResult* a_results) const;
+
+    //! Get the number of nodes.
+    unsigned int getNumNodes() const { return ((unsigned int)m_nodes.size()); }
+
+    //! Get the number of links.
+    unsigned int getNumLinks() const { return ((unsigned int)m_links.size()); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Compute the distance from a point to the line through the nodes of a link.
+    double computeLinkDistance(const cVector3d& a_point,
+                               const cGELSkeletonLink* a_link) const;
+
+    //! Return \b true if a point projects onto a link between its two nodes.
+    bool isBetweenNodes(const cVector3d& a_point,
+                        const cGELSkeletonLink* a_link) const;
+
+    //! Compute the square of the distance from a point to the bounding box of a link.
+    double computeLinkBoxDistanceSq(const cVector3d& a_point,
+                                    const cGELSkeletonLink* a_link) const;
+
+    //! Get the index of the cell containing a coordinate along an axis, clamped to the grid.
+    int getCell(const double a_value, const int a_axis) const;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Nodes of the skeleton, by index.
+    vector<cGELSkeletonNode*> m_nodes;
+
+    //! Links of the skeleton, by index.
+    vector<cGELSkeletonLink*> m_links;
+
+    //! Minimum corner of the grid.
+    cVector3d m_min;
+
+    //! Size of the cells of the grid.
+    double m_cellSize;
+
+    //! Number of cells of the grid along each axis.
+    int m_numCells[3];
+
+    //! Offset of the first element of each cell in m_cellElements, followed by the size of m_cellElements.
+    vector<unsigned int> m_cellOffsets;
+
+    //! Elements of each cell, as indices of nodes, or number of nodes plus indices of links.
+    vector<unsigned int> m_cellElements;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,788 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CGELSkin.h"
+//---------------------------------------------------------------------------
+#include "CGELMesh.h"
+//---------------------------------------------------------------------------
+//! Number of vertices of a block, the unit in which modified vertices are tracked.
+#define CHAI_GEL_SKIN_BLOCK_SIZE 256
+
+//! Length below which a triangle has no normal, as in cMesh::computeAllNormals().
+#define CHAI_GEL_SKIN_MIN_NORMAL_LENGTH 0.0000001
+
+//! Meshes with fewer vertices than this are always updated on the calling thread.
+#define CHAI_GEL_PARALLEL_SKIN_MIN_VERTICES 4096
+
+//! Number of tasks created for each thread when updating in parallel.
+#define CHAI_GEL_PARALLEL_SKIN_TASKS_PER_THREAD 4
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    List a mesh and its descendant meshes, in the order in which
+    cMesh::getVertex() numbers their vertices when children are included.
+
+    \fn       void collectMeshes(cMesh* a_mesh, vector<cMesh*>& a_meshes)
+    \param    a_mesh  Mesh.
+    \param    a_meshes  List to which meshes are added.
+*/
+//===========================================================================
+static void collectMeshes(cMesh* a_mesh, vector<cMesh*>& a_meshes)
+{
+    a_meshes.push_back(a_mesh);
+
+    unsigned int numChildren = a_mesh->getNumChildren();
+    for (unsigned int i=0; i<numChildren; i++)
+    {
+        cMesh* nextMesh = dynamic_cast<cMesh*>(a_mesh->getChild(i));
+        if (nextMesh != NULL)
+        {
+            collectMeshes(nextMesh, a_meshes);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cGELSkin.
+
+    \fn       cGELSkin::cGELSkin()
+*/
+//===========================================================================
+cGELSkin::cGELSkin()
+{
+    m_mesh = NULL;
+    m_numMeshTriangles = 0;
+    m_useSkeletonModel = false;
+    m_useMassParticleModel = false;
+    for (int k=0; k<=GEL_SKIN_NUM_BINDINGS; k++)
+    {
+        m_groupStart[k] = 0;
+    }
+    m_threadPool = cThreadPool::getDefaultThreadPool();
+    m_taskFunction = NULL;
+    m_taskCount = 0;
+    m_numTasks = 0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELSkin.
+
+    \fn       cGELSkin::~cGELSkin()
+*/
+//===========================================================================
+cGELSkin::~cGELSkin()
+{
+}
+
+
+//===========================================================================
+/*!
+    Return \b true if the vertices, the triangles or the models of a mesh
+    have changed since the skin was built from it.
+
+    \fn       bool cGELSkin::isModified(cGELMesh* a_mesh) const
+    \param    a_mesh  Deformable mesh.
+    \return   Return \b true if the skin must be built again.
+*/
+//===========================================================================
+bool cGELSkin::isModified(cGELMesh* a_mesh) const
+{
+    return ((m_mesh != a_mesh) ||
+            (m_vertices.size() != a_mesh->m_gelVertices.size()) ||
+            (m_numMeshTriangles != a_mesh->getNumTriangles(true)) ||
+            (m_useSkeletonModel != a_mesh->m_useSkeletonModel) ||
+            (m_useMassParticleModel != a_mesh->m_useMassParticleModel));
+}
+
+
+//===========================================================================
+/*!
+    Sort the vertices of a deformable mesh into groups by the way they
+    are positioned, as in the former per vertex update: a vertex with a
+    mass particle follows its particle when the mass particle model is
+    used, and otherwise follows its skeleton influences, node or link when
+    the skeleton model is used. Other vertices keep their position. \n
+
+    The triangles of the mesh and of its child meshes are collected with
+    the list of triangles of each vertex. Vertices are numbered as in
+    cGELMesh::buildVertices().
+
+    \fn       void cGELSkin::build(cGELMesh* a_mesh)
+    \param    a_mesh  Deformable mesh.
+*/
+//===========================================================================
+void cGELSkin::build(cGELMesh* a_mesh)
+{
+    m_mesh = a_mesh;
+    m_numMeshTriangles = a_mesh->getNumTriangles(true);
+    m_useSkeletonModel = a_mesh->m_useSkeletonModel;
+    m_useMassParticleModel = a_mesh->m_useMassParticleModel;
+
+    vector<cGELVertex>& gelVertices = a_mesh->m_gelVertices;
+    unsigned int numVertices = (unsigned int)gelVertices.size();
+
+    //-----------------------------------------------------------------------
+    // BINDING OF EACH VERTEX
+    //-----------------------------------------------------------------------
+    vector<unsigned char> binding(numVertices);
+    map<cGELSkeletonNode*, unsigned int> nodes;
+    map<cGELSkeletonLink*, unsigned int> links;
+    m_frameNodes.clear();
+    m_frameLinks.clear();
+
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        cGELVertex& vertex = gelVertices[i];
+        binding[i] = GEL_SKIN_BINDING_NONE;
+
+        if (m_useMassParticleModel && (vertex.m_massParticle != NULL))
+        {
+            binding[i] = GEL_SKIN_BINDING_PARTICLE;
+        }
+        else if (m_useSkeletonModel)
+        {
+            if (vertex.m_influences.size() > 1)
+            {
+                binding[i] = GEL_SKIN_BINDING_INFLUENCES;
+            }
+            else if (vertex.m_node != NULL)
+            {
+                binding[i] = GEL_SKIN_BINDING_NODE;
+            }
+            else if (vertex.m_link != NULL)
+            {
+                binding[i] = GEL_SKIN_BINDING_LINK;
+            }
+        }
+
+        // list the nodes and links used
+        if (binding[i] == GEL_SKIN_BINDING_INFLUENCES)
+        {
+            unsigned int numInfluences = (unsigned int)vertex.m_influences.size();
+            for (unsigned int j=0; j<numInfluences; j++)
+            {
+                addFrame(vertex.m_influences[j].m_node, vertex.m_influences[j].m_link, nodes, links);
+            }
+        }
+        else if ((binding[i] == GEL_SKIN_BINDING_NODE) ||
+                 (binding[i] == GEL_SKIN_BINDING_LINK))
+        {
+            addFrame(vertex.m_node, vertex.m_link, nodes, links);
+        }
+    }
+
+    // frames of links follow those of nodes
+    unsigned int numNodeFrames = (unsigned int)m_frameNodes.size();
+    unsigned int numFrames = numNodeFrames + (unsigned int)m_frameLinks.size();
+    m_frameOrigin.resize(numFrames);
+    for (int k=0; k<3; k++)
+    {
+        m_frameAxis[k].resize(numFrames);
+    }
+
+    //-----------------------------------------------------------------------
+    // GROUPS
+    //-----------------------------------------------------------------------
+    unsigned int count[GEL_SKIN_NUM_BINDINGS] = { 0 };
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        count[binding[i]]++;
+    }
+    m_groupStart[0] = 0;
+    for (int k=0; k<GEL_SKIN_NUM_BINDINGS; k++)
+    {
+        m_groupStart[k+1] = m_groupStart[k] + count[k];
+    }
+
+    m_groupVertex.resize(numVertices);
+    m_groupFrame.resize(m_groupStart[GEL_SKIN_BINDING_PARTICLE]);
+    m_groupParticle.resize(count[GEL_SKIN_BINDING_PARTICLE]);
+    for (int k=0; k<3; k++)
+    {
+        m_groupLocalPos[k].resize(m_groupStart[GEL_SKIN_BINDING_INFLUENCES]);
+        m_influenceLocalPos[k].clear();
+    }
+    m_influenceFrame.clear();
+    m_influenceWeight.clear();
+
+    unsigned int next[GEL_SKIN_NUM_BINDINGS];
+    for (int k=0; k<GEL_SKIN_NUM_BINDINGS; k++)
+    {
+        next[k] = m_groupStart[k];
+    }
+
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        cGELVertex& vertex = gelVertices[i];
+        unsigned int n = next[binding[i]]++;
+        m_groupVertex[n] = i;
+
+        if ((binding[i] == GEL_SKIN_BINDING_NODE) ||
+            (binding[i] == GEL_SKIN_BINDING_LINK))
+        {
+            // the position in the frame is stored in the mass particle
+            m_groupFrame[n] = (vertex.m_node != NULL) ? nodes[vertex.m_node] :
+                                                        (numNodeFrames + links[vertex.m_link]);
+            m_groupLocalPos[0][n] = vertex.m_massParticle->m_pos.x;
+            m_groupLocalPos[1][n] = vertex.m_massParticle->m_pos.y;
+            m_groupLocalPos[2][n] = vertex.m_massParticle->m_pos.z;
+        }
+        else if (binding[i] == GEL_SKIN_BINDING_INFLUENCES)
+        {
+            m_groupFrame[n] = (unsigned int)m_influenceFrame.size();
+            unsigned int numInfluences = (unsigned int)vertex.m_influences.size();
+            for (unsigned int j=0; j<numInfluences; j++)
+            {
+                const cGELVertexInfluence& influence = vertex.m_influences[j];
+                m_influenceFrame.push_back((influence.m_node != NULL) ? nodes[influence.m_node] :
+                                                                        (numNodeFrames + links[influence.m_link]));
+                m_influenceLocalPos[0].push_back(influence.m_pos.x);
+                m_influenceLocalPos[1].push_back(influence.m_pos.y);
+                m_influenceLocalPos[2].push_back(influence.m_pos.z);
+                m_influenceWeight.push_back(influence.m_weight);
+            }
+        }
+        else if (binding[i] == GEL_SKIN_BINDING_PARTICLE)
+        {
+            m_groupParticle[n - m_groupStart[GEL_SKIN_BINDING_PARTICLE]] = vertex.m_massParticle;
+        }
+    }
+    m_influenceFrame.push_back((unsigned int)m_influenceWeight.size());
+
+    //-----------------------------------------------------------------------
+    // VERTICES
+    //-----------------------------------------------------------------------
+    m_vertices.resize(numVertices);
+    for (int k=0; k<3; k++)
+    {
+        m_pos[k].resize(numVertices);
+    }
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        m_vertices[i] = gelVertices[i].m_vertex;
+    }
+
+    //-----------------------------------------------------------------------
+    // TRIANGLES
+    //-----------------------------------------------------------------------
+    vector<cMesh*> meshes;
+    collectMeshes(a_mesh, meshes);
+
+    for (int k=0; k<3; k++)
+    {
+        m_triangleVertex[k].clear();
+    }
+
+    unsigned int offset = 0;
+    unsigned int numMeshes = (unsigned int)meshes.size();
+    for (unsigned int m=0; m<numMeshes; m++)
+    {
+        cMesh* mesh = meshes[m];
+        unsigned int numMeshVertices = mesh->getNumVertices();
+        unsigned int numMeshTriangles = mesh->getNumTriangles();
+        for (unsigned int t=0; t<numMeshTriangles; t++)
+        {
+            cTriangle* triangle = mesh->getTriangle(t);
+            if (!triangle->m_allocated) { continue; }
+
+            unsigned int index[3] = { triangle->m_indexVertex0,
+                                      triangle->m_indexVertex1,
+                                      triangle->m_indexVertex2 };
+
+            // skip triangles with vertices which are not deformable
+            if ((offset + index[0] >= numVertices) ||
+                (offset + index[1] >= numVertices) ||
+                (offset + index[2] >= numVertices))
+            {
+                continue;
+            }
+
+            for (int k=0; k<3; k++)
+            {
+                m_triangleVertex[k].push_back(offset + index[k]);
+            }
+        }
+        offset += numMeshVertices;
+    }
+
+    unsigned int numTriangles = (unsigned int)m_triangleVertex[0].size();
+    m_triangleNormal.resize(numTriangles);
+
+    // count triangles of each vertex, then list them in order
+    m_vertexTriangleOffsets.assign(numVertices + 1, 0);
+    for (unsigned int t=0; t<numTriangles; t++)
+    {
+        for (int k=0; k<3; k++)
+        {
+            m_vertexTriangleOffsets[m_triangleVertex[k][t] + 1]++;
+        }
+    }
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        m_vertexTriangleOffsets[i + 1] += m_vertexTriangleOffsets[i];
+    }
+
+    vector<unsigned int> nextTriangle(m_vertexTriangleOffsets.begin(), m_vertexTriangleOffsets.end() - 1);
+    m_vertexTriangles.resize(3 * numTriangles);
+    for (unsigned int t=0; t<numTriangles; t++)
+    {
+        for (int k=0; k<3; k++)
+        {
+            m_vertexTriangles[nextTriangle[m_triangleVertex[k][t]]++] = t;
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    // MODIFIED VERTICES
+    //-----------------------------------------------------------------------
+    // all vertices are modified
+    unsigned int numBlocks = (numVertices + CHAI_GEL_SKIN_BLOCK_SIZE - 1) / CHAI_GEL_SKIN_BLOCK_SIZE;
+    m_blockDirty.assign(numBlocks, 1);
+}
+
+
+//===========================================================================
+/*!
+    Add a skeleton node or link to the frames of the skin, if it has no
+    frame yet. Nodes and links are numbered separately; the frames of the
+    links follow those of the nodes once all are added.
+
+    \fn       void cGELSkin::addFrame(cGELSkeletonNode* a_node,
+                                  cGELSkeletonLink* a_link,
+                                  map<cGELSkeletonNode*, unsigned int>& a_nodes,
+                                  map<cGELSkeletonLink*, unsigned int>& a_links)
+    \param    a_node  Skeleton node, or NULL.
+    \param    a_link  Skeleton link, if \e a_node is NULL.
+    \param    a_nodes  Index of each node added.
+    \param    a_links  Index of each link added.
+*/
+//===========================================================================
+void cGELSkin::addFrame(cGELSkeletonNode* a_node,
+                        cGELSkeletonLink* a_link,
+                        map<cGELSkeletonNode*, unsigned int>& a_nodes,
+                        map<cGELSkeletonLink*, unsigned int>& a_links)
+{
+    if (a_node != NULL)
+    {
+        if (a_nodes.find(a_node) == a_nodes.end())
+        {
+            a_nodes[a_node] = (unsigned int)m_frameNodes.size();
+            m_frameNodes.push_back(a_node);
+        }
+    }
+    else if (a_links.find(a_link) == a_links.end())
+    {
+        a_links[a_link] = (unsigned int)m_frameLinks.size();
+        m_frameLinks.push_back(a_link);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Read the position of each skeleton node and link used by the skin,
+    and the axes of its frame.
+
+    \fn       void cGELSkin::updateFrames()
+*/
+//===========================================================================
+void cGELSkin::updateFrames()
+{
+    unsigned int numNodes = (unsigned int)m_frameNodes.size();
+    for (unsigned int j=0; j<numNodes; j++)
+    {
+        const cGELSkeletonNode* node = m_frameNodes[j];
+        m_frameOrigin[j] = node->m_pos;
+        for (int k=0; k<3; k++)
+        {
+            m_frameAxis[k][j].set(node->m_rot.m[0][k], node->m_rot.m[1][k], node->m_rot.m[2][k]);
+        }
+    }
+
+    unsigned int numLinks = (unsigned int)m_frameLinks.size();
+    for (unsigned int j=0; j<numLinks; j++)
+    {
+        const cGELSkeletonLink* link = m_frameLinks[j];
+        m_frameOrigin[numNodes + j] = link->m_node0->m_pos;
+        m_frameAxis[0][numNodes + j] = link->m_wA0;
+        m_frameAxis[1][numNodes + j] = link->m_wB0;
+        m_frameAxis[2][numNodes + j] = link->m_wLink01;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Update the vertices of a deformable mesh. Positions are computed for
+    each group of vertices, then the normal of each triangle, and finally
+    the normal of each vertex, which is written with its position to the
+    mesh. On large meshes, each of these three passes
+    is split between the threads of the pool.
+
+    \fn       void cGELSkin::update(cGELMesh* a_mesh)
+    \param    a_mesh  Deformable mesh.
+*/
+//===========================================================================
+void cGELSkin::update(cGELMesh* a_mesh)
+{
+    // rebuild the skin if vertices, triangles or models have changed
+    if (isModified(a_mesh))
+    {
+        build(a_mesh);
+    }
+
+    unsigned int numVertices = (unsigned int)m_vertices.size();
+    if (numVertices == 0) { return; }
+
+    updateFrames();
+
+    run(&cGELSkin::computePositions, numVertices);
+    run(&cGELSkin::computeTriangleNormals, (unsigned int)m_triangleNormal.size());
+    run(&cGELSkin::writeBlocks, (unsigned int)m_blockDirty.size());
+
+    // merge modified blocks into ranges of vertices
+    m_dirtyRanges.clear();
+    unsigned int numBlocks = (unsigned int)m_blockDirty.size();
+    for (unsigned int b=0; b<numBlocks; b++)
+    {
+        if (!m_blockDirty[b]) { continue; }
+
+        unsigned int first = b * CHAI_GEL_SKIN_BLOCK_SIZE;
+        unsigned int last = cMin(first + CHAI_GEL_SKIN_BLOCK_SIZE, numVertices);
+        if ((!m_dirtyRanges.empty()) &&
+            (m_dirtyRanges.back().m_first + m_dirtyRanges.back().m_count == first))
+        {
+            m_dirtyRanges.back().m_count += last - first;
+        }
+        else
+        {
+            cGELSkinRange range;
+            range.m_first = first;
+            range.m_count = last - first;
+            m_dirtyRanges.push_back(range);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Mark all vertices of the skin as unmodified, typically after the
+    modified ranges have been copied to the graphics card.
+
+    \fn       void cGELSkin::clearDirtyRanges()
+*/
+//===========================================================================
+void cGELSkin::clearDirtyRanges()
+{
+    m_blockDirty.assign(m_blockDirty.size(), 0);
+    m_dirtyRanges.clear();
+}
+
+
+//===========================================================================
+/*!
+    Split a range of vertices, triangles or blocks into tasks, and execute
+    a function over the range of each task on the thread pool. Small
+    meshes are computed on the calling thread. Returns when all tasks have
+    completed.
+
+    \fn       void cGELSkin::run(void (cGELSkin::*a_function)(unsigned int, unsigned int),
+                                 unsigned int a_count)
+    \param    a_function  Function computing a range of vertices, triangles or blocks.
+    \param    a_count  Number of vertices, triangles or blocks.
+*/
+//===========================================================================
+void cGELSkin::run(void (cGELSkin::*a_function)(unsigned int, unsigned int),
+                   unsigned int a_count)
+{
+    if (a_count == 0) { return; }
+
+    if ((m_threadPool == NULL) ||
+        (m_threadPool->getNumThreads() == 0) ||
+        (m_vertices.size() < CHAI_GEL_PARALLEL_SKIN_MIN_VERTICES))
+    {
+        (this->*a_function)(0, a_count);
+        return;
+    }
+
+    m_taskFunction = a_function;
+    m_taskCount = a_count;
+    m_numTasks = cMin((m_threadPool->getNumThreads() + 1) * CHAI_GEL_PARALLEL_SKIN_TASKS_PER_THREAD,
+                      a_count);
+
+    m_threadPool->run(runTask, this, m_numTasks);
+}
+
+
+//===========================================================================
+/*!
+    Execute the function given to run() over the range of a task. Called
+    by the threads of the pool.
+
+    \fn       void cGELSkin::runTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELSkin.
+    \param    a_task  Index of the task.
+*/
+//===========================================================================
+void cGELSkin::runTask(void* a_data, unsigned int a_task)
+{
+    cGELSkin* skin = (cGELSkin*)a_data;
+
+    // the first tasks take one more element when the count does not divide evenly
+    unsigned int size = skin->m_taskCount / skin->m_numTasks;
+    unsigned int remainder = skin->m_taskCount % skin->m_numTasks;
+    unsigned int first = a_task * size + cMin(a_task, remainder);
+    unsigned int last = first + size + ((a_task < remainder) ? 1 : 0);
+
+    (skin->*(skin->m_taskFunction))(first, last);
+}
+
+
+//===========================================================================
+/*!
+    Compute the position of a range of vertices, numbered in the order of
+    their groups. Each group is computed by its own loop, with the same
+    arithmetic as the former per vertex update.
+
+    \fn       void cGELSkin::computePositions(unsigned int a_first,
+                                              unsigned int a_last)
+    \param    a_first  Index of the first vertex.
+    \param    a_last  Index following the last vertex.
+*/
+//===========================================================================
+void cGELSkin::computePositions(unsigned int a_first,
+                                unsigned int a_last)
+{
+    const unsigned int* vertex = &m_groupVertex[0];
+    const cVector3d* origin = m_frameOrigin.empty() ? NULL : &m_frameOrigin[0];
+    const cVector3d* axisA = m_frameAxis[0].empty() ? NULL : &m_frameAxis[0][0];
+    const cVector3d* axisB = m_frameAxis[1].empty() ? NULL : &m_frameAxis[1][0];
+    const cVector3d* axisC = m_frameAxis[2].empty() ? NULL : &m_frameAxis[2][0];
+    double* posX = &m_pos[0][0];
+    double* posY = &m_pos[1][0];
+    double* posZ = &m_pos[2][0];
+
+    unsigned int first, last;
+
+    // vertices attached to a node: rotation of the node, then its position
+    first = cMax(a_first, m_groupStart[GEL_SKIN_BINDING_NODE]);
+    last = cMin(a_last, m_groupStart[GEL_SKIN_BINDING_NODE+1]);
+    for (unsigned int n=first; n<last; n++)
+    {
+        unsigned int f = m_groupFrame[n];
+        double x = m_groupLocalPos[0][n];
+        double y = m_groupLocalPos[1][n];
+        double z = m_groupLocalPos[2][n];
+        unsigned int i = vertex[n];
+        posX[i] = (axisA[f].x * x + axisB[f].x * y + axisC[f].x * z) + origin[f].x;
+        posY[i] = (axisA[f].y * x + axisB[f].y * y + axisC[f].y * z) + origin[f].y;
+        posZ[i] = (axisA[f].z * x + axisB[f].z * y + axisC[f].z * z) + origin[f].z;
+    }
+
+    // vertices attached to a link: position of node 0, then axes of the link
+    first = cMax(a_first, m_groupStart[GEL_SKIN_BINDING_LINK]);
+    last = cMin(a_last, m_groupStart[GEL_SKIN_BINDING_LINK+1]);
+    for (unsigned int n=first; n<last; n++)
+    {
+        unsigned int f = m_groupFrame[n];
+        double x = m_groupLocalPos[0][n];
+        double y = m_groupLocalPos[1][n];
+        double z = m_groupLocalPos[2][n];
+        unsigned int i = vertex[n];
+        posX[i] = ((origin[f].x + z * axisC[f].x) + x * axisA[f].x) + y * axisB[f].x;
+        posY[i] = ((origin[f].y + z * axisC[f].y) + x * axisA[f].y) + y * axisB[f].y;
+        posZ[i] = ((origin[f].z + z * axisC[f].z) + x * axisA[f].z) + y * axisB[f].z;
+    }
+
+    // vertices attached to several nodes and links: weighted sum of their positions
+    unsigned int numNodeFrames = (unsigned int)m_frameNodes.size();
+    const unsigned int* influenceFrame = &m_influenceFrame[0];
+    const double* influenceX = m_influenceWeight.empty() ? NULL : &m_influenceLocalPos[0][0];
+    const double* influenceY = m_influenceWeight.empty() ? NULL : &m_influenceLocalPos[1][0];
+    const double* influenceZ = m_influenceWeight.empty() ? NULL : &m_influenceLocalPos[2][0];
+    const double* influenceWeight = m_influenceWeight.empty() ? NULL : &m_influenceWeight[0];
+    first = cMax(a_first, m_groupStart[GEL_SKIN_BINDING_INFLUENCES]);
+    last = cMin(a_last, m_groupStart[GEL_SKIN_BINDING_INFLUENCES+1]);
+    for (unsigned int n=first; n<last; n++)
+    {
+        unsigned int end = (n + 1 < m_groupStart[GEL_SKIN_BINDING_INFLUENCES+1]) ?
+                           m_groupFrame[n + 1] : m_influenceFrame.back();
+        double sumX = 0.0;
+        double sumY = 0.0;
+        double sumZ = 0.0;
+        for (unsigned int j=m_groupFrame[n]; j<end; j++)
+        {
+            unsigned int f = influenceFrame[j];
+            double x = influenceX[j];
+            double y = influenceY[j];
+            double z = influenceZ[j];
+            double w = influenceWeight[j];
+            if (f < numNodeFrames)
+            {
+                sumX = sumX + w * ((axisA[f].x * x + axisB[f].x * y + axisC[f].x * z) + origin[f].x);
+                sumY = sumY + w * ((axisA[f].y * x + axisB[f].y * y + axisC[f].y * z) + origin[f].y);
+                sumZ = sumZ + w * ((axisA[f].z * x + axisB[f].z * y + axisC[f].z * z) + origin[f].z);
+            }
+            else
+            {
+                sumX = sumX + w * (((origin[f].x + z * axisC[f].x) + x * axisA[f].x) + y * axisB[f].x);
+                sumY = sumY + w * (((origin[f].y + z * axisC[f].y) + x * axisA[f].y) + y * axisB[f].y);
+                sumZ = sumZ + w * (((origin[f].z + z * axisC[f].z) + x * axisA[f].z) + y * axisB[f].z);
+            }
+        }
+        unsigned int i = vertex[n];
+        posX[i] = sumX;
+        posY[i] = sumY;
+        posZ[i] = sumZ;
+    }
+
+    // vertices following their mass particle
+    first = cMax(a_first, m_groupStart[GEL_SKIN_BINDING_PARTICLE]);
+    last = cMin(a_last, m_groupStart[GEL_SKIN_BINDING_PARTICLE+1]);
+    for (unsigned int n=first; n<last; n++)
+    {
+        const cVector3d& pos = m_groupParticle[n - m_groupStart[GEL_SKIN_BINDING_PARTICLE]]->m_pos;
+        unsigned int i = vertex[n];
+        posX[i] = pos.x;
+        posY[i] = pos.y;
+        posZ[i] = pos.z;
+    }
+
+    // other vertices keep their position
+    first = cMax(a_first, m_groupStart[GEL_SKIN_BINDING_NONE]);
+    last = cMin(a_last, m_groupStart[GEL_SKIN_BINDING_NONE+1]);
+    for (unsigned int n=first; n<last; n++)
+    {
+        unsigned int i = vertex[n];
+        const cVector3d& pos = m_vertices[i]->m_localPos;
+        posX[i] = pos.x;
+        posY[i] = pos.y;
+        posZ[i] = pos.z;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the unit normal of a range of triangles, as in
+    cMesh::computeAllNormals(). Degenerate triangles get a zero normal.
+
+    \fn       void cGELSkin::computeTriangleNormals(unsigned int a_first,
+                                                    unsigned int a_last)
+    \param    a_first  Index of the first triangle.
+    \param    a_last  Index following the last triangle.
+*/
+//===========================================================================
+void cGELSkin::computeTriangleNormals(unsigned int a_first,
+                                      unsigned int a_last)
+{
+    const double* posX = &m_pos[0][0];
+    const double* posY = &m_pos[1][0];
+    const double* posZ = &m_pos[2][0];
+
+    for (unsigned int t=a_first; t<a_last; t++)
+    {
+        unsigned int i0 = m_triangleVertex[0][t];
+        unsigned int i1 = m_triangleVertex[1][t];
+        unsigned int i2 = m_triangleVertex[2][t];
+
+        // compute normal vector
+        cVector3d v01(posX[i1] - posX[i0], posY[i1] - posY[i0], posZ[i1] - posZ[i0]);
+        cVector3d v02(posX[i2] - posX[i0], posY[i2] - posY[i0], posZ[i2] - posZ[i0]);
+        cVector3d normal;
+        v01.crossr(v02, normal);
+        double length = normal.length();
+        if (length > CHAI_GEL_SKIN_MIN_NORMAL_LENGTH)
+        {
+            normal.div(length);
+        }
+        else
+        {
+            normal.zero();
+        }
+        m_triangleNormal[t] = normal;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the normal of each vertex of a range of blocks by summing the
+    normals of its triangles in their order, and write the position and
+    normal of the vertex to the mesh. A block is marked as modified if the
+    position or normal of any of its vertices changes. Vertices without
+    triangles keep their normal.
+
+    \fn       void cGELSkin::writeBlocks(unsigned int a_first,
+                                         unsigned int a_last)
+    \param    a_first  Index of the first block.
+    \param    a_last  Index following the last block.
+*/
+//===========================================================================
+void cGELSkin::writeBlocks(unsigned int a_first,
+                           unsigned int a_last)
+{
+    unsigned int numVertices = (unsigned int)m_vertices.size();
+    const unsigned int* triangleOffsets = &m_vertexTriangleOffsets[0];
+    const unsigned int* triangles = m_vertexTriangles.empty() ? NULL : &m_vertexTriangles[0];
+    const cVector3d* triangleNormal = m_triangleNormal.empty() ? NULL : &m_triangleNormal[0];
+
+    for (unsigned int b=a_first; b<a_last; b++)
+    {
+        unsigned int first = b * CHAI_GEL_SKIN_BLOCK_SIZE;
+        unsigned int last = cMin(first + CHAI_GEL_SKIN_BLOCK_SIZE, numVertices);
+        bool modified = false;
+
+        for (unsigned int i=first; i<last; i++)
+        {
+            cVertex* vertex = m_vertices[i];
+            cVector3d pos(m_pos[0][i], m_pos[1][i], m_pos[2][i]);
+            if (!vertex->m_localPos.equals(pos))
+            {
+                vertex->m_localPos = pos;
+                modified = true;
+            }
+
+            // sum normals of triangles
+            unsigned int end = triangleOffsets[i + 1];
+            if (triangleOffsets[i] < end)
+            {
+                cVector3d normal(0.0, 0.0, 0.0);
+                for (unsigned int j=triangleOffsets[i]; j<end; j++)
+                {
+                    normal.add(triangleNormal[triangles[j]]);
+                }
+                if (normal.lengthsq() > CHAI_SMALL)
+                {
+                    normal.normalize();
+                }
+                if (!vertex->m_normal.equals(normal))
+                {
+                    vertex->m_normal = normal;
+                    modified = true;
+                }
+            }
+        }
+
+        if (modified)
+        {
+            m_blockDirty[b] = 1;
+        }
+    }
+}
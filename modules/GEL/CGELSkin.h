@@ -0,0 +1,310 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CGELSkinH
+#define CGELSkinH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include "CGELSkeletonNode.h"
+#include "CGELSkeletonLink.h"
+#include "CGELMassParticle.h"
+#include <vector>
+#include <map>
+//---------------------------------------------------------------------------
+using std::vector;
+using std::map;
+//---------------------------------------------------------------------------
+class cGELMesh;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CGELSkin.h
+
+    \brief
+    <b> GEL Module </b> \n
+    Packed Skin of a Deformable Mesh.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cGELSkinRange
+    \ingroup    GEL
+
+    \brief
+    cGELSkinRange is a range of consecutive vertices of a cGELSkin.
+*/
+//===========================================================================
+struct cGELSkinRange
+{
+    //! Index of the first vertex of the range.
+    unsigned int m_first;
+
+    //! Number of vertices of the range.
+    unsigned int m_count;
+};
+
+
+//===========================================================================
+/*!
+    \enum       cGELSkinBinding
+    \ingroup    GEL
+
+    \brief
+    Ways in which the vertices of a cGELSkin are positioned.
+*/
+//===========================================================================
+enum cGELSkinBinding
+{
+    GEL_SKIN_BINDING_NODE,
+    GEL_SKIN_BINDING_LINK,
+    GEL_SKIN_BINDING_INFLUENCES,
+    GEL_SKIN_BINDING_PARTICLE,
+    GEL_SKIN_BINDING_NONE,
+    GEL_SKIN_NUM_BINDINGS
+};
+
+
+//===========================================================================
+/*!
+    \class      cGELSkin
+    \ingroup    GEL
+
+    \brief
+    cGELSkin updates the vertices of a cGELMesh from its skeleton or its
+    mass particles, and tracks which of them have been modified, so that
+    only these are copied to the graphics card again. \n
+
+    The vertices are sorted by the way they are positioned: by a single
+    skeleton node, by a single link, by several nodes and links, or by
+    their mass particle. Each group is stored in contiguous arrays, one
+    array per coordinate, and is updated by a loop without branches on the
+    type of each vertex. The frames of the nodes and links are read once
+    per update. Normals are then recomputed as in cMesh::computeAllNormals(),
+    each vertex summing the normals of its triangles in their order, so
+    that the vertices may be split between the threads of a cThreadPool
+    with results identical to those computed on a single thread. \n
+
+    The vertices are in the order of cGELMesh::m_gelVertices, and are
+    divided into blocks. A block is marked as modified when the position
+    or normal of any of its vertices changes. getDirtyRanges() returns the modified
+    vertices as ranges of whole blocks, so that only these ranges need be
+    copied again, until clearDirtyRanges() is called. cGELMesh passes them
+    to the vertex buffer objects of its meshes after each update. \n
+
+    The skin is built again when vertices, triangles or models of the mesh
+    are added or removed. Bindings of vertices changed by hand after
+    connecting them to the skeleton require a call to invalidate().
+*/
+//===========================================================================
+class cGELSkin
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELSkin.
+    cGELSkin();
+
+    //! Destructor of cGELSkin.
+    ~cGELSkin();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Update the vertices and normals of a deformable mesh, building the skin first if needed.
+    void update(cGELMesh* a_mesh);
+
+    //! Build the skin again on the next update.
+    void invalidate() { m_mesh = NULL; }
+
+    //! Get the number of vertices of the skin.
+    unsigned int getNumVertices() const { return ((unsigned int)m_vertices.size()); }
+
+    //! Get the ranges of vertices modified since the last call to clearDirtyRanges().
+    const vector<cGELSkinRange>& getDirtyRanges() const { return (m_dirtyRanges); }
+
+    //! Mark all vertices of the skin as unmodified.
+    void clearDirtyRanges();
+
+    //! Get the number of vertices positioned by a binding.
+    unsigned int getGroupSize(const cGELSkinBinding a_binding) const
+        { return (m_groupStart[a_binding+1] - m_groupStart[a_binding]); }
+
+    //! Set the thread pool used on large meshes, or NULL to compute on the calling thread only.
+    void setThreadPool(cThreadPool* a_threadPool) { m_threadPool = a_threadPool; }
+
+    //! Get the thread pool used on large meshes.
+    cThreadPool* getThreadPool() const { return (m_threadPool); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Sort the vertices of a mesh by binding and collect its triangles.
+    void build(cGELMesh* a_mesh);
+
+    //! Return \b true if vertices, triangles or models of the mesh have changed since it was built.
+    bool isModified(cGELMesh* a_mesh) const;
+
+    //! Add a skeleton node or link to the frames of the skin, if it has no frame yet.
+    void addFrame(cGELSkeletonNode* a_node,
+                  cGELSkeletonLink* a_link,
+                  map<cGELSkeletonNode*, unsigned int>& a_nodes,
+                  map<cGELSkeletonLink*, unsigned int>& a_links);
+
+    //! Read the position and axes of each node and link.
+    void updateFrames();
+
+    //! Split a range of vertices, triangles or blocks into tasks and execute them on the thread pool.
+    void run(void (cGELSkin::*a_function)(unsigned int, unsigned int),
+             unsigned int a_count);
+
+    //! Execute a task of run(). Called by the threads of the pool.
+    static void runTask(void* a_data, unsigned int a_task);
+
+    //! Compute the position of a range of vertices, in the order of their groups.
+    void computePositions(unsigned int a_first, unsigned int a_last);
+
+    //! Compute the normal of a range of triangles.
+    void computeTriangleNormals(unsigned int a_first, unsigned int a_last);
+
+    //! Compute the normals of a range of blocks and write their vertices to the mesh.
+    void writeBlocks(unsigned int a_first, unsigned int a_last);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - MESH:
+    //-----------------------------------------------------------------------
+
+    //! Mesh from which the skin was built, or NULL if it must be built again.
+    cGELMesh* m_mesh;
+
+    //! Number of triangles of the mesh and its children when the skin was built.
+    unsigned int m_numMeshTriangles;
+
+    //! Skeleton model flag of the mesh when the skin was built.
+    bool m_useSkeletonModel;
+
+    //! Mass particle model flag of the mesh when the skin was built.
+    bool m_useMassParticleModel;
+
+    //! Mesh vertices, by index.
+    vector<cVertex*> m_vertices;
+
+    //! Coordinates of position of each vertex.
+    vector<double> m_pos[3];
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - BINDINGS:
+    //-----------------------------------------------------------------------
+
+    //! Index of the first vertex of each group, followed by the number of vertices.
+    unsigned int m_groupStart[GEL_SKIN_NUM_BINDINGS+1];
+
+    //! Index of the vertex at each position of the groups.
+    vector<unsigned int> m_groupVertex;
+
+    //! Frame of each vertex attached to a single node or link, or offset of its first influence in m_influenceFrame.
+    vector<unsigned int> m_groupFrame;
+
+    //! Coordinates of position of each vertex attached to a single node or link, in its frame.
+    vector<double> m_groupLocalPos[3];
+
+    //! Mass particle of each vertex positioned by its particle, from the first of the group.
+    vector<cGELMassParticle*> m_groupParticle;
+
+    //! Frame of each influence of the vertices attached to several nodes or links, followed by the number of influences.
+    vector<unsigned int> m_influenceFrame;
+
+    //! Coordinates of position of each influence, in its frame.
+    vector<double> m_influenceLocalPos[3];
+
+    //! Weight of each influence.
+    vector<double> m_influenceWeight;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - FRAMES:
+    //-----------------------------------------------------------------------
+
+    //! Skeleton nodes of the first frames.
+    vector<cGELSkeletonNode*> m_frameNodes;
+
+    //! Skeleton links of the frames following the nodes.
+    vector<cGELSkeletonLink*> m_frameLinks;
+
+    //! Origin of each frame.
+    vector<cVector3d> m_frameOrigin;
+
+    //! Axes of each frame: the columns of the rotation of a node, or the axes of a link.
+    vector<cVector3d> m_frameAxis[3];
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - TRIANGLES:
+    //-----------------------------------------------------------------------
+
+    //! Index of vertex 0, 1 and 2 of each triangle.
+    vector<unsigned int> m_triangleVertex[3];
+
+    //! Unit normal of each triangle, or zero if the triangle is degenerate.
+    vector<cVector3d> m_triangleNormal;
+
+    //! Offset of the first triangle of each vertex in m_vertexTriangles, followed by the size of m_vertexTriangles.
+    vector<unsigned int> m_vertexTriangleOffsets;
+
+    //! Triangles of each vertex, in the order of the triangles.
+    vector<unsigned int> m_vertexTriangles;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - MODIFIED VERTICES:
+    //-----------------------------------------------------------------------
+
+    //! If nonzero, a vertex of the block has changed since the last call to clearDirtyRanges().
+    vector<unsigned char> m_blockDirty;
+
+    //! Ranges of vertices of the modified blocks.
+    vector<cGELSkinRange> m_dirtyRanges;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - THREADS:
+    //-----------------------------------------------------------------------
+
+    //! Thread pool used on large meshes.
+    cThreadPool* m_threadPool;
+
+    //! Function executed by the tasks of run().
+    void (cGELSkin::*m_taskFunction)(unsigned int, unsigned int);
+
+    //! Number of vertices, triangles or blocks processed by run().
+    unsigned int m_taskCount;
+
+    //! Number of tasks of run().
+    unsigned int m_numTasks;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,186 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CGELSpatialHash.h"
+#include <math.h>
+//---------------------------------------------------------------------------
+//! Minimum number of buckets per point of the table.
+#define CHAI_GEL_HASH_BUCKETS_PER_POINT 2
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cGELSpatialHash.
+
+    \fn       cGELSpatialHash::cGELSpatialHash()
+*/
+//===========================================================================
+cGELSpatialHash::cGELSpatialHash()
+{
+    m_cellSize = 1.0;
+    m_rebuild = true;
+    m_mask = 0;
+    m_numMovedPoints = 0;
+    m_head.push_back(CHAI_GEL_HASH_END);
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELSpatialHash.
+
+    \fn       cGELSpatialHash::~cGELSpatialHash()
+*/
+//===========================================================================
+cGELSpatialHash::~cGELSpatialHash()
+{
+}
+
+
+//===========================================================================
+/*!
+    Set the size of the cells of the grid.
+
+    \fn       void cGELSpatialHash::setCellSize(const double a_cellSize)
+    \param    a_cellSize  Size of the cells, greater than zero.
+*/
+//===========================================================================
+void cGELSpatialHash::setCellSize(const double a_cellSize)
+{
+    if (a_cellSize != m_cellSize)
+    {
+        m_cellSize = a_cellSize;
+        m_rebuild = true;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Sort the points into the cells of their new positions. Points keep
+    their index from one update to the next; only those which have moved
+    to another bucket are moved between lists.
+
+    \fn       void cGELSpatialHash::update(const vector<cVector3d>& a_positions)
+    \param    a_positions  Position of each point.
+*/
+//===========================================================================
+void cGELSpatialHash::update(const vector<cVector3d>& a_positions)
+{
+    unsigned int numPoints = (unsigned int)a_positions.size();
+
+    if (m_rebuild || (numPoints != m_next.size()))
+    {
+        // size the table to a power of two
+        unsigned int numBuckets = 1;
+        while (numBuckets < CHAI_GEL_HASH_BUCKETS_PER_POINT * numPoints)
+        {
+            numBuckets *= 2;
+        }
+        m_mask = numBuckets - 1;
+        m_head.assign(numBuckets, CHAI_GEL_HASH_END);
+        m_next.resize(numPoints);
+        m_buckets.resize(numPoints);
+        m_cells.resize(3 * numPoints);
+
+        // insert points in reverse order, so that each list is sorted by index
+        for (unsigned int i=numPoints; i>0; i--)
+        {
+            unsigned int point = i - 1;
+            computeCell(a_positions[point], &m_cells[3*point]);
+            m_buckets[point] = computeBucket(&m_cells[3*point]);
+            insert(point, m_buckets[point]);
+        }
+
+        m_numMovedPoints = numPoints;
+        m_rebuild = false;
+        return;
+    }
+
+    m_numMovedPoints = 0;
+    for (unsigned int i=0; i<numPoints; i++)
+    {
+        int* cell = &m_cells[3*i];
+        computeCell(a_positions[i], cell);
+        unsigned int bucket = computeBucket(cell);
+        if (bucket != m_buckets[i])
+        {
+            remove(i, m_buckets[i]);
+            insert(i, bucket);
+            m_buckets[i] = bucket;
+            m_numMovedPoints++;
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Compute the integer coordinates of the cell of the grid containing a
+    position.
+
+    \fn       void cGELSpatialHash::computeCell(const cVector3d& a_position,
+                                              int* a_cell) const
+    \param    a_position  Position.
+    \param    a_cell  Returned coordinates of the cell.
+*/
+//===========================================================================
+void cGELSpatialHash::computeCell(const cVector3d& a_position,
+                                  int* a_cell) const
+{
+    double scale = 1.0 / m_cellSize;
+    a_cell[0] = (int)floor(scale * a_position.x);
+    a_cell[1] = (int)floor(scale * a_position.y);
+    a_cell[2] = (int)floor(scale * a_position.z);
+}
+
+
+//===========================================================================
+/*!
+    Insert a point at the head of the list of a bucket.
+
+    \fn       void cGELSpatialHash::insert(const unsigned int a_point,
+                                         const unsigned int a_bucket)
+    \param    a_point  Index of the point.
+    \param    a_bucket  Index of the bucket.
+*/
+//===========================================================================
+void cGELSpatialHash::insert(const unsigned int a_point,
+                             const unsigned int a_bucket)
+{
+    m_next[a_point] = m_head[a_bucket];
+    m_head[a_bucket] = a_point;
+}
+
+
+//===========================================================================
+/*!
+    Remove a point from the list of a bucket. Buckets hold few points, so
+    the point preceding it is found by walking the list.
+
+    \fn       void cGELSpatialHash::remove(const unsigned int a_point,
+                                         const unsigned int a_bucket)
+    \param    a_point  Index of the point.
+    \param    a_bucket  Index of the bucket holding the point.
+*/
+//===========================================================================
+void cGELSpatialHash::remove(const unsigned int a_point,
+                             const unsigned int a_bucket)
+{
+    unsigned int* link = &m_head[a_bucket];
+    while (*link != a_point)
+    {
+        link = &m_next[*link];
+    }
+    *link = m_next[a_point];
+}
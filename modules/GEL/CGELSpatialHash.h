@@ -0,0 +1,164 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CGELSpatialHashH
+#define CGELSpatialHashH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CGELSpatialHash.h
+
+    \brief
+    <b> GEL Module </b> \n
+    Spatial Hashing of Points.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Index marking the end of the list of points of a bucket of a cGELSpatialHash.
+#define CHAI_GEL_HASH_END   0xffffffff
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \class      cGELSpatialHash
+    \ingroup    GEL
+
+    \brief
+    cGELSpatialHash sorts points into the cells of an unbounded uniform
+    grid. Cells are mapped to the buckets of a table by a hash function of
+    their coordinates, so that memory depends on the number of points only.
+    Several cells may share a bucket; the points of a cell are told apart
+    from the others of its bucket by their cell coordinates. \n
+
+    update() is called with new positions of the points at each simulation
+    step. Each bucket holds a linked list of its points, and only points
+    which have moved to another bucket are moved from list to list. The
+    table is only built again when the number of points or the cell size
+    changes.
+*/
+//===========================================================================
+class cGELSpatialHash
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELSpatialHash.
+    cGELSpatialHash();
+
+    //! Destructor of cGELSpatialHash.
+    ~cGELSpatialHash();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Set the size of the cells. The table is built again on the next update.
+    void setCellSize(const double a_cellSize);
+
+    //! Get the size of the cells.
+    double getCellSize() const { return (m_cellSize); }
+
+    //! Sort the points into the cells of their new positions.
+    void update(const vector<cVector3d>& a_positions);
+
+    //! Get the number of points.
+    unsigned int getNumPoints() const { return ((unsigned int)m_next.size()); }
+
+    //! Compute the coordinates of the cell containing a position.
+    void computeCell(const cVector3d& a_position, int* a_cell) const;
+
+    //! Get the first point of the bucket of a cell, or CHAI_GEL_HASH_END.
+    unsigned int getFirstPoint(const int* a_cell) const { return (m_head[computeBucket(a_cell)]); }
+
+    //! Get the point following a point in its bucket, or CHAI_GEL_HASH_END.
+    unsigned int getNextPoint(const unsigned int a_point) const { return (m_next[a_point]); }
+
+    //! Return \b true if a point lies in a cell.
+    bool isInCell(const unsigned int a_point, const int* a_cell) const
+    {
+        const int* cell = &m_cells[3*a_point];
+        return ((cell[0] == a_cell[0]) && (cell[1] == a_cell[1]) && (cell[2] == a_cell[2]));
+    }
+
+    //! Get the coordinates of the cell of a point.
+    const int* getCell(const unsigned int a_point) const { return (&m_cells[3*a_point]); }
+
+    //! Get the number of points moved to another bucket by the last update.
+    unsigned int getNumMovedPoints() const { return (m_numMovedPoints); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Compute the bucket of a cell, by multiplying each coordinate by a large prime.
+    unsigned int computeBucket(const int* a_cell) const
+    {
+        unsigned int hash = ((unsigned int)a_cell[0] * 73856093u) ^
+                            ((unsigned int)a_cell[1] * 19349663u) ^
+                            ((unsigned int)a_cell[2] * 83492791u);
+        return (hash & m_mask);
+    }
+
+    //! Insert a point at the head of the list of a bucket.
+    void insert(const unsigned int a_point, const unsigned int a_bucket);
+
+    //! Remove a point from the list of a bucket.
+    void remove(const unsigned int a_point, const unsigned int a_bucket);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Size of the cells.
+    double m_cellSize;
+
+    //! If \b true, the table is built again on the next update.
+    bool m_rebuild;
+
+    //! First point of each bucket.
+    vector<unsigned int> m_head;
+
+    //! Point following each point in its bucket.
+    vector<unsigned int> m_next;
+
+    //! Bucket of each point.
+    vector<unsigned int> m_buckets;
+
+    //! Coordinates of the cell of each point, three per point.
+    vector<int> m_cells;
+
+    //! Number of buckets minus one; the number of buckets is a power of two.
+    unsigned int m_mask;
+
+    //! Number of points moved to another bucket by the last update.
+    unsigned int m_numMovedPoints;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,614 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CGELTetrahedralIndex.h"
+//---------------------------------------------------------------------------
+#include <algorithm>
+//---------------------------------------------------------------------------
+//! Maximum number of elements of a leaf of a cGELBoundingTree.
+#define CHAI_GEL_TREE_LEAF_SIZE 4
+
+//! Maximum depth of a cGELBoundingTree, which the median split keeps near the logarithm of the number of elements.
+#define CHAI_GEL_TREE_MAX_DEPTH 64
+
+//! Tolerance on the barycentric coordinates of a point inside a tetrahedron.
+#define CHAI_GEL_TETRAHEDRON_TOLERANCE 0.000000001
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cGELCenterLess
+    \ingroup    GEL
+
+    \brief
+    cGELCenterLess orders elements by the coordinate of their center
+    along an axis.
+*/
+//===========================================================================
+struct cGELCenterLess
+{
+    //! Center of each element.
+    const vector<cVector3d>* m_centers;
+
+    //! Axis along which centers are compared.
+    int m_axis;
+
+    //! Return \b true if the center of element \e a_i is before that of element \e a_j.
+    bool operator()(const unsigned int a_i, const unsigned int a_j) const
+    {
+        double ci = (*m_centers)[a_i].get(m_axis);
+        double cj = (*m_centers)[a_j].get(m_axis);
+        return ((ci < cj) || ((ci == cj) && (a_i < a_j)));
+    }
+};
+
+
+//===========================================================================
+/*!
+    Compute the square of the distance from a point to a box.
+
+    \fn       double computeBoxDistanceSq(const cVector3d& a_point,
+                                    const cGELBoundingTreeNode& a_node)
+    \param    a_point  Point.
+    \param    a_node  Node of the box.
+    \return   Return the square of the distance, zero if the point is inside.
+*/
+//===========================================================================
+static double computeBoxDistanceSq(const cVector3d& a_point,
+                                   const cGELBoundingTreeNode& a_node)
+{
+    double distanceSq = 0.0;
+    for (int k=0; k<3; k++)
+    {
+        double value = a_point.get(k);
+        double d = 0.0;
+        if (value < a_node.m_min.get(k)) { d = a_node.m_min.get(k) - value; }
+        else if (value > a_node.m_max.get(k)) { d = value - a_node.m_max.get(k); }
+        distanceSq += d * d;
+    }
+    return (distanceSq);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cGELBoundingTree.
+
+    \fn       cGELBoundingTree::cGELBoundingTree()
+*/
+//===========================================================================
+cGELBoundingTree::cGELBoundingTree()
+{
+    m_verticesPerElement = 1;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELBoundingTree.
+
+    \fn       cGELBoundingTree::~cGELBoundingTree()
+*/
+//===========================================================================
+cGELBoundingTree::~cGELBoundingTree()
+{
+}
+
+
+//===========================================================================
+/*!
+    Build the hierarchy over a set of elements. Each element is given by
+    \e a_verticesPerElement consecutive vertex indices.
+
+    \fn       void cGELBoundingTree::build(const vector<cVector3d>& a_positions,
+                                         const vector<unsigned int>& a_elementVertices,
+                                         const unsigned int a_verticesPerElement)
+    \param    a_positions  Position of each vertex.
+    \param    a_elementVertices  Vertices of each element.
+    \param    a_verticesPerElement  Number of vertices of each element.
+*/
+//===========================================================================
+void cGELBoundingTree::build(const vector<cVector3d>& a_positions,
+                             const vector<unsigned int>& a_elementVertices,
+                             const unsigned int a_verticesPerElement)
+{
+    m_verticesPerElement = a_verticesPerElement;
+    unsigned int numElements = (unsigned int)a_elementVertices.size() / m_verticesPerElement;
+
+    m_nodes.clear();
+    m_elements.resize(numElements);
+    m_elementVertices.resize(numElements * m_verticesPerElement);
+    if (numElements == 0) { return; }
+
+    // compute the center of each element
+    vector<cVector3d> centers(numElements);
+    for (unsigned int i=0; i<numElements; i++)
+    {
+        cVector3d center(0.0, 0.0, 0.0);
+        for (unsigned int k=0; k<m_verticesPerElement; k++)
+        {
+            center.add(a_positions[a_elementVertices[m_verticesPerElement * i + k]]);
+        }
+        center.div((double)m_verticesPerElement);
+        centers[i] = center;
+        m_elements[i] = i;
+    }
+
+    // split elements recursively
+    m_nodes.reserve(2 * numElements);
+    m_nodes.resize(1);
+    buildNode(0, 0, numElements, centers);
+
+    // store vertices of the elements in the order of the leaves
+    for (unsigned int i=0; i<numElements; i++)
+    {
+        for (unsigned int k=0; k<m_verticesPerElement; k++)
+        {
+            m_elementVertices[m_verticesPerElement * i + k] =
+                a_elementVertices[m_verticesPerElement * m_elements[i] + k];
+        }
+    }
+
+    refit(a_positions);
+}
+
+
+//===========================================================================
+/*!
+    Build the subtree of a node over a range of elements, splitting the
+    range at the median of the centers along the axis on which they are
+    the most spread.
+
+    \fn       void cGELBoundingTree::buildNode(const unsigned int a_node,
+                                             const unsigned int a_first,
+                                             const unsigned int a_last,
+                                             const vector<cVector3d>& a_centers)
+    \param    a_node  Index of the node.
+    \param    a_first  Index of the first element.
+    \param    a_last  Index following the last element.
+    \param    a_centers  Center of each element.
+*/
+//===========================================================================
+void cGELBoundingTree::buildNode(const unsigned int a_node,
+                                 const unsigned int a_first,
+                                 const unsigned int a_last,
+                                 const vector<cVector3d>& a_centers)
+{
+    // leaf
+    if (a_last - a_first <= CHAI_GEL_TREE_LEAF_SIZE)
+    {
+        m_nodes[a_node].m_first = a_first;
+        m_nodes[a_node].m_count = a_last - a_first;
+        return;
+    }
+
+    // select the axis on which the centers are the most spread
+    cVector3d lower = a_centers[m_elements[a_first]];
+    cVector3d upper = lower;
+    for (unsigned int i=a_first+1; i<a_last; i++)
+    {
+        const cVector3d& center = a_centers[m_elements[i]];
+        lower.set(cMin(lower.x, center.x), cMin(lower.y, center.y), cMin(lower.z, center.z));
+        upper.set(cMax(upper.x, center.x), cMax(upper.y, center.y), cMax(upper.z, center.z));
+    }
+    cVector3d size = cSub(upper, lower);
+    int axis = 0;
+    if (size.y > size.get(axis)) { axis = 1; }
+    if (size.z > size.get(axis)) { axis = 2; }
+
+    // split at the median
+    unsigned int middle = (a_first + a_last) / 2;
+    cGELCenterLess less;
+    less.m_centers = &a_centers;
+    less.m_axis = axis;
+    std::nth_element(m_elements.begin() + a_first,
+                     m_elements.begin() + middle,
+                     m_elements.begin() + a_last,
+                     less);
+
+    // children are stored together after their parent
+    unsigned int child = (unsigned int)m_nodes.size();
+    m_nodes.resize(child + 2);
+    m_nodes[a_node].m_first = child;
+    m_nodes[a_node].m_count = 0;
+
+    buildNode(child, a_first, middle, a_centers);
+    buildNode(child + 1, middle, a_last, a_centers);
+}
+
+
+//===========================================================================
+/*!
+    Compute the box of the vertices of a range of elements.
+
+    \fn       void cGELBoundingTree::computeBox(const unsigned int a_first,
+                                              const unsigned int a_last,
+                                              const vector<cVector3d>& a_positions,
+                                              cVector3d& a_min,
+                                              cVector3d& a_max) const
+    \param    a_first  Position of the first element in the leaves.
+    \param    a_last  Position following the last element.
+    \param    a_positions  Position of each vertex.
+    \param    a_min  Returned minimum corner of the box.
+    \param    a_max  Returned maximum corner of the box.
+*/
+//===========================================================================
+void cGELBoundingTree::computeBox(const unsigned int a_first,
+                                  const unsigned int a_last,
+                                  const vector<cVector3d>& a_positions,
+                                  cVector3d& a_min,
+                                  cVector3d& a_max) const
+{
+    const unsigned int* vertices = &m_elementVertices[m_verticesPerElement * a_first];
+    unsigned int numVertices = m_verticesPerElement * (a_last - a_first);
+
+    a_min = a_positions[vertices[0]];
+    a_max = a_min;
+    for (unsigned int i=1; i<numVertices; i++)
+    {
+        const cVector3d& pos = a_positions[vertices[i]];
+        a_min.set(cMin(a_min.x, pos.x), cMin(a_min.y, pos.y), cMin(a_min.z, pos.z));
+        a_max.set(cMax(a_max.x, pos.x), cMax(a_max.y, pos.y), cMax(a_max.z, pos.z));
+    }
+}
+
+
+//===========================================================================
+/*!
+    Refit the boxes of the hierarchy to new vertex positions. The boxes of
+    the leaves are computed from their elements, and those of the
+    internal nodes from their children.
+
+    \fn       void cGELBoundingTree::refit(const vector<cVector3d>& a_positions)
+    \param    a_positions  Position of each vertex.
+*/
+//===========================================================================
+void cGELBoundingTree::refit(const vector<cVector3d>& a_positions)
+{
+    unsigned int numNodes = (unsigned int)m_nodes.size();
+    for (unsigned int i=numNodes; i>0; i--)
+    {
+        cGELBoundingTreeNode& node = m_nodes[i-1];
+        if (node.m_count > 0)
+        {
+            computeBox(node.m_first, node.m_first + node.m_count, a_positions, node.m_min, node.m_max);
+        }
+        else
+        {
+            const cGELBoundingTreeNode& child0 = m_nodes[node.m_first];
+            const cGELBoundingTreeNode& child1 = m_nodes[node.m_first + 1];
+            node.m_min.set(cMin(child0.m_min.x, child1.m_min.x),
+                           cMin(child0.m_min.y, child1.m_min.y),
+                           cMin(child0.m_min.z, child1.m_min.z));
+            node.m_max.set(cMax(child0.m_max.x, child1.m_max.x),
+                           cMax(child0.m_max.y, child1.m_max.y),
+                           cMax(child0.m_max.z, child1.m_max.z));
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cGELTetrahedralIndex.
+
+    \fn       cGELTetrahedralIndex::cGELTetrahedralIndex()
+*/
+//===========================================================================
+cGELTetrahedralIndex::cGELTetrahedralIndex()
+{
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cGELTetrahedralIndex.
+
+    \fn       cGELTetrahedralIndex::~cGELTetrahedralIndex()
+*/
+//===========================================================================
+cGELTetrahedralIndex::~cGELTetrahedralIndex()
+{
+}
+
+
+//===========================================================================
+/*!
+    Build the index over the vertices, tetrahedra and surface triangles of
+    a body. Tetrahedra are given by four vertex indices each, and triangles
+    by three.
+
+    \fn       void cGELTetrahedralIndex::build(const vector<cVector3d>& a_positions,
+                                             const vector<unsigned int>& a_tetrahedra,
+                                             const vector<unsigned int>& a_triangles)
+    \param    a_positions  Position of each vertex.
+    \param    a_tetrahedra  Vertices of each tetrahedron.
+    \param    a_triangles  Vertices of each surface triangle.
+*/
+//===========================================================================
+void cGELTetrahedralIndex::build(const vector<cVector3d>& a_positions,
+                                 const vector<unsigned int>& a_tetrahedra,
+                                 const vector<unsigned int>& a_triangles)
+{
+    m_positions = a_positions;
+
+    vector<unsigned int> vertices(a_positions.size());
+    for (unsigned int i=0; i<vertices.size(); i++)
+    {
+        vertices[i] = i;
+    }
+
+    m_tetrahedronTree.build(m_positions, a_tetrahedra, 4);
+    m_triangleTree.build(m_positions, a_triangles, 3);
+    m_vertexTree.build(m_positions, vertices, 1);
+}
+
+
+//===========================================================================
+/*!
+    Refit the index to new positions of the vertices. The number of
+    vertices must not have changed since build().
+
+    \fn       void cGELTetrahedralIndex::refit(const vector<cVector3d>& a_positions)
+    \param    a_positions  Position of each vertex.
+*/
+//===========================================================================
+void cGELTetrahedralIndex::refit(const vector<cVector3d>& a_positions)
+{
+    m_positions = a_positions;
+
+    m_tetrahedronTree.refit(m_positions);
+    m_triangleTree.refit(m_positions);
+    m_vertexTree.refit(m_positions);
+}
+
+
+//===========================================================================
+/*!
+    Find the tetrahedron containing a point. If several tetrahedra contain
+    the point, as on a shared face, the first one found is returned.
+
+    \fn       int cGELTetrahedralIndex::findTetrahedron(const cVector3d& a_point,
+                                                      double* a_weights) const
+    \param    a_point  Point.
+    \param    a_weights  If not NULL, returns the barycentric coordinates
+              of the point with respect to the four vertices.
+    \return   Return the index of the tetrahedron, or -1 if the point is
+              outside the body.
+*/
+//===========================================================================
+int cGELTetrahedralIndex::findTetrahedron(const cVector3d& a_point,
+                                          double* a_weights) const
+{
+    if (m_tetrahedronTree.getNumNodes() == 0) { return (-1); }
+
+    unsigned int stack[CHAI_GEL_TREE_MAX_DEPTH];
+    unsigned int numStack = 0;
+    stack[numStack++] = 0;
+
+    while (numStack > 0)
+    {
+        const cGELBoundingTreeNode& node = m_tetrahedronTree.getNode(stack[--numStack]);
+        if (computeBoxDistanceSq(a_point, node) > 0.0) { continue; }
+
+        if (node.m_count == 0)
+        {
+            stack[numStack++] = node.m_first + 1;
+            stack[numStack++] = node.m_first;
+            continue;
+        }
+
+        for (unsigned int i=node.m_first; i<node.m_first+node.m_count; i++)
+        {
+            const unsigned int* vertices = m_tetrahedronTree.getElementVertices(i);
+            const cVector3d& v0 = m_positions[vertices[0]];
+            cVector3d edge1 = cSub(m_positions[vertices[1]], v0);
+            cVector3d edge2 = cSub(m_positions[vertices[2]], v0);
+            cVector3d edge3 = cSub(m_positions[vertices[3]], v0);
+            cVector3d q = cSub(a_point, v0);
+
+            // skip flat tetrahedra
+            double volume = cDot(edge1, cCross(edge2, edge3));
+            if (cAbs(volume) < CHAI_SMALL) { continue; }
+
+            // barycentric coordinates by ratios of volumes
+            double w1 = cDot(q, cCross(edge2, edge3)) / volume;
+            double w2 = cDot(edge1, cCross(q, edge3)) / volume;
+            double w3 = cDot(edge1, cCross(edge2, q)) / volume;
+            double w0 = 1.0 - w1 - w2 - w3;
+
+            if ((w0 >= -CHAI_GEL_TETRAHEDRON_TOLERANCE) &&
+                (w1 >= -CHAI_GEL_TETRAHEDRON_TOLERANCE) &&
+                (w2 >= -CHAI_GEL_TETRAHEDRON_TOLERANCE) &&
+                (w3 >= -CHAI_GEL_TETRAHEDRON_TOLERANCE))
+            {
+                if (a_weights != NULL)
+                {
+                    a_weights[0] = w0;
+                    a_weights[1] = w1;
+                    a_weights[2] = w2;
+                    a_weights[3] = w3;
+                }
+                return ((int)m_tetrahedronTree.getElement(i));
+            }
+        }
+    }
+
+    return (-1);
+}
+
+
+//===========================================================================
+/*!
+    Find the closest point of the surface triangles to a point. Nodes are
+    visited nearest first, and skipped when their box is farther than the
+    closest point found.
+
+    \fn       bool cGELTetrahedralIndex::findClosestSurfacePoint(const cVector3d& a_point,
+                                                               cVector3d& a_closestPoint,
+                                                               unsigned int& a_triangle) const
+    \param    a_point  Point.
+    \param    a_closestPoint  Returned closest point of the surface.
+    \param    a_triangle  Returned index of the triangle of the closest point.
+    \return   Return \b false if the index has no triangles.
+*/
+//===========================================================================
+bool cGELTetrahedralIndex::findClosestSurfacePoint(const cVector3d& a_point,
+                                                   cVector3d& a_closestPoint,
+                                                   unsigned int& a_triangle) const
+{
+    if (m_triangleTree.getNumNodes() == 0) { return (false); }
+
+    double bestDistanceSq = CHAI_LARGE;
+    unsigned int stack[CHAI_GEL_TREE_MAX_DEPTH];
+    unsigned int numStack = 0;
+    stack[numStack++] = 0;
+
+    while (numStack > 0)
+    {
+        const cGELBoundingTreeNode& node = m_triangleTree.getNode(stack[--numStack]);
+        if (computeBoxDistanceSq(a_point, node) >= bestDistanceSq) { continue; }
+
+        if (node.m_count == 0)
+        {
+            // visit nearest child first
+            unsigned int child0 = node.m_first;
+            unsigned int child1 = node.m_first + 1;
+            if (computeBoxDistanceSq(a_point, m_triangleTree.getNode(child0)) >
+                computeBoxDistanceSq(a_point, m_triangleTree.getNode(child1)))
+            {
+                cSwap(child0, child1);
+            }
+            stack[numStack++] = child1;
+            stack[numStack++] = child0;
+            continue;
+        }
+
+        for (unsigned int i=node.m_first; i<node.m_first+node.m_count; i++)
+        {
+            const unsigned int* vertices = m_triangleTree.getElementVertices(i);
+            cVector3d point = cProjectPointOnTriangle(a_point,
+                                                      m_positions[vertices[0]],
+                                                      m_positions[vertices[1]],
+                                                      m_positions[vertices[2]]);
+            double distanceSq = cDistanceSq(a_point, point);
+            if (distanceSq < bestDistanceSq)
+            {
+                bestDistanceSq = distanceSq;
+                a_closestPoint = point;
+                a_triangle = m_triangleTree.getElement(i);
+            }
+        }
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Find the vertices nearest to a point, within a maximum distance.
+    Vertices at equal distance are ordered by index.
+
+    \fn       unsigned int cGELTetrahedralIndex::findNearestVertices(const cVector3d& a_point,
+                                                                   const unsigned int a_maxResults,
+                                                                   const double a_maxDistance,
+                                                                   unsigned int* a_vertices,
+                                                                   double* a_distances) const
+    \param    a_point  Point.
+    \param    a_maxResults  Maximum number of vertices returned.
+    \param    a_maxDistance  Maximum distance of the vertices returned.
+    \param    a_vertices  Returned indices of the vertices, by increasing distance.
+    \param    a_distances  Returned distance of each vertex.
+    \return   Return the number of vertices found.
+*/
+//===========================================================================
+unsigned int cGELTetrahedralIndex::findNearestVertices(const cVector3d& a_point,
+                                                       const unsigned int a_maxResults,
+                                                       const double a_maxDistance,
+                                                       unsigned int* a_vertices,
+                                                       double* a_distances) const
+{
+    if ((m_vertexTree.getNumNodes() == 0) || (a_maxResults == 0)) { return (0); }
+
+    // squared distances of the results are kept sorted until the search completes
+    double* distancesSq = a_distances;
+    unsigned int numResults = 0;
+    double maxDistanceSq = a_maxDistance * a_maxDistance;
+
+    unsigned int stack[CHAI_GEL_TREE_MAX_DEPTH];
+    unsigned int numStack = 0;
+    stack[numStack++] = 0;
+
+    while (numStack > 0)
+    {
+        const cGELBoundingTreeNode& node = m_vertexTree.getNode(stack[--numStack]);
+        if (computeBoxDistanceSq(a_point, node) > maxDistanceSq) { continue; }
+
+        if (node.m_count == 0)
+        {
+            // visit nearest child first
+            unsigned int child0 = node.m_first;
+            unsigned int child1 = node.m_first + 1;
+            if (computeBoxDistanceSq(a_point, m_vertexTree.getNode(child0)) >
+                computeBoxDistanceSq(a_point, m_vertexTree.getNode(child1)))
+            {
+                cSwap(child0, child1);
+            }
+            stack[numStack++] = child1;
+            stack[numStack++] = child0;
+            continue;
+        }
+
+        for (unsigned int i=node.m_first; i<node.m_first+node.m_count; i++)
+        {
+            unsigned int vertex = m_vertexTree.getElementVertices(i)[0];
+            double distanceSq = cDistanceSq(a_point, m_positions[vertex]);
+            if (distanceSq > maxDistanceSq) { continue; }
+
+            // results are full and this vertex comes after the last one
+            if ((numResults == a_maxResults) &&
+                ((distanceSq > distancesSq[numResults-1]) ||
+                 ((distanceSq == distancesSq[numResults-1]) && (vertex > a_vertices[numResults-1]))))
+            {
+                continue;
+            }
+
+            // insert vertex in sorted results
+            unsigned int j = (numResults < a_maxResults) ? numResults++ : (numResults - 1);
+            while ((j > 0) &&
+                   ((distancesSq[j-1] > distanceSq) ||
+                    ((distancesSq[j-1] == distanceSq) && (a_vertices[j-1] > vertex))))
+            {
+                distancesSq[j] = distancesSq[j-1];
+                a_vertices[j] = a_vertices[j-1];
+                j--;
+            }
+            distancesSq[j] = distanceSq;
+            a_vertices[j] = vertex;
+
+            // only nearer vertices may now be added
+            if (numResults == a_maxResults)
+            {
+                maxDistanceSq = distancesSq[numResults-1];
+            }
+        }
+    }
+
+    for (unsigned int j=0; j<numResults; j++)
+    {
+        a_distances[j] = sqrt(distancesSq[j]);
+    }
+
+    return (numResults);
+}
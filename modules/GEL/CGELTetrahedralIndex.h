@@ -0,0 +1,251 @@
+//===========================================================================
+/*
+    This file is part of the GEL dynamics engine.
+    Copyright (C) 2003-2009 by Francois Conti, Stanford University.
+    All rights reserved.
+
+    \author    <http://www.chai3d.org>
+    \author    Francois Conti
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CGELTetrahedralIndexH
+#define CGELTetrahedralIndexH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CGELTetrahedralIndex.h
+
+    \brief
+    <b> GEL Module </b> \n
+    Bounding Volume Hierarchies over Tetrahedral Bodies.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cGELBoundingTreeNode
+    \ingroup    GEL
+
+    \brief
+    cGELBoundingTreeNode is a node of a cGELBoundingTree. A leaf holds a
+    range of elements; an internal node has two children stored next to
+    each other.
+*/
+//===========================================================================
+struct cGELBoundingTreeNode
+{
+    //! Minimum corner of the bounding box.
+    cVector3d m_min;
+
+    //! Maximum corner of the bounding box.
+    cVector3d m_max;
+
+    //! Index of the first element of a leaf, or of the first child of an internal node.
+    unsigned int m_first;
+
+    //! Number of elements of a leaf, or zero for an internal node.
+    unsigned int m_count;
+};
+
+
+//===========================================================================
+/*!
+    \class      cGELBoundingTree
+    \ingroup    GEL
+
+    \brief
+    cGELBoundingTree is a bounding volume hierarchy over elements given by
+    a fixed number of vertices: points, triangles or tetrahedra. \n
+
+    The hierarchy is built once by splitting the elements at the median of
+    their centers, and is then refitted to new vertex positions in linear
+    time, keeping its structure, so that it follows a deforming body.
+    Children are stored after their parent, so that refit() updates the
+    boxes in a single pass from the last node to the first.
+*/
+//===========================================================================
+class cGELBoundingTree
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELBoundingTree.
+    cGELBoundingTree();
+
+    //! Destructor of cGELBoundingTree.
+    ~cGELBoundingTree();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the hierarchy over elements given by the indices of their vertices.
+    void build(const vector<cVector3d>& a_positions,
+               const vector<unsigned int>& a_elementVertices,
+               const unsigned int a_verticesPerElement);
+
+    //! Refit the boxes of the hierarchy to new vertex positions.
+    void refit(const vector<cVector3d>& a_positions);
+
+    //! Get the number of elements.
+    unsigned int getNumElements() const { return ((unsigned int)m_elements.size()); }
+
+    //! Get the number of nodes.
+    unsigned int getNumNodes() const { return ((unsigned int)m_nodes.size()); }
+
+    //! Get a node. The root is node 0.
+    const cGELBoundingTreeNode& getNode(const unsigned int a_index) const { return (m_nodes[a_index]); }
+
+    //! Get the index of the element at a position of the leaves.
+    unsigned int getElement(const unsigned int a_position) const { return (m_elements[a_position]); }
+
+    //! Get the vertices of the element at a position of the leaves.
+    const unsigned int* getElementVertices(const unsigned int a_position) const
+        { return (&m_elementVertices[m_verticesPerElement * a_position]); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the subtree of a node over a range of elements.
+    void buildNode(const unsigned int a_node,
+                   const unsigned int a_first,
+                   const unsigned int a_last,
+                   const vector<cVector3d>& a_centers);
+
+    //! Compute the box of the vertices of a range of elements.
+    void computeBox(const unsigned int a_first,
+                    const unsigned int a_last,
+                    const vector<cVector3d>& a_positions,
+                    cVector3d& a_min,
+                    cVector3d& a_max) const;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Nodes of the hierarchy.
+    vector<cGELBoundingTreeNode> m_nodes;
+
+    //! Index of each element, in the order of the leaves.
+    vector<unsigned int> m_elements;
+
+    //! Vertices of each element, in the order of the leaves.
+    vector<unsigned int> m_elementVertices;
+
+    //! Number of vertices of each element.
+    unsigned int m_verticesPerElement;
+};
+
+
+//===========================================================================
+/*!
+    \class      cGELTetrahedralIndex
+    \ingroup    GEL
+
+    \brief
+    cGELTetrahedralIndex locates points in a deformable body made of
+    tetrahedra, such as those generated by TetGen. \n
+
+    The index holds a cGELBoundingTree over the tetrahedra, one over the
+    surface triangles and one over the vertices of the body. It finds the
+    tetrahedron containing a point, the closest point of the surface, and
+    the vertices nearest to a point, in logarithmic time. \n
+
+    build() is called when the elements change, and refit() after the
+    vertices move. Queries do not modify the index and may be run from
+    several threads at once, but not during a call to build() or refit().
+*/
+//===========================================================================
+class cGELTetrahedralIndex
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cGELTetrahedralIndex.
+    cGELTetrahedralIndex();
+
+    //! Destructor of cGELTetrahedralIndex.
+    ~cGELTetrahedralIndex();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the index over vertices, tetrahedra and surface triangles.
+    void build(const vector<cVector3d>& a_positions,
+               const vector<unsigned int>& a_tetrahedra,
+               const vector<unsigned int>& a_triangles);
+
+    //! Refit the index to new positions of the vertices.
+    void refit(const vector<cVector3d>& a_positions);
+
+    //! Find the tetrahedron containing a point, and optionally the barycentric coordinates of the point.
+    int findTetrahedron(const cVector3d& a_point,
+                        double* a_weights = NULL) const;
+
+    //! Find the closest point of the surface triangles to a point.
+    bool findClosestSurfacePoint(const cVector3d& a_point,
+                                 cVector3d& a_closestPoint,
+                                 unsigned int& a_triangle) const;
+
+    //! Find the vertices nearest to a point within a maximum distance, by increasing distance.
+    unsigned int findNearestVertices(const cVector3d& a_point,
+                                     const unsigned int a_maxResults,
+                                     const double a_maxDistance,
+                                     unsigned int* a_vertices,
+                                     double* a_distances) const;
+
+    //! Get the number of vertices.
+    unsigned int getNumVertices() const { return ((unsigned int)m_positions.size()); }
+
+    //! Get the number of tetrahedra.
+    unsigned int getNumTetrahedra() const { return (m_tetrahedronTree.getNumElements()); }
+
+    //! Get the number of surface triangles.
+    unsigned int getNumTriangles() const { return (m_triangleTree.getNumElements()); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Position of each vertex.
+    vector<cVector3d> m_positions;
+
+    //! Hierarchy over the tetrahedra.
+    cGELBoundingTree m_tetrahedronTree;
+
+    //! Hierarchy over the surface triangles.
+    cGELBoundingTree m_triangleTree;
+
+    //! Hierarchy over the vertices.
+    cGELBoundingTree m_vertexTree;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -18,6 +18,9 @@
 #include "CGELSkeletonLink.h"
 #include "CGELSkeletonNode.h"
 #include "chai3d.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -30,6 +33,32 @@
 */
 //===========================================================================
 
+//===========================================================================
+/*!
+    \struct     cGELVertexInfluence
+    \ingroup    GEL
+
+    \brief
+    cGELVertexInfluence is a skeleton node or link to which a vertex is
+    attached, with the position of the vertex in its frame and its weight.
+*/
+//===========================================================================
+struct cGELVertexInfluence
+{
+    //! Skeleton node, or NULL if the influence is a link.
+    cGELSkeletonNode* m_node;
+
+    //! Skeleton link, or NULL if the influence is a node.
+    cGELSkeletonLink* m_link;
+
+    //! Position of the vertex in the frame of the node or link.
+    cVector3d m_pos;
+
+    //! Weight of the influence. The weights of a vertex sum to one.
+    double m_weight;
+};
+
+
 //===========================================================================
 /*!
     \class      cGELVertex
@@ -70,6 +99,9 @@ class cGELVertex
 
     //! Skeleton node to which this vertex may be linked to.
     cGELSkeletonNode* m_node;
+
+    //! Skeleton nodes and links blended to position the vertex, if it is attached to more than one.
+    vector<cGELVertexInfluence> m_influences;
 };
 
 //---------------------------------------------------------------------------
@@ -14,6 +14,221 @@
 #include "CGELWorld.h"
 //---------------------------------------------------------------------------
 
+//===========================================================================
+/*!
+    \struct     cGELWorldStep
+    \ingroup    GEL
+
+    \brief
+    cGELWorldStep holds the deformable objects and parameters of a call to
+    cGELWorld::updateDynamics() or cGELWorld::updateSkins(), shared by the
+    tasks of the thread pool.
+*/
+//===========================================================================
+struct cGELWorldStep
+{
+    //! Deformable objects, one per task.
+    vector<cGELMesh*> m_meshes;
+
+    //! Thread pool, or NULL.
+    cThreadPool* m_threadPool;
+
+    //! Integration method of the mass particle models.
+    cGELIntegrator m_integrator;
+
+    //! Integration time step.
+    double m_timeInterval;
+
+    //! Relative residual at which the solver of the implicit integrator stops.
+    double m_solverTolerance;
+
+    //! Maximum number of iterations of the solver of the implicit integrator.
+    unsigned int m_solverMaxIterations;
+};
+
+
+//===========================================================================
+/*!
+    Execute a stage of a time step for each deformable object, on the
+    thread pool if there is more than one object.
+
+    \fn       void runStage(cGELWorldStep& a_step, cThreadPoolFunction a_function)
+    \param    a_step  Objects and parameters of the time step.
+    \param    a_function  Function executing the stage for one object.
+*/
+//===========================================================================
+static void runStage(cGELWorldStep& a_step, cThreadPoolFunction a_function)
+{
+    unsigned int numMeshes = (unsigned int)a_step.m_meshes.size();
+    if ((a_step.m_threadPool != NULL) && (numMeshes > 1))
+    {
+        a_step.m_threadPool->run(a_function, &a_step, numMeshes);
+    }
+    else
+    {
+        for (unsigned int i=0; i<numMeshes; i++)
+        {
+            a_function(&a_step, i);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Copy the state of the mass particles of an object into its particle
+    system. Called by runStage().
+
+    \fn       void readParticlesTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void readParticlesTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    cGELMesh* mesh = step->m_meshes[a_task];
+    mesh->m_particleSystem.setThreadPool(step->m_threadPool);
+    mesh->readParticles();
+}
+
+
+//===========================================================================
+/*!
+    Clear the forces of an object. Called by runStage().
+
+    \fn       void clearForcesTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void clearForcesTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    step->m_meshes[a_task]->clearForces();
+}
+
+
+//===========================================================================
+/*!
+    Compute the internal forces of an object. Called by runStage().
+
+    \fn       void computeForcesTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void computeForcesTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    step->m_meshes[a_task]->computeForces();
+}
+
+
+//===========================================================================
+/*!
+    Compute the next pose of an object. Called by runStage().
+
+    \fn       void computeNextPoseTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void computeNextPoseTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    cGELMesh* mesh = step->m_meshes[a_task];
+    if (step->m_integrator == GEL_INTEGRATOR_IMPLICIT_EULER)
+    {
+        mesh->computeNextPoseImplicit(step->m_timeInterval,
+                                      step->m_solverTolerance,
+                                      step->m_solverMaxIterations);
+    }
+    else
+    {
+        mesh->computeNextPose(step->m_timeInterval);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Apply the next pose of an object. Called by runStage().
+
+    \fn       void applyNextPoseTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void applyNextPoseTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    step->m_meshes[a_task]->applyNextPose();
+}
+
+
+//===========================================================================
+/*!
+    Copy the state of the particle system of an object back to its mass
+    particles. Called by runStage().
+
+    \fn       void writeParticlesTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void writeParticlesTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    step->m_meshes[a_task]->writeParticles();
+}
+
+
+//===========================================================================
+/*!
+    Refit the tetrahedral index of an object to its mass particles, if the
+    object uses one. Called by runStage().
+
+    \fn       void updateTetrahedralIndexTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void updateTetrahedralIndexTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    cGELMesh* mesh = step->m_meshes[a_task];
+    if (mesh->m_useTetrahedralIndex && mesh->m_useMassParticleModel)
+    {
+        mesh->updateTetrahedralIndex();
+    }
+}
+
+
+//===========================================================================
+/*!
+    Update the vertices of an object. Called by runStage().
+
+    \fn       void updateSkinTask(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cGELWorldStep.
+    \param    a_task  Index of the object.
+*/
+//===========================================================================
+static void updateSkinTask(void* a_data, unsigned int a_task)
+{
+    cGELWorldStep* step = (cGELWorldStep*)a_data;
+    cGELMesh* mesh = step->m_meshes[a_task];
+    mesh->m_skin.setThreadPool(step->m_threadPool);
+    mesh->updateVertexPosition();
+
+    // vertices of skeleton models only move here
+    if (mesh->m_useTetrahedralIndex && !mesh->m_useMassParticleModel)
+    {
+        mesh->updateTetrahedralIndex();
+    }
+}
+
+
 //==========================================================================
 /*!
     Extends cGELWorld to support collision detection.
@@ -63,6 +278,19 @@ cGELWorld::cGELWorld()
     // set a default value for the integration time step [s].
     m_integrationTime = 1.0f / 400.0f;
 
+    // integrate by explicit Euler by default
+    m_integrator = GEL_INTEGRATOR_EXPLICIT_EULER;
+    m_solverTolerance = 0.01;
+    m_solverMaxIterations = 50;
+
+    // contact forces
+    m_contactStiffness = 50.0;
+    m_contactDamping = 0.1;
+
+    // use the thread pool of the library, once there is work for it
+    m_threadPool = NULL;
+    m_useDefaultThreadPool = true;
+
     // create a collision detector for world
     m_collisionDetector = new cGELWorldCollision(this);
 }
@@ -93,10 +321,11 @@ void cGELWorld::render(const int a_renderMode)
 {
     list<cGELMesh*>::iterator i;
 
+    // render all deformable objects, culled by the view frustum if any
     for(i = m_gelMeshes.begin(); i != m_gelMeshes.end(); ++i)
     {
         cGELMesh* nextItem = *i;
-        nextItem->renderSceneGraph(a_renderMode);
+        nextItem->renderSceneGraph(a_renderMode, m_renderFrustum);
     }
 }
 
@@ -121,69 +350,105 @@ void cGELWorld::clearExternalForces()
 
 //===========================================================================
 /*!
-    Compute simulation for a_time time interval.
+    Compute simulation for a_time time interval. The interval is divided
+    in steps of at most m_integrationTime. With the implicit integrator,
+    m_integrationTime may be as long as a haptic tick, even for stiff
+    springs. \n
+
+    Each stage of a step (clearing forces, computing forces, adding contact
+    forces, computing and applying the next pose) completes for all
+    objects before the next stage starts. Within a stage, objects are computed concurrently on
+    the thread pool.
 
     \fn       void cGELWorld::updateDynamics(double a_time)
 */
 //===========================================================================
 void cGELWorld::updateDynamics(double a_time)
 {
-    list<cGELMesh*>::iterator i;
-
     double nextTime = m_simulationTime + a_time;
 
-    double integrationTime = cMin(m_integrationTime, a_time);
+    updateThreadPool();
+
+    cGELWorldStep step;
+    step.m_meshes.assign(m_gelMeshes.begin(), m_gelMeshes.end());
+    step.m_threadPool = m_threadPool;
+    step.m_integrator = m_integrator;
+    step.m_timeInterval = cMin(m_integrationTime, a_time);
+    step.m_solverTolerance = m_solverTolerance;
+    step.m_solverMaxIterations = m_solverMaxIterations;
+
+    // copy state of mass particles into the particle system of each model
+    runStage(step, readParticlesTask);
 
     while (m_simulationTime < nextTime)
     {
         // clear all internal forces of each model
-        for(i = m_gelMeshes.begin(); i != m_gelMeshes.end(); ++i)
-        {
-            cGELMesh *nextItem = *i;
-            nextItem->clearForces();
-        }
+        runStage(step, clearForcesTask);
 
         // compute all internal forces for ach model
-        for(i = m_gelMeshes.begin(); i != m_gelMeshes.end(); ++i)
-        {
-            cGELMesh *nextItem = *i;
-            nextItem->computeForces();
-        }
+        runStage(step, computeForcesTask);
+
+        // add forces of contacts between models
+        m_contactModel.setThreadPool(m_threadPool);
+        m_contactModel.computeForces(step.m_meshes, m_contactStiffness, m_contactDamping);
 
         // compute next pose of model
-        for(i = m_gelMeshes.begin(); i != m_gelMeshes.end(); ++i)
-        {
-            cGELMesh *nextItem = *i;
-            nextItem->computeNextPose(integrationTime);
-        }
+        runStage(step, computeNextPoseTask);
 
         // apply next pose
-        for(i = m_gelMeshes.begin(); i != m_gelMeshes.end(); ++i)
-        {
-            cGELMesh *nextItem = *i;
-            nextItem->applyNextPose();
-        }
+        runStage(step, applyNextPoseTask);
 
         // update simulation time
         m_simulationTime = m_simulationTime + m_integrationTime;
     }
+
+    // copy new state back to the mass particles
+    runStage(step, writeParticlesTask);
+
+    // follow the particles with the tetrahedral indices
+    runStage(step, updateTetrahedralIndexTask);
 }
 
 //===========================================================================
 /*!
-    Update vertices of all objects.
+    Set m_threadPool to the default thread pool of the library when the
+    world is first updated with objects, so that worlds which are never
+    simulated do not create the threads of the pool.
 
-    \fn       void cGELWorld::updateDynamics(double a_time)
+    \fn       void cGELWorld::updateThreadPool()
 */
 //===========================================================================
-void cGELWorld::updateSkins()
+void cGELWorld::updateThreadPool()
 {
-    // update surface mesh to latest skeleton configuration
-    list<cGELMesh*>::iterator i;
-    for(i = m_gelMeshes.begin(); i != m_gelMeshes.end(); ++i)
+    if (m_useDefaultThreadPool && !m_gelMeshes.empty())
     {
-        cGELMesh *nextItem = *i;
-        nextItem->updateVertexPosition();
+        if (m_threadPool == NULL)
+        {
+            m_threadPool = cThreadPool::getDefaultThreadPool();
+        }
+        m_useDefaultThreadPool = false;
     }
 }
 
+
+//===========================================================================
+/*!
+    Update vertices of all objects. Objects are updated concurrently on
+    the thread pool, and the vertices of large objects are themselves
+    split between the threads.
+
+    \fn       void cGELWorld::updateSkins()
+*/
+//===========================================================================
+void cGELWorld::updateSkins()
+{
+    updateThreadPool();
+
+    cGELWorldStep step;
+    step.m_meshes.assign(m_gelMeshes.begin(), m_gelMeshes.end());
+    step.m_threadPool = m_threadPool;
+
+    // update surface mesh to latest skeleton configuration
+    runStage(step, updateSkinTask);
+}
+
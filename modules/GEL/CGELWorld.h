@@ -16,6 +16,14 @@
 //---------------------------------------------------------------------------
 #include "chai3d.h"
 #include "CGELMesh.h"
+#include "CGELContactModel.h"
+//---------------------------------------------------------------------------
+//! Integration method of the mass particle models of a cGELWorld.
+enum cGELIntegrator
+{
+    GEL_INTEGRATOR_EXPLICIT_EULER,
+    GEL_INTEGRATOR_IMPLICIT_EULER
+};
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -35,6 +43,15 @@
 
     \brief      
     cGELWorld implements a world to handle deformable objects within CHAI 3D.
+
+    When a thread pool is set, the deformable objects are simulated
+    concurrently, one task per object for each stage of a time step, and
+    the mass particle models of large objects are themselves split
+    between the threads. Results are identical to those computed on a
+    single thread. Skeleton links must connect nodes of the same object. \n
+
+    Objects with cGELMesh::m_useContacts set push each other apart with
+    penalty forces computed by m_contactModel at each step.
 */
 //===========================================================================
 class cGELWorld : public cGenericObject
@@ -79,6 +96,30 @@ class cGELWorld : public cGenericObject
     //! Integration time.
     double m_integrationTime;
 
+    //! Integration method of the mass particle models.
+    cGELIntegrator m_integrator;
+
+    //! Relative residual at which the solver of the implicit integrator stops.
+    double m_solverTolerance;
+
+    //! Maximum number of iterations of the solver of the implicit integrator.
+    unsigned int m_solverMaxIterations;
+
+    //! Contacts between objects.
+    cGELContactModel m_contactModel;
+
+    //! Force per unit of penetration depth of contacts.
+    double m_contactStiffness;
+
+    //! Force per unit of velocity along the normal of contacts.
+    double m_contactDamping;
+
+    //! Thread pool computing the simulation, or NULL to compute it on the calling thread only.
+    cThreadPool* m_threadPool;
+
+    //! If \b true, m_threadPool is set to the default thread pool of the library on the first update of a non-empty world.
+    bool m_useDefaultThreadPool;
+
     //! Gravity constant.
     cVector3d m_gravity;
 
@@ -91,6 +132,9 @@ class cGELWorld : public cGenericObject
 
     //! Render deformable mesh.
     virtual void render(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL);
+
+    //! Fetch the default thread pool on the first update of a non-empty world, if requested.
+    void updateThreadPool();
 };
 
 
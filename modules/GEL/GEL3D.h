@@ -31,10 +31,16 @@
 
 #include "CGELMassParticle.h"
 #include "CGELLinearSpring.h"
+#include "CGELParticleSystem.h"
 #include "CGELSkeletonNode.h"
 #include "CGELSkeletonLink.h"
+#include "CGELSkeletonIndex.h"
 #include "CGELVertex.h"
+#include "CGELSkin.h"
+#include "CGELTetrahedralIndex.h"
 #include "CGELMesh.h"
+#include "CGELSpatialHash.h"
+#include "CGELContactModel.h"
 #include "CGELWorld.h"
 
 //---------------------------------------------------------------------------
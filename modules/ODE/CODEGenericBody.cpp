@@ -49,6 +49,9 @@ void cODEGenericBody::initialize(cODEWorld* a_world)
     // init ODE data
     m_ode_triMeshDataID = NULL;
     m_ode_body = NULL;
+    m_ode_geom = NULL;
+    m_sharedVertices = NULL;
+    m_poseIndex = -1;
 
     m_prevTransform[0] = 1.0;
     m_prevTransform[1] = 0.0;
@@ -120,8 +123,9 @@ void cODEGenericBody::setPosition(cVector3d &a_position)
         // store value
         m_localPos = a_position;
 
-        // adjust position
+        // adjust position, and wake body if it was deactivated at rest
         dBodySetPosition(m_ode_body, a_position.x, a_position.y, a_position.z);
+        wakeUp();
     }
     else if (m_ode_geom != NULL)
     {
@@ -163,6 +167,7 @@ void cODEGenericBody::setRotation(cMatrix3d &a_rotation)
         // store new rotation matrix
         m_localRot = a_rotation;
         dBodySetRotation(m_ode_body, R);
+        wakeUp();
     }
     else if (m_ode_geom != NULL)
     {
@@ -176,7 +181,9 @@ void cODEGenericBody::setRotation(cMatrix3d &a_rotation)
 //===========================================================================
 /*!
     Apply an external force at a given position. Position and force
-    are expressed in global coordinates.
+    are expressed in global coordinates. If the simulation thread of the
+    world is running, the force is queued and applied on its next step.
+    A body deactivated at rest is woken up.
 
     \fn       void cODEGenericBody::addGlobalForceAtGlobalPos(cVector3d& a_force,
                                                             cVector3d& a_pos)
@@ -186,8 +193,15 @@ void cODEGenericBody::setRotation(cMatrix3d &a_rotation)
 //===========================================================================
 void cODEGenericBody::addGlobalForceAtGlobalPos(cVector3d& a_force, cVector3d& a_pos)
 {
-    if (m_ode_body != NULL)
+    if (m_ode_body == NULL) { return; }
+
+    if (m_ODEWorld->isSimulationRunning())
     {
+        m_ODEWorld->queueForce(this, a_force, a_pos);
+    }
+    else
+    {
+        wakeUp();
         dBodyAddForceAtPos(m_ode_body,
                         a_force.x, a_force.y, a_force.z,
                         a_pos.x, a_pos.y, a_pos.z);
@@ -227,27 +241,7 @@ void cODEGenericBody::updateBodyPosition(void)
                 odeRotation[8],odeRotation[9],odeRotation[10]);
 
     // store previous position if object is a mesh
-    if (m_ode_triMeshDataID != NULL)
-    {
-        m_prevTransform[0] = odeRotation[0];
-        m_prevTransform[1] = odeRotation[4];
-        m_prevTransform[2] = odeRotation[8];
-        m_prevTransform[3] = 0.0;
-        m_prevTransform[4] = odeRotation[1];
-        m_prevTransform[5] = odeRotation[5];
-        m_prevTransform[6] = odeRotation[9];
-        m_prevTransform[7] = 0.0;
-        m_prevTransform[8] = odeRotation[2];
-        m_prevTransform[9] = odeRotation[6];
-        m_prevTransform[10] = odeRotation[10];
-        m_prevTransform[11] = 0.0;
-        m_prevTransform[12] = odePosition[0];
-        m_prevTransform[13] = odePosition[1];
-        m_prevTransform[14] = odePosition[2];
-        m_prevTransform[15] = 1.0;
-
-        dGeomTriMeshSetLastTransform(m_ode_geom, m_prevTransform);
-    }
+    updateLastTransform();
 
 	// Normalize frame
 	// This can be useful is ODE is running in SINGLE precision mode
@@ -268,6 +262,43 @@ void cODEGenericBody::updateBodyPosition(void)
 }
 
 
+//===========================================================================
+/*!
+    Pass the current position and orientation of the ODE body to its
+    triangle mesh model, if any, which uses it as the previous transform
+    on the next collision.
+
+    \fn       void cODEGenericBody::updateLastTransform()
+*/
+//===========================================================================
+void cODEGenericBody::updateLastTransform()
+{
+    if ((m_ode_body == NULL) || (m_ode_triMeshDataID == NULL)) { return; }
+
+    const double* odePosition = dBodyGetPosition(m_ode_body);
+    const double* odeRotation = dBodyGetRotation(m_ode_body);
+
+    m_prevTransform[0] = odeRotation[0];
+    m_prevTransform[1] = odeRotation[4];
+    m_prevTransform[2] = odeRotation[8];
+    m_prevTransform[3] = 0.0;
+    m_prevTransform[4] = odeRotation[1];
+    m_prevTransform[5] = odeRotation[5];
+    m_prevTransform[6] = odeRotation[9];
+    m_prevTransform[7] = 0.0;
+    m_prevTransform[8] = odeRotation[2];
+    m_prevTransform[9] = odeRotation[6];
+    m_prevTransform[10] = odeRotation[10];
+    m_prevTransform[11] = 0.0;
+    m_prevTransform[12] = odePosition[0];
+    m_prevTransform[13] = odePosition[1];
+    m_prevTransform[14] = odePosition[2];
+    m_prevTransform[15] = 1.0;
+
+    dGeomTriMeshSetLastTransform(m_ode_geom, m_prevTransform);
+}
+
+
 //===========================================================================
 /*!
     Compute collision detection between a ray and body image.
@@ -689,7 +720,10 @@ void cODEGenericBody::createStaticPlane(const cVector3d& a_position,
 /*!
     Create an ODE dynamic model of a mesh.
     This model requires the body image to be a mesh and uses it triangles
-    to build its physical model.
+    to build its physical model. If a single mesh of the body image holds
+    vertices, ODE reads their positions directly from the vertex array of
+    the mesh, which is also drawn by the renderer. Call updateDynamicMesh()
+    after moving the vertices.
 
     \fn     void cODEGenericBody::createDynamicMesh(bool a_staticObject,
                                         const cVector3d& a_offsetPos,
@@ -731,32 +765,11 @@ void cODEGenericBody::createDynamicMesh(bool a_staticObject,
     m_posOffsetDynColModel = a_offsetPos;
     m_rotOffsetDynColModel = a_offsetRot;
 
-    // create a table which lists all vertices and triangles
-    // these vertices must be of type float and not double!
-    // even if we are using the double precision compiled version of ODE !
-    int numTriangles = mesh->getNumTriangles(true);
-
-    int vertexCount = mesh->getNumVertices(true);
-    m_vertices = new float[3 * vertexCount];
-
-    int indexCount = 3 * numTriangles;
-    m_vertexIndices = new int[indexCount];
-
-    // build table of ODE vertices and vertex indices recusevily
-    int nIndexOffset = 0;
-    int nVerticesCount = 0;
-    int nIndexCount = 0;
-    int nTriangles = buildMeshTable(mesh, nIndexOffset, nVerticesCount, nIndexCount);
-
-    // build box
+    // build table of ODE vertices and vertex indices recursively
+    m_meshes.clear();
+    collectMeshes(mesh);
     m_ode_triMeshDataID = dGeomTriMeshDataCreate();
-    dGeomTriMeshDataBuildSingle(m_ode_triMeshDataID,
-                                m_vertices,          // vertex positions
-                                3 * sizeof(float),   // size of vertex
-                                vertexCount,         // number of vertices
-                                m_vertexIndices,     // triangle indices
-                                3 * nTriangles,      // number of triangles
-                                3 * sizeof(int));
+    buildMeshTable();
 
     m_ode_geom = dCreateTriMesh(m_ODEWorld->m_ode_space, m_ode_triMeshDataID, 0, 0, 0);
 
@@ -800,78 +813,223 @@ void cODEGenericBody::createDynamicMesh(bool a_staticObject,
 
 //===========================================================================
 /*!
-    Creates an ODE list of vertices and vertex indices from a mesh
-    and its children.
-
-    \fn       int cODEGenericBody::buildMeshTable(cMesh* a_mesh,
-                                int& a_indexOffset,
-                                int& a_verticesCount,
-                                int& a_indexCount)
-    \param	a_mesh  current mesh to be added to ODE vertex and triangle list.
-    \param	a_indexOffset  index offset as meshes are added in one list.
-    \param	a_verticesCount  vertex counter.
-    \param	a_indexCount  Index counter.
-    \param    return the number of triangle added to ODE list
+    Add a mesh and its children to the list of meshes forming the triangle
+    mesh model.
+
+    \fn       void cODEGenericBody::collectMeshes(cMesh* a_mesh)
+    \param    a_mesh  Mesh to be added to the list.
 */
 //===========================================================================
-int cODEGenericBody::buildMeshTable(cMesh* a_mesh,
-                                    int& a_indexOffset,
-                                    int& a_verticesCount,
-                                    int& a_indexCount)
+void cODEGenericBody::collectMeshes(cMesh* a_mesh)
 {
-    // temp variables
-    int nTriangles = 0;
-
-    // compute number of vertices and triangles for a_mesh
-    int numTriangles = a_mesh->getNumTriangles();
-    int numVertices = a_mesh->getNumVertices();
+    m_meshes.push_back(a_mesh);
 
-    // store vertices
-    for (int i=0; i<numVertices; i++)
+    // process children
+    int numChildren = a_mesh->getNumChildren();
+    for (int i=0; i<numChildren; i++)
     {
-        cVertex* nextVertex = a_mesh->getVertex(i);
-        cVector3d pos = nextVertex->getPos();
-        m_vertices[a_verticesCount] = pos.x;
-        a_verticesCount++;
-        m_vertices[a_verticesCount] = pos.y;
-        a_verticesCount++;
-        m_vertices[a_verticesCount] = pos.z;
-        a_verticesCount++;
+        cGenericObject* nextObject = a_mesh->getChild(i);
+        cMesh* nextMesh = dynamic_cast<cMesh*>(nextObject);
+        if (nextMesh != NULL)
+        {
+            collectMeshes(nextMesh);
+        }
     }
+}
+
+
+//===========================================================================
+/*!
+    Creates an ODE list of vertices and vertex indices from the meshes of
+    the body image, and passes it to the ODE triangle mesh data. \n
+
+    When a single mesh holds vertices, ODE is given the vertex array of
+    the mesh itself, striding over the other members of cVertex, so that
+    no copy is made. Otherwise vertex positions are copied to a table of
+    doubles. Triangles are listed if allocated and if their three vertices
+    are distinct; degenerate triangles are not skipped by their area, since
+    it changes when the mesh deforms.
+
+    \fn       void cODEGenericBody::buildMeshTable()
+*/
+//===========================================================================
+void cODEGenericBody::buildMeshTable()
+{
+    m_meshSizes.clear();
+    m_meshIndices.clear();
+    m_sharedVertices = NULL;
 
     // store triangles
-    for (int i=0; i<numTriangles; i++)
+    unsigned int numMeshes = (unsigned int)m_meshes.size();
+    int numVertices = 0;
+    int numMeshesWithVertices = 0;
+    for (unsigned int i=0; i<numMeshes; i++)
     {
-        cTriangle* nextTriangle = a_mesh->getTriangle(i);
-        double area = nextTriangle->computeArea();
-        if (area > 0)
+        vector<cVertex>* vertices = m_meshes[i]->pVertices();
+        vector<cTriangle>* triangles = m_meshes[i]->pTriangles();
+        int numMeshVertices = (int)vertices->size();
+        int numMeshTriangles = (int)triangles->size();
+        m_meshSizes.push_back(numMeshVertices);
+        m_meshSizes.push_back(numMeshTriangles);
+
+        for (int j=0; j<numMeshTriangles; j++)
+        {
+            cTriangle* nextTriangle = &(*triangles)[j];
+            if (!nextTriangle->m_allocated) { continue; }
+
+            int vertex0 = nextTriangle->getIndexVertex0();
+            int vertex1 = nextTriangle->getIndexVertex1();
+            int vertex2 = nextTriangle->getIndexVertex2();
+            if ((vertex0 != vertex1) && (vertex1 != vertex2) && (vertex2 != vertex0))
+            {
+                m_meshIndices.push_back(vertex0 + numVertices);
+                m_meshIndices.push_back(vertex1 + numVertices);
+                m_meshIndices.push_back(vertex2 + numVertices);
+            }
+        }
+
+        if (numMeshVertices > 0)
         {
-            int vertex0 = nextTriangle->getIndexVertex0() + a_indexOffset;
-            int vertex1 = nextTriangle->getIndexVertex1() + a_indexOffset;
-            int vertex2 = nextTriangle->getIndexVertex2() + a_indexOffset;
-            m_vertexIndices[a_indexCount] = vertex0; a_indexCount++;
-            m_vertexIndices[a_indexCount] = vertex1; a_indexCount++;
-            m_vertexIndices[a_indexCount] = vertex2; a_indexCount++;
-            nTriangles++;
+            m_sharedVertices = &(*vertices)[0];
+            numMeshesWithVertices++;
         }
+        numVertices = numVertices + numMeshVertices;
     }
 
-    // update offset
-    a_indexOffset = a_indexOffset + numVertices;
+    const int* indices = NULL;
+    if (m_meshIndices.size() > 0)
+    {
+        indices = &m_meshIndices[0];
+    }
 
-    // process children
-    int numChildren = a_mesh->getNumChildren();
-    for (int i=0; i<numChildren; i++)
+    if (numMeshesWithVertices == 1)
     {
-        cGenericObject* nextObject = a_mesh->getChild(i);
-        cMesh* nextMesh = dynamic_cast<cMesh*>(nextObject);
-        if (nextMesh != NULL)
+        // share the vertex array of the mesh
+        m_meshVertices.clear();
+        dGeomTriMeshDataBuildDouble(m_ode_triMeshDataID,
+                                    &m_sharedVertices[0].m_localPos,  // vertex positions
+                                    sizeof(cVertex),                  // size of vertex
+                                    numVertices,                      // number of vertices
+                                    indices,                          // triangle indices
+                                    (int)m_meshIndices.size(),        // number of indices
+                                    3 * sizeof(int));
+    }
+    else
+    {
+        // copy vertex positions of all meshes
+        m_sharedVertices = NULL;
+        m_meshVertices.resize(3 * numVertices);
+        copyMeshVertices();
+
+        const double* positions = NULL;
+        if (numVertices > 0)
+        {
+            positions = &m_meshVertices[0];
+        }
+        dGeomTriMeshDataBuildDouble(m_ode_triMeshDataID,
+                                    positions,                        // vertex positions
+                                    3 * sizeof(double),               // size of vertex
+                                    numVertices,                      // number of vertices
+                                    indices,                          // triangle indices
+                                    (int)m_meshIndices.size(),        // number of indices
+                                    3 * sizeof(int));
+    }
+}
+
+
+//===========================================================================
+/*!
+    Copy the local positions of the vertices of all meshes to the ODE
+    vertex table. Not used when the vertex array of a mesh is shared.
+
+    \fn       void cODEGenericBody::copyMeshVertices()
+*/
+//===========================================================================
+void cODEGenericBody::copyMeshVertices()
+{
+    unsigned int index = 0;
+    unsigned int numMeshes = (unsigned int)m_meshes.size();
+    for (unsigned int i=0; i<numMeshes; i++)
+    {
+        vector<cVertex>* vertices = m_meshes[i]->pVertices();
+        unsigned int numMeshVertices = (unsigned int)vertices->size();
+        for (unsigned int j=0; j<numMeshVertices; j++)
+        {
+            const cVector3d& pos = (*vertices)[j].m_localPos;
+            m_meshVertices[index]   = pos.x;
+            m_meshVertices[index+1] = pos.y;
+            m_meshVertices[index+2] = pos.z;
+            index = index + 3;
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Check whether vertices or triangles have been added to or removed
+    from the meshes since the ODE table was built, or if the vertex array
+    shared with ODE has been reallocated.
+
+    \fn       bool cODEGenericBody::isMeshTableModified()
+    \return   Return \b true if the table must be built again.
+*/
+//===========================================================================
+bool cODEGenericBody::isMeshTableModified()
+{
+    unsigned int numMeshes = (unsigned int)m_meshes.size();
+    for (unsigned int i=0; i<numMeshes; i++)
+    {
+        vector<cVertex>* vertices = m_meshes[i]->pVertices();
+        if ((vertices->size() != m_meshSizes[2*i]) ||
+            (m_meshes[i]->pTriangles()->size() != m_meshSizes[2*i+1]))
+        {
+            return (true);
+        }
+
+        if ((m_sharedVertices != NULL) && (vertices->size() > 0) &&
+            (&(*vertices)[0] != m_sharedVertices))
         {
-            nTriangles = nTriangles + buildMeshTable(nextMesh, a_indexOffset, a_verticesCount, a_indexCount);
+            return (true);
         }
     }
+    return (false);
+}
+
+
+//===========================================================================
+/*!
+    Update the ODE triangle mesh model after the vertices of the body
+    image have been moved, for instance by a deformable model. The
+    bounding volume tree of ODE is refitted to the new positions in place.
+    If vertices or triangles have been added or removed, the table of the
+    model is built again. Mass and inertia of the body are not changed.
+
+    \fn       void cODEGenericBody::updateDynamicMesh()
+*/
+//===========================================================================
+void cODEGenericBody::updateDynamicMesh()
+{
+    if (m_ode_triMeshDataID == NULL) { return; }
 
-    return (nTriangles);
+    if (isMeshTableModified())
+    {
+        buildMeshTable();
+        dGeomTriMeshSetData(m_ode_geom, m_ode_triMeshDataID);
+    }
+    else
+    {
+        if (m_sharedVertices == NULL)
+        {
+            copyMeshVertices();
+        }
+        dGeomTriMeshDataUpdate(m_ode_triMeshDataID);
+    }
+
+    // setting the position again marks the geometry as moved, so that
+    // ODE recomputes its bounding box in the collision space
+    const dReal* pos = dGeomGetPosition(m_ode_geom);
+    dGeomSetPosition(m_ode_geom, pos[0], pos[1], pos[2]);
 }
 
 
@@ -890,6 +1048,53 @@ void cODEGenericBody::enableDynamics()
 }
 
 
+//===========================================================================
+/*!
+    Set the automatic deactivation of the object, overriding the settings
+    of the world. The object is deactivated when its linear and angular
+    speeds stay below the thresholds during a number of steps and a
+    duration. It is woken up by contacts with active objects, and by
+    forces applied through addGlobalForceAtGlobalPos(). If the simulation
+    thread of the world is running, it is stopped while ODE is updated,
+    then started again.
+
+    \fn       void cODEGenericBody::setAutoDisable(const bool a_enabled,
+                                                  const double a_linearThreshold,
+                                                  const double a_angularThreshold,
+                                                  const int a_steps,
+                                                  const double a_time)
+    \param    a_enabled  If \b true, the object is deactivated at rest.
+    \param    a_linearThreshold  Linear speed below which the object is at rest.
+    \param    a_angularThreshold  Angular speed below which the object is at rest.
+    \param    a_steps  Number of steps at rest before deactivation.
+    \param    a_time  Time at rest before deactivation, in seconds.
+*/
+//===========================================================================
+void cODEGenericBody::setAutoDisable(const bool a_enabled,
+                                     const double a_linearThreshold,
+                                     const double a_angularThreshold,
+                                     const int a_steps,
+                                     const double a_time)
+{
+    if (m_ode_body == NULL) { return; }
+
+    // the simulation thread must not step the world meanwhile
+    bool running = m_ODEWorld->isSimulationRunning();
+    m_ODEWorld->stopSimulation();
+
+    dBodySetAutoDisableFlag(m_ode_body, a_enabled);
+    dBodySetAutoDisableLinearThreshold(m_ode_body, a_linearThreshold);
+    dBodySetAutoDisableAngularThreshold(m_ode_body, a_angularThreshold);
+    dBodySetAutoDisableSteps(m_ode_body, a_steps);
+    dBodySetAutoDisableTime(m_ode_body, a_time);
+
+    if (running)
+    {
+        m_ODEWorld->startSimulation(m_ODEWorld->getTimeStep());
+    }
+}
+
+
 //===========================================================================
 /*!
     Disable object from being updated within the dynamics simulation.
@@ -917,7 +1122,7 @@ void cODEGenericBody::render(const int a_renderMode)
 {
     if (m_imageModel != NULL)
     {
-        m_imageModel->renderSceneGraph(a_renderMode);
+        m_imageModel->renderSceneGraph(a_renderMode, m_renderFrustum);
     }
     if (m_showDynamicCollisionModel)
     {
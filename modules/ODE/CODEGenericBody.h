@@ -112,6 +112,16 @@ class cODEGenericBody : public cGenericObject
     //! Is the current object static? (cannot move).
     bool isStatic() { return (m_static); } 
 
+    //! Return \b true if the object is simulated, \b false if it is static or deactivated at rest.
+    bool isActive() { return ((m_ode_body != NULL) && (dBodyIsEnabled(m_ode_body) != 0)); }
+
+    //! Set the automatic deactivation of the object at rest, overriding the settings of the world.
+    void setAutoDisable(const bool a_enabled,
+                        const double a_linearThreshold = 0.01,
+                        const double a_angularThreshold = 0.01,
+                        const int a_steps = 10,
+                        const double a_time = 0.0);
+
     //! Create a dynamic model of the object.
 	virtual void buildDynamicModel() {};
 
@@ -145,9 +155,15 @@ class cODEGenericBody : public cGenericObject
                            const cVector3d& a_offsetPos = cVector3d(0.0, 0.0, 0.0),
                            const cMatrix3d& a_offsetRot = cIdentity3d());
 
+    //! Update the triangle mesh model after the vertices of the body image have moved.
+    void updateDynamicMesh();
+
     //! Update global position frames.
     void updateGlobalPositions(const bool a_frameOnly);
 
+    //! Collisions with the body image are computed by computeOtherCollisionDetection().
+    virtual bool getUseOtherCollisionDetection() const { return (true); }
+
     //! Render object in OpenGL.
     void render(const int a_renderMode);
 
@@ -166,6 +182,9 @@ class cODEGenericBody : public cGenericObject
 
   private:
 
+    //! The simulation thread of the world reads ODE bodies and their pose index.
+    friend class cODEWorld;
+
 	//-----------------------------------------------------------------------
     // MEMBERS:
     //-----------------------------------------------------------------------
@@ -185,11 +204,20 @@ class cODEGenericBody : public cGenericObject
     //! ODE body geometry.
     dGeomID m_ode_geom;
 
-    //! ODE vertices (for triangle mesh models) - Do not use doubles since not supported under ODE! 
-    float* m_vertices;
+    //! Meshes of the body image forming the triangle mesh model.
+    vector<cMesh*> m_meshes;
+
+    //! Numbers of vertices and triangles of each mesh when the triangle mesh model was built.
+    vector<unsigned int> m_meshSizes;
+
+    //! Vertices of the mesh shared with ODE, or NULL if positions are copied to m_meshVertices.
+    cVertex* m_sharedVertices;
 
-    //! ODE indices (for triangle mesh models).
-    int* m_vertexIndices;
+    //! ODE vertex positions, three per vertex, when several meshes have vertices.
+    vector<double> m_meshVertices;
+
+    //! ODE vertex indices, three per triangle.
+    vector<int> m_meshIndices;
 
     //! ODE previous tri mesh position and orientation.
     double m_prevTransform[16];
@@ -197,6 +225,9 @@ class cODEGenericBody : public cGenericObject
     //! ODE tri mesh ID.
     dTriMeshDataID m_ode_triMeshDataID;
 
+    //! Index of the pose of the body published by the simulation thread, or -1.
+    int m_poseIndex;
+
     //! Enable/Disable graphical representation of collision model.
     bool m_showDynamicCollisionModel;
 
@@ -217,12 +248,33 @@ class cODEGenericBody : public cGenericObject
     cVector3d m_posOffsetDynColModel;
     cMatrix3d m_rotOffsetDynColModel;
 
+    //! Collect a mesh and its children into the list of meshes of the triangle mesh model.
+    void collectMeshes(cMesh* a_mesh);
+
     //! Build table of triangles and vertices for ODE mesh representation.
-    int buildMeshTable(cMesh* a_mesh, int& a_indexOffset, int& a_verticesCount, int& a_indexCount);
+    void buildMeshTable();
+
+    //! Copy vertex positions of the meshes to the ODE vertex table.
+    void copyMeshVertices();
+
+    //! Return \b true if vertices or triangles have been added or reallocated since the table was built.
+    bool isMeshTableModified();
 
     //! Initialize ODE body.
     void initialize(cODEWorld* a_world);
 
+    //! Pass the current ODE transform to the triangle mesh model.
+    void updateLastTransform();
+
+    //! Wake the object up if it was deactivated at rest. Objects disabled by disableDynamics() stay disabled.
+    void wakeUp()
+    {
+        if ((m_ode_body != NULL) && (m_ode_geom != NULL) && dGeomIsEnabled(m_ode_geom))
+        {
+            dBodyEnable(m_ode_body);
+        }
+    }
+
     //! Compute collision with object geometry.
     virtual bool computeOtherCollisionDetection(cVector3d& a_segmentPointA,
                                                 cVector3d& a_segmentPointB,
@@ -23,8 +23,84 @@
 //---------------------------------------------------------------------------
 //! Maximum number of contact points per body.
 #define MAX_CONTACTS_PER_BODY 16  
+
+//! Default maximum number of steps taken by a tick of the simulation thread.
+#define CHAI_ODE_MAX_STEPS_PER_TICK 10
+
+//! Default linear motion below which cached contacts are reused.
+#define CHAI_ODE_LINEAR_CACHE_TOLERANCE 0.0001
+
+//! Default angular motion below which cached contacts are reused.
+#define CHAI_ODE_ANGULAR_CACHE_TOLERANCE 0.0001
 //---------------------------------------------------------------------------
 
+//===========================================================================
+/*!
+    Full memory barrier, ordering the memory accesses of the simulation
+    thread and of the threads reading its poses or queuing forces.
+
+    \fn       static inline void cODEMemoryBarrier()
+*/
+//===========================================================================
+static inline void cODEMemoryBarrier()
+{
+#if defined(_WIN32)
+    MemoryBarrier();
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    __sync_synchronize();
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Atomically replace a value if it is equal to an expected value.
+
+    \fn       static inline long cODECompareAndSwap(volatile long* a_value,
+                                                   const long a_expected,
+                                                   const long a_newValue)
+    \param    a_value  Value to be replaced.
+    \param    a_expected  Expected value.
+    \param    a_newValue  New value.
+    \return   Return the previous value, equal to a_expected if replaced.
+*/
+//===========================================================================
+static inline long cODECompareAndSwap(volatile long* a_value,
+                                      const long a_expected,
+                                      const long a_newValue)
+{
+#if defined(_WIN32)
+    return (InterlockedCompareExchange(a_value, a_newValue, a_expected));
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    return (__sync_val_compare_and_swap(a_value, a_expected, a_newValue));
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Atomically increment a value.
+
+    \fn       static inline void cODEAtomicIncrement(volatile long* a_value)
+    \param    a_value  Value to be incremented.
+*/
+//===========================================================================
+static inline void cODEAtomicIncrement(volatile long* a_value)
+{
+#if defined(_WIN32)
+    InterlockedIncrement(a_value);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    __sync_add_and_fetch(a_value, 1);
+#endif
+}
+
+
 //==========================================================================
 /*!
     Extends cODEWorld to support collision detection.
@@ -100,6 +176,47 @@ cODEWorld::cODEWorld(cWorld* a_parentWorld)
 	dWorldSetLinearDamping(m_ode_world, 0.00001);
 	dWorldSetAngularDamping(m_ode_world, 0.0001);
 	dWorldSetMaxAngularSpeed(m_ode_world, 200);
+
+    // simulation thread
+    m_timeStep = 0.001;
+    m_maxStepsPerTick = CHAI_ODE_MAX_STEPS_PER_TICK;
+    m_accumulator = 0.0;
+    m_lastClock = 0.0;
+    m_clockOffset = 0.0;
+    m_latestPose = 0;
+    for (int i=0; i<3; i++)
+    {
+        m_poseClock[i] = 0.0;
+        m_poseSequence[i] = 0;
+    }
+    m_forceQueueTail = 0;
+    m_forceQueueHead = 0;
+    for (int i=0; i<CHAI_ODE_FORCE_QUEUE_SIZE; i++)
+    {
+        m_forceQueue[i].m_sequence = i;
+        m_forceQueue[i].m_body = NULL;
+    }
+    m_numSteps = 0;
+    m_numDroppedSteps = 0;
+    m_numDroppedForces = 0;
+    m_threadDataAllocated = false;
+    m_stopRequested = false;
+    m_stopAcknowledged = false;
+
+    // the simulation thread must never preempt the haptics thread, which
+    // runs at a real-time priority of its own: run it at normal priority
+    m_simulationLoop.setPolicy(CHAI_HAPTIC_LOOP_POLICY_NORMAL, 0);
+
+    // contacts are computed at every step by default
+    m_useContactCache = false;
+    m_linearCacheTolerance = CHAI_ODE_LINEAR_CACHE_TOLERANCE;
+    m_angularCacheTolerance = CHAI_ODE_ANGULAR_CACHE_TOLERANCE;
+    m_contactCacheStep = 0;
+    m_numActiveBodies = 0;
+    m_numContacts = 0;
+    m_numCachedContacts = 0;
+    m_numCollisionTests = 0;
+    m_numRestingPairs = 0;
 }
 
 
@@ -112,6 +229,9 @@ cODEWorld::cODEWorld(cWorld* a_parentWorld)
 //===========================================================================
 cODEWorld::~cODEWorld()
 {
+    // stop simulation thread
+    stopSimulation();
+
     // clear all bodies
     m_bodies.clear();
 
@@ -124,7 +244,8 @@ cODEWorld::~cODEWorld()
 
 //===========================================================================
 /*!
-      Define a gravity field.
+      Define a gravity field. If the simulation thread is running, it is
+      stopped while ODE is updated, then started again.
 
       \fn       void cODEWorld::setGravity(cVector3d a_gravity)
       \param    a_gravity  Gravity field.
@@ -132,8 +253,24 @@ cODEWorld::~cODEWorld()
 //===========================================================================
 void cODEWorld::setGravity(cVector3d a_gravity)
 {
+    // the simulation thread must not step the world meanwhile
+    bool running = isSimulationRunning();
+    stopSimulation();
+
     // update ode
     dWorldSetGravity (m_ode_world, a_gravity.x, a_gravity.y, a_gravity.z);
+
+    // wake up bodies at rest, which would otherwise ignore the new field
+    list<cODEGenericBody*>::iterator i;
+    for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
+    {
+        (*i)->wakeUp();
+    }
+
+    if (running)
+    {
+        startSimulation(m_timeStep);
+    }
 }
 
 
@@ -158,6 +295,104 @@ cVector3d cODEWorld::getGravity()
 }
 
 
+//===========================================================================
+/*!
+      Set the automatic deactivation of bodies at rest, for the world and
+      all its bodies. A body is deactivated when its linear and angular
+      speeds stay below the thresholds during a number of steps and a
+      duration, and is no longer simulated until an active body touches
+      it or a force is applied to it. Settings may be overridden for a
+      body with cODEGenericBody::setAutoDisable(). If the simulation thread
+      is running, it is stopped while ODE is updated, then started again.
+
+      \fn       void cODEWorld::setAutoDisable(const bool a_enabled,
+                                               const double a_linearThreshold,
+                                               const double a_angularThreshold,
+                                               const int a_steps,
+                                               const double a_time)
+      \param    a_enabled  If \b true, bodies at rest are deactivated.
+      \param    a_linearThreshold  Linear speed below which a body is at rest.
+      \param    a_angularThreshold  Angular speed below which a body is at rest.
+      \param    a_steps  Number of steps at rest before deactivation.
+      \param    a_time  Time at rest before deactivation, in seconds.
+*/
+//===========================================================================
+void cODEWorld::setAutoDisable(const bool a_enabled,
+                               const double a_linearThreshold,
+                               const double a_angularThreshold,
+                               const int a_steps,
+                               const double a_time)
+{
+    // the simulation thread must not step the world meanwhile
+    bool running = isSimulationRunning();
+    stopSimulation();
+
+    // settings of bodies created from now on
+    dWorldSetAutoDisableFlag(m_ode_world, a_enabled);
+    dWorldSetAutoDisableLinearThreshold(m_ode_world, a_linearThreshold);
+    dWorldSetAutoDisableAngularThreshold(m_ode_world, a_angularThreshold);
+    dWorldSetAutoDisableSteps(m_ode_world, a_steps);
+    dWorldSetAutoDisableTime(m_ode_world, a_time);
+
+    // settings of existing bodies
+    list<cODEGenericBody*>::iterator i;
+    for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
+    {
+        cODEGenericBody* nextItem = *i;
+        if (nextItem->m_ode_body != NULL)
+        {
+            dBodySetAutoDisableDefaults(nextItem->m_ode_body);
+        }
+    }
+
+    if (running)
+    {
+        startSimulation(m_timeStep);
+    }
+}
+
+
+//===========================================================================
+/*!
+      Enable or disable the cache of contacts between pairs of geometries.
+      Must not be called while the simulation thread is running.
+
+      \fn       void cODEWorld::setUseContactCache(const bool a_useContactCache)
+      \param    a_useContactCache  If \b true, contacts are cached.
+*/
+//===========================================================================
+void cODEWorld::setUseContactCache(const bool a_useContactCache)
+{
+    m_useContactCache = a_useContactCache;
+    if (!m_useContactCache)
+    {
+        m_contactCache.clear();
+    }
+}
+
+
+//===========================================================================
+/*!
+      Set the motion below which the cached contacts of a pair of
+      geometries are reused. Each coordinate of the position of a body,
+      and each coefficient of its rotation matrix, is compared to its
+      value when the contacts were found. Larger tolerances save more
+      collision tests, at the cost of less accurate resting contacts.
+
+      \fn       void cODEWorld::setContactCacheTolerance(const double a_linearTolerance,
+                                                         const double a_angularTolerance)
+      \param    a_linearTolerance  Linear tolerance.
+      \param    a_angularTolerance  Angular tolerance (coefficients of rotation matrices).
+*/
+//===========================================================================
+void cODEWorld::setContactCacheTolerance(const double a_linearTolerance,
+                                         const double a_angularTolerance)
+{
+    m_linearCacheTolerance = a_linearTolerance;
+    m_angularCacheTolerance = a_angularTolerance;
+}
+
+
 //===========================================================================
 /*!
      Render world in OpenGL.
@@ -170,11 +405,11 @@ void cODEWorld::render(const int a_renderMode)
 {
     list<cODEGenericBody*>::iterator i;
 
-    // render all dynamic ODE bodies
+    // render all dynamic ODE bodies, culled by the view frustum if any
     for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
     {
         cODEGenericBody* nextItem = *i;
-        nextItem->renderSceneGraph(a_renderMode);
+        nextItem->renderSceneGraph(a_renderMode, m_renderFrustum);
     }
 }
 
@@ -207,7 +442,9 @@ void cODEWorld::updateGlobalPositions(const bool a_frameOnly)
 
 //===========================================================================
 /*!
-      Compute simulation for a_time time interval.
+      Compute simulation for a_time time interval. If the simulation
+      thread is running, the simulation is computed by the thread and
+      bodies are only set to their interpolated poses.
 
       \fn       void cODEWorld::updateDynamics(double a_interval)
       \param    a_interval  Time increment.
@@ -215,8 +452,36 @@ void cODEWorld::updateGlobalPositions(const bool a_frameOnly)
 //===========================================================================
 void cODEWorld::updateDynamics(double a_interval)
 {
+    if (!isSimulationRunning())
+    {
+        stepDynamics(a_interval);
+    }
+
+    // update CHAI 3D positions for of all object
+    updateBodyPositions();
+}
+
+
+//===========================================================================
+/*!
+      Compute collisions and integrate the simulation over a time interval.
+
+      \fn       void cODEWorld::stepDynamics(double a_interval)
+      \param    a_interval  Time increment.
+*/
+//===========================================================================
+void cODEWorld::stepDynamics(double a_interval)
+{
+    // reset statistics of the step
+    m_numContacts = 0;
+    m_numCachedContacts = 0;
+    m_numCollisionTests = 0;
+    m_numRestingPairs = 0;
+    m_contactCacheStep++;
+
 	// update collision callback information
-	dSpaceCollide (m_ode_space, 0, &(cODEWorld::nearCallback));
+	dSpaceCollide (m_ode_space, this, &(cODEWorld::nearCallback));
+    cleanContactCache();
 
     // integrate simulation during an certain interval
 	// dWorldStep (m_ode_world, a_interval);
@@ -226,17 +491,24 @@ void cODEWorld::updateDynamics(double a_interval)
     // cleanup contacts from previous iteration
 	dJointGroupEmpty(m_ode_contactgroup);
 
+    // count bodies which are still active
+    m_numActiveBodies = 0;
+    list<cODEGenericBody*>::iterator i;
+    for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
+    {
+        if ((*i)->isActive()) { m_numActiveBodies++; }
+    }
+
     // add time to overall simulation
     m_simulationTime = m_simulationTime + a_interval;
-
-    // update CHAI 3D positions for of all object
-    updateBodyPositions();
 }
 
 
 //===========================================================================
 /*!
       Update position and orientation from ode models to chai models.
+      If the simulation thread is running, bodies are set to the poses
+      interpolated between the last two states published by the thread.
 
       \fn       void cODEWorld::updateBodyPositions(void)
 */
@@ -245,6 +517,22 @@ void cODEWorld::updateBodyPositions(void)
 {
     list<cODEGenericBody*>::iterator i;
 
+    if (isSimulationRunning())
+    {
+        cVector3d pos;
+        cMatrix3d rot;
+        for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
+        {
+            cODEGenericBody* nextItem = *i;
+            if (getBodyPose(nextItem, pos, rot))
+            {
+                nextItem->setPos(pos);
+                nextItem->setRot(rot);
+            }
+        }
+        return;
+    }
+
     for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
     {
         cODEGenericBody* nextItem = *i;
@@ -255,18 +543,382 @@ void cODEWorld::updateBodyPositions(void)
 
 //===========================================================================
 /*!
-      Callback for handling collision detection.
+      Start computing the simulation in a dedicated thread, at a fixed
+      time step. Bodies are published at their current poses, and
+      updateDynamics() then only sets them to their interpolated poses.
+      The thread runs at the rate of the time step, under the normal
+      scheduling policy so that it never preempts the haptics thread. A
+      real-time policy may be set through getSimulationLoop() before
+      calling this method, with a priority below that of the haptics
+      thread. \n
+
+      Only the poses of bodies whose dynamic models exist when this method
+      is called are published. Bodies and their models must be created
+      while the thread is stopped, since ODE is not locked against it.
+
+      \fn       bool cODEWorld::startSimulation(const double a_timeStep)
+      \param    a_timeStep  Time step of the simulation, in seconds.
+      \return   Return \b true if the thread has started.
+*/
+//===========================================================================
+bool cODEWorld::startSimulation(const double a_timeStep)
+{
+    if (isSimulationRunning() || (a_timeStep <= 0.0)) { return (false); }
+    m_timeStep = a_timeStep;
+
+    // list bodies whose poses are published
+    m_poseBodies.clear();
+    list<cODEGenericBody*>::iterator i;
+    for(i = m_bodies.begin(); i != m_bodies.end(); ++i)
+    {
+        cODEGenericBody* nextItem = *i;
+        if (nextItem->m_ode_body != NULL)
+        {
+            nextItem->m_poseIndex = (int)m_poseBodies.size();
+            m_poseBodies.push_back(nextItem);
+        }
+        else
+        {
+            nextItem->m_poseIndex = -1;
+        }
+    }
+
+    // start from the current time and poses
+    m_lastClock = cHapticLoop::getClockSeconds();
+    m_clockOffset = m_lastClock - m_simulationTime;
+    m_accumulator = 0.0;
+    for (int j=0; j<3; j++)
+    {
+        m_poses[j].resize(m_poseBodies.size());
+        m_poseSequence[j] = 0;
+    }
+    for (int j=0; j<3; j++)
+    {
+        publishPoses();
+    }
+
+    m_numSteps = 0;
+    m_numDroppedSteps = 0;
+    m_numDroppedForces = 0;
+    m_stopRequested = false;
+    m_stopAcknowledged = false;
+
+    m_simulationLoop.setFrequency(1.0 / m_timeStep);
+    return (m_simulationLoop.start(simulationTick, this));
+}
+
+
+//===========================================================================
+/*!
+      Stop the simulation thread and wait for its current tick to
+      complete. The thread first releases the ODE data it allocated, on
+      its next tick. Forces still queued are applied on the next call to
+      updateDynamics().
+
+      \fn       void cODEWorld::stopSimulation()
+*/
+//===========================================================================
+void cODEWorld::stopSimulation()
+{
+    if (!isSimulationRunning()) { return; }
+
+    // ODE data of a thread can only be released by the thread itself
+    m_stopRequested = true;
+    cODEMemoryBarrier();
+    while (!m_stopAcknowledged)
+    {
+        cSleepMs(1);
+    }
+
+    m_simulationLoop.stop();
+    applyQueuedForces();
+}
+
+
+//===========================================================================
+/*!
+      Tick of the simulation thread. The time elapsed since the previous
+      tick is added to the time not yet simulated, and steps are taken
+      while it exceeds the time step. After an overrun of more than
+      m_maxStepsPerTick steps, the remaining time is dropped so that the
+      thread does not fall further behind. \n
+
+      ODE requires each thread calling its collision functions to allocate
+      its own data: the first tick allocates it, and the tick following a
+      call to stopSimulation() releases it and simulates nothing.
+
+      \fn       void cODEWorld::simulationTick(void* a_world)
+      \param    a_world  World simulated by the thread.
+*/
+//===========================================================================
+void cODEWorld::simulationTick(void* a_world)
+{
+    cODEWorld* world = (cODEWorld*)a_world;
+
+    // release the ODE data of the thread before it stops
+    if (world->m_stopRequested)
+    {
+        if (world->m_threadDataAllocated)
+        {
+            dCleanupODEAllDataForThread();
+            world->m_threadDataAllocated = false;
+        }
+        cODEMemoryBarrier();
+        world->m_stopAcknowledged = true;
+        return;
+    }
+
+    // allocate the ODE data of the thread
+    if (!world->m_threadDataAllocated)
+    {
+        dAllocateODEDataForThread(dAllocateMaskAll);
+        world->m_threadDataAllocated = true;
+    }
+
+    double clock = cHapticLoop::getClockSeconds();
+    world->m_accumulator = world->m_accumulator + (clock - world->m_lastClock);
+    world->m_lastClock = clock;
+
+    unsigned int numSteps = 0;
+    while (world->m_accumulator >= world->m_timeStep)
+    {
+        if (numSteps >= world->m_maxStepsPerTick)
+        {
+            unsigned int numDropped = (unsigned int)(world->m_accumulator / world->m_timeStep);
+            double droppedTime = (double)numDropped * world->m_timeStep;
+            world->m_accumulator = world->m_accumulator - droppedTime;
+            world->m_clockOffset = world->m_clockOffset + droppedTime;
+            world->m_numDroppedSteps = world->m_numDroppedSteps + numDropped;
+            break;
+        }
+
+        world->applyQueuedForces();
+        world->stepDynamics(world->m_timeStep);
+        world->publishPoses();
+
+        world->m_accumulator = world->m_accumulator - world->m_timeStep;
+        world->m_numSteps++;
+        numSteps++;
+    }
+}
+
+
+//===========================================================================
+/*!
+      Write the current poses of the bodies to the oldest of the three
+      states, and publish it as the latest one. The sequence number of the
+      state is odd while it is written, so that readers which read it at
+      the same time read again.
+
+      \fn       void cODEWorld::publishPoses()
+*/
+//===========================================================================
+void cODEWorld::publishPoses()
+{
+    long state = (m_latestPose + 1) % 3;
+
+    m_poseSequence[state] = m_poseSequence[state] + 1;
+    cODEMemoryBarrier();
+
+    vector<cODEBodyPose>& poses = m_poses[state];
+    unsigned int numBodies = (unsigned int)m_poseBodies.size();
+    for (unsigned int i=0; i<numBodies; i++)
+    {
+        cODEGenericBody* nextItem = m_poseBodies[i];
+        const dReal* odePosition = dBodyGetPosition(nextItem->m_ode_body);
+        const dReal* odeRotation = dBodyGetRotation(nextItem->m_ode_body);
+
+        cMatrix3d rot;
+        rot.set(odeRotation[0], odeRotation[1], odeRotation[2],
+                odeRotation[4], odeRotation[5], odeRotation[6],
+                odeRotation[8], odeRotation[9], odeRotation[10]);
+        poses[i].m_pos.set(odePosition[0], odePosition[1], odePosition[2]);
+        poses[i].m_rot.fromRotMat(rot);
+
+        // store previous position if object is a mesh
+        nextItem->updateLastTransform();
+    }
+    m_poseClock[state] = m_clockOffset + m_simulationTime;
+
+    cODEMemoryBarrier();
+    m_poseSequence[state] = m_poseSequence[state] + 1;
+    cODEMemoryBarrier();
+    m_latestPose = state;
+}
+
+
+//===========================================================================
+/*!
+      Get the pose of a body interpolated between the last two states
+      published by the simulation thread, one time step behind the
+      current time. May be called by any thread; never waits for the
+      simulation thread.
+
+      \fn       bool cODEWorld::getBodyPose(const cODEGenericBody* a_body,
+                                            cVector3d& a_pos,
+                                            cMatrix3d& a_rot) const
+      \param    a_body  Body.
+      \param    a_pos  Returned position of the body.
+      \param    a_rot  Returned orientation of the body.
+      \return   Return \b false if the thread is not running or the body is static.
+*/
+//===========================================================================
+bool cODEWorld::getBodyPose(const cODEGenericBody* a_body,
+                            cVector3d& a_pos,
+                            cMatrix3d& a_rot) const
+{
+    if (!isSimulationRunning() || (a_body->m_poseIndex < 0)) { return (false); }
+    int index = a_body->m_poseIndex;
+
+    // read the last two states, again if one was written meanwhile
+    cODEBodyPose pose0, pose1;
+    double clock1;
+    while (true)
+    {
+        long latest = m_latestPose;
+        long previous = (latest + 2) % 3;
+        long sequence0 = m_poseSequence[previous];
+        long sequence1 = m_poseSequence[latest];
+        cODEMemoryBarrier();
+
+        if (((sequence0 | sequence1) & 1) == 0)
+        {
+            pose0 = m_poses[previous][index];
+            pose1 = m_poses[latest][index];
+            clock1 = m_poseClock[latest];
+            cODEMemoryBarrier();
+
+            if ((m_poseSequence[previous] == sequence0) &&
+                (m_poseSequence[latest] == sequence1))
+            {
+                break;
+            }
+        }
+    }
+
+    // interpolate one time step behind the current time
+    double level = (cHapticLoop::getClockSeconds() - clock1) / m_timeStep;
+    level = cClamp01(level);
+
+    a_pos = cAdd(cMul(1.0 - level, pose0.m_pos), cMul(level, pose1.m_pos));
+
+    if (pose0.m_rot.dot(pose1.m_rot) < 0.0)
+    {
+        pose1.m_rot.negate();
+    }
+    cQuaternion rot;
+    rot.slerp(level, pose0.m_rot, pose1.m_rot);
+    rot.normalize();
+    rot.toRotMat(a_rot);
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+      Queue a force to be applied by the simulation thread on its next
+      step. Several threads may queue forces at the same time, without
+      locks: each reserves an entry of a bounded ring by incrementing its
+      tail, and marks the entry as filled through its sequence number.
+
+      \fn       bool cODEWorld::queueForce(cODEGenericBody* a_body,
+                                           const cVector3d& a_force,
+                                           const cVector3d& a_pos)
+      \param    a_body  Body to which the force is applied.
+      \param    a_force  Force in global coordinates.
+      \param    a_pos  Position at which the force is applied, in global coordinates.
+      \return   Return \b false if the queue is full and the force is dropped.
+*/
+//===========================================================================
+bool cODEWorld::queueForce(cODEGenericBody* a_body,
+                           const cVector3d& a_force,
+                           const cVector3d& a_pos)
+{
+    long position = m_forceQueueTail;
+    cODEQueuedForce* entry;
+    while (true)
+    {
+        entry = &m_forceQueue[position & (CHAI_ODE_FORCE_QUEUE_SIZE - 1)];
+        long difference = (long)((unsigned long)entry->m_sequence - (unsigned long)position);
+        if (difference == 0)
+        {
+            // the entry is free; try to reserve it
+            long previous = cODECompareAndSwap(&m_forceQueueTail, position, position + 1);
+            if (previous == position) { break; }
+            position = previous;
+        }
+        else if (difference < 0)
+        {
+            // the queue is full
+            cODEAtomicIncrement(&m_numDroppedForces);
+            return (false);
+        }
+        else
+        {
+            // another thread has reserved the entry
+            position = m_forceQueueTail;
+        }
+    }
+
+    entry->m_body = a_body;
+    entry->m_force = a_force;
+    entry->m_pos = a_pos;
+    cODEMemoryBarrier();
+    entry->m_sequence = position + 1;
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+      Apply the forces queued to the simulation thread to their bodies, in
+      the order they were queued. Called by the simulation thread only.
+
+      \fn       void cODEWorld::applyQueuedForces()
+*/
+//===========================================================================
+void cODEWorld::applyQueuedForces()
+{
+    while (true)
+    {
+        cODEQueuedForce* entry = &m_forceQueue[m_forceQueueHead & (CHAI_ODE_FORCE_QUEUE_SIZE - 1)];
+        long difference = (long)((unsigned long)entry->m_sequence - (unsigned long)(m_forceQueueHead + 1));
+        if (difference < 0) { return; }
+        cODEMemoryBarrier();
+
+        entry->m_body->wakeUp();
+        dBodyAddForceAtPos(entry->m_body->m_ode_body,
+                           entry->m_force.x, entry->m_force.y, entry->m_force.z,
+                           entry->m_pos.x, entry->m_pos.y, entry->m_pos.z);
+
+        // release the entry for the next round of the ring
+        cODEMemoryBarrier();
+        entry->m_sequence = m_forceQueueHead + CHAI_ODE_FORCE_QUEUE_SIZE;
+        m_forceQueueHead++;
+    }
+}
+
+
+//===========================================================================
+/*!
+      Callback for handling collision detection. Pairs of geometries whose
+      bodies are both static or at rest are not tested; a resting body
+      touched by an active one is woken up by ODE through their contacts.
 
       \fn       void cODEWorld::nearCallback (void *a_data, 
                                               dGeomID a_object1, 
                                               dGeomID a_object2)
-      \param    a_data   Not used here.
+      \param    a_data   ODE world.
       \param    a_object1  Reference to ODE object 1.
       \param    a_object2  Reference to ODE object 2.
 */
 //===========================================================================
 void cODEWorld::nearCallback (void *a_data, dGeomID a_object1, dGeomID a_object2)
 {
+    cODEWorld* world = (cODEWorld*)a_data;
+
     // retrieve body ID for each object. This value is defined unless the object
     // is static.
     dBodyID b1 = dGeomGetBody(a_object1);
@@ -275,44 +927,188 @@ void cODEWorld::nearCallback (void *a_data, dGeomID a_object1, dGeomID a_object2
     // exit without doing anything if the two bodies are connected by a joint
     if (b1 && b2 && dAreConnectedExcluding (b1,b2,dJointTypeContact)) return;
 
-    dContact contact[MAX_CONTACTS_PER_BODY];
-    int n = dCollide (a_object1, a_object2, MAX_CONTACTS_PER_BODY,&(contact[0].geom),sizeof(dContact));
-    if (n > 0) 
+    // exit if both objects are static or at rest, keeping their cached contacts
+    bool active1 = (b1 != NULL) && (dBodyIsEnabled(b1) != 0);
+    bool active2 = (b2 != NULL) && (dBodyIsEnabled(b2) != 0);
+    if (!active1 && !active2)
     {
-        for (int i=0; i<n; i++) 
+        if ((b1 == NULL) && (b2 == NULL)) return;
+        world->m_numRestingPairs++;
+
+        if (world->m_useContactCache)
         {
-            // define default collision properties (this section could be extended to support some ODE material class!)
-            contact[i].surface.slip1 = 0.7;
-            contact[i].surface.slip2 = 0.7;
-            contact[i].surface.mode = dContactSoftERP | dContactSoftCFM | dContactApprox1 | dContactSlip1 | dContactSlip2;
-            contact[i].surface.mu = 50;
-            contact[i].surface.soft_erp = 0.90;
-            contact[i].surface.soft_cfm = 0.10;
-
-            // get handles on each body
-            cODEGenericBody* ode_body = NULL;
-            if (b1 != NULL)
+            pair<dGeomID, dGeomID> key = (a_object1 < a_object2) ?
+                                         pair<dGeomID, dGeomID>(a_object1, a_object2) :
+                                         pair<dGeomID, dGeomID>(a_object2, a_object1);
+            map<pair<dGeomID, dGeomID>, cODEContactCacheEntry>::iterator entry = world->m_contactCache.find(key);
+            if (entry != world->m_contactCache.end())
             {
-	            ode_body = (cODEGenericBody*)dBodyGetData (b1);
+                entry->second.m_step = world->m_contactCacheStep;
             }
-            else if (b2 != NULL)
+        }
+        return;
+    }
+
+    dContactGeom contactGeoms[MAX_CONTACTS_PER_BODY];
+    int n = world->findContacts(a_object1, a_object2, contactGeoms);
+    for (int i=0; i<n; i++) 
+    {
+        dContact contact;
+        contact.geom = contactGeoms[i];
+
+        // define default collision properties (this section could be extended to support some ODE material class!)
+        contact.surface.slip1 = 0.7;
+        contact.surface.slip2 = 0.7;
+        contact.surface.mode = dContactSoftERP | dContactSoftCFM | dContactApprox1 | dContactSlip1 | dContactSlip2;
+        contact.surface.mu = 50;
+        contact.surface.soft_erp = 0.90;
+        contact.surface.soft_cfm = 0.10;
+
+        // create a joint following collision
+        dJointID c = dJointCreateContact (world->m_ode_world,
+                                          world->m_ode_contactgroup,
+                                          &contact);
+        dJointAttach (c,
+                      dGeomGetBody(contact.geom.g1),
+                      dGeomGetBody(contact.geom.g2));
+    }
+    world->m_numContacts = world->m_numContacts + n;
+}
+
+
+//===========================================================================
+/*!
+      Find the contacts between two geometries. If the cache is used and
+      the pair is cached, its contacts are reused as long as neither
+      geometry has moved by more than the tolerances since they were
+      found. Contacts are always computed with the geometry of lower
+      address first, so that cached contacts keep their orientation.
+
+      \fn       int cODEWorld::findContacts(dGeomID a_object1,
+                                            dGeomID a_object2,
+                                            dContactGeom* a_contacts)
+      \param    a_object1  Reference to ODE object 1.
+      \param    a_object2  Reference to ODE object 2.
+      \param    a_contacts  Returned contacts, MAX_CONTACTS_PER_BODY at most.
+      \return   Return the number of contacts.
+*/
+//===========================================================================
+int cODEWorld::findContacts(dGeomID a_object1,
+                            dGeomID a_object2,
+                            dContactGeom* a_contacts)
+{
+    if (a_object2 < a_object1)
+    {
+        dGeomID object = a_object1;
+        a_object1 = a_object2;
+        a_object2 = object;
+    }
+
+    if (!m_useContactCache)
+    {
+        m_numCollisionTests++;
+        return (dCollide(a_object1, a_object2, MAX_CONTACTS_PER_BODY, a_contacts, sizeof(dContactGeom)));
+    }
+
+    cODEContactCacheEntry& entry = m_contactCache[pair<dGeomID, dGeomID>(a_object1, a_object2)];
+
+    // compare the state of both geometries to the cached one
+    dReal state[2][15];
+    getGeomState(a_object1, state[0]);
+    getGeomState(a_object2, state[1]);
+
+    bool moved = entry.m_contacts.empty();
+    for (int i=0; (i<2) && !moved; i++)
+    {
+        // static geometries are compared exactly
+        bool isBody = (dGeomGetBody((i == 0) ? a_object1 : a_object2) != NULL);
+        for (int j=0; j<15; j++)
+        {
+            double tolerance = 0.0;
+            if (isBody)
             {
-                // if first object is static, use the second one. (both objects can not be static) 
-                ode_body = (cODEGenericBody*)dBodyGetData (b2);
+                tolerance = (j < 3) ? m_linearCacheTolerance : m_angularCacheTolerance;
             }
-                
-            // create a joint following collision
-            if (ode_body != NULL)
+            dReal value = state[i][j];
+            dReal cachedValue = entry.m_state[i][j];
+            if ((value != cachedValue) && !(fabs(value - cachedValue) <= tolerance))
             {
-                dJointID c = dJointCreateContact (ode_body->m_ODEWorld->m_ode_world,
-									                ode_body->m_ODEWorld->m_ode_contactgroup,
-									                &contact[i]);
-                dJointAttach (c,
-		                    dGeomGetBody(contact[i].geom.g1),
-		                    dGeomGetBody(contact[i].geom.g2));
+                moved = true;
+                break;
             }
-
         }
     }
+
+    if (moved)
+    {
+        entry.m_contacts.resize(MAX_CONTACTS_PER_BODY);
+        entry.m_numContacts = dCollide(a_object1, a_object2, MAX_CONTACTS_PER_BODY,
+                                       &entry.m_contacts[0], sizeof(dContactGeom));
+        memcpy(entry.m_state, state, sizeof(state));
+        m_numCollisionTests++;
+    }
+    else
+    {
+        m_numCachedContacts = m_numCachedContacts + entry.m_numContacts;
+    }
+    entry.m_step = m_contactCacheStep;
+
+    for (int i=0; i<entry.m_numContacts; i++)
+    {
+        a_contacts[i] = entry.m_contacts[i];
+    }
+    return (entry.m_numContacts);
+}
+
+
+//===========================================================================
+/*!
+      Read the state of a geometry: the position and rotation of its body,
+      or the bounding box of a static geometry followed by zeros.
+
+      \fn       void cODEWorld::getGeomState(dGeomID a_object, dReal* a_state)
+      \param    a_object  Reference to ODE object.
+      \param    a_state  Returned state, 15 values.
+*/
+//===========================================================================
+void cODEWorld::getGeomState(dGeomID a_object, dReal* a_state)
+{
+    dBodyID body = dGeomGetBody(a_object);
+    if (body != NULL)
+    {
+        const dReal* pos = dBodyGetPosition(body);
+        const dReal* rot = dBodyGetRotation(body);
+        for (int i=0; i<3; i++) { a_state[i] = pos[i]; }
+        for (int i=0; i<12; i++) { a_state[3+i] = rot[i]; }
+    }
+    else
+    {
+        dGeomGetAABB(a_object, a_state);
+        for (int i=6; i<15; i++) { a_state[i] = 0.0; }
+    }
 }
 
+
+//===========================================================================
+/*!
+      Remove from the cache the pairs of geometries which were not
+      reported by the collision space during the current step.
+
+      \fn       void cODEWorld::cleanContactCache()
+*/
+//===========================================================================
+void cODEWorld::cleanContactCache()
+{
+    map<pair<dGeomID, dGeomID>, cODEContactCacheEntry>::iterator i = m_contactCache.begin();
+    while (i != m_contactCache.end())
+    {
+        if (i->second.m_step != m_contactCacheStep)
+        {
+            m_contactCache.erase(i++);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
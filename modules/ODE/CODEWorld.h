@@ -24,6 +24,13 @@
 //---------------------------------------------------------------------------
 #include "chai3d.h"
 #include "CODEGenericBody.h"
+#include <map>
+//---------------------------------------------------------------------------
+using std::map;
+using std::pair;
+//---------------------------------------------------------------------------
+//! Number of forces which can be queued to the simulation thread of a cODEWorld (power of two).
+#define CHAI_ODE_FORCE_QUEUE_SIZE 1024
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -37,6 +44,78 @@
 //===========================================================================
 
 
+//===========================================================================
+/*!
+    \struct     cODEBodyPose
+    \ingroup    ODE
+
+    \brief
+    cODEBodyPose is the position and orientation of an ODE body published
+    by the simulation thread of a cODEWorld.
+*/
+//===========================================================================
+struct cODEBodyPose
+{
+    //! Position of the body.
+    cVector3d m_pos;
+
+    //! Orientation of the body.
+    cQuaternion m_rot;
+};
+
+
+//===========================================================================
+/*!
+    \struct     cODEQueuedForce
+    \ingroup    ODE
+
+    \brief
+    cODEQueuedForce is a force applied to an ODE body, queued to the
+    simulation thread of a cODEWorld.
+*/
+//===========================================================================
+struct cODEQueuedForce
+{
+    //! Sequence number telling whether the entry is free or holds a force.
+    volatile long m_sequence;
+
+    //! Body to which the force is applied.
+    cODEGenericBody* m_body;
+
+    //! Force in global coordinates.
+    cVector3d m_force;
+
+    //! Position at which the force is applied, in global coordinates.
+    cVector3d m_pos;
+};
+
+
+//===========================================================================
+/*!
+    \struct     cODEContactCacheEntry
+    \ingroup    ODE
+
+    \brief
+    cODEContactCacheEntry holds the contacts found between a pair of ODE
+    geometries, and the state of both geometries when they were found.
+*/
+//===========================================================================
+struct cODEContactCacheEntry
+{
+    //! Contacts found between the two geometries.
+    vector<dContactGeom> m_contacts;
+
+    //! Number of contacts found between the two geometries.
+    int m_numContacts;
+
+    //! State of each geometry when the contacts were found: body position and rotation, or bounding box of a static geometry.
+    dReal m_state[2][15];
+
+    //! Step at which the pair was last reported by the collision space.
+    unsigned int m_step;
+};
+
+
 //===========================================================================
 /*!
     \class      cODEWorld
@@ -44,7 +123,39 @@
 
     \brief      
     cODEWorld implements a virtual world to handle ODE based objects 
-    (cODEGenericBody).
+    (cODEGenericBody). \n
+
+    By default the simulation is computed by updateDynamics(), called by
+    the application at the interval of its choice. Alternatively,
+    startSimulation() computes it in a dedicated thread at a fixed time
+    step, so that long steps, with many contacts for instance, do not delay
+    the haptics loop. The thread accumulates the time elapsed since its
+    previous tick and takes as many steps as fit in it. \n
+
+    After each step, the thread publishes the poses of the bodies. The
+    three latest states are kept in a ring: the two last published ones,
+    read by the haptics and graphics threads, and the one being written.
+    Readers interpolate between the last two states, one step behind the
+    simulation, and never wait: if the writer reuses a state while it is
+    being read, the reader reads again. While the thread runs,
+    updateDynamics() and updateBodyPositions() only set the bodies to
+    their interpolated poses, and forces applied by
+    cODEGenericBody::addGlobalForceAtGlobalPos() are queued without locks
+    and applied by the thread on the next step. Bodies must be created
+    and configured while the thread is stopped; their poses are only
+    published once the thread is started again.
+    The thread runs at normal priority by default, below the haptics
+    thread. \n
+
+    Bodies at rest may be deactivated automatically (see setAutoDisable()).
+    Pairs of geometries whose bodies are both at rest or static are not
+    tested for collision; ODE wakes a body up when an active body touches
+    it. If enabled with setUseContactCache(), the contacts of each pair of
+    geometries are kept from one step to the next, and reused as long as
+    neither geometry has moved by more than a tolerance, so that resting
+    contacts are not computed again.
+    ODE does not let contact impulses be carried over between steps, so
+    only the contact geometry is cached.
 */
 //===========================================================================
 class cODEWorld : public cGenericObject
@@ -70,7 +181,7 @@ class cODEWorld : public cGenericObject
     // METHODS:
     //-----------------------------------------------------------------------
 
-    //! Set gravity field.
+    //! Set gravity field. Restarts the simulation thread if it is running.
     void setGravity(cVector3d a_gravity);
 
     //! Read gravity field.
@@ -85,12 +196,89 @@ class cODEWorld : public cGenericObject
     //! Set max angular speed.
     void setMaxAngularSpeed(double a_value) { dWorldSetMaxAngularSpeed(m_ode_world, a_value); }
 
-    //! compute dynamic simulation.
+    //! Set the automatic deactivation of bodies at rest, for all bodies of the world. Restarts the simulation thread if it is running.
+    void setAutoDisable(const bool a_enabled,
+                        const double a_linearThreshold = 0.01,
+                        const double a_angularThreshold = 0.01,
+                        const int a_steps = 10,
+                        const double a_time = 0.0);
+
+    //! Return \b true if bodies at rest are deactivated automatically.
+    bool getAutoDisable() { return (dWorldGetAutoDisableFlag(m_ode_world) != 0); }
+
+    //! Enable or disable the cache of contacts between pairs of geometries.
+    void setUseContactCache(const bool a_useContactCache);
+
+    //! Return \b true if the cache of contacts is used.
+    bool getUseContactCache() const { return (m_useContactCache); }
+
+    //! Set the motion below which the cached contacts of a pair of geometries are reused.
+    void setContactCacheTolerance(const double a_linearTolerance, const double a_angularTolerance);
+
+    //! compute dynamic simulation, or update interpolated positions if the simulation thread is running.
     void updateDynamics(double a_interval);
 
     //! update position and orientation from ode models to chai models.
     void updateBodyPositions(void);
 
+
+	//-----------------------------------------------------------------------
+    // METHODS - SIMULATION THREAD:
+    //-----------------------------------------------------------------------
+
+    //! Start computing the simulation in a dedicated thread at a fixed time step.
+    bool startSimulation(const double a_timeStep = 0.001);
+
+    //! Stop the simulation thread.
+    void stopSimulation();
+
+    //! Return \b true if the simulation thread is running.
+    bool isSimulationRunning() const { return (m_simulationLoop.isRunning()); }
+
+    //! Get the time step of the simulation thread.
+    double getTimeStep() const { return (m_timeStep); }
+
+    //! Set the maximum number of steps taken by a tick of the simulation thread to catch up.
+    void setMaxStepsPerTick(const unsigned int a_maxSteps) { m_maxStepsPerTick = a_maxSteps; }
+
+    //! Get the loop running the simulation thread, to set its scheduling or read its statistics.
+    cHapticLoop* getSimulationLoop() { return (&m_simulationLoop); }
+
+    //! Get the interpolated pose of a body published by the simulation thread.
+    bool getBodyPose(const cODEGenericBody* a_body, cVector3d& a_pos, cMatrix3d& a_rot) const;
+
+    //! Queue a force to be applied by the simulation thread on its next step.
+    bool queueForce(cODEGenericBody* a_body, const cVector3d& a_force, const cVector3d& a_pos);
+
+    //! Get the number of steps computed by the simulation thread.
+    unsigned int getNumSteps() const { return (m_numSteps); }
+
+    //! Get the number of steps dropped because the simulation thread could not catch up.
+    unsigned int getNumDroppedSteps() const { return (m_numDroppedSteps); }
+
+    //! Get the number of forces dropped because the queue was full.
+    unsigned int getNumDroppedForces() const { return ((unsigned int)m_numDroppedForces); }
+
+
+	//-----------------------------------------------------------------------
+    // METHODS - STATISTICS OF THE LAST STEP:
+    //-----------------------------------------------------------------------
+
+    //! Get the number of bodies which were active.
+    unsigned int getNumActiveBodies() const { return (m_numActiveBodies); }
+
+    //! Get the number of contacts created.
+    unsigned int getNumContacts() const { return (m_numContacts); }
+
+    //! Get the number of contacts reused from the cache.
+    unsigned int getNumCachedContacts() const { return (m_numCachedContacts); }
+
+    //! Get the number of pairs of geometries tested for collision.
+    unsigned int getNumCollisionTests() const { return (m_numCollisionTests); }
+
+    //! Get the number of pairs of geometries not tested because both were at rest.
+    unsigned int getNumRestingPairs() const { return (m_numRestingPairs); }
+
     // update global position frames.
     void updateGlobalPositions(const bool a_frameOnly);
 
@@ -122,6 +310,106 @@ class cODEWorld : public cGenericObject
 	cWorld* m_parentWorld;
 
 
+	//-----------------------------------------------------------------------
+    // MEMBERS - SIMULATION THREAD:
+    //-----------------------------------------------------------------------
+
+    //! Loop running the simulation thread.
+    cHapticLoop m_simulationLoop;
+
+    //! Time step of the simulation thread.
+    double m_timeStep;
+
+    //! Maximum number of steps taken by a tick of the simulation thread.
+    unsigned int m_maxStepsPerTick;
+
+    //! Time elapsed and not yet simulated.
+    double m_accumulator;
+
+    //! Clock time of the previous tick of the simulation thread.
+    double m_lastClock;
+
+    //! Clock time at which the simulation time was zero, shifted by dropped steps.
+    double m_clockOffset;
+
+    //! Bodies whose poses are published, each at the index cODEGenericBody::m_poseIndex.
+    vector<cODEGenericBody*> m_poseBodies;
+
+    //! Poses of the bodies in each of the three published states.
+    vector<cODEBodyPose> m_poses[3];
+
+    //! Clock time of each published state.
+    double m_poseClock[3];
+
+    //! Sequence number of each published state, odd while the state is written.
+    volatile long m_poseSequence[3];
+
+    //! Index of the latest published state.
+    volatile long m_latestPose;
+
+    //! Forces queued to the simulation thread.
+    cODEQueuedForce m_forceQueue[CHAI_ODE_FORCE_QUEUE_SIZE];
+
+    //! Position of the next force to be queued.
+    volatile long m_forceQueueTail;
+
+    //! Position of the next force to be applied.
+    long m_forceQueueHead;
+
+    //! Number of steps computed by the simulation thread.
+    unsigned int m_numSteps;
+
+    //! Number of steps dropped by the simulation thread.
+    unsigned int m_numDroppedSteps;
+
+    //! Number of forces dropped because the queue was full.
+    volatile long m_numDroppedForces;
+
+    //! If \b true, the simulation thread has allocated its ODE data.
+    bool m_threadDataAllocated;
+
+    //! If \b true, the simulation thread releases its ODE data and stops simulating.
+    volatile bool m_stopRequested;
+
+    //! If \b true, the simulation thread has released its ODE data.
+    volatile bool m_stopAcknowledged;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS - CONTACTS:
+    //-----------------------------------------------------------------------
+
+    //! If \b true, contacts between pairs of geometries are cached.
+    bool m_useContactCache;
+
+    //! Linear motion below which cached contacts are reused.
+    double m_linearCacheTolerance;
+
+    //! Angular motion below which cached contacts are reused.
+    double m_angularCacheTolerance;
+
+    //! Contacts cached for each pair of geometries, the first having the lower address.
+    map<pair<dGeomID, dGeomID>, cODEContactCacheEntry> m_contactCache;
+
+    //! Number of steps computed, used to find cache entries of pairs no longer in contact.
+    unsigned int m_contactCacheStep;
+
+    //! Number of active bodies during the last step.
+    unsigned int m_numActiveBodies;
+
+    //! Number of contacts created during the last step.
+    unsigned int m_numContacts;
+
+    //! Number of contacts reused from the cache during the last step.
+    unsigned int m_numCachedContacts;
+
+    //! Number of pairs of geometries tested for collision during the last step.
+    unsigned int m_numCollisionTests;
+
+    //! Number of pairs of geometries at rest during the last step.
+    unsigned int m_numRestingPairs;
+
+
 	//-----------------------------------------------------------------------
     // METHODS:
     //-----------------------------------------------------------------------
@@ -129,6 +417,27 @@ class cODEWorld : public cGenericObject
 	//! ODE collision callback.
 	static void nearCallback (void *data, dGeomID o1, dGeomID o2);
 
+    //! Compute collisions and integrate the simulation over a time interval.
+    void stepDynamics(double a_interval);
+
+    //! Tick of the simulation thread.
+    static void simulationTick(void* a_world);
+
+    //! Write the poses of the bodies to a new state and publish it.
+    void publishPoses();
+
+    //! Apply the forces queued to the simulation thread.
+    void applyQueuedForces();
+
+    //! Find the contacts between two geometries, or take them from the cache.
+    int findContacts(dGeomID a_object1, dGeomID a_object2, dContactGeom* a_contacts);
+
+    //! Read the state of a geometry, compared to decide whether its cached contacts are still valid.
+    static void getGeomState(dGeomID a_object, dReal* a_state);
+
+    //! Remove from the cache the pairs no longer reported by the collision space.
+    void cleanContactCache();
+
     //! Render deformable mesh (OpenGL).
     virtual void render(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL);
 };
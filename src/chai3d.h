@@ -65,12 +65,15 @@
 //---------------------------------------------------------------------------
 #include "graphics/CColor.h"
 #include "graphics/CDraw3D.h"
+#include "graphics/CFrustum.h"
 #include "graphics/CGenericTexture.h"
 #include "graphics/CMacrosGL.h"
 #include "graphics/CMaterial.h"
+#include "graphics/CMeshSimplifier.h"
 #include "graphics/CTexture2D.h"
 #include "graphics/CTriangle.h"
 #include "graphics/CVertex.h"
+#include "graphics/CVertexBuffer.h"
 
 
 //---------------------------------------------------------------------------
@@ -99,6 +102,7 @@
 #include "scenegraph/CGenericObject.h"
 #include "scenegraph/CLight.h"
 #include "scenegraph/CMesh.h"
+#include "scenegraph/CRenderQueue.h"
 #include "scenegraph/CShapeLine.h"
 #include "scenegraph/CShapeSphere.h"
 #include "scenegraph/CShapeTorus.h"
@@ -136,9 +140,11 @@
 //!     \defgroup   collisions  Collision Detection
 //---------------------------------------------------------------------------
 #include "collisions/CCollisionAABB.h"
+#include "collisions/CCollisionAABBFlat.h"
 #include "collisions/CCollisionAABBBox.h"
 #include "collisions/CCollisionAABBTree.h"
 #include "collisions/CCollisionBasics.h"
+#include "collisions/CCollisionBroadphase.h"
 #include "collisions/CCollisionBrute.h"
 #include "collisions/CCollisionSpheres.h"
 #include "collisions/CCollisionSpheresGeometry.h"
@@ -148,8 +154,13 @@
 //---------------------------------------------------------------------------
 //!     \defgroup   timers  Timers
 //---------------------------------------------------------------------------
+#include "timers/CHapticLoop.h"
+#include "timers/CMutex.h"
 #include "timers/CPrecisionClock.h"
+#include "timers/CProfiler.h"
 #include "timers/CThread.h"
+#include "timers/CThreadPool.h"
+#include "timers/CTripleBuffer.h"
 
 
 //---------------------------------------------------------------------------
@@ -160,6 +171,7 @@
 #include "files/CFileLoaderOBJ.h"
 #include "files/CFileLoaderTGA.h"
 #include "files/CImageLoader.h"
+#include "files/CImageSequenceWriter.h"
 #include "files/CMeshLoader.h"
 
 
@@ -174,6 +186,9 @@
 //---------------------------------------------------------------------------
 //!     \defgroup   display  Viewports
 //---------------------------------------------------------------------------
+#include "display/CFrameBuffer.h"
+#include "display/CFrameCapture.h"
+
 #if defined(_WIN32)
 #include "display/CViewport.h"
 #endif
@@ -24,10 +24,38 @@
 #include <iostream>
 using namespace std;
 //---------------------------------------------------------------------------
-//! Pointer to first free location in array of AABB tree nodes.
-cCollisionAABBInternal* g_nextFreeNode;
+//! Trees with fewer triangles than this are always built on the calling thread.
+#define CHAI_AABB_PARALLEL_BUILD_MIN_TRIANGLES 4096
+
+//! Number of subtrees created for each thread when building a tree in parallel.
+#define CHAI_AABB_PARALLEL_BUILD_TASKS_PER_THREAD 4
 //---------------------------------------------------------------------------
 
+//===========================================================================
+/*!
+    Build one of the subtrees of an AABB tree which has been left to build
+    by cCollisionAABB::initialize(). Called by the threads of a cThreadPool.
+
+    \fn       void buildSubTree(void* a_data, unsigned int a_task)
+    \param    a_data  Pointer to the cCollisionAABBBuildSettings of the tree.
+    \param    a_task  Index of the subtree in the list of tasks.
+*/
+//===========================================================================
+static void buildSubTree(void* a_data, unsigned int a_task)
+{
+    const cCollisionAABBBuildSettings* treeSettings = (const cCollisionAABBBuildSettings*)a_data;
+    const cCollisionAABBBuildTask& task = (*treeSettings->m_tasks)[a_task];
+
+    // build the complete subtree
+    cCollisionAABBBuildSettings settings;
+    settings.m_useSAH   = treeSettings->m_useSAH;
+    settings.m_taskSize = 0;
+    settings.m_tasks    = NULL;
+
+    task.m_node->initialize(task.m_numLeaves, task.m_leaves, task.m_depth, settings);
+}
+
+
 //===========================================================================
 /*!
     Constructor of cCollisionAABB.
@@ -48,6 +76,12 @@ cCollisionAABB::cCollisionAABB(vector<cTriangle> *a_triangles, bool a_useNeighbo
     m_leaves        = NULL;
     m_numTriangles  = 0;
     m_useNeighbors  = a_useNeighbors;
+    m_useSAH        = true;
+    m_threadPool    = NULL;
+    m_useDefaultThreadPool = true;
+    m_radius        = 0.0;
+    m_buildCost     = 0.0;
+    m_numMeshTriangles = 0;
 }
 
 
@@ -62,23 +96,18 @@ cCollisionAABB::~cCollisionAABB()
 {
 
     // clear collision tree
-    if (m_root != NULL)
+    if (m_internalNodes != NULL)
     {
         delete [] m_internalNodes;
-        m_root = NULL;
+        m_internalNodes = NULL;
     }
+    m_root = NULL;
 
-    // Delete the allocated array of leaf nodes
-    //
-    // If there's only one triangle, m_root = m_leaves
-    // and we've already deleted the leaves...
-    if (m_numTriangles > 1)
+    // delete the allocated array of leaf nodes
+    if (m_leaves != NULL)
     {
-        if (m_leaves)
-        {
-            delete [] m_leaves;
-            m_leaves = NULL;
-        }
+        delete [] m_leaves;
+        m_leaves = NULL;
     }
 }
 
@@ -92,6 +121,15 @@ cCollisionAABB::~cCollisionAABB()
     with a bounding box of minimal dimensions such that it fully encloses
     the bounding boxes of its two children and is aligned with the axes.
 
+    Nodes are split with the binned Surface Area Heuristic unless
+    setUseSAH(false) has been called. On large meshes, the upper levels
+    of the tree are built first, and the remaining subtrees are then built
+    in parallel by the thread pool. Unless setThreadPool() has been called,
+    the default thread pool of the library is only fetched, and thus
+    created, when a tree is that large. The construction is re-entrant, so
+    several trees may be initialized at the same time from different
+    threads.
+
     \fn       void cCollisionAABB::initialize(double a_radius)
     \param    a_radius radius to add around the triangles.
 */
@@ -100,13 +138,22 @@ void cCollisionAABB::initialize(double a_radius)
 {
     unsigned int i;
     m_lastCollision = NULL;
+    m_radius = a_radius;
+    m_buildCost = 0.0;
+    m_numMeshTriangles = (unsigned int)m_triangles->size();
 
     // if a previous tree was created, delete it
-    if (m_root != NULL)
+    if (m_internalNodes != NULL)
     {
-        delete[] m_root;
-        m_root = NULL;
+        delete [] m_internalNodes;
+        m_internalNodes = NULL;
     }
+    if (m_leaves != NULL)
+    {
+        delete [] m_leaves;
+        m_leaves = NULL;
+    }
+    m_root = NULL;
 
     // reset triangle counter
     m_numTriangles = 0;
@@ -145,10 +192,41 @@ void cCollisionAABB::initialize(double a_radius)
     // allocate an array to hold all internal nodes of the binary tree
     if (m_numTriangles >= 2)
     {
-        g_nextFreeNode = new cCollisionAABBInternal[m_numTriangles];
-        m_internalNodes = g_nextFreeNode;
-        m_root = g_nextFreeNode;
-        g_nextFreeNode->initialize(m_numTriangles, m_leaves, 0);
+        m_internalNodes = new cCollisionAABBInternal[m_numTriangles - 1];
+        m_root = m_internalNodes;
+
+        cCollisionAABBBuildSettings settings;
+        settings.m_useSAH   = m_useSAH;
+        settings.m_taskSize = 0;
+        settings.m_tasks    = NULL;
+
+        // on large meshes, build the upper levels of the tree first and
+        // keep the smaller subtrees for the threads of the pool
+        vector<cCollisionAABBBuildTask> tasks;
+        if ((m_useDefaultThreadPool) && (m_threadPool == NULL) &&
+            (m_numTriangles >= CHAI_AABB_PARALLEL_BUILD_MIN_TRIANGLES))
+        {
+            m_threadPool = cThreadPool::getDefaultThreadPool();
+        }
+
+        unsigned int numThreads = (m_threadPool != NULL) ? m_threadPool->getNumThreads() : 0;
+        if ((numThreads > 0) && (m_numTriangles >= CHAI_AABB_PARALLEL_BUILD_MIN_TRIANGLES))
+        {
+            settings.m_taskSize = m_numTriangles /
+                ((numThreads + 1) * CHAI_AABB_PARALLEL_BUILD_TASKS_PER_THREAD);
+            settings.m_tasks = &tasks;
+        }
+
+        m_internalNodes->initialize(m_numTriangles, m_leaves, 0, settings);
+
+        // build the remaining subtrees
+        if (tasks.size() > 0)
+        {
+            m_threadPool->run(buildSubTree, &settings, (unsigned int)tasks.size());
+        }
+
+        // store the cost of the new tree for refit()
+        m_buildCost = computeCost();
     }
 
     // there is only one triangle, so the tree consists of just one leaf
@@ -173,7 +251,12 @@ void cCollisionAABB::initialize(double a_radius)
     AABB boxes, starting at the root and recursing through the tree, breaking
     the recursion along any path in which the bounding box of the line segment
     does not intersect the bounding box of the node.  At the leafs,
-    triangle-segment intersection testing is called.
+    triangle-segment intersection testing is called. \n
+
+    If neighbor lists are used, the triangle hit by the previous query and
+    its neighbors are tested first. When only the nearest collision is
+    reported, the segment is then shortened to the nearest collision found
+    so far, so that the traversal skips the nodes beyond it.
 
     \fn       bool cCollisionAABB::computeCollision(cVector3d& a_segmentPointA,
               cVector3d& a_segmentPointB, cCollisionRecorder& a_recorder,
@@ -191,24 +274,179 @@ bool cCollisionAABB::computeCollision(cVector3d& a_segmentPointA, cVector3d& a_s
     // if the root is null, the tree is empty, so there can be no collision
     if (m_root == NULL)
     {
+        m_lastCollision = NULL;
         return (false);
     }
 
+    // during sustained contact, the segment usually hits the triangle found
+    // by the previous query or one of its neighbors
+    cTriangle* neighbor = NULL;
+    if ((m_useNeighbors) && (m_lastCollision != NULL) &&
+        (m_lastCollision->m_neighbors != NULL) &&
+        (a_settings.m_checkForNearestCollisionOnly))
+    {
+        neighbor = computeNeighborCollision(m_lastCollision,
+                                            a_segmentPointA,
+                                            a_segmentPointB,
+                                            a_recorder,
+                                            a_settings);
+    }
+
+    // a nearer triangle can only be hit before the nearest collision found
+    // so far, so the rest of the segment is discarded
+    cVector3d segmentPointB = a_segmentPointB;
+    if (a_settings.m_checkForNearestCollisionOnly)
+    {
+        clipSegment(a_segmentPointA, a_segmentPointB, a_recorder, segmentPointB);
+    }
+
     // create an axis-aligned bounding box for the line
     cCollisionAABBBox lineBox;
     lineBox.setEmpty();
     lineBox.enclose(a_segmentPointA);
-    lineBox.enclose(a_segmentPointB);
+    lineBox.enclose(segmentPointB);
 
     // test for intersection between the line segment and the root of the
     // collision tree; the root will recursively call children down the tree
+    double squareDistance = a_recorder.m_nearestCollision.m_squareDistance;
     bool result = m_root->computeCollision(a_segmentPointA, 
-                                           a_segmentPointB, 
+                                           segmentPointB, 
                                            lineBox,
                                            a_recorder, a_settings);
 
+    // remember the nearest triangle for the next query
+    m_lastCollision = neighbor;
+    if (result && (a_recorder.m_nearestCollision.m_squareDistance < squareDistance))
+    {
+        m_lastCollision = a_recorder.m_nearestCollision.m_triangle;
+    }
+
     // return whether there was an intersection
-    return result;
+    return (result || (neighbor != NULL));
+}
+
+
+//===========================================================================
+/*!
+    Get the bounding box of the root node of the collision tree. Boxes
+    include the radius passed to initialize().
+
+    \fn       bool cCollisionAABB::getBoundaryBox(cVector3d& a_boxMin,
+                                                  cVector3d& a_boxMax)
+    \param    a_boxMin  Returns the minimum corner of the box.
+    \param    a_boxMax  Returns the maximum corner of the box.
+    \return   Return \b false if the tree is empty.
+*/
+//===========================================================================
+bool cCollisionAABB::getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax)
+{
+    // if the root is null, the tree is empty
+    if (m_root == NULL)
+    {
+        return (false);
+    }
+
+    a_boxMin = m_root->m_bbox.m_min;
+    a_boxMax = m_root->m_bbox.m_max;
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Update the bounding boxes of the tree after the vertices of the mesh
+    have moved, without changing the structure of the tree. Leaves are
+    fitted to their triangles, then internal nodes are fitted to their
+    children in a single backward pass over the array of internal nodes,
+    in which children are always stored after their parent. The cost of
+    the refitted tree grows as the triangles drift away from the layout
+    they had when the tree was built; if a rebuild ratio has been set with
+    setRebuildRatio() and the cost exceeds the cost of the original tree
+    by this ratio, the tree is built again. \n
+
+    If triangles have been added to or removed from the mesh since the
+    tree was built, the tree is built again.
+
+    \fn       bool cCollisionAABB::refit()
+    \return   Return \b true.
+*/
+//===========================================================================
+bool cCollisionAABB::refit()
+{
+    // the tree must be built again if triangles have been added or removed
+    if (m_triangles->size() != m_numMeshTriangles)
+    {
+        initialize(m_radius);
+        return (true);
+    }
+
+    // if the root is null, the tree is empty
+    if (m_root == NULL)
+    {
+        return (true);
+    }
+
+    m_lastCollision = NULL;
+
+    // fit leaves around their triangles
+    for (unsigned int i=0; i<m_numTriangles; i++)
+    {
+        m_leaves[i].fitBBox(m_radius);
+    }
+
+    // fit internal nodes around their children, from the last one to the root
+    if (m_numTriangles < 2)
+    {
+        return (true);
+    }
+
+    for (int i=(int)m_numTriangles-2; i>=0; i--)
+    {
+        m_internalNodes[i].fitBBox();
+    }
+
+    // rebuild the tree if its quality has degraded too much
+    if ((m_rebuildRatio > 0.0) && (m_buildCost > 0.0) &&
+        (computeCost() > m_rebuildRatio * m_buildCost))
+    {
+        initialize(m_radius);
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Compute the sum of the surface areas of the internal nodes of the tree,
+    divided by the surface area of the root. This is proportional to the
+    expected number of nodes visited by a query.
+
+    \fn       double cCollisionAABB::computeCost() const
+    \return   Return the relative cost of the tree.
+*/
+//===========================================================================
+double cCollisionAABB::computeCost() const
+{
+    if ((m_internalNodes == NULL) || (m_numTriangles < 2))
+    {
+        return (0.0);
+    }
+
+    double rootArea = m_internalNodes[0].m_bbox.getSurfaceArea();
+    if (rootArea <= 0.0)
+    {
+        return (0.0);
+    }
+
+    double area = 0.0;
+    for (unsigned int i=0; i<m_numTriangles-1; i++)
+    {
+        area += m_internalNodes[i].m_bbox.getSurfaceArea();
+    }
+
+    return (area / rootArea);
 }
 
 
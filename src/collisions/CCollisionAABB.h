@@ -29,6 +29,7 @@
 #include "collisions/CGenericCollision.h"
 #include "collisions/CCollisionAABBBox.h"
 #include "collisions/CCollisionAABBTree.h"
+#include "timers/CThreadPool.h"
 #include <vector>
 //---------------------------------------------------------------------------
 
@@ -85,9 +86,35 @@ class cCollisionAABB : public cGenericCollision
     //! Return the root node of the collision tree.
     cCollisionAABBNode* getRoot() { return (m_root); }
 
+    //! Get the bounding box of the root node of the collision tree.
+    bool getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax);
+
+    //! Update the bounding boxes of the tree from the current vertex positions.
+    bool refit();
+
+    //! Select whether the tree is built with the Surface Area Heuristic (default) or by splitting nodes at their center.
+    void setUseSAH(const bool a_useSAH) { m_useSAH = a_useSAH; }
+
+    //! Return \b true if the tree is built with the Surface Area Heuristic.
+    bool getUseSAH() const { return (m_useSAH); }
+
+    //! Set the thread pool used to build subtrees in parallel, or NULL to build on the calling thread only.
+    void setThreadPool(cThreadPool* a_threadPool) { m_threadPool = a_threadPool; m_useDefaultThreadPool = false; }
+
+    //! Get the thread pool used to build subtrees in parallel, or NULL if none has been set or needed yet.
+    cThreadPool* getThreadPool() const { return (m_threadPool); }
+
 
   protected:
 
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Return the sum of the surface areas of the internal nodes, relative to the area of the root.
+    double computeCost() const;
+
+
 	//-----------------------------------------------------------------------
     // MEMBERS:
     //-----------------------------------------------------------------------
@@ -112,6 +139,24 @@ class cCollisionAABB : public cGenericCollision
 
     //! Use list of triangles' neighbors to speed up collision detection?
     bool m_useNeighbors;
+
+    //! Build the tree with the Surface Area Heuristic?
+    bool m_useSAH;
+
+    //! Thread pool used to build subtrees in parallel.
+    cThreadPool* m_threadPool;
+
+    //! If \b true, the default thread pool is used once a tree is large enough to be built in parallel.
+    bool m_useDefaultThreadPool;
+
+    //! Radius added around the triangles when the tree was built.
+    double m_radius;
+
+    //! Cost of the tree when it was built, as returned by computeCost().
+    double m_buildCost;
+
+    //! Size of the list of triangles of the mesh when the tree was built.
+    unsigned int m_numMeshTriangles;
 };
 
 //---------------------------------------------------------------------------
@@ -199,6 +199,12 @@ class cCollisionAABBBox
     //! Return the length of the longest axis of the bounding box.
     double size() const;
 
+    //! Return the surface area of the bounding box.
+    inline double getSurfaceArea() const
+    {
+        return (8.0 * (m_extent.x * m_extent.y + m_extent.y * m_extent.z + m_extent.z * m_extent.x));
+    }
+
 
     //-----------------------------------------------------------------------
     /*!
@@ -0,0 +1,1171 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "collisions/CCollisionAABBFlat.h"
+#include <algorithm>
+#include <float.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CHAI_AABB_FLAT_USE_SSE2
+#include <emmintrin.h>
+#endif
+//---------------------------------------------------------------------------
+//! Maximum depth of a cCollisionAABBFlat tree that can be traversed by a query.
+#define CHAI_AABB_FLAT_STACK_SIZE 64
+
+//! Distance added to the collision radius when culling triangles, covering the tolerances of the exact tests.
+#define CHAI_AABB_FLAT_CULL_EPSILON 1e-9
+
+//! Maximum number of segments traversing the tree together in a batched query.
+#define CHAI_AABB_FLAT_PACKET_SIZE 32
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Compare the centers of the boxes of two triangles along a given axis.
+    Used to split the triangles at the median when building the tree.
+*/
+//===========================================================================
+struct cCollisionAABBFlatCompare
+{
+    const vector<cCollisionAABBBox>* m_boxes;
+    unsigned int m_axis;
+
+    bool operator()(const unsigned int a_index0, const unsigned int a_index1) const
+    {
+        return ((*m_boxes)[a_index0].m_center[m_axis] <
+                (*m_boxes)[a_index1].m_center[m_axis]);
+    }
+};
+
+
+//===========================================================================
+/*!
+    Convert a double to the largest float which is not greater than it.
+*/
+//===========================================================================
+static inline float cFloatRoundDown(const double a_value)
+{
+    float value = (float)a_value;
+    if ((double)value > a_value)
+    {
+        value -= (float)(fabs(value) * FLT_EPSILON) + FLT_MIN;
+    }
+    return (value);
+}
+
+
+//===========================================================================
+/*!
+    Convert a double to the smallest float which is not less than it.
+*/
+//===========================================================================
+static inline float cFloatRoundUp(const double a_value)
+{
+    float value = (float)a_value;
+    if ((double)value < a_value)
+    {
+        value += (float)(fabs(value) * FLT_EPSILON) + FLT_MIN;
+    }
+    return (value);
+}
+
+
+//===========================================================================
+/*!
+    Segment prepared for the slab tests against the nodes of the tree and
+    for the culling of the triangles of the leaves.
+*/
+//===========================================================================
+struct cCollisionAABBFlatSegment
+{
+    //! Start point of the segment.
+    double m_origin[3];
+
+    //! Direction of the segment, from its start point to its end point.
+    double m_dir[3];
+
+    //! Inverse of the coordinates of the direction of the segment.
+    double m_invDir[3];
+
+    //! If \b true, the segment is parallel to the slabs of the given axis.
+    bool m_parallel[3];
+
+    //! Distance by which boxes are enlarged for the slab tests.
+    double m_radius;
+
+    //! Distance beyond which triangles are culled.
+    double m_distance;
+
+    //! Length of the segment.
+    double m_length;
+
+    //! Position along the segment beyond which no nearer collision can be found.
+    double m_maxParam;
+
+    void set(const cVector3d& a_segmentPointA, const cVector3d& a_segmentPointB,
+             const double a_collisionRadius, const double a_treeRadius)
+    {
+        // boxes are enlarged if the collision radius exceeds the radius
+        // used to build the tree
+        m_radius = cMax(0.0, a_collisionRadius - a_treeRadius);
+
+        // triangles farther than the collision radius from the segment are
+        // culled; the exact tests tolerate errors proportional to the length
+        // of the segment
+        m_length = cDistance(a_segmentPointA, a_segmentPointB);
+        m_distance = a_collisionRadius + CHAI_AABB_FLAT_CULL_EPSILON * (1.0 + m_length);
+        m_maxParam = 1.0;
+
+        // precompute the inverse direction of the segment
+        for (unsigned int i=0; i<3; i++)
+        {
+            m_origin[i] = a_segmentPointA[i];
+            m_dir[i] = a_segmentPointB[i] - a_segmentPointA[i];
+            m_parallel[i] = (m_dir[i] == 0.0);
+            m_invDir[i] = m_parallel[i] ? 0.0 : 1.0 / m_dir[i];
+        }
+    }
+
+    void clip(const cCollisionRecorder& a_recorder, const cCollisionSettings& a_settings)
+    {
+        // when only the nearest collision is reported, boxes located beyond
+        // the nearest collision found so far can be skipped
+        double squareDistance = a_recorder.m_nearestCollision.m_squareDistance;
+        if (a_settings.m_checkForNearestCollisionOnly &&
+            (squareDistance < CHAI_DBL_MAX) && (m_length > 0.0))
+        {
+            double margin = CHAI_AABB_FLAT_CULL_EPSILON * (1.0 + m_length);
+            m_maxParam = cMin(1.0, (sqrt(squareDistance) + margin) / m_length);
+        }
+    }
+
+    bool hits(const cCollisionAABBFlatNode& a_node) const
+    {
+        // clip the segment against the three slabs of the box
+        double tmin = 0.0;
+        double tmax = m_maxParam;
+        for (unsigned int i=0; i<3; i++)
+        {
+            double lower = (double)a_node.m_min[i] - m_radius;
+            double upper = (double)a_node.m_max[i] + m_radius;
+            if (m_parallel[i])
+            {
+                if ((m_origin[i] < lower) || (m_origin[i] > upper)) { return (false); }
+            }
+            else
+            {
+                double t0 = (lower - m_origin[i]) * m_invDir[i];
+                double t1 = (upper - m_origin[i]) * m_invDir[i];
+                if (t0 > t1) { double t = t0; t0 = t1; t1 = t; }
+                if (t0 > tmin) { tmin = t0; }
+                if (t1 < tmax) { tmax = t1; }
+                if (tmin > tmax) { return (false); }
+            }
+        }
+        return (true);
+    }
+
+    bool isRightNearer(const cCollisionAABBFlatNode& a_left,
+                       const cCollisionAABBFlatNode& a_right) const
+    {
+        // compare the centers of both boxes along the direction of the segment
+        double d = 0.0;
+        for (unsigned int i=0; i<3; i++)
+        {
+            d += (((double)a_left.m_min[i] + (double)a_left.m_max[i]) -
+                  ((double)a_right.m_min[i] + (double)a_right.m_max[i])) * m_dir[i];
+        }
+        return (d > 0.0);
+    }
+};
+
+
+//===========================================================================
+/*!
+    Packet of segments traversing the tree together. With SSE2, the
+    coordinates of the segments are also stored by axis, so that the slab
+    tests of two segments are computed at once.
+*/
+//===========================================================================
+struct cCollisionAABBFlatPacket
+{
+    //! Segments of the packet.
+    cCollisionAABBFlatSegment m_segments[CHAI_AABB_FLAT_PACKET_SIZE];
+
+    //! Number of segments of the packet.
+    unsigned int m_numSegments;
+
+#if defined(CHAI_AABB_FLAT_USE_SSE2)
+    //! Start points of the segments, by axis. One entry pads packets of odd size.
+    double m_origin[3][CHAI_AABB_FLAT_PACKET_SIZE + 1];
+
+    //! Inverse directions of the segments, by axis.
+    double m_invDir[3][CHAI_AABB_FLAT_PACKET_SIZE + 1];
+
+    //! Distances by which boxes are enlarged for each segment.
+    double m_radius[CHAI_AABB_FLAT_PACKET_SIZE + 1];
+
+    //! Positions along each segment beyond which no nearer collision can be found.
+    double m_maxParam[CHAI_AABB_FLAT_PACKET_SIZE + 1];
+#endif
+
+    void set(const unsigned int a_numSegments)
+    {
+        m_numSegments = a_numSegments;
+
+#if defined(CHAI_AABB_FLAT_USE_SSE2)
+        for (unsigned int j=0; j<=a_numSegments; j++)
+        {
+            const cCollisionAABBFlatSegment& segment =
+                m_segments[(j < a_numSegments) ? j : (a_numSegments - 1)];
+            for (unsigned int k=0; k<3; k++)
+            {
+                m_origin[k][j] = segment.m_origin[k];
+                m_invDir[k][j] = segment.m_invDir[k];
+            }
+            m_radius[j] = segment.m_radius;
+            m_maxParam[j] = segment.m_maxParam;
+        }
+#endif
+    }
+
+    void clip(const unsigned int a_segment,
+              const cCollisionRecorder& a_recorder,
+              const cCollisionSettings& a_settings)
+    {
+        m_segments[a_segment].clip(a_recorder, a_settings);
+
+#if defined(CHAI_AABB_FLAT_USE_SSE2)
+        m_maxParam[a_segment] = m_segments[a_segment].m_maxParam;
+#endif
+    }
+
+    unsigned int hits(const cCollisionAABBFlatNode& a_node, const unsigned int a_mask) const
+    {
+        unsigned int mask = 0;
+
+#if defined(CHAI_AABB_FLAT_USE_SSE2)
+        // same slab tests as cCollisionAABBFlatSegment::hits(), two
+        // segments at a time
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        for (unsigned int j=0; j<m_numSegments; j+=2)
+        {
+            if (((a_mask >> j) & 3) == 0) { continue; }
+
+            __m128d radius = _mm_loadu_pd(&m_radius[j]);
+            __m128d tmin = zero;
+            __m128d tmax = _mm_loadu_pd(&m_maxParam[j]);
+            __m128d outside = zero;
+            for (unsigned int k=0; k<3; k++)
+            {
+                __m128d lower = _mm_sub_pd(_mm_set1_pd((double)a_node.m_min[k]), radius);
+                __m128d upper = _mm_add_pd(_mm_set1_pd((double)a_node.m_max[k]), radius);
+                __m128d origin = _mm_loadu_pd(&m_origin[k][j]);
+                __m128d invDir = _mm_loadu_pd(&m_invDir[k][j]);
+                __m128d t0 = _mm_mul_pd(_mm_sub_pd(lower, origin), invDir);
+                __m128d t1 = _mm_mul_pd(_mm_sub_pd(upper, origin), invDir);
+
+                // segments parallel to the slabs are not clipped, but must
+                // start between them
+                __m128d parallel = _mm_cmpeq_pd(invDir, zero);
+                __m128d tnear = _mm_andnot_pd(parallel, _mm_min_pd(t0, t1));
+                __m128d tfar = _mm_or_pd(_mm_and_pd(parallel, one),
+                                         _mm_andnot_pd(parallel, _mm_max_pd(t0, t1)));
+                outside = _mm_or_pd(outside, _mm_and_pd(parallel,
+                          _mm_or_pd(_mm_cmplt_pd(origin, lower), _mm_cmpgt_pd(origin, upper))));
+
+                tmin = _mm_max_pd(tmin, tnear);
+                tmax = _mm_min_pd(tmax, tfar);
+            }
+            __m128d inside = _mm_andnot_pd(outside, _mm_cmple_pd(tmin, tmax));
+            mask |= ((unsigned int)_mm_movemask_pd(inside) << j);
+        }
+        mask &= a_mask;
+#else
+        for (unsigned int j=0, m=a_mask; m != 0; j++, m >>= 1)
+        {
+            if ((m & 1) && m_segments[j].hits(a_node))
+            {
+                mask |= (1u << j);
+            }
+        }
+#endif
+
+        return (mask);
+    }
+};
+
+
+//===========================================================================
+/*!
+    Constructor of cCollisionAABBFlat.
+
+    \fn       cCollisionAABBFlat::cCollisionAABBFlat(vector<cTriangle> *a_triangles,
+                                                     bool a_useNeighbors)
+    \param    a_triangles     Pointer to array of triangles.
+    \param    a_useNeighbors  Use neighbor lists to speed up collision detection?
+*/
+//===========================================================================
+cCollisionAABBFlat::cCollisionAABBFlat(vector<cTriangle> *a_triangles, bool a_useNeighbors)
+{
+    // list of triangles used when building the tree
+    m_triangles = a_triangles;
+
+    // initialize members
+    m_radius        = 0.0;
+    m_buildCost     = 0.0;
+    m_numMeshTriangles = 0;
+    m_depth         = 0;
+    m_lastCollision = NULL;
+    m_useNeighbors  = a_useNeighbors;
+}
+
+
+//===========================================================================
+/*!
+    Build the tree. Each leaf encloses up to CHAI_AABB_FLAT_LEAF_SIZE
+    allocated triangles; internal nodes split their triangles at the median
+    of the centers of the triangles along the longest axis. The positions
+    of the vertices are then copied in leaf order.
+
+    \fn       void cCollisionAABBFlat::initialize(double a_radius)
+    \param    a_radius radius to add around the triangles.
+*/
+//===========================================================================
+void cCollisionAABBFlat::initialize(double a_radius)
+{
+    m_lastCollision = NULL;
+    m_radius = a_radius;
+    m_depth = 0;
+    m_buildCost = 0.0;
+    m_numMeshTriangles = (unsigned int)m_triangles->size();
+
+    // clear previous tree
+    m_nodes.clear();
+    m_triangleIndices.clear();
+    m_vertices.clear();
+    updateCullData();
+
+    // compute the bounding box of each allocated triangle
+    unsigned int numTriangles = (unsigned int)m_triangles->size();
+    vector<cCollisionAABBBox> boxes(numTriangles);
+    for (unsigned int i=0; i<numTriangles; i++)
+    {
+        cTriangle* triangle = &(*m_triangles)[i];
+        if (triangle->allocated())
+        {
+            cCollisionAABBBox& box = boxes[i];
+            box.setEmpty();
+            box.enclose(triangle->getVertex0()->getPos());
+            box.enclose(triangle->getVertex1()->getPos());
+            box.enclose(triangle->getVertex2()->getPos());
+            box.setValue(cSub(box.m_min, cVector3d(a_radius, a_radius, a_radius)),
+                         cAdd(box.m_max, cVector3d(a_radius, a_radius, a_radius)));
+            m_triangleIndices.push_back(i);
+        }
+    }
+
+    // check if the number of triangles is equal to zero
+    if (m_triangleIndices.size() == 0)
+    {
+        return;
+    }
+
+    // build tree. The indices of the triangles are reordered in leaf order.
+    unsigned int numLeafTriangles = (unsigned int)m_triangleIndices.size();
+    m_nodes.reserve(2 * (numLeafTriangles / CHAI_AABB_FLAT_LEAF_SIZE + 1));
+    buildTree(0, numLeafTriangles, boxes, 0);
+
+    // copy vertices in leaf order
+    m_vertices.resize(3 * numLeafTriangles);
+    for (unsigned int i=0; i<numLeafTriangles; i++)
+    {
+        cTriangle* triangle = &(*m_triangles)[m_triangleIndices[i]];
+        m_vertices[3*i+0] = triangle->getVertex0()->getPos();
+        m_vertices[3*i+1] = triangle->getVertex1()->getPos();
+        m_vertices[3*i+2] = triangle->getVertex2()->getPos();
+    }
+    updateCullData();
+
+    // store the cost of the new tree for refit()
+    m_buildCost = computeCost();
+}
+
+
+//===========================================================================
+/*!
+    Build the subtree enclosing a range of triangles. The node is appended
+    to the array, followed by its left subtree and then its right subtree.
+
+    \fn       unsigned int cCollisionAABBFlat::buildTree(unsigned int a_first,
+              unsigned int a_numTriangles, const vector<cCollisionAABBBox>& a_boxes,
+              const unsigned int a_depth)
+    \param    a_first  Position of the first triangle of the range in leaf order.
+    \param    a_numTriangles  Number of triangles of the range.
+    \param    a_boxes  Bounding boxes of the triangles of the mesh.
+    \param    a_depth  Depth of the node.
+    \return   Return the index of the node.
+*/
+//===========================================================================
+unsigned int cCollisionAABBFlat::buildTree(unsigned int a_first,
+                                           unsigned int a_numTriangles,
+                                           const vector<cCollisionAABBBox>& a_boxes,
+                                           const unsigned int a_depth)
+{
+    unsigned int index = (unsigned int)m_nodes.size();
+    m_nodes.push_back(cCollisionAABBFlatNode());
+    if (a_depth > m_depth) { m_depth = a_depth; }
+
+    // compute the boxes enclosing the triangles and their centers
+    unsigned int* indices = &m_triangleIndices[a_first];
+    cCollisionAABBBox bbox, centers;
+    bbox.setEmpty();
+    centers.setEmpty();
+    for (unsigned int i=0; i<a_numTriangles; i++)
+    {
+        bbox.enclose(a_boxes[indices[i]]);
+        centers.enclose(a_boxes[indices[i]].m_center);
+    }
+
+    cCollisionAABBFlatNode& node = m_nodes[index];
+    for (unsigned int i=0; i<3; i++)
+    {
+        node.m_min[i] = cFloatRoundDown(bbox.m_min[i]);
+        node.m_max[i] = cFloatRoundUp(bbox.m_max[i]);
+    }
+
+    // leaf node
+    if (a_numTriangles <= CHAI_AABB_FLAT_LEAF_SIZE)
+    {
+        node.m_index = a_first;
+        node.m_numTriangles = a_numTriangles;
+        return (index);
+    }
+
+    // split at the median along the axis along which the centers are spread the most
+    cCollisionAABBFlatCompare compare;
+    compare.m_boxes = &a_boxes;
+    compare.m_axis = centers.longestAxis();
+
+    unsigned int median = a_numTriangles / 2;
+    std::nth_element(indices, indices + median, indices + a_numTriangles, compare);
+
+    // the left child is located right after its parent
+    buildTree(a_first, median, a_boxes, a_depth + 1);
+    unsigned int right = buildTree(a_first + median, a_numTriangles - median, a_boxes, a_depth + 1);
+
+    m_nodes[index].m_index = right;
+    m_nodes[index].m_numTriangles = 0;
+
+    return (index);
+}
+
+
+//===========================================================================
+/*!
+    Check if the given line segment intersects any triangle of the mesh.
+    The tree is traversed with an explicit stack, discarding every node
+    whose box is not crossed by the segment. The triangles of the leaves
+    that are reached are tested using the copy of their vertices. Children
+    are visited nearest first and, when only the nearest collision is
+    reported, nodes located beyond the nearest collision found so far are
+    skipped. \n
+
+    If neighbor lists are used, the triangle hit by the previous query and
+    its neighbors are tested first, so that the traversal starts with the
+    segment already clipped to the nearest of them.
+
+    \fn       bool cCollisionAABBFlat::computeCollision(cVector3d& a_segmentPointA,
+              cVector3d& a_segmentPointB, cCollisionRecorder& a_recorder,
+              cCollisionSettings& a_settings)
+    \param    a_segmentPointA  Initial point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_recorder  Stores all collision events
+    \param    a_settings  Contains collision settings information.
+    \return   Return true if a collision event has occurred.
+*/
+//===========================================================================
+bool cCollisionAABBFlat::computeCollision(cVector3d& a_segmentPointA,
+                                          cVector3d& a_segmentPointB,
+                                          cCollisionRecorder& a_recorder,
+                                          cCollisionSettings& a_settings)
+{
+    // if there are no nodes, the tree is empty, so there can be no collision
+    if (m_nodes.size() == 0)
+    {
+        m_lastCollision = NULL;
+        return (false);
+    }
+
+    // during sustained contact, the segment usually hits the triangle found
+    // by the previous query or one of its neighbors; a nearer triangle may
+    // still be elsewhere, so the tree is traversed in any case
+    cTriangle* neighbor = NULL;
+    if ((m_useNeighbors) && (m_lastCollision != NULL) &&
+        (m_lastCollision->m_neighbors != NULL) &&
+        (a_settings.m_checkForNearestCollisionOnly))
+    {
+        neighbor = computeNeighborCollision(m_lastCollision,
+                                            a_segmentPointA,
+                                            a_segmentPointB,
+                                            a_recorder,
+                                            a_settings);
+    }
+
+    // prepare the segment for the slab tests and the culling of triangles
+    cCollisionAABBFlatSegment segment;
+    segment.set(a_segmentPointA, a_segmentPointB, a_settings.m_collisionRadius, m_radius);
+    segment.clip(a_recorder, a_settings);
+
+    const cCollisionAABBFlatNode* nodes = &m_nodes[0];
+    double squareDistance = a_recorder.m_nearestCollision.m_squareDistance;
+    bool hit = false;
+
+    unsigned int stack[CHAI_AABB_FLAT_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const cCollisionAABBFlatNode& node = nodes[stack[--stackSize]];
+        a_recorder.m_numNodeTests++;
+        if (!segment.hits(node)) { continue; }
+
+        if (node.m_numTriangles > 0)
+        {
+            // test the triangles of the leaf
+            if (computeLeafCollision(node, a_segmentPointA, a_segmentPointB,
+                                     segment.m_distance, a_recorder, a_settings))
+            {
+                hit = true;
+                segment.clip(a_recorder, a_settings);
+            }
+        }
+        else
+        {
+            // visit the nearest child first, so that the other one may be
+            // skipped once a collision has been found
+            unsigned int left = (unsigned int)(&node - nodes) + 1;
+            if (segment.isRightNearer(nodes[left], nodes[node.m_index]))
+            {
+                stack[stackSize++] = left;
+                stack[stackSize++] = node.m_index;
+            }
+            else
+            {
+                stack[stackSize++] = node.m_index;
+                stack[stackSize++] = left;
+            }
+        }
+    }
+
+    // remember the nearest triangle for the next query
+    m_lastCollision = neighbor;
+    if (hit && (a_recorder.m_nearestCollision.m_squareDistance < squareDistance))
+    {
+        m_lastCollision = a_recorder.m_nearestCollision.m_triangle;
+    }
+
+    // return whether there was an intersection
+    return (hit || (neighbor != NULL));
+}
+
+
+//===========================================================================
+/*!
+    Check a batch of segments for collisions. The segments are split into
+    packets of up to CHAI_AABB_FLAT_PACKET_SIZE segments, and the tree is
+    traversed once per packet: each node carries a mask of the segments of
+    the packet which cross its box, and subtrees are skipped as soon as
+    the mask is empty. Each segment is tested with its own settings. \n
+
+    The neighbors of the last triangle hit are not used by batched queries.
+
+    \fn       bool cCollisionAABBFlat::computeCollisions(vector<cCollisionSegment>& a_segments)
+    \param    a_segments  Segments to test, in the local frame of the object.
+    \return   Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cCollisionAABBFlat::computeCollisions(vector<cCollisionSegment>& a_segments)
+{
+    m_lastCollision = NULL;
+
+    // if there are no nodes, the tree is empty, so there can be no collision
+    if (m_nodes.size() == 0)
+    {
+        return (false);
+    }
+
+    bool hit = false;
+    unsigned int numSegments = (unsigned int)a_segments.size();
+    for (unsigned int first=0; first<numSegments; first+=CHAI_AABB_FLAT_PACKET_SIZE)
+    {
+        unsigned int numPacketSegments = numSegments - first;
+        if (numPacketSegments > CHAI_AABB_FLAT_PACKET_SIZE)
+        {
+            numPacketSegments = CHAI_AABB_FLAT_PACKET_SIZE;
+        }
+        hit = hit | computePacketCollisions(&a_segments[first], numPacketSegments);
+    }
+
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Check a packet of segments for collisions with a single traversal of
+    the tree.
+
+    \fn       bool cCollisionAABBFlat::computePacketCollisions(cCollisionSegment* a_segments,
+              const unsigned int a_numSegments)
+    \param    a_segments  Segments of the packet.
+    \param    a_numSegments  Number of segments, at most CHAI_AABB_FLAT_PACKET_SIZE.
+    \return   Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cCollisionAABBFlat::computePacketCollisions(cCollisionSegment* a_segments,
+                                                 const unsigned int a_numSegments)
+{
+    // prepare the segments of the packet, and compute the box enclosing
+    // all of them
+    cCollisionAABBFlatPacket packet;
+    cCollisionAABBFlatSegment* segments = packet.m_segments;
+    double packetMin[3], packetMax[3];
+    for (unsigned int k=0; k<3; k++)
+    {
+        packetMin[k] = CHAI_LARGE;
+        packetMax[k] = -CHAI_LARGE;
+    }
+    for (unsigned int j=0; j<a_numSegments; j++)
+    {
+        const cVector3d& segmentPointA = a_segments[j].m_segmentPointA;
+        const cVector3d& segmentPointB = a_segments[j].m_segmentPointB;
+        segments[j].set(segmentPointA, segmentPointB,
+                        a_segments[j].m_settings->m_collisionRadius,
+                        m_radius);
+        segments[j].clip(*a_segments[j].m_recorder, *a_segments[j].m_settings);
+        for (unsigned int k=0; k<3; k++)
+        {
+            double radius = segments[j].m_radius;
+            packetMin[k] = cMin(packetMin[k], cMin(segmentPointA[k], segmentPointB[k]) - radius);
+            packetMax[k] = cMax(packetMax[k], cMax(segmentPointA[k], segmentPointB[k]) + radius);
+        }
+    }
+    packet.set(a_numSegments);
+
+    const cCollisionAABBFlatNode* nodes = &m_nodes[0];
+    unsigned int numNodeTests = 0;
+    bool hit = false;
+
+    unsigned int stack[CHAI_AABB_FLAT_STACK_SIZE];
+    unsigned int masks[CHAI_AABB_FLAT_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize] = 0;
+    masks[stackSize++] = (a_numSegments < 32) ? ((1u << a_numSegments) - 1) : 0xffffffff;
+
+    while (stackSize > 0)
+    {
+        --stackSize;
+        const cCollisionAABBFlatNode& node = nodes[stack[stackSize]];
+        numNodeTests++;
+
+        // skip the node if its box does not overlap the box of the packet
+        if ((node.m_min[0] > packetMax[0]) || (node.m_max[0] < packetMin[0]) ||
+            (node.m_min[1] > packetMax[1]) || (node.m_max[1] < packetMin[1]) ||
+            (node.m_min[2] > packetMax[2]) || (node.m_max[2] < packetMin[2]))
+        {
+            continue;
+        }
+
+        // find the segments of the packet which cross the box of the node
+        unsigned int mask = packet.hits(node, masks[stackSize]);
+        if (mask == 0) { continue; }
+
+        if (node.m_numTriangles > 0)
+        {
+            // test the triangles of the leaf against each segment
+            for (unsigned int j=0; mask != 0; j++, mask >>= 1)
+            {
+                if ((mask & 1) == 0) { continue; }
+                cCollisionSegment& segment = a_segments[j];
+                if (computeLeafCollision(node,
+                                         segment.m_segmentPointA,
+                                         segment.m_segmentPointB,
+                                         segments[j].m_distance,
+                                         *segment.m_recorder,
+                                         *segment.m_settings))
+                {
+                    hit = true;
+                    packet.clip(j, *segment.m_recorder, *segment.m_settings);
+                }
+            }
+        }
+        else
+        {
+            // visit first the child which is nearest to the first segment
+            // of the packet
+            unsigned int left = (unsigned int)(&node - nodes) + 1;
+            unsigned int right = node.m_index;
+            unsigned int lead = 0;
+            while (((mask >> lead) & 1) == 0) { lead++; }
+            if (segments[lead].isRightNearer(nodes[left], nodes[right]))
+            {
+                unsigned int index = left; left = right; right = index;
+            }
+            stack[stackSize] = right;
+            masks[stackSize++] = mask;
+            stack[stackSize] = left;
+            masks[stackSize++] = mask;
+        }
+    }
+
+    // every node visited by the packet counts as tested for each of its segments
+    for (unsigned int j=0; j<a_numSegments; j++)
+    {
+        a_segments[j].m_recorder->m_numNodeTests += numNodeTests;
+    }
+
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Check a segment for collisions with the triangles of a leaf. The
+    triangles are culled by cullTriangles() before the exact tests.
+
+    \fn       bool cCollisionAABBFlat::computeLeafCollision(const cCollisionAABBFlatNode& a_node,
+              cVector3d& a_segmentPointA, cVector3d& a_segmentPointB,
+              const double a_distance, cCollisionRecorder& a_recorder,
+              cCollisionSettings& a_settings)
+    \param    a_node  Leaf node.
+    \param    a_segmentPointA  Initial point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_distance  Distance from the segment beyond which triangles are culled.
+    \param    a_recorder  Stores all collision events.
+    \param    a_settings  Contains collision settings information.
+    \return   Return \b true if a collision event has occurred.
+*/
+//===========================================================================
+bool cCollisionAABBFlat::computeLeafCollision(const cCollisionAABBFlatNode& a_node,
+                                              cVector3d& a_segmentPointA,
+                                              cVector3d& a_segmentPointB,
+                                              const double a_distance,
+                                              cCollisionRecorder& a_recorder,
+                                              cCollisionSettings& a_settings)
+{
+    const cVector3d* vertices = &m_vertices[0];
+    bool hit = false;
+
+    // test the triangles of the leaf which the segment may hit
+    unsigned int mask = cullTriangles(a_node.m_index, a_node.m_numTriangles,
+                                      a_segmentPointA, a_segmentPointB,
+                                      a_distance);
+    for (unsigned int i=a_node.m_index; mask != 0; i++, mask >>= 1)
+    {
+        if ((mask & 1) == 0) { continue; }
+        cTriangle* triangle = &(*m_triangles)[m_triangleIndices[i]];
+        if (triangle->computeCollision(vertices[3*i+0],
+                                       vertices[3*i+1],
+                                       vertices[3*i+2],
+                                       a_segmentPointA,
+                                       a_segmentPointB,
+                                       a_recorder,
+                                       a_settings))
+        {
+            hit = true;
+        }
+    }
+
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Get the bounding box of the root node of the tree. Boxes include the
+    radius passed to initialize().
+
+    \fn       bool cCollisionAABBFlat::getBoundaryBox(cVector3d& a_boxMin,
+                                                      cVector3d& a_boxMax)
+    \param    a_boxMin  Returns the minimum corner of the box.
+    \param    a_boxMax  Returns the maximum corner of the box.
+    \return   Return \b false if the tree is empty.
+*/
+//===========================================================================
+bool cCollisionAABBFlat::getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax)
+{
+    // if there are no nodes, the tree is empty
+    if (m_nodes.size() == 0)
+    {
+        return (false);
+    }
+
+    a_boxMin.set(m_nodes[0].m_min[0], m_nodes[0].m_min[1], m_nodes[0].m_min[2]);
+    a_boxMax.set(m_nodes[0].m_max[0], m_nodes[0].m_max[1], m_nodes[0].m_max[2]);
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Update the tree after the vertices of the mesh have moved, without
+    changing its structure. The copy of the vertex positions is taken
+    again, leaves are fitted to their triangles, and internal nodes are
+    fitted to their children in a single backward pass, since children
+    are always stored after their parent. If a rebuild ratio has been set
+    with setRebuildRatio() and the cost of the refitted tree exceeds the
+    cost of the original tree by this ratio, the tree is built again. \n
+
+    If triangles have been added to or removed from the mesh since the
+    tree was built, the tree is built again.
+
+    \fn       bool cCollisionAABBFlat::refit()
+    \return   Return \b true.
+*/
+//===========================================================================
+bool cCollisionAABBFlat::refit()
+{
+    // the tree must be built again if triangles have been added or removed
+    if (m_triangles->size() != m_numMeshTriangles)
+    {
+        initialize(m_radius);
+        return (true);
+    }
+
+    m_lastCollision = NULL;
+
+    // copy vertices in leaf order
+    unsigned int numLeafTriangles = (unsigned int)m_triangleIndices.size();
+    for (unsigned int i=0; i<numLeafTriangles; i++)
+    {
+        cTriangle* triangle = &(*m_triangles)[m_triangleIndices[i]];
+        m_vertices[3*i+0] = triangle->getVertex0()->getPos();
+        m_vertices[3*i+1] = triangle->getVertex1()->getPos();
+        m_vertices[3*i+2] = triangle->getVertex2()->getPos();
+    }
+    updateCullData();
+
+    // fit nodes, from the last one to the root
+    for (int i=(int)m_nodes.size()-1; i>=0; i--)
+    {
+        cCollisionAABBFlatNode& node = m_nodes[i];
+        if (node.m_numTriangles > 0)
+        {
+            // leaf: enclose the vertices of its triangles
+            cCollisionAABBBox bbox;
+            bbox.setEmpty();
+            unsigned int first = 3 * node.m_index;
+            unsigned int last = 3 * (node.m_index + node.m_numTriangles);
+            for (unsigned int j=first; j<last; j++)
+            {
+                bbox.enclose(m_vertices[j]);
+            }
+
+            for (unsigned int k=0; k<3; k++)
+            {
+                node.m_min[k] = cFloatRoundDown(bbox.m_min[k] - m_radius);
+                node.m_max[k] = cFloatRoundUp(bbox.m_max[k] + m_radius);
+            }
+        }
+        else
+        {
+            // internal node: enclose both children
+            const cCollisionAABBFlatNode& left  = m_nodes[i+1];
+            const cCollisionAABBFlatNode& right = m_nodes[node.m_index];
+            for (unsigned int k=0; k<3; k++)
+            {
+                node.m_min[k] = cMin(left.m_min[k], right.m_min[k]);
+                node.m_max[k] = cMax(left.m_max[k], right.m_max[k]);
+            }
+        }
+    }
+
+    // rebuild the tree if its quality has degraded too much
+    if ((m_rebuildRatio > 0.0) && (m_buildCost > 0.0) &&
+        (computeCost() > m_rebuildRatio * m_buildCost))
+    {
+        initialize(m_radius);
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Compute the sum of the surface areas of the internal nodes of the tree,
+    divided by the surface area of the root. This is proportional to the
+    expected number of nodes visited by a query.
+
+    \fn       double cCollisionAABBFlat::computeCost() const
+    \return   Return the relative cost of the tree.
+*/
+//===========================================================================
+double cCollisionAABBFlat::computeCost() const
+{
+    double rootArea = 0.0;
+    double area = 0.0;
+    for (unsigned int i=0; i<m_nodes.size(); i++)
+    {
+        const cCollisionAABBFlatNode& node = m_nodes[i];
+        if (node.m_numTriangles == 0)
+        {
+            double dx = (double)node.m_max[0] - (double)node.m_min[0];
+            double dy = (double)node.m_max[1] - (double)node.m_min[1];
+            double dz = (double)node.m_max[2] - (double)node.m_min[2];
+            double nodeArea = 2.0 * (dx * dy + dy * dz + dz * dx);
+            if (i == 0) { rootArea = nodeArea; }
+            area += nodeArea;
+        }
+    }
+
+    if (rootArea <= 0.0)
+    {
+        return (0.0);
+    }
+
+    return (area / rootArea);
+}
+
+
+//===========================================================================
+/*!
+    Compute the unit normal, the plane offset and the bounding box of each
+    triangle from the copy of its vertices. The data is stored as separate
+    arrays of coordinates in leaf order, so that the triangles of a leaf
+    can be culled together by cullTriangles(). Degenerate triangles get a
+    null normal and are never culled by their plane.
+
+    \fn       void cCollisionAABBFlat::updateCullData()
+*/
+//===========================================================================
+void cCollisionAABBFlat::updateCullData()
+{
+    unsigned int numLeafTriangles = (unsigned int)(m_vertices.size() / 3);
+    for (unsigned int k=0; k<3; k++)
+    {
+        m_planeNormals[k].resize(numLeafTriangles);
+        m_triangleMin[k].resize(numLeafTriangles);
+        m_triangleMax[k].resize(numLeafTriangles);
+    }
+    m_planeOffsets.resize(numLeafTriangles);
+
+    for (unsigned int i=0; i<numLeafTriangles; i++)
+    {
+        const cVector3d& vertex0 = m_vertices[3*i+0];
+        const cVector3d& vertex1 = m_vertices[3*i+1];
+        const cVector3d& vertex2 = m_vertices[3*i+2];
+
+        cVector3d normal = cCross(cSub(vertex1, vertex0), cSub(vertex2, vertex0));
+        double length = normal.length();
+        if (length > 0.0)
+        {
+            normal.div(length);
+        }
+        else
+        {
+            normal.zero();
+        }
+
+        for (unsigned int k=0; k<3; k++)
+        {
+            m_planeNormals[k][i] = normal[k];
+            m_triangleMin[k][i] = cMin(vertex0[k], cMin(vertex1[k], vertex2[k]));
+            m_triangleMax[k][i] = cMax(vertex0[k], cMax(vertex1[k], vertex2[k]));
+        }
+        m_planeOffsets[i] = cDot(normal, vertex0);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Find the triangles of a leaf which may lie within a given distance of
+    a segment. A triangle is culled if both points of the segment lie on
+    the same side of its plane, farther than the distance, or if its
+    bounding box enlarged by the distance does not overlap the bounding
+    box of the segment. \n
+
+    Culling is conservative: every triangle hit by the exact tests of
+    cTriangle::computeCollision() with a collision radius smaller than the
+    distance is kept, so that query results are not changed. With SSE2,
+    two triangles are culled at once.
+
+    \fn       unsigned int cCollisionAABBFlat::cullTriangles(const unsigned int a_first,
+              const unsigned int a_numTriangles, const cVector3d& a_segmentPointA,
+              const cVector3d& a_segmentPointB, const double a_distance) const
+    \param    a_first  Position of the first triangle of the leaf in leaf order.
+    \param    a_numTriangles  Number of triangles of the leaf.
+    \param    a_segmentPointA  Initial point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_distance  Distance from the segment within which triangles are kept.
+    \return   Return a mask whose bit \e i is set if triangle \e a_first + \e i is kept.
+*/
+//===========================================================================
+unsigned int cCollisionAABBFlat::cullTriangles(const unsigned int a_first,
+                                               const unsigned int a_numTriangles,
+                                               const cVector3d& a_segmentPointA,
+                                               const cVector3d& a_segmentPointB,
+                                               const double a_distance) const
+{
+    unsigned int mask = 0;
+    unsigned int i = 0;
+
+#if defined(CHAI_AABB_FLAT_USE_SSE2)
+    const __m128d distance = _mm_set1_pd(a_distance);
+    const __m128d negDistance = _mm_set1_pd(-a_distance);
+    __m128d pointA[3], pointB[3], segmentMin[3], segmentMax[3];
+    for (unsigned int k=0; k<3; k++)
+    {
+        pointA[k] = _mm_set1_pd(a_segmentPointA[k]);
+        pointB[k] = _mm_set1_pd(a_segmentPointB[k]);
+        segmentMin[k] = _mm_sub_pd(_mm_min_pd(pointA[k], pointB[k]), distance);
+        segmentMax[k] = _mm_add_pd(_mm_max_pd(pointA[k], pointB[k]), distance);
+    }
+
+    for (; i+1<a_numTriangles; i+=2)
+    {
+        unsigned int index = a_first + i;
+
+        // signed distances of both points of the segment to the planes
+        __m128d offset = _mm_loadu_pd(&m_planeOffsets[index]);
+        __m128d distanceA = _mm_sub_pd(_mm_setzero_pd(), offset);
+        __m128d distanceB = distanceA;
+        for (unsigned int k=0; k<3; k++)
+        {
+            __m128d normal = _mm_loadu_pd(&m_planeNormals[k][index]);
+            distanceA = _mm_add_pd(distanceA, _mm_mul_pd(normal, pointA[k]));
+            distanceB = _mm_add_pd(distanceB, _mm_mul_pd(normal, pointB[k]));
+        }
+        __m128d culled = _mm_or_pd(
+            _mm_and_pd(_mm_cmpgt_pd(distanceA, distance), _mm_cmpgt_pd(distanceB, distance)),
+            _mm_and_pd(_mm_cmplt_pd(distanceA, negDistance), _mm_cmplt_pd(distanceB, negDistance)));
+
+        // bounding boxes
+        for (unsigned int k=0; k<3; k++)
+        {
+            culled = _mm_or_pd(culled, _mm_cmpgt_pd(_mm_loadu_pd(&m_triangleMin[k][index]), segmentMax[k]));
+            culled = _mm_or_pd(culled, _mm_cmplt_pd(_mm_loadu_pd(&m_triangleMax[k][index]), segmentMin[k]));
+        }
+
+        mask |= (~_mm_movemask_pd(culled) & 3) << i;
+    }
+#endif
+
+    for (; i<a_numTriangles; i++)
+    {
+        unsigned int index = a_first + i;
+
+        // signed distances of both points of the segment to the plane
+        double distanceA = -m_planeOffsets[index];
+        double distanceB = -m_planeOffsets[index];
+        bool culled = false;
+        for (unsigned int k=0; k<3; k++)
+        {
+            distanceA += m_planeNormals[k][index] * a_segmentPointA[k];
+            distanceB += m_planeNormals[k][index] * a_segmentPointB[k];
+        }
+        if (((distanceA > a_distance) && (distanceB > a_distance)) ||
+            ((distanceA < -a_distance) && (distanceB < -a_distance)))
+        {
+            culled = true;
+        }
+
+        // bounding box
+        for (unsigned int k=0; (k<3) && !culled; k++)
+        {
+            double segmentMin = cMin(a_segmentPointA[k], a_segmentPointB[k]) - a_distance;
+            double segmentMax = cMax(a_segmentPointA[k], a_segmentPointB[k]) + a_distance;
+            if ((m_triangleMin[k][index] > segmentMax) ||
+                (m_triangleMax[k][index] < segmentMin))
+            {
+                culled = true;
+            }
+        }
+
+        if (!culled)
+        {
+            mask |= (1 << i);
+        }
+    }
+
+    return (mask);
+}
+
+
+//===========================================================================
+/*!
+    Render the bounding boxes of the tree in OpenGL. A negative display
+    depth renders all levels up to and including its absolute value,
+    a positive display depth renders that level only.
+
+    \fn       void cCollisionAABBFlat::render()
+*/
+//===========================================================================
+void cCollisionAABBFlat::render()
+{
+    if (m_nodes.size() == 0)
+    {
+        return;
+    }
+
+    // set rendering settings
+    glDisable(GL_LIGHTING);
+    glLineWidth(1.0);
+    glColor4fv(m_material.m_ambient.pColor());
+
+    // traverse the tree, keeping track of the depth of each node
+    unsigned int stack[CHAI_AABB_FLAT_STACK_SIZE];
+    int depths[CHAI_AABB_FLAT_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize] = 0;
+    depths[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        stackSize--;
+        unsigned int index = stack[stackSize];
+        int depth = depths[stackSize];
+        const cCollisionAABBFlatNode& node = m_nodes[index];
+
+        if (((m_displayDepth < 0) && (abs(m_displayDepth) >= depth)) || (m_displayDepth == depth))
+        {
+            cDrawWireBox(node.m_min[0], node.m_max[0],
+                         node.m_min[1], node.m_max[1],
+                         node.m_min[2], node.m_max[2]);
+        }
+
+        // visit children up to the requested level
+        if ((node.m_numTriangles == 0) && (depth < abs(m_displayDepth)))
+        {
+            stack[stackSize] = node.m_index;
+            depths[stackSize++] = depth + 1;
+            stack[stackSize] = index + 1;
+            depths[stackSize++] = depth + 1;
+        }
+    }
+
+    // restore lighting settings
+    glEnable(GL_LIGHTING);
+}
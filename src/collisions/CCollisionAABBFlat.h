@@ -0,0 +1,229 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CCollisionAABBFlatH
+#define CCollisionAABBFlatH
+//---------------------------------------------------------------------------
+#include "graphics/CTriangle.h"
+#include "graphics/CVertex.h"
+#include "math/CMaths.h"
+#include "collisions/CGenericCollision.h"
+#include "collisions/CCollisionAABBBox.h"
+#include <vector>
+//---------------------------------------------------------------------------
+//! Maximum number of triangles stored in a leaf of a cCollisionAABBFlat tree.
+#define CHAI_AABB_FLAT_LEAF_SIZE 4
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CCollisionAABBFlat.h
+
+    \brief
+    <b> Collision Detection </b> \n
+    Axis-Aligned Bounding Box Tree (AABB) - Flat Layout.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cCollisionAABBFlatNode
+    \ingroup    collisions
+
+    \brief
+    cCollisionAABBFlatNode is a 32 byte node of a cCollisionAABBFlat tree.
+    Nodes are stored in depth-first order: the left child of an internal
+    node immediately follows its parent in the array.
+*/
+//===========================================================================
+struct cCollisionAABBFlatNode
+{
+    //! Minimum corner of the bounding box, rounded down to float.
+    float m_min[3];
+
+    //! Maximum corner of the bounding box, rounded up to float.
+    float m_max[3];
+
+    //! Index of the right child (internal node) or of the first triangle in leaf order (leaf).
+    unsigned int m_index;
+
+    //! Number of triangles of a leaf. Internal nodes have no triangles.
+    unsigned int m_numTriangles;
+};
+
+
+//===========================================================================
+/*!
+    \class      cCollisionAABBFlat
+    \ingroup    collisions
+
+    \brief
+    cCollisionAABBFlat is an Axis-Aligned Bounding Box collision detection
+    tree stored as a single array of compact nodes, with no virtual calls
+    and no pointers between nodes. \n
+
+    Each leaf holds a small range of triangles. A copy of the vertex
+    positions of every triangle is stored in leaf order, so that the
+    triangles of a leaf are tested without reading the vertices through
+    the mesh. The copy is taken by initialize(), and taken again by
+    refit(), which must be called whenever the vertices of the mesh are
+    modified. \n
+
+    Queries traverse the tree with an explicit stack. The triangles of a
+    leaf are first culled together against the segment, using their
+    planes and bounding boxes enlarged by the collision radius (with SSE2
+    when available), so that the exact intersection tests of
+    cTriangle::computeCollision() only run on the triangles that the
+    segment may hit.
+*/
+//===========================================================================
+class cCollisionAABBFlat : public cGenericCollision
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cCollisionAABBFlat.
+    cCollisionAABBFlat(vector<cTriangle>* a_triangles, bool a_useNeighbors);
+
+    //! Destructor of cCollisionAABBFlat.
+    virtual ~cCollisionAABBFlat() {};
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the tree and copy the vertices of the triangles.
+    void initialize(double a_radius = 0);
+
+    //! Draw the bounding boxes in OpenGL.
+    void render();
+
+    //! Return the nearest triangle intersected by the given segment, if any.
+    bool computeCollision(cVector3d& a_segmentPointA, cVector3d& a_segmentPointB,
+         cCollisionRecorder& a_recorder, cCollisionSettings& a_settings);
+
+    //! Compute the collisions of a batch of segments, traversing the tree once per packet of segments.
+    bool computeCollisions(vector<cCollisionSegment>& a_segments);
+
+    //! Get the bounding box of the root node of the tree.
+    bool getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax);
+
+    //! Update the vertex copy and the bounding boxes of the tree from the current vertex positions.
+    bool refit();
+
+    //! Get the number of nodes of the tree.
+    unsigned int getNumNodes() const { return ((unsigned int)m_nodes.size()); }
+
+    //! Get the depth of the tree.
+    unsigned int getDepth() const { return (m_depth); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the subtree over a range of triangles and return the index of its root node.
+    unsigned int buildTree(unsigned int a_first,
+                           unsigned int a_numTriangles,
+                           const vector<cCollisionAABBBox>& a_boxes,
+                           const unsigned int a_depth);
+
+    //! Return the sum of the surface areas of the internal nodes, relative to the area of the root.
+    double computeCost() const;
+
+    //! Compute the planes and bounding boxes of the triangles from the copy of their vertices.
+    void updateCullData();
+
+    //! Compute the collisions of a packet of segments with a single traversal of the tree.
+    bool computePacketCollisions(cCollisionSegment* a_segments,
+                                 const unsigned int a_numSegments);
+
+    //! Compute the collisions of a segment with the triangles of a leaf.
+    bool computeLeafCollision(const cCollisionAABBFlatNode& a_node,
+                              cVector3d& a_segmentPointA,
+                              cVector3d& a_segmentPointB,
+                              const double a_distance,
+                              cCollisionRecorder& a_recorder,
+                              cCollisionSettings& a_settings);
+
+    //! Return a bit mask of the triangles of a leaf which may be within a distance of a segment.
+    unsigned int cullTriangles(const unsigned int a_first,
+                               const unsigned int a_numTriangles,
+                               const cVector3d& a_segmentPointA,
+                               const cVector3d& a_segmentPointB,
+                               const double a_distance) const;
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Pointer to the list of triangles in the mesh.
+    vector<cTriangle> *m_triangles;
+
+    //! Nodes of the tree, in depth-first order. The root is located at index 0.
+    vector<cCollisionAABBFlatNode> m_nodes;
+
+    //! Indices of the triangles of the mesh, in leaf order.
+    vector<unsigned int> m_triangleIndices;
+
+    //! Positions of the three vertices of each triangle, in leaf order.
+    vector<cVector3d> m_vertices;
+
+    //! Coordinates of the unit normal of each triangle, in leaf order.
+    vector<double> m_planeNormals[3];
+
+    //! Offset of the plane of each triangle along its normal, in leaf order.
+    vector<double> m_planeOffsets;
+
+    //! Coordinates of the minimum corner of the bounding box of each triangle, in leaf order.
+    vector<double> m_triangleMin[3];
+
+    //! Coordinates of the maximum corner of the bounding box of each triangle, in leaf order.
+    vector<double> m_triangleMax[3];
+
+    //! Radius added around the triangles when the tree was built.
+    double m_radius;
+
+    //! Cost of the tree when it was built, as returned by computeCost().
+    double m_buildCost;
+
+    //! Size of the list of triangles of the mesh when the tree was built.
+    unsigned int m_numMeshTriangles;
+
+    //! Depth of the tree.
+    unsigned int m_depth;
+
+    //! Triangle returned by last successful collision test.
+    cTriangle* m_lastCollision;
+
+    //! Use list of triangles' neighbors to speed up collision detection?
+    bool m_useNeighbors;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
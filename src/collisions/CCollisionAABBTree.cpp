@@ -22,9 +22,6 @@
 //---------------------------------------------------------------------------
 #include "collisions/CCollisionAABBTree.h"
 //---------------------------------------------------------------------------
-//! Pointer for creating new AABB tree nodes, declared in CCollisionAABB.cpp.
-extern cCollisionAABBInternal* g_nextFreeNode;
-//---------------------------------------------------------------------------
 
 //===========================================================================
 /*!
@@ -177,24 +174,82 @@ void cCollisionAABBInternal::render(int a_depth)
 
 //===========================================================================
 /*!
-    Initialize an internal AABB tree node.
+    Exchange the contents of two leaf nodes.
+
+    \fn       void swapLeaves(cCollisionAABBLeaf& a_leaf0, cCollisionAABBLeaf& a_leaf1)
+    \param    a_leaf0  First leaf.
+    \param    a_leaf1  Second leaf.
+*/
+//===========================================================================
+inline void swapLeaves(cCollisionAABBLeaf& a_leaf0, cCollisionAABBLeaf& a_leaf1)
+{
+    cTriangle *t_triangle           = a_leaf0.m_triangle;
+    cCollisionAABBBox t_bbox        = a_leaf0.m_bbox;
+    int t_depth                     = a_leaf0.m_depth;
+    cCollisionAABBNode* t_parent    = a_leaf0.m_parent;
+    int t_nodeType                  = a_leaf0.m_nodeType;
+
+    a_leaf0.m_triangle = a_leaf1.m_triangle;
+    a_leaf0.m_bbox     = a_leaf1.m_bbox;
+    a_leaf0.m_depth    = a_leaf1.m_depth;
+    a_leaf0.m_parent   = a_leaf1.m_parent;
+    a_leaf0.m_nodeType = a_leaf1.m_nodeType;
+
+    a_leaf1.m_triangle = t_triangle;
+    a_leaf1.m_bbox     = t_bbox;
+    a_leaf1.m_depth    = t_depth;
+    a_leaf1.m_parent   = t_parent;
+    a_leaf1.m_nodeType = t_nodeType;
+}
+
+
+//===========================================================================
+/*!
+    Return half the surface area of a box given by its two extreme points.
+
+    \fn       double halfArea(const double a_min[3], const double a_max[3])
+    \param    a_min  Minimum point of the box.
+    \param    a_max  Maximum point of the box.
+    \return   Return half the surface area of the box.
+*/
+//===========================================================================
+inline double halfArea(const double a_min[3], const double a_max[3])
+{
+    double dx = a_max[0] - a_min[0];
+    double dy = a_max[1] - a_min[1];
+    double dz = a_max[2] - a_min[2];
+    return (dx * dy + dy * dz + dz * dx);
+}
+
+
+//===========================================================================
+/*!
+    Initialize an internal AABB tree node and build the subtree over the
+    given leaves. The a_numLeaves-1 internal nodes of the subtree are
+    stored contiguously in memory, starting at this node: the right
+    subtree follows this node, and the left subtree follows the right
+    subtree. The construction does not use any global state, so that
+    several trees, or several subtrees of the same tree, can be built
+    at the same time.
 
     \fn       void cCollisionAABBInternal::initialize(unsigned int a_numLeaves,
                                         cCollisionAABBLeaf *a_leaves,
-                                        unsigned int a_depth)
+                                        unsigned int a_depth,
+                                        const cCollisionAABBBuildSettings& a_settings)
     \param    a_numLeaves  Number of leaves in subtree rooted at this node.
     \param    a_leaves  Pointer to the location in the array of leafs for the
                         first leaf under this internal node.
     \param    a_depth  Depth of this node in the collision tree.
+    \param    a_settings  Parameters of the construction. If a list of tasks
+                          is given, the subtrees which are small enough are
+                          appended to it instead of being built.
 */
 //===========================================================================
 void cCollisionAABBInternal::initialize(unsigned int a_numLeaves,
                                         cCollisionAABBLeaf *a_leaves,
-                                        unsigned int a_depth)
+                                        unsigned int a_depth,
+                                        const cCollisionAABBBuildSettings& a_settings)
 {
-    // increment free node counter
-    g_nextFreeNode++;
-
     // set depth of this node and initialize left and right subtree pointers
     m_depth = a_depth;
     m_leftSubTree = NULL;
@@ -208,48 +263,20 @@ void cCollisionAABBInternal::initialize(unsigned int a_numLeaves,
         m_bbox.enclose(a_leaves[j].m_bbox);
     }
 
-    // move leafs with smaller coordinates (on the longest axis) towards the
-    // beginning of the array and leaves with larger coordinates towards the
-    // end of the array
-    int axis = m_bbox.longestAxis();
-    unsigned int i = 0;
-    unsigned int mid = a_numLeaves;
-    while (i < mid)
+    // move leafs of the first group towards the beginning of the array and
+    // leafs of the second group towards the end of the array
+    unsigned int mid;
+    if (a_settings.m_useSAH)
     {
-        if (a_leaves[i].m_bbox.getCenter().get(axis) < m_bbox.getCenter().get(axis))
-        {
-            ++i;
-        }
-        else
-        {
-            mid--;
-            //std::swap(a_leaves[i], a_leaves[mid]);
-
-            cTriangle *t_triangle           = a_leaves[i].m_triangle;
-            cCollisionAABBBox t_bbox        = a_leaves[i].m_bbox;
-            int t_depth                     = a_leaves[i].m_depth;
-            cCollisionAABBNode* t_parent    = a_leaves[i].m_parent;
-            int t_nodeType                  = a_leaves[i].m_nodeType;
-
-            a_leaves[i].m_triangle = a_leaves[mid].m_triangle;
-            a_leaves[i].m_bbox     = a_leaves[mid].m_bbox;
-            a_leaves[i].m_depth    = a_leaves[mid].m_depth;
-            a_leaves[i].m_parent   = a_leaves[mid].m_parent;
-            a_leaves[i].m_nodeType = a_leaves[mid].m_nodeType;
-
-            a_leaves[mid].m_triangle = t_triangle;
-            a_leaves[mid].m_bbox     = t_bbox;
-            a_leaves[mid].m_depth    = t_depth;
-            a_leaves[mid].m_parent   = t_parent;
-            a_leaves[mid].m_nodeType = t_nodeType;
-        }
+        mid = splitSAH(a_numLeaves, a_leaves);
+    }
+    else
+    {
+        mid = splitCenter(a_numLeaves, a_leaves);
     }
 
-    // we expect mid, used as the right iterator in the "insertion sort" style
-    // rearrangement above, to have moved roughly to the middle of the array;
-    // however, if it never moved left or moved all the way left, set it to
-    // the middle of the array so that neither the left nor right subtree will
-    // be empty
+    // if either group is empty, set mid to the middle of the array so
+    // that neither the left nor right subtree will be empty
     if (mid == 0 || mid == a_numLeaves)
     {
         mid = a_numLeaves / 2;
@@ -258,9 +285,21 @@ void cCollisionAABBInternal::initialize(unsigned int a_numLeaves,
     // if the right subtree contains multiple triangles, create new internal node
     if (mid >= 2)
     {
-        m_rightSubTree = g_nextFreeNode;
-        g_nextFreeNode->initialize(mid, &a_leaves[0], m_depth + 1);
-        //new(g_nextFreeNode++) cCollisionAABBInternal(mid, &a_leaves[0], m_depth + 1);
+        cCollisionAABBInternal* node = this + 1;
+        m_rightSubTree = node;
+        if ((a_settings.m_tasks != NULL) && (mid <= a_settings.m_taskSize))
+        {
+            cCollisionAABBBuildTask task;
+            task.m_node = node;
+            task.m_leaves = &a_leaves[0];
+            task.m_numLeaves = mid;
+            task.m_depth = m_depth + 1;
+            a_settings.m_tasks->push_back(task);
+        }
+        else
+        {
+            node->initialize(mid, &a_leaves[0], m_depth + 1, a_settings);
+        }
     }
 
     // if there is only one triangle in the right subtree, the right subtree
@@ -274,9 +313,21 @@ void cCollisionAABBInternal::initialize(unsigned int a_numLeaves,
     // if the left subtree contains multiple triangles, create new internal node
     if (a_numLeaves - mid >= 2)
     {
-        m_leftSubTree = g_nextFreeNode;
-        g_nextFreeNode->initialize(a_numLeaves - mid, &a_leaves[mid], m_depth + 1);
-        // new(g_nextFreeNode++) cCollisionAABBInternal(a_numLeaves - mid, &a_leaves[mid], m_depth + 1);
+        cCollisionAABBInternal* node = this + mid;
+        m_leftSubTree = node;
+        if ((a_settings.m_tasks != NULL) && (a_numLeaves - mid <= a_settings.m_taskSize))
+        {
+            cCollisionAABBBuildTask task;
+            task.m_node = node;
+            task.m_leaves = &a_leaves[mid];
+            task.m_numLeaves = a_numLeaves - mid;
+            task.m_depth = m_depth + 1;
+            a_settings.m_tasks->push_back(task);
+        }
+        else
+        {
+            node->initialize(a_numLeaves - mid, &a_leaves[mid], m_depth + 1, a_settings);
+        }
     }
 
     // if there is only one triangle in the left subtree, the left subtree
@@ -289,6 +340,197 @@ void cCollisionAABBInternal::initialize(unsigned int a_numLeaves,
 }
 
 
+//===========================================================================
+/*!
+    Move the leaves whose centers lie below the center of the longest axis
+    of this node towards the beginning of the array, and the other leaves
+    towards the end of the array. The bounding box of the node must enclose
+    the leaves.
+
+    \fn       unsigned int cCollisionAABBInternal::splitCenter(unsigned int a_numLeaves,
+                                        cCollisionAABBLeaf *a_leaves)
+    \param    a_numLeaves  Number of leaves.
+    \param    a_leaves  Pointer to the first leaf.
+    \return   Return the number of leaves of the first group.
+*/
+//===========================================================================
+unsigned int cCollisionAABBInternal::splitCenter(unsigned int a_numLeaves,
+                                                 cCollisionAABBLeaf *a_leaves)
+{
+    int axis = m_bbox.longestAxis();
+    unsigned int i = 0;
+    unsigned int mid = a_numLeaves;
+    while (i < mid)
+    {
+        if (a_leaves[i].m_bbox.getCenter().get(axis) < m_bbox.getCenter().get(axis))
+        {
+            ++i;
+        }
+        else
+        {
+            mid--;
+            swapLeaves(a_leaves[i], a_leaves[mid]);
+        }
+    }
+
+    return (mid);
+}
+
+
+//===========================================================================
+/*!
+    Split the leaves with the binned Surface Area Heuristic. The centers of
+    the leaves are sorted into CHAI_AABB_SAH_NUM_BINS bins along each axis,
+    and the boundary between two bins which minimizes the sum of the surface
+    area of each group multiplied by its number of leaves is selected. Leaves
+    of the first group are moved towards the beginning of the array.
+
+    \fn       unsigned int cCollisionAABBInternal::splitSAH(unsigned int a_numLeaves,
+                                        cCollisionAABBLeaf *a_leaves)
+    \param    a_numLeaves  Number of leaves.
+    \param    a_leaves  Pointer to the first leaf.
+    \return   Return the number of leaves of the first group, or 0 if all
+              leaves share the same center.
+*/
+//===========================================================================
+unsigned int cCollisionAABBInternal::splitSAH(unsigned int a_numLeaves,
+                                              cCollisionAABBLeaf *a_leaves)
+{
+    const int numBins = CHAI_AABB_SAH_NUM_BINS;
+    unsigned int i, j;
+    int k, n;
+
+    // compute the bounds of the centers of the leaves
+    double centerMin[3] = {  1.0e50,  1.0e50,  1.0e50 };
+    double centerMax[3] = { -1.0e50, -1.0e50, -1.0e50 };
+    for (i = 0; i < a_numLeaves; ++i)
+    {
+        const cVector3d& center = a_leaves[i].m_bbox.m_center;
+        for (k = 0; k < 3; k++)
+        {
+            if (center[k] < centerMin[k]) { centerMin[k] = center[k]; }
+            if (center[k] > centerMax[k]) { centerMax[k] = center[k]; }
+        }
+    }
+
+    // evaluate the cost of each bin boundary along each axis
+    double bestCost = 0.0;
+    int bestAxis = -1;
+    int bestBin = 0;
+    double scale[3];
+
+    for (k = 0; k < 3; k++)
+    {
+        double extent = centerMax[k] - centerMin[k];
+        if (extent <= 0.0)
+        {
+            continue;
+        }
+        scale[k] = numBins / extent;
+
+        // sort leaves into bins
+        unsigned int count[numBins];
+        double binMin[numBins][3];
+        double binMax[numBins][3];
+        for (n = 0; n < numBins; n++)
+        {
+            count[n] = 0;
+            for (j = 0; j < 3; j++)
+            {
+                binMin[n][j] =  1.0e50;
+                binMax[n][j] = -1.0e50;
+            }
+        }
+
+        for (i = 0; i < a_numLeaves; ++i)
+        {
+            const cCollisionAABBBox& box = a_leaves[i].m_bbox;
+            int bin = (int)((box.m_center[k] - centerMin[k]) * scale[k]);
+            if (bin >= numBins) { bin = numBins - 1; }
+
+            count[bin]++;
+            for (j = 0; j < 3; j++)
+            {
+                if (box.m_min[j] < binMin[bin][j]) { binMin[bin][j] = box.m_min[j]; }
+                if (box.m_max[j] > binMax[bin][j]) { binMax[bin][j] = box.m_max[j]; }
+            }
+        }
+
+        // sweep from the last bin to compute the area and size of each second group
+        double areaAbove[numBins];
+        unsigned int countAbove[numBins];
+        double boxMin[3] = {  1.0e50,  1.0e50,  1.0e50 };
+        double boxMax[3] = { -1.0e50, -1.0e50, -1.0e50 };
+        unsigned int total = 0;
+        for (n = numBins - 1; n > 0; n--)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                boxMin[j] = cMin(boxMin[j], binMin[n][j]);
+                boxMax[j] = cMax(boxMax[j], binMax[n][j]);
+            }
+            total += count[n];
+            countAbove[n] = total;
+            areaAbove[n] = (total > 0) ? halfArea(boxMin, boxMax) : 0.0;
+        }
+
+        // sweep from the first bin and evaluate the cost of each boundary
+        for (j = 0; j < 3; j++)
+        {
+            boxMin[j] =  1.0e50;
+            boxMax[j] = -1.0e50;
+        }
+        total = 0;
+        for (n = 1; n < numBins; n++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                boxMin[j] = cMin(boxMin[j], binMin[n-1][j]);
+                boxMax[j] = cMax(boxMax[j], binMax[n-1][j]);
+            }
+            total += count[n-1];
+            if ((total == 0) || (countAbove[n] == 0))
+            {
+                continue;
+            }
+
+            double cost = halfArea(boxMin, boxMax) * total + areaAbove[n] * countAbove[n];
+            if ((bestAxis < 0) || (cost < bestCost))
+            {
+                bestCost = cost;
+                bestAxis = k;
+                bestBin  = n;
+            }
+        }
+    }
+
+    // all leaves share the same center
+    if (bestAxis < 0)
+    {
+        return (0);
+    }
+
+    // move the leaves located below the selected boundary to the beginning of the array
+    i = 0;
+    unsigned int mid = a_numLeaves;
+    while (i < mid)
+    {
+        int bin = (int)((a_leaves[i].m_bbox.m_center[bestAxis] - centerMin[bestAxis]) * scale[bestAxis]);
+        if (bin < bestBin)
+        {
+            ++i;
+        }
+        else
+        {
+            mid--;
+            swapLeaves(a_leaves[i], a_leaves[mid]);
+        }
+    }
+
+    return (mid);
+}
+
+
 //===========================================================================
 /*!
     Determine whether the given ray intersects the bounding box.  Based on code
@@ -413,6 +655,9 @@ bool cCollisionAABBInternal::computeCollision(cVector3d& a_segmentPointA,
                                               cCollisionRecorder& a_recorder,
                                               cCollisionSettings& a_settings)
 {
+    // count test for profiling
+    a_recorder.m_numNodeTests++;
+
     // if a line's bounding box does not intersect the node's bounding box,
     // there can be no intersection
     if (!intersect(m_bbox, a_lineBox))
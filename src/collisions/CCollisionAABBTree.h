@@ -25,6 +25,14 @@
 //---------------------------------------------------------------------------
 #include "collisions/CCollisionBasics.h"
 #include "collisions/CCollisionAABBBox.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+class cCollisionAABBLeaf;
+class cCollisionAABBInternal;
+//---------------------------------------------------------------------------
+//! Number of bins used to evaluate the Surface Area Heuristic when splitting a node.
+#define CHAI_AABB_SAH_NUM_BINS 16
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -48,6 +56,54 @@ typedef enum
 
 //---------------------------------------------------------------------------
 
+//===========================================================================
+/*!
+    \struct     cCollisionAABBBuildTask
+    \ingroup    collisions
+
+    \brief
+    cCollisionAABBBuildTask describes a subtree of an AABB tree which
+    remains to be built.
+*/
+//===========================================================================
+struct cCollisionAABBBuildTask
+{
+    //! Root node of the subtree.
+    cCollisionAABBInternal* m_node;
+
+    //! First leaf of the subtree.
+    cCollisionAABBLeaf* m_leaves;
+
+    //! Number of leaves in the subtree.
+    unsigned int m_numLeaves;
+
+    //! Depth of the root node of the subtree.
+    unsigned int m_depth;
+};
+
+
+//===========================================================================
+/*!
+    \struct     cCollisionAABBBuildSettings
+    \ingroup    collisions
+
+    \brief
+    cCollisionAABBBuildSettings holds the parameters used when building
+    an AABB tree.
+*/
+//===========================================================================
+struct cCollisionAABBBuildSettings
+{
+    //! If \b true, nodes are split with the Surface Area Heuristic, otherwise at the center of their longest axis.
+    bool m_useSAH;
+
+    //! Subtrees with at most this number of leaves are appended to m_tasks instead of being built.
+    unsigned int m_taskSize;
+
+    //! List of subtrees left to build, or NULL to build complete subtrees.
+    vector<cCollisionAABBBuildTask>* m_tasks;
+};
+
 //===========================================================================
 /*!
     \class      cCollisionAABBNode
@@ -212,9 +268,9 @@ class cCollisionAABBInternal : public cCollisionAABBNode
     // METHODS:
     //-----------------------------------------------------------------------
 
-    //! Initialize internal node.
+    //! Initialize internal node and build the subtree over the given leaves.
     void initialize(unsigned int a_numLeaves, cCollisionAABBLeaf *a_leaves,
-            unsigned int a_depth = -1);
+            unsigned int a_depth, const cCollisionAABBBuildSettings& a_settings);
 
     //! Size the bounding box for this node to enclose its children.
     void fitBBox(double a_radius = 0) {m_bbox.enclose(m_leftSubTree->m_bbox, m_rightSubTree->m_bbox);}
@@ -236,6 +292,21 @@ class cCollisionAABBInternal : public cCollisionAABBNode
     virtual void setParent(cCollisionAABBNode* a_parent, int a_recursive);
 
 
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Reorder leaves around the center of the longest axis of the node and return the size of the first group.
+    unsigned int splitCenter(unsigned int a_numLeaves, cCollisionAABBLeaf *a_leaves);
+
+    //! Reorder leaves around the plane of lowest Surface Area Heuristic cost and return the size of the first group.
+    unsigned int splitSAH(unsigned int a_numLeaves, cCollisionAABBLeaf *a_leaves);
+
+
+  public:
+
 	//-----------------------------------------------------------------------
     // MEMBERS:
     //-----------------------------------------------------------------------
@@ -100,7 +100,9 @@ struct cCollisionEvent
     \ingroup    collisions
     
     \brief    
-    cCollisionRecorder stores a list of collision events.
+    cCollisionRecorder stores a list of collision events. It also counts
+    the tree nodes and the triangles tested by the collision detectors,
+    for profiling.
 */
 //===========================================================================
 class cCollisionRecorder
@@ -122,11 +124,13 @@ class cCollisionRecorder
     // METHODS:
     //-----------------------------------------------------------------------
 
-    //! Clear all records.
+    //! Clear all records and counters.
     void clear()
     {
         m_nearestCollision.clear();
         m_collisions.clear();
+        m_numNodeTests = 0;
+        m_numTriangleTests = 0;
     }
 
 
@@ -139,6 +143,12 @@ class cCollisionRecorder
 
     //! List of collisions.
     vector<cCollisionEvent> m_collisions;
+
+    //! Number of nodes of collision trees tested since the last call to clear().
+    unsigned int m_numNodeTests;
+
+    //! Number of triangles tested since the last call to clear().
+    unsigned int m_numTriangleTests;
 };
 
 
@@ -176,6 +186,33 @@ struct cCollisionSettings
     double m_collisionRadius;
 };
 
+
+//===========================================================================
+/*!
+    \struct     cCollisionSegment
+    \ingroup    collisions
+
+    \brief
+    cCollisionSegment describes one segment of a batch of collision
+    queries, together with the recorder which receives its collision
+    events and the settings used to test it.
+*/
+//===========================================================================
+struct cCollisionSegment
+{
+    //! Start point of the segment.
+    cVector3d m_segmentPointA;
+
+    //! End point of the segment.
+    cVector3d m_segmentPointB;
+
+    //! Recorder which stores the collision events of the segment.
+    cCollisionRecorder* m_recorder;
+
+    //! Settings used to test the segment.
+    cCollisionSettings* m_settings;
+};
+
 //---------------------------------------------------------------------------
 #endif
 //---------------------------------------------------------------------------
@@ -0,0 +1,610 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "collisions/CCollisionBroadphase.h"
+#include "collisions/CGenericCollision.h"
+#include "scenegraph/CGenericObject.h"
+#include <algorithm>
+//---------------------------------------------------------------------------
+//! Maximum depth of the broadphase tree that can be traversed by a query.
+#define CHAI_BROADPHASE_STACK_SIZE 64
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Compare the centers of the boxes of two proxies along a given axis.
+    Used to split the proxies at the median when building the tree.
+*/
+//===========================================================================
+struct cCollisionBroadphaseCompare
+{
+    const vector<cCollisionBroadphaseProxy>* m_proxies;
+    unsigned int m_axis;
+
+    bool operator()(const unsigned int a_index0, const unsigned int a_index1) const
+    {
+        return ((*m_proxies)[a_index0].m_bbox.m_center[m_axis] <
+                (*m_proxies)[a_index1].m_bbox.m_center[m_axis]);
+    }
+};
+
+
+//===========================================================================
+/*!
+    Determine whether a segment intersects a bounding box which is inflated
+    by a given radius, by clipping the segment against the three slabs of
+    the box.
+
+    \fn       bool cBroadphaseSegmentHitsBox(const cVector3d& a_segmentPointA,
+              const cVector3d& a_segmentDir, const cCollisionAABBBox& a_box,
+              const double a_radius)
+    \param    a_segmentPointA  Start point of segment.
+    \param    a_segmentDir  Vector from the start point to the end point of segment.
+    \param    a_box  Bounding box.
+    \param    a_radius  Radius by which the box is inflated.
+    \return   Return \b true if the segment intersects the inflated box.
+*/
+//===========================================================================
+static inline bool cBroadphaseSegmentHitsBox(const cVector3d& a_segmentPointA,
+                                             const cVector3d& a_segmentDir,
+                                             const cCollisionAABBBox& a_box,
+                                             const double a_radius)
+{
+    double tmin = 0.0;
+    double tmax = 1.0;
+
+    for (unsigned int i=0; i<3; i++)
+    {
+        double lower = a_box.m_min[i] - a_radius;
+        double upper = a_box.m_max[i] + a_radius;
+
+        if (a_segmentDir[i] == 0.0)
+        {
+            // segment is parallel to the slab
+            if ((a_segmentPointA[i] < lower) || (a_segmentPointA[i] > upper))
+            {
+                return (false);
+            }
+        }
+        else
+        {
+            // clip segment against both planes of the slab
+            double invDir = 1.0 / a_segmentDir[i];
+            double t0 = (lower - a_segmentPointA[i]) * invDir;
+            double t1 = (upper - a_segmentPointA[i]) * invDir;
+            if (t0 > t1) { double t = t0; t0 = t1; t1 = t; }
+            if (t0 > tmin) { tmin = t0; }
+            if (t1 < tmax) { tmax = t1; }
+            if (tmin > tmax) { return (false); }
+        }
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cCollisionBroadphase.
+
+    \fn       cCollisionBroadphase::cCollisionBroadphase()
+*/
+//===========================================================================
+cCollisionBroadphase::cCollisionBroadphase()
+{
+    m_numObjectsTested = 0;
+}
+
+
+//===========================================================================
+/*!
+    Remove all proxies and nodes from the broadphase.
+
+    \fn       void cCollisionBroadphase::clear()
+*/
+//===========================================================================
+void cCollisionBroadphase::clear()
+{
+    m_proxies.clear();
+    m_newProxies.clear();
+    m_nodes.clear();
+    m_alwaysTested.clear();
+    m_moving.clear();
+    m_numObjectsTested = 0;
+}
+
+
+//===========================================================================
+/*!
+    Update the broadphase from the descendants of \e a_root. The global
+    positions of the scene graph must have been computed beforehand by
+    calling cGenericObject::computeGlobalPositions(). \n
+
+    If the list of objects (and of their collision detectors) is the same
+    as at the previous update, the boxes of the tree are refitted to the new
+    positions of the objects. Otherwise the tree is rebuilt.
+
+    \fn       void cCollisionBroadphase::update(cGenericObject* a_root)
+    \param    a_root  Root of the scene graph, usually a cWorld.
+*/
+//===========================================================================
+void cCollisionBroadphase::update(cGenericObject* a_root)
+{
+    // collect the proxies of all descendants of the root. Their poses are
+    // expressed in the frame of the root, in which segments are given.
+    m_newProxies.clear();
+    cVector3d rootPos = a_root->getGlobalPos();
+    cMatrix3d rootRotTrans = cTrans(a_root->getGlobalRot());
+
+    unsigned int numChildren = a_root->getNumChildren();
+    for (unsigned int i=0; i<numChildren; i++)
+    {
+        addProxies(a_root->getChild(i), rootPos, rootRotTrans, m_newProxies);
+    }
+
+    // check whether the structure of the scene graph has changed
+    bool rebuild = (m_newProxies.size() != m_proxies.size());
+    unsigned int numProxies = (unsigned int)m_newProxies.size();
+    for (unsigned int i=0; (i<numProxies) && (!rebuild); i++)
+    {
+        const cCollisionBroadphaseProxy& proxy = m_newProxies[i];
+        const cCollisionBroadphaseProxy& prevProxy = m_proxies[i];
+        if ((proxy.m_object != prevProxy.m_object) ||
+            (proxy.m_collisionDetector != prevProxy.m_collisionDetector) ||
+            (proxy.m_bounded != prevProxy.m_bounded) ||
+            (proxy.m_subtree != prevProxy.m_subtree))
+        {
+            rebuild = true;
+        }
+    }
+    m_proxies.swap(m_newProxies);
+
+    // sort proxies into those stored in the tree and those always tested
+    m_alwaysTested.clear();
+    m_moving.clear();
+    vector<unsigned int> bounded;
+    for (unsigned int i=0; i<numProxies; i++)
+    {
+        if (!m_proxies[i].m_bounded)
+        {
+            m_alwaysTested.push_back(i);
+        }
+        else
+        {
+            if (rebuild) { bounded.push_back(i); }
+            if (m_proxies[i].m_moving) { m_moving.push_back(i); }
+        }
+    }
+
+    // refit or rebuild tree
+    if (!rebuild)
+    {
+        refit();
+    }
+    else
+    {
+        m_nodes.clear();
+        if (bounded.size() > 0)
+        {
+            m_nodes.reserve(2 * bounded.size() - 1);
+            buildTree(&bounded[0], (unsigned int)bounded.size());
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Append a proxy for \e a_object if it owns a collision detector, then
+    recurse into its children. Ghost objects and their descendants are
+    ignored, as they are by cGenericObject::computeCollisionDetection().
+
+    \fn       void cCollisionBroadphase::addProxies(cGenericObject* a_object,
+              const cVector3d& a_rootPos, const cMatrix3d& a_rootRotTrans,
+              vector<cCollisionBroadphaseProxy>& a_proxies)
+    \param    a_object  Object to be added.
+    \param    a_rootPos  Global position of the root.
+    \param    a_rootRotTrans  Transpose of the global rotation of the root.
+    \param    a_proxies  List to which proxies are appended.
+*/
+//===========================================================================
+void cCollisionBroadphase::addProxies(cGenericObject* a_object,
+                                      const cVector3d& a_rootPos,
+                                      const cMatrix3d& a_rootRotTrans,
+                                      vector<cCollisionBroadphaseProxy>& a_proxies)
+{
+    // ghosts are ignored by collision detection
+    if (a_object->getAsGhost()) { return; }
+
+    cCollisionBroadphaseProxy proxy;
+    proxy.m_object = a_object;
+    proxy.m_collisionDetector = a_object->getCollisionDetector();
+    proxy.m_bounded = false;
+    proxy.m_subtree = false;
+    proxy.m_moving = false;
+
+    // objects which compute collisions of their own are tested as a whole,
+    // with the segment expressed in the frame of their parent
+    if (a_object->getUseOtherCollisionDetection())
+    {
+        cGenericObject* parent = a_object->getParent();
+        proxy.m_subtree = true;
+        proxy.m_rot = cMul(a_rootRotTrans, parent->getGlobalRot());
+        proxy.m_pos = cMul(a_rootRotTrans, cSub(parent->getGlobalPos(), a_rootPos));
+        proxy.m_bbox.setEmpty();
+        a_proxies.push_back(proxy);
+        return;
+    }
+
+    if (proxy.m_collisionDetector != NULL)
+    {
+        // pose of the object relative to the root
+        cVector3d globalPos = a_object->getGlobalPos();
+        cMatrix3d globalRot = a_object->getGlobalRot();
+        proxy.m_rot = cMul(a_rootRotTrans, globalRot);
+        proxy.m_pos = cMul(a_rootRotTrans, cSub(globalPos, a_rootPos));
+
+        // has the object moved since the previous update of the global positions?
+        cMatrix3d prevGlobalRot = a_object->getPrevGlobalRot();
+        proxy.m_moving = (!globalPos.equals(a_object->getPrevGlobalPos()) ||
+                          !globalRot.equals(prevGlobalRot));
+
+        // transform the box of the collision detector into the root frame
+        cVector3d localMin, localMax;
+        if (proxy.m_collisionDetector->getBoundaryBox(localMin, localMax))
+        {
+            cVector3d center = cMul(0.5, cAdd(localMin, localMax));
+            cVector3d extent = cMul(0.5, cSub(localMax, localMin));
+            cVector3d globalCenter = cAdd(proxy.m_pos, cMul(proxy.m_rot, center));
+            cVector3d globalExtent;
+            for (unsigned int i=0; i<3; i++)
+            {
+                globalExtent[i] = fabs(proxy.m_rot.m[i][0]) * extent.x +
+                                  fabs(proxy.m_rot.m[i][1]) * extent.y +
+                                  fabs(proxy.m_rot.m[i][2]) * extent.z;
+            }
+            proxy.m_bbox.setValue(cSub(globalCenter, globalExtent),
+                                  cAdd(globalCenter, globalExtent));
+            proxy.m_bounded = true;
+        }
+        else
+        {
+            proxy.m_bbox.setEmpty();
+        }
+
+        a_proxies.push_back(proxy);
+    }
+
+    // add children
+    unsigned int numChildren = a_object->getNumChildren();
+    for (unsigned int i=0; i<numChildren; i++)
+    {
+        addProxies(a_object->getChild(i), a_rootPos, a_rootRotTrans, a_proxies);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Build the subtree enclosing the given proxies by splitting them at the
+    median of their centers along the longest axis. Children are always
+    appended after their parent.
+
+    \fn       int cCollisionBroadphase::buildTree(unsigned int* a_indices,
+                                                  const unsigned int a_numIndices)
+    \param    a_indices  Indices of the proxies to be enclosed.
+    \param    a_numIndices  Number of indices.
+    \return   Return the index of the root node of the subtree.
+*/
+//===========================================================================
+int cCollisionBroadphase::buildTree(unsigned int* a_indices,
+                                    const unsigned int a_numIndices)
+{
+    int index = (int)m_nodes.size();
+    cCollisionBroadphaseNode node;
+    node.m_left = -1;
+    node.m_right = -1;
+    node.m_proxy = -1;
+    m_nodes.push_back(node);
+
+    // leaf node
+    if (a_numIndices == 1)
+    {
+        m_nodes[index].m_proxy = (int)a_indices[0];
+        m_nodes[index].m_bbox = m_proxies[a_indices[0]].m_bbox;
+        return (index);
+    }
+
+    // find the axis along which the centers are spread the most
+    cCollisionAABBBox centers;
+    centers.setEmpty();
+    for (unsigned int i=0; i<a_numIndices; i++)
+    {
+        centers.enclose(m_proxies[a_indices[i]].m_bbox.m_center);
+    }
+
+    cCollisionBroadphaseCompare compare;
+    compare.m_proxies = &m_proxies;
+    compare.m_axis = centers.longestAxis();
+
+    // split at the median
+    unsigned int median = a_numIndices / 2;
+    std::nth_element(a_indices, a_indices + median, a_indices + a_numIndices, compare);
+
+    int left = buildTree(a_indices, median);
+    int right = buildTree(a_indices + median, a_numIndices - median);
+
+    m_nodes[index].m_left = left;
+    m_nodes[index].m_right = right;
+    m_nodes[index].m_bbox.enclose(m_nodes[left].m_bbox, m_nodes[right].m_bbox);
+
+    return (index);
+}
+
+
+//===========================================================================
+/*!
+    Recompute the boxes of all nodes of the tree, from the leaves up to the
+    root, after the boxes of the proxies have been updated.
+
+    \fn       void cCollisionBroadphase::refit()
+*/
+//===========================================================================
+void cCollisionBroadphase::refit()
+{
+    // children are stored after their parent, so a backward pass
+    // updates every node after both of its children
+    for (int i=(int)m_nodes.size()-1; i>=0; i--)
+    {
+        cCollisionBroadphaseNode& node = m_nodes[i];
+        if (node.m_proxy >= 0)
+        {
+            node.m_bbox = m_proxies[node.m_proxy].m_bbox;
+        }
+        else
+        {
+            node.m_bbox.enclose(m_nodes[node.m_left].m_bbox, m_nodes[node.m_right].m_bbox);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Check for collisions between a segment and the objects stored in the
+    broadphase. The segment is expressed in the frame of the root which was
+    passed to update(). Only the objects whose boxes are crossed by the
+    segment, inflated by the collision radius, are tested. \n
+
+    When \e m_adjustObjectMotion is enabled, the start point of the segment
+    is moved along with each moving object, so these objects are always
+    tested. Objects are tested in the order of the scene graph, as they
+    would be by cGenericObject::computeCollisionDetection().
+
+    \fn       bool cCollisionBroadphase::computeCollision(cVector3d& a_segmentPointA,
+              cVector3d& a_segmentPointB, cCollisionRecorder& a_recorder,
+              cCollisionSettings& a_settings)
+    \param    a_segmentPointA  Start point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_recorder  Stores all collision events.
+    \param    a_settings  Contains collision settings information.
+    \return   Return \b true if a collision event has occurred.
+*/
+//===========================================================================
+bool cCollisionBroadphase::computeCollision(cVector3d& a_segmentPointA,
+                                            cVector3d& a_segmentPointB,
+                                            cCollisionRecorder& a_recorder,
+                                            cCollisionSettings& a_settings)
+{
+    m_numObjectsTested = 0;
+
+    // collect the proxies to be tested
+    vector<unsigned int> candidates;
+    findCandidates(a_segmentPointA, a_segmentPointB, a_settings, candidates);
+
+    // test candidates in scene graph order
+    std::sort(candidates.begin(), candidates.end());
+
+    bool hit = false;
+    unsigned int numCandidates = (unsigned int)candidates.size();
+    for (unsigned int i=0; i<numCandidates; i++)
+    {
+        const cCollisionBroadphaseProxy& proxy = m_proxies[candidates[i]];
+        if (proxy.m_object->getAsGhost()) { continue; }
+
+        // convert segment into the frame of the proxy
+        cMatrix3d transRot;
+        proxy.m_rot.transr(transRot);
+
+        cVector3d localSegmentPointA = cSub(a_segmentPointA, proxy.m_pos);
+        transRot.mul(localSegmentPointA);
+
+        cVector3d localSegmentPointB = cSub(a_segmentPointB, proxy.m_pos);
+        transRot.mul(localSegmentPointB);
+
+        if (proxy.m_subtree)
+        {
+            hit = hit | proxy.m_object->computeCollisionDetection(localSegmentPointA,
+                                                                  localSegmentPointB,
+                                                                  a_recorder,
+                                                                  a_settings);
+        }
+        else
+        {
+            hit = hit | proxy.m_object->computeLocalCollisionDetection(localSegmentPointA,
+                                                                       localSegmentPointB,
+                                                                       a_recorder,
+                                                                       a_settings);
+        }
+        m_numObjectsTested++;
+    }
+
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Check for collisions between a batch of segments and the objects stored
+    in the broadphase. The candidates of every segment are collected first,
+    and each object is then called once with all the segments which may
+    hit it, so that its collision detector can test them together (see
+    cGenericCollision::computeCollisions()). Each segment is tested with
+    its own settings and stores its collision events in its own recorder.
+
+    \fn       bool cCollisionBroadphase::computeCollisions(vector<cCollisionSegment>& a_segments)
+    \param    a_segments  Segments to test, expressed in the frame of the root.
+    \return   Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cCollisionBroadphase::computeCollisions(vector<cCollisionSegment>& a_segments)
+{
+    m_numObjectsTested = 0;
+
+    // collect pairs of candidate proxies and segments
+    vector<unsigned int> candidates;
+    vector<std::pair<unsigned int, unsigned int> > pairs;
+    unsigned int numSegments = (unsigned int)a_segments.size();
+    for (unsigned int i=0; i<numSegments; i++)
+    {
+        candidates.clear();
+        findCandidates(a_segments[i].m_segmentPointA,
+                       a_segments[i].m_segmentPointB,
+                       *a_segments[i].m_settings,
+                       candidates);
+        for (unsigned int j=0; j<candidates.size(); j++)
+        {
+            pairs.push_back(std::make_pair(candidates[j], i));
+        }
+    }
+
+    // group the segments by proxy, in scene graph order
+    std::sort(pairs.begin(), pairs.end());
+
+    bool hit = false;
+    vector<cCollisionSegment> localSegments;
+    unsigned int numPairs = (unsigned int)pairs.size();
+    unsigned int first = 0;
+    while (first < numPairs)
+    {
+        const cCollisionBroadphaseProxy& proxy = m_proxies[pairs[first].first];
+        unsigned int last = first;
+        while ((last < numPairs) && (pairs[last].first == pairs[first].first))
+        {
+            last++;
+        }
+
+        if (!proxy.m_object->getAsGhost())
+        {
+            // convert segments into the frame of the proxy
+            cMatrix3d transRot;
+            proxy.m_rot.transr(transRot);
+
+            localSegments.resize(last - first);
+            for (unsigned int i=first; i<last; i++)
+            {
+                cCollisionSegment& segment = localSegments[i - first];
+                segment = a_segments[pairs[i].second];
+                segment.m_segmentPointA.sub(proxy.m_pos);
+                transRot.mul(segment.m_segmentPointA);
+                segment.m_segmentPointB.sub(proxy.m_pos);
+                transRot.mul(segment.m_segmentPointB);
+            }
+
+            if (proxy.m_subtree)
+            {
+                hit = hit | proxy.m_object->computeCollisionDetections(localSegments);
+            }
+            else
+            {
+                hit = hit | proxy.m_object->computeLocalCollisionDetections(localSegments);
+            }
+            m_numObjectsTested++;
+        }
+
+        first = last;
+    }
+
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Collect the proxies which must be tested against a segment: the
+    proxies whose boxes are crossed by the segment inflated by the
+    collision radius, the proxies which are not stored in the tree, and,
+    when \e m_adjustObjectMotion is enabled, the moving proxies.
+
+    \fn       void cCollisionBroadphase::findCandidates(const cVector3d& a_segmentPointA,
+              const cVector3d& a_segmentPointB, const cCollisionSettings& a_settings,
+              vector<unsigned int>& a_candidates)
+    \param    a_segmentPointA  Start point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_settings  Contains collision settings information.
+    \param    a_candidates  List to which the indices of the proxies are appended.
+*/
+//===========================================================================
+void cCollisionBroadphase::findCandidates(const cVector3d& a_segmentPointA,
+                                          const cVector3d& a_segmentPointB,
+                                          const cCollisionSettings& a_settings,
+                                          vector<unsigned int>& a_candidates)
+{
+    a_candidates.insert(a_candidates.end(), m_alwaysTested.begin(), m_alwaysTested.end());
+    if (a_settings.m_adjustObjectMotion)
+    {
+        a_candidates.insert(a_candidates.end(), m_moving.begin(), m_moving.end());
+    }
+
+    if (m_nodes.size() == 0)
+    {
+        return;
+    }
+
+    cVector3d segmentDir = cSub(a_segmentPointB, a_segmentPointA);
+    double radius = a_settings.m_collisionRadius;
+
+    int stack[CHAI_BROADPHASE_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const cCollisionBroadphaseNode& node = m_nodes[stack[--stackSize]];
+        if (!cBroadphaseSegmentHitsBox(a_segmentPointA, segmentDir, node.m_bbox, radius))
+        {
+            continue;
+        }
+
+        if (node.m_proxy >= 0)
+        {
+            // moving objects have already been added
+            if (!(a_settings.m_adjustObjectMotion && m_proxies[node.m_proxy].m_moving))
+            {
+                a_candidates.push_back((unsigned int)node.m_proxy);
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.m_right;
+            stack[stackSize++] = node.m_left;
+        }
+    }
+}
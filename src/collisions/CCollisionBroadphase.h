@@ -0,0 +1,224 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CCollisionBroadphaseH
+#define CCollisionBroadphaseH
+//---------------------------------------------------------------------------
+#include "math/CMaths.h"
+#include "collisions/CCollisionBasics.h"
+#include "collisions/CCollisionAABBBox.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+class cGenericObject;
+class cGenericCollision;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CCollisionBroadphase.h
+
+    \brief
+    <b> Collision Detection </b> \n
+    Scene-Level Broadphase.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cCollisionBroadphaseProxy
+    \ingroup    collisions
+
+    \brief
+    cCollisionBroadphaseProxy stores an object of the scene graph together
+    with its pose and bounding box, expressed in the coordinate frame of
+    the root of the broadphase.
+*/
+//===========================================================================
+struct cCollisionBroadphaseProxy
+{
+    //! Object represented by this proxy.
+    cGenericObject* m_object;
+
+    //! Collision detector of the object when the proxy was created.
+    cGenericCollision* m_collisionDetector;
+
+    //! Position of the frame in which the segment is passed to the object.
+    cVector3d m_pos;
+
+    //! Rotation of the frame in which the segment is passed to the object.
+    cMatrix3d m_rot;
+
+    //! Bounding box of the object expressed in the root frame.
+    cCollisionAABBBox m_bbox;
+
+    //! If \b true, the object has a bounding box and is stored in the tree.
+    bool m_bounded;
+
+    /*!
+        If \b true, the object computes collisions of its own (see
+        cGenericObject::getUseOtherCollisionDetection()). The segment is then
+        passed in the frame of its parent to the object and its descendants.
+    */
+    bool m_subtree;
+
+    //! If \b true, the object has moved since the previous global position update.
+    bool m_moving;
+};
+
+
+//===========================================================================
+/*!
+    \struct     cCollisionBroadphaseNode
+    \ingroup    collisions
+
+    \brief
+    cCollisionBroadphaseNode is a node of the broadphase tree. Nodes are
+    stored in a flat array where children are always located after
+    their parent, so that the tree can be refitted with a single
+    backward pass.
+*/
+//===========================================================================
+struct cCollisionBroadphaseNode
+{
+    //! Bounding box enclosing all proxies of the subtree.
+    cCollisionAABBBox m_bbox;
+
+    //! Index of the left child, or -1 if the node is a leaf.
+    int m_left;
+
+    //! Index of the right child, or -1 if the node is a leaf.
+    int m_right;
+
+    //! Index of the proxy stored in a leaf, or -1 if the node is internal.
+    int m_proxy;
+};
+
+
+//===========================================================================
+/*!
+    \class      cCollisionBroadphase
+    \ingroup    collisions
+
+    \brief
+    cCollisionBroadphase holds an axis-aligned bounding box tree built over
+    the objects of a scene graph. Each object that owns a collision detector
+    is stored as a proxy whose box is the bounding box of its collision
+    detector, transformed by the global pose of the object. \n
+
+    Calling update() after the global positions of the scene graph have been
+    computed refits the tree, or rebuilds it when objects have been added,
+    removed, or have changed collision detector. A segment query then only
+    calls the collision detectors of the objects whose boxes are crossed
+    by the segment.
+*/
+//===========================================================================
+class cCollisionBroadphase
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cCollisionBroadphase.
+    cCollisionBroadphase();
+
+    //! Destructor of cCollisionBroadphase.
+    virtual ~cCollisionBroadphase() {};
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Refit or rebuild the tree from the global positions of the descendants of an object.
+    void update(cGenericObject* a_root);
+
+    //! Remove all proxies from the broadphase.
+    void clear();
+
+    //! Compute collision detection between a segment expressed in the root frame and all proxies.
+    bool computeCollision(cVector3d& a_segmentPointA,
+                          cVector3d& a_segmentPointB,
+                          cCollisionRecorder& a_recorder,
+                          cCollisionSettings& a_settings);
+
+    //! Compute collision detection between a batch of segments expressed in the root frame and all proxies.
+    bool computeCollisions(vector<cCollisionSegment>& a_segments);
+
+    //! Get the number of objects stored in the broadphase.
+    unsigned int getNumProxies() const { return ((unsigned int)m_proxies.size()); }
+
+    //! Get the number of objects whose collision detectors were called by the last query.
+    unsigned int getNumObjectsTested() const { return (m_numObjectsTested); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Append the proxies of an object and its descendants to a list.
+    void addProxies(cGenericObject* a_object,
+                    const cVector3d& a_rootPos,
+                    const cMatrix3d& a_rootRotTrans,
+                    vector<cCollisionBroadphaseProxy>& a_proxies);
+
+    //! Build the tree over a range of proxy indices and return the index of its root node.
+    int buildTree(unsigned int* a_indices, const unsigned int a_numIndices);
+
+    //! Recompute the boxes of all nodes from the boxes of the proxies.
+    void refit();
+
+    //! Append the indices of the proxies to be tested against a segment to a list.
+    void findCandidates(const cVector3d& a_segmentPointA,
+                        const cVector3d& a_segmentPointB,
+                        const cCollisionSettings& a_settings,
+                        vector<unsigned int>& a_candidates);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! List of proxies, in the order in which the scene graph is traversed.
+    vector<cCollisionBroadphaseProxy> m_proxies;
+
+    //! Temporary list of proxies used when updating the broadphase.
+    vector<cCollisionBroadphaseProxy> m_newProxies;
+
+    //! Nodes of the tree. The root node is located at index 0.
+    vector<cCollisionBroadphaseNode> m_nodes;
+
+    //! Indices of the proxies which are not stored in the tree and are tested against every segment.
+    vector<unsigned int> m_alwaysTested;
+
+    //! Indices of the proxies of the tree which have moved since the last global position update.
+    vector<unsigned int> m_moving;
+
+    //! Number of objects whose collision detectors were called by the last query.
+    unsigned int m_numObjectsTested;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 
 //---------------------------------------------------------------------------
 #include "collisions/CCollisionBrute.h"
+#include "collisions/CCollisionAABBBox.h"
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -69,4 +70,41 @@ bool cCollisionBrute::computeCollision(cVector3d& a_segmentPointA,
 }
 
 
+//===========================================================================
+/*!
+    Get the bounding box of all triangles checked by this collision detector.
+    As no tree is stored, the box is computed from the current positions
+    of the vertices.
+
+    \fn       bool cCollisionBrute::getBoundaryBox(cVector3d& a_boxMin,
+                                                   cVector3d& a_boxMax)
+    \param    a_boxMin  Returns the minimum corner of the box.
+    \param    a_boxMax  Returns the maximum corner of the box.
+    \return   Return \b false if the mesh contains no triangles.
+*/
+//===========================================================================
+bool cCollisionBrute::getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax)
+{
+    unsigned int numTriangles = m_triangles->size();
+    if (numTriangles == 0)
+    {
+        return (false);
+    }
+
+    cCollisionAABBBox box;
+    box.setEmpty();
+    for (unsigned int i=0; i<numTriangles; i++)
+    {
+        box.enclose((*m_triangles)[i].getVertex0()->getPos());
+        box.enclose((*m_triangles)[i].getVertex1()->getPos());
+        box.enclose((*m_triangles)[i].getVertex2()->getPos());
+    }
+
+    a_boxMin = box.m_min;
+    a_boxMax = box.m_max;
+
+    return (true);
+}
+
+
 
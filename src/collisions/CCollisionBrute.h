@@ -83,6 +83,12 @@ class cCollisionBrute : public cGenericCollision
                           cCollisionRecorder& a_recorder,
                           cCollisionSettings& a_settings);
 
+    //! Get the bounding box of all triangles of the mesh.
+    bool getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax);
+
+    //! There are no bounding volumes to update.
+    bool refit() { return (true); }
+
   protected:
 
 	//-----------------------------------------------------------------------
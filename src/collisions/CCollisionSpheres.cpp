@@ -56,6 +56,10 @@ cCollisionSpheres::cCollisionSpheres(vector<cTriangle> *a_triangles,
     m_useNeighbors = a_useNeighbors;
     m_root = NULL;
     m_firstLeaf = 0;
+    m_firstNode = NULL;
+    m_numLeaves = 0;
+    m_radius = 0.0;
+    m_buildCost = 0.0;
 
     // set material properties
     m_material.m_ambient.set(0.1, 0.3, 0.1, 0.3);
@@ -75,8 +79,8 @@ cCollisionSpheres::cCollisionSpheres(vector<cTriangle> *a_triangles,
 cCollisionSpheres::~cCollisionSpheres()
 {
     // delete array of internal nodes
-    if (m_root != NULL)
-        delete [] m_root;
+    if (m_firstNode != NULL)
+        delete [] m_firstNode;
 
     // delete array of leaf nodes
     // if ((m_trigs) && (m_trigs->size() > 1) && (m_firstLeaf))
@@ -104,11 +108,26 @@ void cCollisionSpheres::initialize(double a_radius)
 {
 	secret = NULL;
 
+    // delete the previous tree
+    if (m_firstNode != NULL)
+    {
+        delete [] m_firstNode;
+        m_firstNode = NULL;
+    }
+    if (m_firstLeaf != NULL)
+    {
+        delete [] m_firstLeaf;
+        m_firstLeaf = NULL;
+    }
+
     // initialize number of triangles, root pointer, and last intersected triangle
     int numTriangles = m_trigs->size();
 
     m_root = NULL;
     m_lastCollision = NULL;
+    m_numLeaves = numTriangles;
+    m_radius = a_radius;
+    m_buildCost = 0.0;
 
     // if there are triangles, build the tree
     if (numTriangles > 0)
@@ -122,8 +141,12 @@ void cCollisionSpheres::initialize(double a_radius)
         if (numTriangles > 1)
         {
             g_nextInternalNode = new cCollisionSpheresNode[numTriangles-1];
+            m_firstNode = g_nextInternalNode;
             m_root = g_nextInternalNode;
             new(g_nextInternalNode++) cCollisionSpheresNode(m_trigs, NULL, a_radius);
+
+            // store the cost of the new tree for refit()
+            m_buildCost = computeCost();
         }
 
         // if there is only one triangle, just allocate one leaf node and
@@ -193,7 +216,12 @@ void cCollisionSpheres::render()
     sphere tree, starting at the root and recursing through the tree, breaking
     the recursion along any path in which the sphere bounding the line segment
     does not intersect the sphere of the node.  At the leafs, triangle-segment
-    intersection testing is called.
+    intersection testing is called. \n
+
+    If neighbor lists are used, the triangle hit by the previous query and
+    its neighbors are tested first. When only the nearest collision is
+    reported, the segment is then shortened to the nearest collision found
+    so far, which shrinks the sphere enclosing it.
 
     \fn       bool cCollisionSpheres::computeCollision(cVector3d& a_segmentPointA,
                                          cVector3d& a_segmentPointB,
@@ -211,32 +239,6 @@ bool cCollisionSpheres::computeCollision(cVector3d& a_segmentPointA,
                                          cCollisionRecorder& a_recorder,
                                          cCollisionSettings& a_settings)
 {
-    // if this is a subsequent call from the proxy algorithm after detecting
-    // an initial collision, and if the flag to use neighbor checking is set,
-    // only neighbors of the triangle from the first collision detection
-    // need to be checked
-    if ((m_useNeighbors) && (m_root != NULL) &&
-        (m_lastCollision != NULL) && (m_lastCollision->m_neighbors != NULL))
-    {
-        // check each neighbor, and find the closest for which there is a
-        // collision, if any
-        for (unsigned int i=0; i<m_lastCollision->m_neighbors->size(); i++)
-        {
-            ((*(m_lastCollision->m_neighbors))[i])->computeCollision(
-                    a_segmentPointA, a_segmentPointB, a_recorder, a_settings);
-        }
-
-        // if at least one neighbor triangle was intersected, return true
-        if (a_recorder.m_collisions.size() > 0) return true;
-
-        // otherwise there was no collision; return false
-        m_lastCollision = NULL;
-        return false;
-    }
-
-    // otherwise, if this is the first call in an iteration of the proxy
-    // algorithm (or a call from any other algorithm), check the sphere tree
-
     // if the root is null, the tree is empty, so there can be no collision
     if (m_root == 0)
     {
@@ -244,12 +246,38 @@ bool cCollisionSpheres::computeCollision(cVector3d& a_segmentPointA,
         return 0;
     }
 
+    // if this is a subsequent call from the proxy algorithm after detecting
+    // an initial collision, and if the flag to use neighbor checking is set,
+    // the neighbors of the triangle from the previous collision are checked
+    // first
+    cTriangle* neighbor = NULL;
+    if ((m_useNeighbors) &&
+        (m_lastCollision != NULL) && (m_lastCollision->m_neighbors != NULL) &&
+        (a_settings.m_checkForNearestCollisionOnly))
+    {
+        neighbor = computeNeighborCollision(m_lastCollision,
+                                            a_segmentPointA,
+                                            a_segmentPointB,
+                                            a_recorder,
+                                            a_settings);
+    }
+
+    // a nearer triangle can only be hit before the nearest collision found
+    // so far, so the rest of the segment is discarded before the sphere
+    // tree is checked
+    cVector3d segmentPointB = a_segmentPointB;
+    if (a_settings.m_checkForNearestCollisionOnly)
+    {
+        clipSegment(a_segmentPointA, a_segmentPointB, a_recorder, segmentPointB);
+    }
+
     // create a cCollisionSpheresLine object and enclose it in a sphere leaf
-    cCollisionSpheresLine curLine(a_segmentPointA,a_segmentPointB);
+    cCollisionSpheresLine curLine(a_segmentPointA,segmentPointB);
     cCollisionSpheresLeaf lineSphere(&curLine);
 
     // test for intersection between the line segment and the root of the
     // collision tree; the root will recursively call children down the tree
+    double squareDistance = a_recorder.m_nearestCollision.m_squareDistance;
     bool result = cCollisionSpheresSphere::computeCollision(m_root,
                                                             &lineSphere,
                                                             a_recorder,
@@ -259,8 +287,138 @@ bool cCollisionSpheres::computeCollision(cVector3d& a_segmentPointA,
     // object
     lineSphere.m_prim = 0;
 
+    // remember the nearest triangle for the next query
+    m_lastCollision = neighbor;
+    if (result && (a_recorder.m_nearestCollision.m_squareDistance < squareDistance))
+    {
+        m_lastCollision = a_recorder.m_nearestCollision.m_triangle;
+    }
+
     // return whether there was an intersection
-    return result;
+    return (result || (neighbor != NULL));
+}
+
+
+//===========================================================================
+/*!
+    Get the axis-aligned box enclosing the sphere at the root of the tree.
+
+    \fn       bool cCollisionSpheres::getBoundaryBox(cVector3d& a_boxMin,
+                                                     cVector3d& a_boxMax)
+    \param    a_boxMin  Returns the minimum corner of the box.
+    \param    a_boxMax  Returns the maximum corner of the box.
+    \return   Return \b false if the tree is empty.
+*/
+//===========================================================================
+bool cCollisionSpheres::getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax)
+{
+    // if the root is null, the tree is empty
+    if (m_root == NULL)
+    {
+        return (false);
+    }
+
+    double radius = m_root->getRadius();
+    a_boxMin = cSub(m_root->getCenter(), cVector3d(radius, radius, radius));
+    a_boxMax = cAdd(m_root->getCenter(), cVector3d(radius, radius, radius));
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Update the spheres of the tree after the vertices of the mesh have
+    moved, without changing the structure of the tree. Leaves are fitted
+    to their triangles, then internal nodes are fitted to their children
+    in a single backward pass over the array of internal nodes, in which
+    children are always stored after their parent. If a rebuild ratio has
+    been set with setRebuildRatio() and the cost of the refitted tree
+    exceeds the cost of the original tree by this ratio, the tree is built
+    again. \n
+
+    If triangles have been added to or removed from the mesh since the
+    tree was built, the tree is built again.
+
+    \fn       bool cCollisionSpheres::refit()
+    \return   Return \b true.
+*/
+//===========================================================================
+bool cCollisionSpheres::refit()
+{
+    // the tree must be built again if triangles have been added or removed
+    if (m_trigs->size() != m_numLeaves)
+    {
+        initialize(m_radius);
+        return (true);
+    }
+
+    // if the root is null, the tree is empty
+    if (m_root == NULL)
+    {
+        return (true);
+    }
+
+    m_lastCollision = NULL;
+
+    // fit leaves around their triangles
+    for (unsigned int i=0; i<m_numLeaves; i++)
+    {
+        m_firstLeaf[i].fitSphere(m_radius);
+    }
+
+    // fit internal nodes around their children, from the last one to the root
+    if (m_firstNode == NULL)
+    {
+        return (true);
+    }
+
+    for (int i=(int)m_numLeaves-2; i>=0; i--)
+    {
+        m_firstNode[i].fitSphere();
+    }
+
+    // rebuild the tree if its quality has degraded too much
+    if ((m_rebuildRatio > 0.0) && (m_buildCost > 0.0) &&
+        (computeCost() > m_rebuildRatio * m_buildCost))
+    {
+        initialize(m_radius);
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Compute the sum of the squared radii of the internal nodes of the tree,
+    divided by the squared radius of the root. This grows with the expected
+    number of nodes visited by a query.
+
+    \fn       double cCollisionSpheres::computeCost() const
+    \return   Return the relative cost of the tree.
+*/
+//===========================================================================
+double cCollisionSpheres::computeCost() const
+{
+    if (m_firstNode == NULL)
+    {
+        return (0.0);
+    }
+
+    double rootArea = cSqr(m_firstNode[0].getRadius());
+    if (rootArea <= 0.0)
+    {
+        return (0.0);
+    }
+
+    double area = 0.0;
+    for (unsigned int i=0; i<m_numLeaves-1; i++)
+    {
+        area += cSqr(m_firstNode[i].getRadius());
+    }
+
+    return (area / rootArea);
 }
 
 
@@ -305,6 +463,9 @@ bool cCollisionSpheresSphere::computeCollision(cCollisionSpheresSphere *a_sa,
                                                cCollisionRecorder& a_recorder,
                                                cCollisionSettings& a_settings)
 {
+    // count test for profiling
+    a_recorder.m_numNodeTests++;
+
     // if first sphere is an internal node, call internal node collision function
     if (!a_sa->isLeaf())
     {
@@ -465,6 +626,21 @@ void cCollisionSpheresNode::ConstructChildren(Plist &a_primList)
     else
         m_right = new(g_nextInternalNode++) cCollisionSpheresNode(rightList, this);
 
+    // enclose both children
+    fitSphere();
+}
+
+
+//===========================================================================
+/*!
+    Compute the center and radius of the smallest sphere enclosing the
+    spheres of both children of this node.
+
+    \fn       void cCollisionSpheresNode::fitSphere()
+*/
+//===========================================================================
+void cCollisionSpheresNode::fitSphere()
+{
     // get centers and radii of left and right children
     const cVector3d &lc = m_left->m_center;
     const cVector3d &rc = m_right->m_center;
@@ -671,6 +847,36 @@ cCollisionSpheresLeaf::cCollisionSpheresLeaf(cTriangle* a_tri,
 }
 
 
+//===========================================================================
+/*!
+    Compute the sphere enclosing the triangle of this leaf from the current
+    positions of its vertices.
+
+    \fn       void cCollisionSpheresLeaf::fitSphere(double a_extendedRadius)
+    \param    a_extendedRadius  Bounding radius.
+*/
+//===========================================================================
+void cCollisionSpheresLeaf::fitSphere(double a_extendedRadius)
+{
+    // leaves of a mesh always hold triangle primitives
+    cCollisionSpheresTri* tri = (cCollisionSpheresTri*)m_prim;
+    cTriangle* triangle = tri->getOriginal();
+    if (triangle == NULL)
+    {
+        return;
+    }
+
+    tri->fitSphere(triangle->getVertex0()->getPos(),
+                   triangle->getVertex1()->getPos(),
+                   triangle->getVertex2()->getPos(),
+                   a_extendedRadius);
+
+    // set the center and radius of the bounding sphere to enclose the primitive
+    m_radius = m_prim->getRadius();
+    m_center = m_prim->getCenter();
+}
+
+
 //===========================================================================
 /*!
     Draw the collision sphere if at the given depth.
@@ -55,6 +55,9 @@ class cCollisionSpheresSphere;
 
 //! Leaf nodes of the sphere tree.
 class cCollisionSpheresLeaf;
+
+//! Internal nodes of the sphere tree.
+class cCollisionSpheresNode;
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -99,6 +102,12 @@ class cCollisionSpheres : public cGenericCollision
                           cCollisionRecorder& a_recorder,
                           cCollisionSettings& a_settings);
 
+    //! Get the bounding box of the sphere at the root of the sphere tree.
+    bool getBoundaryBox(cVector3d& a_boxMin, cVector3d& a_boxMax);
+
+    //! Update the spheres of the tree from the current vertex positions.
+    bool refit();
+
 
 	//-----------------------------------------------------------------------
     // MEMBERS:
@@ -119,8 +128,30 @@ class cCollisionSpheres : public cGenericCollision
     //! Pointer to the beginning of list of leaf nodes.
     cCollisionSpheresLeaf *m_firstLeaf;
 
+    //! Pointer to the beginning of list of internal nodes, or NULL if the tree has a single leaf.
+    cCollisionSpheresNode *m_firstNode;
+
+    //! Number of leaf nodes.
+    unsigned int m_numLeaves;
+
+    //! Radius added around the triangles when the tree was built.
+    double m_radius;
+
+    //! Cost of the tree when it was built, as returned by computeCost().
+    double m_buildCost;
+
     //! For internal and debug usage.
 	cTriangle* secret;
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Return the sum of the squared radii of the internal nodes, relative to the squared radius of the root.
+    double computeCost() const;
 };
 
 
@@ -171,7 +202,7 @@ class cCollisionSpheresSphere
     inline const cVector3d &getCenter() { return m_center; }
 
     //! Return the radius of the sphere.
-    inline double getRadius() { return m_radius; }
+    inline double getRadius() const { return m_radius; }
 
     //! Return whether the node is a leaf node.
     virtual int isLeaf() = 0;
@@ -250,6 +281,9 @@ class cCollisionSpheresNode : public cCollisionSpheresSphere
     //! Create subtrees by splitting primitives into left and right lists.
     void ConstructChildren(Plist &a_primList);
 
+    //! Compute the sphere enclosing the spheres of both children.
+    void fitSphere();
+
     //! Return whether the node is a leaf node. (In this class, it is not.)
     int isLeaf()  { return 0; }
 
@@ -320,6 +354,9 @@ class cCollisionSpheresLeaf : public cCollisionSpheresSphere
     //! Return whether the node is a leaf node. (In this class, it is.)
     int isLeaf()  { return 1; }
 
+    //! Compute the sphere enclosing the triangle from the current positions of its vertices.
+    void fitSphere(double a_extendedRadius);
+
     //! Draw the collision sphere if at the given depth.
     void draw(int a_depth);
 
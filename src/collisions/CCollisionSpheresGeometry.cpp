@@ -80,6 +80,32 @@ cCollisionSpheresTri::cCollisionSpheresTri(cVector3d a,
                                            cVector3d b,
                                            cVector3d c,
                                            double a_extendedRadius)
+{
+    m_original = NULL;
+    fitSphere(a, b, c, a_extendedRadius);
+}
+
+
+//===========================================================================
+/*!
+    Compute the bounding sphere of the triangle from the positions of its
+    vertices. Also called when the tree is refitted after the vertices of
+    the mesh have moved.
+
+    \fn       void cCollisionSpheresTri::fitSphere(cVector3d a,
+                                           cVector3d b,
+                                           cVector3d c,
+                                           double a_extendedRadius)
+    \param    a     First vertex of the triangle.
+    \param    b     Second vertex of the triangle.
+    \param    c     Third vertex of the triangle.
+    \param    a_extendedRadius  Additional radius to add to sphere.
+*/
+//===========================================================================
+void cCollisionSpheresTri::fitSphere(cVector3d a,
+                                     cVector3d b,
+                                     cVector3d c,
+                                     double a_extendedRadius)
 {
     // Calculate the center of the circumscribing sphere for this triangle:
     // First compute the normal to the plane of this triangle
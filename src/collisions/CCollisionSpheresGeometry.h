@@ -264,6 +264,12 @@ class cCollisionSpheresTri : public cCollisionSpheresGenericShape
                           cCollisionRecorder& a_recorder,
                           cCollisionSettings& a_settings);
 
+    //! Compute the bounding sphere of the triangle from the positions of its vertices.
+    void fitSphere(cVector3d a,
+                   cVector3d b,
+                   cVector3d c,
+                   double a_extendedRadius);
+
     //! Return the center of the triangle.
     inline const cVector3d &getCenter() const  { return m_center; }
 
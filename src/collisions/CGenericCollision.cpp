@@ -20,6 +20,7 @@
 
 //---------------------------------------------------------------------------
 #include "collisions/CGenericCollision.h"
+#include "graphics/CTriangle.h"
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -39,5 +40,142 @@ cGenericCollision::cGenericCollision()
 
     // set default value for display depth (level 0 = root)
     m_displayDepth = 3;
+
+    // refitted trees are never rebuilt by default
+    m_rebuildRatio = 0.0;
+
+    // reset neighbor counters
+    m_numNeighborQueries = 0;
+    m_numNeighborHits = 0;
+}
+
+
+//===========================================================================
+/*!
+    Check a batch of segments for collisions. Each segment is tested with
+    its own settings, and its collision events are stored in its own
+    recorder. This default implementation calls computeCollision() for
+    each segment; collision detectors which can traverse their tree once
+    for the whole batch override it.
+
+    \fn       bool cGenericCollision::computeCollisions(vector<cCollisionSegment>& a_segments)
+    \param    a_segments  Segments to test, in the local frame of the object.
+    \return   Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cGenericCollision::computeCollisions(vector<cCollisionSegment>& a_segments)
+{
+    bool hit = false;
+    for (unsigned int i=0; i<a_segments.size(); i++)
+    {
+        cCollisionSegment& segment = a_segments[i];
+        hit = hit | computeCollision(segment.m_segmentPointA,
+                                     segment.m_segmentPointB,
+                                     *segment.m_recorder,
+                                     *segment.m_settings);
+    }
+
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Test the neighbors of a triangle against a segment. During sustained
+    contact, the segment passed by the proxy algorithm keeps hitting the
+    triangle hit by the previous query or one of its neighbors, so testing
+    them first records a collision early. The neighbor list of a triangle
+    includes the triangle itself. \n
+
+    A nearer triangle may still lie outside the neighbors, so the caller
+    must traverse the tree in any case. A neighbor hit only shortens the
+    segment, with clipSegment(), so that most of the tree is skipped.
+
+    \fn       cTriangle* cGenericCollision::computeNeighborCollision(cTriangle* a_triangle,
+              cVector3d& a_segmentPointA, cVector3d& a_segmentPointB,
+              cCollisionRecorder& a_recorder, cCollisionSettings& a_settings)
+    \param    a_triangle  Triangle hit by the previous query.
+    \param    a_segmentPointA  Initial point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_recorder  Stores all collision events.
+    \param    a_settings  Contains collision settings information.
+    \return   Return the nearest neighbor hit, \e a_triangle if neighbors
+              were hit but none is nearer than the collisions already
+              recorded, or \b NULL if no neighbor was hit.
+*/
+//===========================================================================
+cTriangle* cGenericCollision::computeNeighborCollision(cTriangle* a_triangle,
+                                                       cVector3d& a_segmentPointA,
+                                                       cVector3d& a_segmentPointB,
+                                                       cCollisionRecorder& a_recorder,
+                                                       cCollisionSettings& a_settings)
+{
+    m_numNeighborQueries++;
+
+    vector<cTriangle*>* neighbors = a_triangle->m_neighbors;
+    cTriangle* nearest = NULL;
+    bool hit = false;
+
+    for (unsigned int i=0; i<neighbors->size(); i++)
+    {
+        cTriangle* triangle = (*neighbors)[i];
+        double squareDistance = a_recorder.m_nearestCollision.m_squareDistance;
+        if (triangle->computeCollision(a_segmentPointA, a_segmentPointB,
+                                       a_recorder, a_settings))
+        {
+            hit = true;
+            if (a_recorder.m_nearestCollision.m_squareDistance < squareDistance)
+            {
+                nearest = triangle;
+            }
+        }
+    }
+
+    if (!hit)
+    {
+        return (NULL);
+    }
+
+    m_numNeighborHits++;
+    return ((nearest != NULL) ? nearest : a_triangle);
+}
+
+
+//===========================================================================
+/*!
+    Compute the end of a segment shortened so that it stops at the nearest
+    collision stored in a recorder. A triangle only records a collision if
+    it is nearer to the origin of the segment than the one already
+    recorded, so the part of the segment beyond it need not be tested.
+
+    \fn       void cGenericCollision::clipSegment(const cVector3d& a_segmentPointA,
+              const cVector3d& a_segmentPointB,
+              const cCollisionRecorder& a_recorder,
+              cVector3d& a_clippedPointB) const
+    \param    a_segmentPointA  Initial point of segment.
+    \param    a_segmentPointB  End point of segment.
+    \param    a_recorder  Recorder holding the nearest collision so far.
+    \param    a_clippedPointB  Returns the end point of the shortened segment.
+*/
+//===========================================================================
+void cGenericCollision::clipSegment(const cVector3d& a_segmentPointA,
+                                    const cVector3d& a_segmentPointB,
+                                    const cCollisionRecorder& a_recorder,
+                                    cVector3d& a_clippedPointB) const
+{
+    cVector3d segment;
+    a_segmentPointB.subr(a_segmentPointA, segment);
+
+    // no collision has been recorded within the segment
+    double squareDistance = a_recorder.m_nearestCollision.m_squareDistance;
+    double squareLength = segment.lengthsq();
+    if (squareDistance >= squareLength)
+    {
+        a_clippedPointB = a_segmentPointB;
+        return;
+    }
+
+    segment.mul(sqrt(squareDistance / squareLength));
+    a_segmentPointA.addr(segment, a_clippedPointB);
 }
 
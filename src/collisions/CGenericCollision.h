@@ -79,6 +79,30 @@ class cGenericCollision
                                   cCollisionSettings& a_settings)
                                   { return (false); }
 
+    //! Compute the collisions of a batch of segments, each with its own recorder and settings.
+    virtual bool computeCollisions(vector<cCollisionSegment>& a_segments);
+
+    //! Get the bounding box of the collision geometry in the local frame of the object. Returns \b false if unknown.
+    virtual bool getBoundaryBox(cVector3d& /*a_boxMin*/, cVector3d& /*a_boxMax*/) { return (false); }
+
+    //! Update the bounding volumes from the current vertex positions. Returns \b false if initialize() must be called instead.
+    virtual bool refit() { return (false); }
+
+    //! Set the ratio by which the cost of a refitted tree may grow before refit() rebuilds it. Zero disables rebuilds.
+    void setRebuildRatio(const double a_rebuildRatio) { m_rebuildRatio = a_rebuildRatio; }
+
+    //! Get the ratio by which the cost of a refitted tree may grow before refit() rebuilds it.
+    double getRebuildRatio() const { return (m_rebuildRatio); }
+
+    //! Get the number of queries which first tested the neighbors of the last triangle hit.
+    unsigned int getNumNeighborQueries() const { return (m_numNeighborQueries); }
+
+    //! Get the number of queries in which a neighbor of the last triangle hit was hit, shortening the traversal of the tree.
+    unsigned int getNumNeighborHits() const { return (m_numNeighborHits); }
+
+    //! Reset the counters of neighbor queries and hits.
+    void resetNeighborCounters() { m_numNeighborQueries = 0; m_numNeighborHits = 0; }
+
     //! Set level of collision tree to display.
     void setDisplayDepth(int a_depth) { m_displayDepth = a_depth; }
 
@@ -96,6 +120,24 @@ class cGenericCollision
 
   protected:
 
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Test the neighbors of a triangle against a segment and return the triangle to test first next time, or NULL if none was hit.
+    cTriangle* computeNeighborCollision(cTriangle* a_triangle,
+                                       cVector3d& a_segmentPointA,
+                                       cVector3d& a_segmentPointB,
+                                       cCollisionRecorder& a_recorder,
+                                       cCollisionSettings& a_settings);
+
+    //! Compute the end of a segment shortened to the nearest collision recorded so far.
+    void clipSegment(const cVector3d& a_segmentPointA,
+                     const cVector3d& a_segmentPointB,
+                     const cCollisionRecorder& a_recorder,
+                     cVector3d& a_clippedPointB) const;
+
+
 	//-----------------------------------------------------------------------
     // MEMBERS:
     //-----------------------------------------------------------------------
@@ -105,6 +147,15 @@ class cGenericCollision
         up to and including this level, positive values render _just_ this level.
     */
     int m_displayDepth;
+
+    //! Ratio by which the cost of a refitted tree may grow before refit() rebuilds it.
+    double m_rebuildRatio;
+
+    //! Number of queries which first tested the neighbors of the last triangle hit.
+    unsigned int m_numNeighborQueries;
+
+    //! Number of queries in which a neighbor of the last triangle hit was hit.
+    unsigned int m_numNeighborHits;
 };
 
 //---------------------------------------------------------------------------
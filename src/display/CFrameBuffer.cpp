@@ -0,0 +1,300 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "display/CFrameBuffer.h"
+#include "graphics/CMacrosGL.h"
+#include <string>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// OpenGL 3.0 definitions, missing from the headers of some platforms. The
+// values are shared by the ARB and EXT extensions.
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER                  0x8D40
+#endif
+#ifndef GL_RENDERBUFFER
+#define GL_RENDERBUFFER                 0x8D41
+#endif
+#ifndef GL_FRAMEBUFFER_BINDING
+#define GL_FRAMEBUFFER_BINDING          0x8CA6
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE         0x8CD5
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0            0x8CE0
+#endif
+#ifndef GL_DEPTH_ATTACHMENT
+#define GL_DEPTH_ATTACHMENT             0x8D00
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24            0x81A6
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cFrameBuffer.
+
+    \fn       cFrameBuffer::cFrameBuffer()
+*/
+//===========================================================================
+cFrameBuffer::cFrameBuffer()
+{
+    m_frameBuffer = 0;
+    m_colorBuffer = 0;
+    m_depthBuffer = 0;
+    m_width = 0;
+    m_height = 0;
+    m_rebuild = true;
+    m_bound = false;
+    m_previousFrameBuffer = 0;
+    for (int i=0; i<4; i++)
+    {
+        m_previousViewport[i] = 0;
+    }
+    m_frameBufferSupport = -1;
+    m_glGenFramebuffers = NULL;
+    m_glDeleteFramebuffers = NULL;
+    m_glBindFramebuffer = NULL;
+    m_glCheckFramebufferStatus = NULL;
+    m_glFramebufferRenderbuffer = NULL;
+    m_glGenRenderbuffers = NULL;
+    m_glDeleteRenderbuffers = NULL;
+    m_glBindRenderbuffer = NULL;
+    m_glRenderbufferStorage = NULL;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cFrameBuffer.
+
+    \fn       cFrameBuffer::~cFrameBuffer()
+*/
+//===========================================================================
+cFrameBuffer::~cFrameBuffer()
+{
+    release();
+}
+
+
+//===========================================================================
+/*!
+    Check whether the current OpenGL context supports frame buffer
+    objects, through OpenGL 3.0 or the GL_ARB_framebuffer_object or
+    GL_EXT_framebuffer_object extension, and load their entry points.
+    The result is kept until release(), since the buffers are created in
+    the same context.
+
+    \fn       bool cFrameBuffer::isSupported()
+    \return   Return \b true if frame buffer objects are supported.
+*/
+//===========================================================================
+bool cFrameBuffer::isSupported()
+{
+    if (m_frameBufferSupport != -1)
+    {
+        return (m_frameBufferSupport == 1);
+    }
+
+    // no context is current yet
+    int version = cGetGLVersion();
+    if (version == 0) { return (false); }
+
+    // entry points of the EXT extension end with EXT
+    std::string suffix;
+    if ((version < 30) && (!cGetGLExtension("GL_ARB_framebuffer_object")))
+    {
+        if (!cGetGLExtension("GL_EXT_framebuffer_object"))
+        {
+            m_frameBufferSupport = 0;
+            return (false);
+        }
+        suffix = "EXT";
+    }
+
+    m_glGenFramebuffers = (cGLGenFramebuffers)cGetGLFunction("glGenFramebuffers" + suffix);
+    m_glDeleteFramebuffers = (cGLDeleteFramebuffers)cGetGLFunction("glDeleteFramebuffers" + suffix);
+    m_glBindFramebuffer = (cGLBindFramebuffer)cGetGLFunction("glBindFramebuffer" + suffix);
+    m_glCheckFramebufferStatus = (cGLCheckFramebufferStatus)cGetGLFunction("glCheckFramebufferStatus" + suffix);
+    m_glFramebufferRenderbuffer = (cGLFramebufferRenderbuffer)cGetGLFunction("glFramebufferRenderbuffer" + suffix);
+    m_glGenRenderbuffers = (cGLGenRenderbuffers)cGetGLFunction("glGenRenderbuffers" + suffix);
+    m_glDeleteRenderbuffers = (cGLDeleteRenderbuffers)cGetGLFunction("glDeleteRenderbuffers" + suffix);
+    m_glBindRenderbuffer = (cGLBindRenderbuffer)cGetGLFunction("glBindRenderbuffer" + suffix);
+    m_glRenderbufferStorage = (cGLRenderbufferStorage)cGetGLFunction("glRenderbufferStorage" + suffix);
+
+    if ((m_glGenFramebuffers != NULL) && (m_glDeleteFramebuffers != NULL) &&
+        (m_glBindFramebuffer != NULL) && (m_glCheckFramebufferStatus != NULL) &&
+        (m_glFramebufferRenderbuffer != NULL) && (m_glGenRenderbuffers != NULL) &&
+        (m_glDeleteRenderbuffers != NULL) && (m_glBindRenderbuffer != NULL) &&
+        (m_glRenderbufferStorage != NULL))
+    {
+        m_frameBufferSupport = 1;
+    }
+    else
+    {
+        m_frameBufferSupport = 0;
+    }
+
+    return (m_frameBufferSupport == 1);
+}
+
+
+//===========================================================================
+/*!
+    Set the size of the buffers. The buffers are created again with this
+    size by the next call to bind().
+
+    \fn       void cFrameBuffer::setSize(const unsigned int a_width,
+                                         const unsigned int a_height)
+    \param    a_width  Width in pixels.
+    \param    a_height  Height in pixels.
+*/
+//===========================================================================
+void cFrameBuffer::setSize(const unsigned int a_width, const unsigned int a_height)
+{
+    if ((a_width == m_width) && (a_height == m_height)) { return; }
+
+    m_width = a_width;
+    m_height = a_height;
+    m_rebuild = true;
+}
+
+
+//===========================================================================
+/*!
+    Bind the buffers, so that OpenGL renders to them, and set the viewport
+    to cover them. The frame buffer and viewport which were current are
+    restored by unbind(). Buffers are created on the first call, and
+    after their size has changed or they have been released.
+
+    \fn       bool cFrameBuffer::bind()
+    \return   Return \b false if frame buffer objects are not supported,
+              or the buffers could not be created.
+*/
+//===========================================================================
+bool cFrameBuffer::bind()
+{
+    if (m_bound) { return (true); }
+    if ((m_width == 0) || (m_height == 0)) { return (false); }
+
+    // buffers are created again, after support is checked again
+    if (m_rebuild) { release(); }
+    if (!isSupported()) { return (false); }
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_previousFrameBuffer);
+    glGetIntegerv(GL_VIEWPORT, m_previousViewport);
+
+    // create buffers
+    if (m_rebuild)
+    {
+        GLuint buffer;
+        m_glGenFramebuffers(1, &buffer);
+        m_frameBuffer = buffer;
+
+        GLuint renderBuffers[2];
+        m_glGenRenderbuffers(2, renderBuffers);
+        m_colorBuffer = renderBuffers[0];
+        m_depthBuffer = renderBuffers[1];
+
+        m_glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+        m_glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+        m_glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+        m_glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
+        m_glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        m_glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+        m_glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                    GL_RENDERBUFFER, m_colorBuffer);
+        m_glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                    GL_RENDERBUFFER, m_depthBuffer);
+
+        // the driver may not support this combination of formats
+        if (m_glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            m_glBindFramebuffer(GL_FRAMEBUFFER, m_previousFrameBuffer);
+            release();
+            return (false);
+        }
+
+        m_rebuild = false;
+    }
+    else
+    {
+        m_glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    }
+
+    glViewport(0, 0, m_width, m_height);
+    m_bound = true;
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Restore the frame buffer and viewport which were current before the
+    last call to bind().
+
+    \fn       void cFrameBuffer::unbind()
+*/
+//===========================================================================
+void cFrameBuffer::unbind()
+{
+    if (!m_bound) { return; }
+
+    m_glBindFramebuffer(GL_FRAMEBUFFER, m_previousFrameBuffer);
+    glViewport(m_previousViewport[0], m_previousViewport[1],
+               m_previousViewport[2], m_previousViewport[3]);
+    m_bound = false;
+}
+
+
+//===========================================================================
+/*!
+    Delete the buffers from the OpenGL context. They are created again by
+    the next call to bind(), which also checks support of frame buffer
+    objects again, in the context current at that time.
+
+    \fn       void cFrameBuffer::release()
+*/
+//===========================================================================
+void cFrameBuffer::release()
+{
+    unbind();
+
+    if ((m_frameBuffer != 0) && (m_glDeleteFramebuffers != NULL))
+    {
+        GLuint buffer = m_frameBuffer;
+        m_glDeleteFramebuffers(1, &buffer);
+
+        GLuint renderBuffers[2];
+        renderBuffers[0] = m_colorBuffer;
+        renderBuffers[1] = m_depthBuffer;
+        m_glDeleteRenderbuffers(2, renderBuffers);
+    }
+
+    m_frameBuffer = 0;
+    m_colorBuffer = 0;
+    m_depthBuffer = 0;
+    m_rebuild = true;
+    m_frameBufferSupport = -1;
+}
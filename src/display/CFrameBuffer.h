@@ -0,0 +1,186 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CFrameBufferH
+#define CFrameBufferH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CFrameBuffer.h
+
+    \brief
+    <b> Viewport </b> \n
+    Offscreen Render Target.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// Entry points of frame buffer objects, loaded by cFrameBuffer.
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+typedef void (APIENTRY *cGLGenFramebuffers)(GLsizei, GLuint*);
+typedef void (APIENTRY *cGLDeleteFramebuffers)(GLsizei, const GLuint*);
+typedef void (APIENTRY *cGLBindFramebuffer)(GLenum, GLuint);
+typedef GLenum (APIENTRY *cGLCheckFramebufferStatus)(GLenum);
+typedef void (APIENTRY *cGLFramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
+typedef void (APIENTRY *cGLGenRenderbuffers)(GLsizei, GLuint*);
+typedef void (APIENTRY *cGLDeleteRenderbuffers)(GLsizei, const GLuint*);
+typedef void (APIENTRY *cGLBindRenderbuffer)(GLenum, GLuint);
+typedef void (APIENTRY *cGLRenderbufferStorage)(GLenum, GLenum, GLsizei, GLsizei);
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \class      cFrameBuffer
+    \ingroup    display
+
+    \brief
+    cFrameBuffer is an offscreen render target: an OpenGL frame buffer
+    object with a color and a depth buffer. \n
+
+    Unlike cViewport, it does not depend on a window system. Any OpenGL
+    context may be used, including a context without window, such as an
+    EGL surfaceless context or an OSMesa context created by the
+    application on a headless machine. Typically:
+
+    \code
+    frameBuffer.setSize(width, height);
+    frameBuffer.bind();
+    camera->renderView(width, height);
+    frameCapture.capture(width, height);
+    frameBuffer.unbind();
+    \endcode
+
+    Buffers are created by the first call to bind(), and created again
+    when the size changes. Frame buffer objects require OpenGL 3.0 or the
+    GL_ARB_framebuffer_object or GL_EXT_framebuffer_object extension; when
+    none is available, bind() returns \b false and the caller renders to
+    the default frame buffer instead. Buffers belong to the OpenGL context
+    which was current when they were created, and must be released with
+    release() before this context is destroyed or reset. Support and entry
+    points are checked in the same context, and checked again after
+    release(), so that a frame buffer may be used with another context.
+*/
+//===========================================================================
+class cFrameBuffer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cFrameBuffer.
+    cFrameBuffer();
+
+    //! Destructor of cFrameBuffer.
+    ~cFrameBuffer();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Return \b true if the OpenGL context of the buffers supports frame buffer objects.
+    bool isSupported();
+
+    //! Set the size of the buffers, in pixels.
+    void setSize(const unsigned int a_width, const unsigned int a_height);
+
+    //! Get the width of the buffers, in pixels.
+    unsigned int getWidth() const { return (m_width); }
+
+    //! Get the height of the buffers, in pixels.
+    unsigned int getHeight() const { return (m_height); }
+
+    //! Render to the buffers, and set the viewport to cover them.
+    bool bind();
+
+    //! Render to the frame buffer and viewport which were current before bind().
+    void unbind();
+
+    //! Delete the buffers. They are created again, and support checked again, by the next call to bind().
+    void release();
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! OpenGL frame buffer object, or 0.
+    unsigned int m_frameBuffer;
+
+    //! OpenGL render buffer holding the colors, or 0.
+    unsigned int m_colorBuffer;
+
+    //! OpenGL render buffer holding the depths, or 0.
+    unsigned int m_depthBuffer;
+
+    //! Width of the buffers, in pixels.
+    unsigned int m_width;
+
+    //! Height of the buffers, in pixels.
+    unsigned int m_height;
+
+    //! If \b true, the buffers are created again by the next call to bind().
+    bool m_rebuild;
+
+    //! If \b true, the buffers are bound.
+    bool m_bound;
+
+    //! Frame buffer bound before bind().
+    int m_previousFrameBuffer;
+
+    //! Viewport set before bind().
+    int m_previousViewport[4];
+
+    //! Support of frame buffer objects: -1 if not checked yet, 0 or 1.
+    int m_frameBufferSupport;
+
+    //! Entry points of frame buffer objects.
+    cGLGenFramebuffers m_glGenFramebuffers;
+    cGLDeleteFramebuffers m_glDeleteFramebuffers;
+    cGLBindFramebuffer m_glBindFramebuffer;
+    cGLCheckFramebufferStatus m_glCheckFramebufferStatus;
+    cGLFramebufferRenderbuffer m_glFramebufferRenderbuffer;
+    cGLGenRenderbuffers m_glGenRenderbuffers;
+    cGLDeleteRenderbuffers m_glDeleteRenderbuffers;
+    cGLBindRenderbuffer m_glBindRenderbuffer;
+    cGLRenderbufferStorage m_glRenderbufferStorage;
+
+  private:
+
+    //! Frame buffers cannot be copied.
+    cFrameBuffer(const cFrameBuffer&);
+
+    //! Frame buffers cannot be assigned.
+    cFrameBuffer& operator=(const cFrameBuffer&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,309 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "display/CFrameCapture.h"
+#include "graphics/CMacrosGL.h"
+#include <string>
+#include <string.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// OpenGL 2.1 definitions, missing from the headers of some platforms.
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER            0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ                  0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY                    0x88B8
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cFrameCapture.
+
+    \fn       cFrameCapture::cFrameCapture(cImageSequenceWriter* a_writer)
+    \param    a_writer  Writer receiving the captured frames, or NULL.
+*/
+//===========================================================================
+cFrameCapture::cFrameCapture(cImageSequenceWriter* a_writer)
+{
+    m_writer = a_writer;
+    for (unsigned int i=0; i<CHAI_FRAME_CAPTURE_NUM_BUFFERS; i++)
+    {
+        m_buffers[i] = 0;
+        m_sizes[i] = 0;
+        m_widths[i] = 0;
+        m_heights[i] = 0;
+        m_pending[i] = false;
+    }
+    m_nextBuffer = 0;
+    m_pixelBufferSupport = -1;
+    m_glGenBuffers = NULL;
+    m_glDeleteBuffers = NULL;
+    m_glBindBuffer = NULL;
+    m_glBufferData = NULL;
+    m_glMapBuffer = NULL;
+    m_glUnmapBuffer = NULL;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cFrameCapture.
+
+    \fn       cFrameCapture::~cFrameCapture()
+*/
+//===========================================================================
+cFrameCapture::~cFrameCapture()
+{
+    release();
+}
+
+
+//===========================================================================
+/*!
+    Check whether the current OpenGL context supports pixel buffer
+    objects, through OpenGL 2.1 or the GL_ARB_pixel_buffer_object
+    extension, and load their entry points. The result is kept until
+    release(), since the buffers are created in the same context.
+
+    \fn       bool cFrameCapture::isSupported()
+    \return   Return \b true if pixel buffer objects are supported.
+*/
+//===========================================================================
+bool cFrameCapture::isSupported()
+{
+    if (m_pixelBufferSupport != -1)
+    {
+        return (m_pixelBufferSupport == 1);
+    }
+
+    // no context is current yet
+    int version = cGetGLVersion();
+    if (version == 0) { return (false); }
+
+    // entry points of buffer objects end with ARB before OpenGL 1.5
+    std::string suffix;
+    if (version < 21)
+    {
+        if (!cGetGLExtension("GL_ARB_pixel_buffer_object"))
+        {
+            m_pixelBufferSupport = 0;
+            return (false);
+        }
+        if (version < 15)
+        {
+            suffix = "ARB";
+        }
+    }
+
+    m_glGenBuffers = (cGLGenBuffers)cGetGLFunction("glGenBuffers" + suffix);
+    m_glDeleteBuffers = (cGLDeleteBuffers)cGetGLFunction("glDeleteBuffers" + suffix);
+    m_glBindBuffer = (cGLBindBuffer)cGetGLFunction("glBindBuffer" + suffix);
+    m_glBufferData = (cGLBufferData)cGetGLFunction("glBufferData" + suffix);
+    m_glMapBuffer = (cGLMapBuffer)cGetGLFunction("glMapBuffer" + suffix);
+    m_glUnmapBuffer = (cGLUnmapBuffer)cGetGLFunction("glUnmapBuffer" + suffix);
+
+    if ((m_glGenBuffers != NULL) && (m_glDeleteBuffers != NULL) &&
+        (m_glBindBuffer != NULL) && (m_glBufferData != NULL) &&
+        (m_glMapBuffer != NULL) && (m_glUnmapBuffer != NULL))
+    {
+        m_pixelBufferSupport = 1;
+    }
+    else
+    {
+        m_pixelBufferSupport = 0;
+    }
+
+    return (m_pixelBufferSupport == 1);
+}
+
+
+//===========================================================================
+/*!
+    Start reading the lower left corner of the current read buffer back
+    into the next buffer of the ring, typically right after
+    cCamera::renderView(). If this buffer still holds an older frame, that
+    frame is first handed over to the writer. Without pixel buffer
+    objects, the frame is read and handed over at once.
+
+    \fn       void cFrameCapture::capture(const unsigned int a_width,
+                                          const unsigned int a_height)
+    \param    a_width  Width of the frame in pixels.
+    \param    a_height  Height of the frame in pixels.
+*/
+//===========================================================================
+void cFrameCapture::capture(const unsigned int a_width, const unsigned int a_height)
+{
+    if ((a_width == 0) || (a_height == 0)) { return; }
+
+    // read synchronously
+    if (!isSupported())
+    {
+        cImageSequenceFrame* frame = (m_writer != NULL) ? m_writer->getFrame(a_width, a_height) : NULL;
+        if (frame == NULL) { return; }
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, a_width, a_height, GL_RGBA, GL_UNSIGNED_BYTE, &frame->m_data[0]);
+        m_writer->submit(frame);
+        return;
+    }
+
+    // the oldest frame has been copied by now
+    unsigned int index = m_nextBuffer;
+    if (m_pending[index])
+    {
+        complete(index);
+    }
+
+    // create buffer
+    if (m_buffers[index] == 0)
+    {
+        GLuint buffer;
+        m_glGenBuffers(1, &buffer);
+        m_buffers[index] = buffer;
+        m_sizes[index] = 0;
+    }
+
+    // read pixels into the buffer; glReadPixels returns without waiting
+    unsigned int size = 4 * a_width * a_height;
+    m_glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[index]);
+    if (m_sizes[index] != size)
+    {
+        m_glBufferData(GL_PIXEL_PACK_BUFFER, (ptrdiff_t)size, NULL, GL_STREAM_READ);
+        m_sizes[index] = size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, a_width, a_height, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)0);
+    m_glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_widths[index] = a_width;
+    m_heights[index] = a_height;
+    m_pending[index] = true;
+    m_nextBuffer = (index + 1) % CHAI_FRAME_CAPTURE_NUM_BUFFERS;
+}
+
+
+//===========================================================================
+/*!
+    Hand all frames of the ring over to the writer, oldest first. This
+    waits until the graphics card has copied the last frame.
+
+    \fn       void cFrameCapture::flush()
+*/
+//===========================================================================
+void cFrameCapture::flush()
+{
+    for (unsigned int i=0; i<CHAI_FRAME_CAPTURE_NUM_BUFFERS; i++)
+    {
+        unsigned int index = (m_nextBuffer + i) % CHAI_FRAME_CAPTURE_NUM_BUFFERS;
+        if (m_pending[index])
+        {
+            complete(index);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Delete the buffers from the OpenGL context. Frames which have not been
+    handed over yet are lost; call flush() first to keep them. Support of
+    pixel buffer objects is checked again by the next capture, in the
+    context current at that time.
+
+    \fn       void cFrameCapture::release()
+*/
+//===========================================================================
+void cFrameCapture::release()
+{
+    for (unsigned int i=0; i<CHAI_FRAME_CAPTURE_NUM_BUFFERS; i++)
+    {
+        if ((m_buffers[i] != 0) && (m_glDeleteBuffers != NULL))
+        {
+            GLuint buffer = m_buffers[i];
+            m_glDeleteBuffers(1, &buffer);
+        }
+        m_buffers[i] = 0;
+        m_sizes[i] = 0;
+        m_pending[i] = false;
+    }
+    m_nextBuffer = 0;
+    m_pixelBufferSupport = -1;
+}
+
+
+//===========================================================================
+/*!
+    Get the number of frames read into the ring and not yet handed over
+    to the writer.
+
+    \fn       unsigned int cFrameCapture::getNumPendingFrames() const
+    \return   Return the number of frames being read back.
+*/
+//===========================================================================
+unsigned int cFrameCapture::getNumPendingFrames() const
+{
+    unsigned int numFrames = 0;
+    for (unsigned int i=0; i<CHAI_FRAME_CAPTURE_NUM_BUFFERS; i++)
+    {
+        if (m_pending[i]) { numFrames++; }
+    }
+
+    return (numFrames);
+}
+
+
+//===========================================================================
+/*!
+    Map a buffer of the ring and copy its frame to a frame of the writer.
+    The frame is dropped if the writer has no room for it.
+
+    \fn       void cFrameCapture::complete(const unsigned int a_buffer)
+    \param    a_buffer  Index of the buffer.
+*/
+//===========================================================================
+void cFrameCapture::complete(const unsigned int a_buffer)
+{
+    m_pending[a_buffer] = false;
+
+    cImageSequenceFrame* frame = (m_writer != NULL) ?
+        m_writer->getFrame(m_widths[a_buffer], m_heights[a_buffer]) : NULL;
+    if (frame == NULL) { return; }
+
+    m_glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[a_buffer]);
+    const GLvoid* data = m_glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (data != NULL)
+    {
+        memcpy(&frame->m_data[0], data, frame->m_data.size());
+        m_glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        // keep the sequence continuous with a black frame
+        memset(&frame->m_data[0], 0, frame->m_data.size());
+    }
+    m_glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_writer->submit(frame);
+}
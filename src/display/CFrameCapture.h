@@ -0,0 +1,187 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CFrameCaptureH
+#define CFrameCaptureH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+#include "files/CImageSequenceWriter.h"
+#include <stddef.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CFrameCapture.h
+
+    \brief
+    <b> Viewport </b> \n
+    Asynchronous Frame Capture.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Number of pixel buffers in the ring of a cFrameCapture.
+#define CHAI_FRAME_CAPTURE_NUM_BUFFERS  3
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Entry points of pixel buffer objects, loaded by cFrameCapture.
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+typedef void (APIENTRY *cGLGenBuffers)(GLsizei, GLuint*);
+typedef void (APIENTRY *cGLDeleteBuffers)(GLsizei, const GLuint*);
+typedef void (APIENTRY *cGLBindBuffer)(GLenum, GLuint);
+typedef void (APIENTRY *cGLBufferData)(GLenum, ptrdiff_t, const GLvoid*, GLenum);
+typedef GLvoid* (APIENTRY *cGLMapBuffer)(GLenum, GLenum);
+typedef GLboolean (APIENTRY *cGLUnmapBuffer)(GLenum);
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \class      cFrameCapture
+    \ingroup    display
+
+    \brief
+    cFrameCapture reads rendered frames back from OpenGL without waiting
+    for the rendering to complete, and passes them to a
+    cImageSequenceWriter. \n
+
+    cCamera::copyImageData() calls glReadPixels() into client memory,
+    which waits until the graphics card has finished rendering the frame.
+    Instead, capture() reads the frame into one of a ring of pixel buffer
+    objects, and returns immediately while the graphics card copies the
+    pixels. The frame is mapped and handed to the writer only when its
+    buffer comes round again, CHAI_FRAME_CAPTURE_NUM_BUFFERS - 1 frames
+    later, by which time the copy has completed. flush() hands over the
+    frames still in the ring, and must be called at the end of a
+    recording. \n
+
+    Frames are read from the current read buffer of OpenGL, which is the
+    color buffer of a bound cFrameBuffer when rendering offscreen. Pixel
+    buffer objects require OpenGL 2.1 or the GL_ARB_pixel_buffer_object
+    extension; without them, capture() reads frames synchronously.
+    Buffers belong to the OpenGL context which was current when they were
+    created, and must be released with release() before this context is
+    destroyed or reset. Support and entry points are checked in the same
+    context, and checked again after release(), so that a capture may be
+    used with another context.
+*/
+//===========================================================================
+class cFrameCapture
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cFrameCapture.
+    cFrameCapture(cImageSequenceWriter* a_writer = NULL);
+
+    //! Destructor of cFrameCapture.
+    ~cFrameCapture();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Return \b true if the OpenGL context of the buffers supports pixel buffer objects.
+    bool isSupported();
+
+    //! Set the writer receiving the captured frames.
+    void setWriter(cImageSequenceWriter* a_writer) { m_writer = a_writer; }
+
+    //! Get the writer receiving the captured frames.
+    cImageSequenceWriter* getWriter() const { return (m_writer); }
+
+    //! Start reading the current frame back, and hand over the oldest frame of the ring.
+    void capture(const unsigned int a_width, const unsigned int a_height);
+
+    //! Hand over all frames of the ring to the writer.
+    void flush();
+
+    //! Delete the buffers. Frames still in the ring are lost, and support is checked again.
+    void release();
+
+    //! Get the number of frames being read back.
+    unsigned int getNumPendingFrames() const;
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Map a buffer of the ring and hand its frame over to the writer.
+    void complete(const unsigned int a_buffer);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Writer receiving the captured frames, or NULL.
+    cImageSequenceWriter* m_writer;
+
+    //! OpenGL pixel buffers of the ring, or 0.
+    unsigned int m_buffers[CHAI_FRAME_CAPTURE_NUM_BUFFERS];
+
+    //! Size of each buffer, in bytes.
+    unsigned int m_sizes[CHAI_FRAME_CAPTURE_NUM_BUFFERS];
+
+    //! Width of the frame read into each buffer.
+    unsigned int m_widths[CHAI_FRAME_CAPTURE_NUM_BUFFERS];
+
+    //! Height of the frame read into each buffer.
+    unsigned int m_heights[CHAI_FRAME_CAPTURE_NUM_BUFFERS];
+
+    //! If \b true, the buffer holds a frame not handed over yet.
+    bool m_pending[CHAI_FRAME_CAPTURE_NUM_BUFFERS];
+
+    //! Index of the buffer receiving the next frame.
+    unsigned int m_nextBuffer;
+
+    //! Support of pixel buffer objects: -1 if not checked yet, 0 or 1.
+    int m_pixelBufferSupport;
+
+    //! Entry points of pixel buffer objects.
+    cGLGenBuffers m_glGenBuffers;
+    cGLDeleteBuffers m_glDeleteBuffers;
+    cGLBindBuffer m_glBindBuffer;
+    cGLBufferData m_glBufferData;
+    cGLMapBuffer m_glMapBuffer;
+    cGLUnmapBuffer m_glUnmapBuffer;
+
+  private:
+
+    //! Frame captures cannot be copied.
+    cFrameCapture(const cFrameCapture&);
+
+    //! Frame captures cannot be assigned.
+    cFrameCapture& operator=(const cFrameCapture&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,467 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "files/CImageSequenceWriter.h"
+#include <algorithm>
+#include <stdio.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cImageSequenceWriter.
+
+    \fn     cImageSequenceWriter::cImageSequenceWriter()
+*/
+//===========================================================================
+cImageSequenceWriter::cImageSequenceWriter()
+{
+    m_nextIndex = 0;
+    m_maxPendingFrames = CHAI_IMAGE_SEQUENCE_MAX_PENDING;
+    m_numWrittenFrames = 0;
+    m_numDroppedFrames = 0;
+    m_running = false;
+    m_quit = false;
+
+#if defined(_WIN32)
+    m_thread = NULL;
+    InitializeCriticalSection(&m_lock);
+    m_workSemaphore = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_init(&m_lock, NULL);
+    pthread_cond_init(&m_workCondition, NULL);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cImageSequenceWriter. Waits until all pending frames are
+    written, then deletes all frames, including frames taken by getFrame()
+    and never submitted, which must no longer be used.
+
+    \fn     cImageSequenceWriter::~cImageSequenceWriter()
+*/
+//===========================================================================
+cImageSequenceWriter::~cImageSequenceWriter()
+{
+    stop();
+
+    for (unsigned int i=0; i<m_freeFrames.size(); i++)
+    {
+        delete m_freeFrames[i];
+    }
+    for (unsigned int i=0; i<m_filledFrames.size(); i++)
+    {
+        delete m_filledFrames[i];
+    }
+
+#if defined(_WIN32)
+    CloseHandle(m_workSemaphore);
+    DeleteCriticalSection(&m_lock);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_cond_destroy(&m_workCondition);
+    pthread_mutex_destroy(&m_lock);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Start the writer thread. Frames are written to files named after the
+    prefix, the index of the frame on six digits, and the extension .tga.
+    The prefix may contain a directory, which must exist.
+
+    \fn     bool cImageSequenceWriter::start(const std::string& a_prefix,
+            const unsigned int a_firstIndex)
+    \param  a_prefix  Prefix of the names of the files, such as "capture/frame".
+    \param  a_firstIndex  Index of the first frame.
+    \return Return \b true if the writer thread was started.
+*/
+//===========================================================================
+bool cImageSequenceWriter::start(const std::string& a_prefix,
+                                 const unsigned int a_firstIndex)
+{
+    stop();
+
+    m_prefix = a_prefix;
+    m_nextIndex = a_firstIndex;
+    m_numWrittenFrames = 0;
+    m_numDroppedFrames = 0;
+    m_quit = false;
+
+#if defined(_WIN32)
+    m_thread = CreateThread(0, 0, writerFunction, this, 0, NULL);
+    m_running = (m_thread != NULL);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    m_running = (pthread_create(&m_thread, 0, writerFunction, this) == 0);
+#endif
+
+    return (m_running);
+}
+
+
+//===========================================================================
+/*!
+    Stop the writer thread, after all pending frames have been written.
+
+    \fn     void cImageSequenceWriter::stop()
+*/
+//===========================================================================
+void cImageSequenceWriter::stop()
+{
+    if (!m_running) { return; }
+
+    lock();
+    m_quit = true;
+    m_running = false;
+    unlock();
+
+#if defined(_WIN32)
+    ReleaseSemaphore(m_workSemaphore, 1, NULL);
+    WaitForSingleObject(m_thread, INFINITE);
+    CloseHandle(m_thread);
+    m_thread = NULL;
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_lock(&m_lock);
+    pthread_cond_signal(&m_workCondition);
+    pthread_mutex_unlock(&m_lock);
+    pthread_join(m_thread, NULL);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Get a frame to be filled by the caller and passed to submit(). Its
+    memory is reused from frames already written when possible.
+
+    \fn     cImageSequenceFrame* cImageSequenceWriter::getFrame(
+            const unsigned int a_width, const unsigned int a_height)
+    \param  a_width  Width of the image in pixels.
+    \param  a_height  Height of the image in pixels.
+    \return Return a frame with room for the pixels of the image, or NULL
+            if the writer is not running or too many frames are waiting
+            to be written, in which case the frame is counted as dropped.
+*/
+//===========================================================================
+cImageSequenceFrame* cImageSequenceWriter::getFrame(const unsigned int a_width,
+                                                    const unsigned int a_height)
+{
+    lock();
+
+    if (!m_running)
+    {
+        unlock();
+        return (NULL);
+    }
+
+    if (m_pendingFrames.size() + m_filledFrames.size() >= m_maxPendingFrames)
+    {
+        m_numDroppedFrames++;
+        unlock();
+        return (NULL);
+    }
+
+    cImageSequenceFrame* frame;
+    if (m_freeFrames.empty())
+    {
+        frame = new cImageSequenceFrame;
+    }
+    else
+    {
+        frame = m_freeFrames.back();
+        m_freeFrames.pop_back();
+    }
+    m_filledFrames.push_back(frame);
+
+    unlock();
+
+    frame->m_width = a_width;
+    frame->m_height = a_height;
+    frame->m_index = 0;
+    frame->m_data.resize(4 * a_width * a_height);
+
+    return (frame);
+}
+
+
+//===========================================================================
+/*!
+    Queue a frame returned by getFrame() to be written by the writer
+    thread. The frame takes the next index of the sequence. Frames which
+    were not returned by getFrame(), or were already submitted, are
+    ignored.
+
+    \fn     void cImageSequenceWriter::submit(cImageSequenceFrame* a_frame)
+    \param  a_frame  Frame filled by the caller.
+*/
+//===========================================================================
+void cImageSequenceWriter::submit(cImageSequenceFrame* a_frame)
+{
+    if (a_frame == NULL) { return; }
+
+    lock();
+
+    vector<cImageSequenceFrame*>::iterator it =
+        std::find(m_filledFrames.begin(), m_filledFrames.end(), a_frame);
+    if (it == m_filledFrames.end())
+    {
+        unlock();
+        return;
+    }
+    m_filledFrames.erase(it);
+
+    // the writer was stopped while the frame was filled
+    if (!m_running)
+    {
+        m_freeFrames.push_back(a_frame);
+        unlock();
+        return;
+    }
+
+    a_frame->m_index = m_nextIndex++;
+    m_pendingFrames.push_back(a_frame);
+
+#if defined(_WIN32)
+    unlock();
+    ReleaseSemaphore(m_workSemaphore, 1, NULL);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_cond_signal(&m_workCondition);
+    unlock();
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Get the number of frames written since start().
+
+    \fn     unsigned int cImageSequenceWriter::getNumWrittenFrames()
+    \return Return the number of frames written.
+*/
+//===========================================================================
+unsigned int cImageSequenceWriter::getNumWrittenFrames()
+{
+    lock();
+    unsigned int numFrames = m_numWrittenFrames;
+    unlock();
+
+    return (numFrames);
+}
+
+
+//===========================================================================
+/*!
+    Get the number of frames dropped since start(), because too many
+    frames were waiting to be written.
+
+    \fn     unsigned int cImageSequenceWriter::getNumDroppedFrames()
+    \return Return the number of frames dropped.
+*/
+//===========================================================================
+unsigned int cImageSequenceWriter::getNumDroppedFrames()
+{
+    lock();
+    unsigned int numFrames = m_numDroppedFrames;
+    unlock();
+
+    return (numFrames);
+}
+
+
+//===========================================================================
+/*!
+    Write an image to an uncompressed 32-bit TGA file. Rows are stored
+    from the bottom up, as read by OpenGL, so that they need not be
+    reordered.
+
+    \fn     bool cImageSequenceWriter::writeTGA(const std::string& a_filename,
+            const cImageSequenceFrame& a_frame)
+    \param  a_filename  Name of the file.
+    \param  a_frame  Image to write.
+    \return Return \b true if the file was written.
+*/
+//===========================================================================
+bool cImageSequenceWriter::writeTGA(const std::string& a_filename,
+                                    const cImageSequenceFrame& a_frame)
+{
+    if (a_frame.m_data.size() < 4 * a_frame.m_width * a_frame.m_height) { return (false); }
+
+    FILE* file = fopen(a_filename.c_str(), "wb");
+    if (file == NULL) { return (false); }
+
+    // header: true color image, 32 bits per pixel with 8 bits of alpha,
+    // origin at the lower left corner
+    unsigned char header[18];
+    for (int i=0; i<18; i++) { header[i] = 0; }
+    header[2] = 2;
+    header[12] = (unsigned char)(a_frame.m_width & 0xff);
+    header[13] = (unsigned char)((a_frame.m_width >> 8) & 0xff);
+    header[14] = (unsigned char)(a_frame.m_height & 0xff);
+    header[15] = (unsigned char)((a_frame.m_height >> 8) & 0xff);
+    header[16] = 32;
+    header[17] = 8;
+    bool success = (fwrite(header, 1, 18, file) == 18);
+
+    // pixels are stored in BGRA order
+    vector<unsigned char> row(4 * a_frame.m_width);
+    const unsigned char* pixel = a_frame.m_data.empty() ? NULL : &a_frame.m_data[0];
+    for (unsigned int y=0; (y<a_frame.m_height) && success; y++)
+    {
+        for (unsigned int x=0; x<a_frame.m_width; x++)
+        {
+            row[4*x]   = pixel[2];
+            row[4*x+1] = pixel[1];
+            row[4*x+2] = pixel[0];
+            row[4*x+3] = pixel[3];
+            pixel += 4;
+        }
+        success = (fwrite(&row[0], 1, row.size(), file) == row.size());
+    }
+
+    fclose(file);
+
+    return (success);
+}
+
+
+//===========================================================================
+/*!
+    Main loop of the writer thread.
+
+    \fn     void cImageSequenceWriter::work()
+*/
+//===========================================================================
+void cImageSequenceWriter::work()
+{
+    lock();
+    while (true)
+    {
+        // wait for a frame
+        if (m_pendingFrames.empty())
+        {
+            if (m_quit) { break; }
+
+#if defined(_WIN32)
+            unlock();
+            WaitForSingleObject(m_workSemaphore, INFINITE);
+            lock();
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+            pthread_cond_wait(&m_workCondition, &m_lock);
+#endif
+            continue;
+        }
+
+        // write the oldest frame
+        cImageSequenceFrame* frame = m_pendingFrames.front();
+        m_pendingFrames.pop_front();
+        unlock();
+
+        char number[16];
+        sprintf(number, "%06u", frame->m_index);
+        bool success = writeTGA(m_prefix + number + ".tga", *frame);
+
+        lock();
+        if (success)
+        {
+            m_numWrittenFrames++;
+        }
+        else
+        {
+            m_numDroppedFrames++;
+        }
+        m_freeFrames.push_back(frame);
+    }
+    unlock();
+}
+
+
+//===========================================================================
+/*!
+    Acquire the lock of the writer.
+
+    \fn     void cImageSequenceWriter::lock()
+*/
+//===========================================================================
+void cImageSequenceWriter::lock()
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&m_lock);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_lock(&m_lock);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Release the lock of the writer.
+
+    \fn     void cImageSequenceWriter::unlock()
+*/
+//===========================================================================
+void cImageSequenceWriter::unlock()
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&m_lock);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_unlock(&m_lock);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Entry point of the writer thread.
+
+    \param  a_writer  Writer owning the thread.
+*/
+//===========================================================================
+#if defined(_WIN32)
+DWORD WINAPI cImageSequenceWriter::writerFunction(LPVOID a_writer)
+{
+    ((cImageSequenceWriter*)a_writer)->work();
+    return (0);
+}
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+void* cImageSequenceWriter::writerFunction(void* a_writer)
+{
+    ((cImageSequenceWriter*)a_writer)->work();
+    return (NULL);
+}
+#endif
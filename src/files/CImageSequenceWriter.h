@@ -0,0 +1,237 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CImageSequenceWriterH
+#define CImageSequenceWriterH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+#include <deque>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CImageSequenceWriter.h
+
+    \brief
+    <b> Files </b> \n
+    Background Image Sequence Writer.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Default number of frames waiting to be written before new frames are dropped.
+#define CHAI_IMAGE_SEQUENCE_MAX_PENDING     16
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cImageSequenceFrame
+    \ingroup    files
+
+    \brief
+    cImageSequenceFrame is an image waiting to be written by a
+    cImageSequenceWriter.
+*/
+//===========================================================================
+struct cImageSequenceFrame
+{
+    //! Pixels in RGBA format, 8 bits per component, from the bottom row up as read by OpenGL.
+    vector<unsigned char> m_data;
+
+    //! Width of the image in pixels.
+    unsigned int m_width;
+
+    //! Height of the image in pixels.
+    unsigned int m_height;
+
+    //! Index of the image in the sequence.
+    unsigned int m_index;
+};
+
+
+//===========================================================================
+/*!
+    \class      cImageSequenceWriter
+    \ingroup    files
+
+    \brief
+    cImageSequenceWriter writes a sequence of images to numbered files
+    from a background thread, so that recording a session does not slow
+    down the thread which renders it. \n
+
+    The rendering thread takes a frame from getFrame(), fills its pixels,
+    and hands it back with submit(). The writer thread encodes submitted
+    frames, in order, as uncompressed 32-bit TGA files named after a
+    prefix and the index of the frame, such as "capture/frame000042.tga",
+    then recycles their memory. If the disk cannot keep up, getFrame()
+    returns NULL once too many frames are waiting, and the frame is
+    dropped rather than blocking the rendering thread. Frames taken and
+    never submitted remain owned by the writer, which deletes them when
+    it is destroyed.
+*/
+//===========================================================================
+class cImageSequenceWriter
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cImageSequenceWriter.
+    cImageSequenceWriter();
+
+    //! Destructor of cImageSequenceWriter. Writes all pending frames and deletes all frames.
+    ~cImageSequenceWriter();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Start the writer thread, with a prefix for the names of the files.
+    bool start(const std::string& a_prefix, const unsigned int a_firstIndex = 0);
+
+    //! Write all pending frames and stop the writer thread.
+    void stop();
+
+    //! Return \b true if the writer thread is running.
+    bool isRunning() const { return (m_running); }
+
+    //! Get a frame to fill, or NULL if the frame must be dropped.
+    cImageSequenceFrame* getFrame(const unsigned int a_width, const unsigned int a_height);
+
+    //! Queue a frame returned by getFrame() to be written.
+    void submit(cImageSequenceFrame* a_frame);
+
+    //! Set the number of frames waiting to be written before new frames are dropped.
+    void setMaxPendingFrames(const unsigned int a_maxPendingFrames) { m_maxPendingFrames = a_maxPendingFrames; }
+
+    //! Get the number of frames waiting to be written before new frames are dropped.
+    unsigned int getMaxPendingFrames() const { return (m_maxPendingFrames); }
+
+    //! Get the number of frames written since start().
+    unsigned int getNumWrittenFrames();
+
+    //! Get the number of frames dropped since start().
+    unsigned int getNumDroppedFrames();
+
+    //! Write an image to a TGA file.
+    static bool writeTGA(const std::string& a_filename, const cImageSequenceFrame& a_frame);
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Write submitted frames until the writer is stopped.
+    void work();
+
+    //! Acquire the lock of the writer.
+    void lock();
+
+    //! Release the lock of the writer.
+    void unlock();
+
+#if defined(_WIN32)
+    //! Entry point of the writer thread.
+    static DWORD WINAPI writerFunction(LPVOID a_writer);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Entry point of the writer thread.
+    static void* writerFunction(void* a_writer);
+#endif
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Prefix of the names of the files.
+    std::string m_prefix;
+
+    //! Index of the next frame submitted.
+    unsigned int m_nextIndex;
+
+    //! Frames waiting to be written, in order.
+    std::deque<cImageSequenceFrame*> m_pendingFrames;
+
+    //! Frames whose memory can be reused.
+    vector<cImageSequenceFrame*> m_freeFrames;
+
+    //! Frames taken by getFrame() and not submitted yet.
+    vector<cImageSequenceFrame*> m_filledFrames;
+
+    //! Number of frames waiting to be written before new frames are dropped.
+    unsigned int m_maxPendingFrames;
+
+    //! Number of frames written since start().
+    unsigned int m_numWrittenFrames;
+
+    //! Number of frames dropped since start().
+    unsigned int m_numDroppedFrames;
+
+    //! If \b true, the writer thread is running.
+    bool m_running;
+
+    //! If \b true, the writer thread terminates once all pending frames are written.
+    bool m_quit;
+
+#if defined(_WIN32)
+    //! Writer thread handle.
+    HANDLE m_thread;
+
+    //! Lock protecting the frames and counters.
+    CRITICAL_SECTION m_lock;
+
+    //! Semaphore released when frames are submitted.
+    HANDLE m_workSemaphore;
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Writer thread handle.
+    pthread_t m_thread;
+
+    //! Lock protecting the frames and counters.
+    pthread_mutex_t m_lock;
+
+    //! Condition signaled when frames are submitted.
+    pthread_cond_t m_workCondition;
+#endif
+
+  private:
+
+    //! Writers cannot be copied.
+    cImageSequenceWriter(const cImageSequenceWriter&);
+
+    //! Writers cannot be assigned.
+    cImageSequenceWriter& operator=(const cImageSequenceWriter&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
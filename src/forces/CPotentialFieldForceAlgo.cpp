@@ -22,6 +22,7 @@
 #include "forces/CInteractionBasics.h"
 #include "forces/CPotentialFieldForceAlgo.h"
 #include "scenegraph/CWorld.h"
+#include "timers/CProfiler.h"
 //---------------------------------------------------------------------------
 unsigned int cPotentialFieldForceAlgo::m_IDNcounter = 0;
 //---------------------------------------------------------------------------
@@ -60,6 +61,8 @@ cPotentialFieldForceAlgo::cPotentialFieldForceAlgo()
 cVector3d cPotentialFieldForceAlgo::computeForces(const cVector3d& a_toolPos,
                                                   const cVector3d& a_toolVel)
 {
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_POTENTIAL_FIELDS);
+
     // initialize force
     cVector3d force;
     force.zero();
@@ -21,6 +21,7 @@
 //---------------------------------------------------------------------------
 #include "forces/CProxyPointForceAlgo.h"
 #include "scenegraph/CWorld.h"
+#include "timers/CProfiler.h"
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -266,6 +267,8 @@ void cProxyPointForceAlgo::computeNextBestProxyPosition(const cVector3d& a_goal)
 
 bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints0(const cVector3d& a_goalGlobalPos)
 {
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_PROXY_CONSTRAINT_0);
+
     // We define the goal position of the proxy.
     cVector3d goalGlobalPos = a_goalGlobalPos;
 
@@ -348,6 +351,8 @@ bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints0(const cVector
                                                   targetPos,
                                                   m_collisionRecorderConstraint0,
                                                   m_collisionSettings);
+    profilerScope.addTests(m_collisionRecorderConstraint0.m_numNodeTests,
+                           m_collisionRecorderConstraint0.m_numTriangleTests);
 
 
     // check if collision occurred between proxy and goal positions.
@@ -466,6 +471,8 @@ bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints0(const cVector
 
 bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints1(const cVector3d& a_goalGlobalPos)
 {
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_PROXY_CONSTRAINT_1);
+
     // The proxy is now constrained on a plane; we now calculate the nearest
     // point to the original goal (device position) on this plane; this point
     // is computed by projecting the ideal goal onto the plane defined by the
@@ -510,6 +517,8 @@ bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints1(const cVector
                                                    targetPos,
                                                    m_collisionRecorderConstraint1,
                                                    m_collisionSettings);
+    profilerScope.addTests(m_collisionRecorderConstraint1.m_numNodeTests,
+                           m_collisionRecorderConstraint1.m_numTriangleTests);
 
     // check if collision occurred between proxy and goal positions.
     double collisionDistance;
@@ -615,6 +624,8 @@ bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints1(const cVector
 
 bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints2(const cVector3d& a_goalGlobalPos)
 {
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_PROXY_CONSTRAINT_2);
+
     // The proxy is now constrained by two triangles and can only move along
     // a virtual line; we now calculate the nearest point to the original
     // goal (device position) along this line by projecting the ideal
@@ -676,6 +687,8 @@ bool cProxyPointForceAlgo::computeNextProxyPositionWithContraints2(const cVector
                                                    targetPos,
                                                    m_collisionRecorderConstraint2,
                                                    m_collisionSettings);
+    profilerScope.addTests(m_collisionRecorderConstraint2.m_numNodeTests,
+                           m_collisionRecorderConstraint2.m_numTriangleTests);
 
     // check if collision occurred between proxy and goal positions.
     double collisionDistance;
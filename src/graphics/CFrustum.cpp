@@ -0,0 +1,196 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "graphics/CFrustum.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cFrustum. All planes are tested, and the frustum holds
+    no statistics and no projection.
+
+    \fn       cFrustum::cFrustum()
+*/
+//===========================================================================
+cFrustum::cFrustum()
+{
+    for (int i=0; i<CHAI_FRUSTUM_NUM_PLANES; i++)
+    {
+        m_normals[i].zero();
+        m_offsets[i] = 0.0;
+    }
+    m_mask = CHAI_FRUSTUM_ALL_PLANES;
+    m_viewNormal.zero();
+    m_viewOffset = 0.0;
+    m_pixelsPerUnit = 0.0;
+    m_perspective = false;
+    m_statistics = NULL;
+}
+
+
+//===========================================================================
+/*!
+    Extract the planes of the frustum from the projection and modelview
+    matrices, in the column-major order of OpenGL. Each plane is a sum or
+    difference of the fourth row of their product with one of the other
+    rows. The planes are expressed in the frame which the modelview matrix
+    transforms into eye coordinates. \n
+
+    The view axis is the third row of the modelview matrix, negated and
+    divided by the scale of the matrix, so that depths are measured in
+    units of that frame. The scale in pixels of the projection is taken
+    from the second diagonal element of the projection matrix.
+
+    \fn       void cFrustum::set(const double* a_projection,
+                                 const double* a_modelview,
+                                 const int a_viewportHeight)
+    \param    a_projection  Projection matrix.
+    \param    a_modelview  Modelview matrix.
+    \param    a_viewportHeight  Height of the viewport in pixels.
+*/
+//===========================================================================
+void cFrustum::set(const double* a_projection, const double* a_modelview,
+                   const int a_viewportHeight)
+{
+    // product of the matrices, by rows
+    double m[4][4];
+    for (int row=0; row<4; row++)
+    {
+        for (int col=0; col<4; col++)
+        {
+            double sum = 0.0;
+            for (int k=0; k<4; k++)
+            {
+                sum += a_projection[4*k + row] * a_modelview[4*col + k];
+            }
+            m[row][col] = sum;
+        }
+    }
+
+    // left, right, bottom, top, near and far
+    for (int i=0; i<CHAI_FRUSTUM_NUM_PLANES; i++)
+    {
+        int row = i / 2;
+        double sign = (i % 2 == 0) ? 1.0 : -1.0;
+        m_normals[i].set(m[3][0] + sign * m[row][0],
+                         m[3][1] + sign * m[row][1],
+                         m[3][2] + sign * m[row][2]);
+        m_offsets[i] = m[3][3] + sign * m[row][3];
+    }
+
+    m_mask = CHAI_FRUSTUM_ALL_PLANES;
+
+    // view axis and projected scale
+    cVector3d axis(a_modelview[2], a_modelview[6], a_modelview[10]);
+    double scale = axis.length();
+    if (scale > 0.0)
+    {
+        axis.mul(-1.0 / scale);
+        m_viewNormal = axis;
+        m_viewOffset = -a_modelview[14] / scale;
+    }
+    m_perspective = (a_projection[15] == 0.0);
+    m_pixelsPerUnit = a_projection[5] * 0.5 * (double)a_viewportHeight;
+    if (!m_perspective) { m_pixelsPerUnit *= scale; }
+}
+
+
+//===========================================================================
+/*!
+    Express the planes of a frustum in the frame of a child object, given
+    the position and rotation of the child in the frame of the frustum.
+    Only the planes of the mask are transformed, while the view axis is
+    always transformed; the mask, projection and statistics are copied.
+
+    \fn       void cFrustum::transform(const cFrustum& a_frustum,
+                                       const cVector3d& a_pos,
+                                       const cMatrix3d& a_rot)
+    \param    a_frustum  Frustum in the frame of the parent.
+    \param    a_pos  Position of the child frame.
+    \param    a_rot  Rotation of the child frame.
+*/
+//===========================================================================
+void cFrustum::transform(const cFrustum& a_frustum,
+                         const cVector3d& a_pos,
+                         const cMatrix3d& a_rot)
+{
+    m_mask = a_frustum.m_mask;
+    m_pixelsPerUnit = a_frustum.m_pixelsPerUnit;
+    m_perspective = a_frustum.m_perspective;
+    m_statistics = a_frustum.m_statistics;
+
+    // view axis
+    const cVector3d& v = a_frustum.m_viewNormal;
+    m_viewNormal.set(a_rot.m[0][0] * v.x + a_rot.m[1][0] * v.y + a_rot.m[2][0] * v.z,
+                     a_rot.m[0][1] * v.x + a_rot.m[1][1] * v.y + a_rot.m[2][1] * v.z,
+                     a_rot.m[0][2] * v.x + a_rot.m[1][2] * v.y + a_rot.m[2][2] * v.z);
+    m_viewOffset = a_frustum.m_viewOffset + v.dot(a_pos);
+
+    for (int i=0; i<CHAI_FRUSTUM_NUM_PLANES; i++)
+    {
+        if ((m_mask & (1 << i)) == 0) { continue; }
+
+        // rotate the normal by the transpose of the rotation
+        const cVector3d& n = a_frustum.m_normals[i];
+        m_normals[i].set(a_rot.m[0][0] * n.x + a_rot.m[1][0] * n.y + a_rot.m[2][0] * n.z,
+                         a_rot.m[0][1] * n.x + a_rot.m[1][1] * n.y + a_rot.m[2][1] * n.z,
+                         a_rot.m[0][2] * n.x + a_rot.m[1][2] * n.y + a_rot.m[2][2] * n.z);
+        m_offsets[i] = a_frustum.m_offsets[i] + n.dot(a_pos);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Test a box against the planes of the mask. The box is outside if its
+    corner furthest along the normal of a plane lies behind it. Planes
+    which the nearest corner lies in front of are removed from the mask.
+
+    \fn       bool cFrustum::cullBox(const cVector3d& a_boxMin,
+                                     const cVector3d& a_boxMax)
+    \param    a_boxMin  Minimum corner of the box.
+    \param    a_boxMax  Maximum corner of the box.
+    \return   Return \b true if the box lies outside the frustum.
+*/
+//===========================================================================
+bool cFrustum::cullBox(const cVector3d& a_boxMin, const cVector3d& a_boxMax)
+{
+    for (int i=0; i<CHAI_FRUSTUM_NUM_PLANES; i++)
+    {
+        if ((m_mask & (1 << i)) == 0) { continue; }
+
+        const cVector3d& n = m_normals[i];
+
+        // corners furthest and nearest along the normal
+        double furthest = m_offsets[i];
+        double nearest = m_offsets[i];
+        if (n.x >= 0.0) { furthest += n.x * a_boxMax.x; nearest += n.x * a_boxMin.x; }
+        else            { furthest += n.x * a_boxMin.x; nearest += n.x * a_boxMax.x; }
+        if (n.y >= 0.0) { furthest += n.y * a_boxMax.y; nearest += n.y * a_boxMin.y; }
+        else            { furthest += n.y * a_boxMin.y; nearest += n.y * a_boxMax.y; }
+        if (n.z >= 0.0) { furthest += n.z * a_boxMax.z; nearest += n.z * a_boxMin.z; }
+        else            { furthest += n.z * a_boxMin.z; nearest += n.z * a_boxMax.z; }
+
+        if (furthest < 0.0) { return (true); }
+        if (nearest >= 0.0) { m_mask &= ~(1 << i); }
+    }
+
+    return (false);
+}
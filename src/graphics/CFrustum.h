@@ -0,0 +1,190 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CFrustumH
+#define CFrustumH
+//---------------------------------------------------------------------------
+#include "math/CVector3d.h"
+#include "math/CMatrix3d.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CFrustum.h
+
+    \brief
+    <b> Graphics </b> \n
+    View Frustum Culling.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Number of planes bounding a cFrustum.
+#define CHAI_FRUSTUM_NUM_PLANES     6
+
+//! Mask of a cFrustum in which all planes are tested.
+#define CHAI_FRUSTUM_ALL_PLANES     0x3f
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cRenderStatistics
+    \ingroup    graphics
+
+    \brief
+    cRenderStatistics counts the objects and triangles submitted to OpenGL
+    while rendering a scene graph, the objects skipped by culling, and the
+    material and texture changes skipped by a cRenderQueue.
+*/
+//===========================================================================
+struct cRenderStatistics
+{
+    //! Number of objects rendered.
+    unsigned int m_numObjects;
+
+    //! Number of triangles of the meshes rendered.
+    unsigned int m_numTriangles;
+
+    //! Number of objects skipped with their children, outside the view frustum.
+    unsigned int m_numCulledObjects;
+
+    //! Number of materials not sent again to OpenGL, being those of the previous mesh.
+    unsigned int m_numSkippedMaterials;
+
+    //! Number of textures not bound again, being those of the previous mesh.
+    unsigned int m_numSkippedTextures;
+
+    //! Reset all counters to zero.
+    void reset()
+    {
+        m_numObjects = 0; m_numTriangles = 0; m_numCulledObjects = 0;
+        m_numSkippedMaterials = 0; m_numSkippedTextures = 0;
+    }
+};
+
+
+//===========================================================================
+/*!
+    \class      cFrustum
+    \ingroup    graphics
+
+    \brief
+    cFrustum holds the six planes of a view frustum (left, right, bottom,
+    top, near and far), expressed in the frame of an object of the scene
+    graph. \n
+
+    The planes are extracted from the projection and modelview matrices of
+    a camera, then moved down the scene graph by transform(), so that the
+    boundary box of each object is tested in its own frame. A box is
+    outside the frustum when its corner furthest along the normal of a
+    plane is behind that plane. Planes which the box lies entirely in
+    front of are removed from the mask of the frustum; since boundary boxes
+    enclose the boxes of children, the children of the object need not be
+    tested against them. \n
+
+    The frustum also holds the view axis of the camera and the scale of its
+    projection on screen, which are moved down the scene graph with the
+    planes, so that objects can measure their projected size without
+    reading back the OpenGL matrices.
+*/
+//===========================================================================
+class cFrustum
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cFrustum.
+    cFrustum();
+
+    //! Destructor of cFrustum.
+    ~cFrustum() {};
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Extract the planes from OpenGL projection and modelview matrices, for a viewport of given height.
+    void set(const double* a_projection, const double* a_modelview,
+             const int a_viewportHeight);
+
+    //! Express the planes of a frustum in a child frame, given its position and rotation.
+    void transform(const cFrustum& a_frustum,
+                   const cVector3d& a_pos,
+                   const cMatrix3d& a_rot);
+
+    //! Return \b true if a box lies outside the frustum, and remove the planes the box lies in front of.
+    bool cullBox(const cVector3d& a_boxMin, const cVector3d& a_boxMax);
+
+    //! Get the statistics of the rendering pass, or NULL.
+    cRenderStatistics* getStatistics() const { return (m_statistics); }
+
+    //! Set the statistics updated by the rendering pass, or NULL.
+    void setStatistics(cRenderStatistics* a_statistics) { m_statistics = a_statistics; }
+
+    //! Get the depth of a point along the view axis.
+    double getDepth(const cVector3d& a_point) const { return (m_viewNormal.dot(a_point) + m_viewOffset); }
+
+    //! Get the size in pixels of a unit length perpendicular to the view axis, at a given depth.
+    double getPixelsPerUnit(const double a_depth) const { return (m_perspective ? (m_pixelsPerUnit / a_depth) : m_pixelsPerUnit); }
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Normals of the planes, pointing inside the frustum.
+    cVector3d m_normals[CHAI_FRUSTUM_NUM_PLANES];
+
+    //! Offsets of the planes; a point \e p is in front of plane \e i if m_normals[i].dot(p) + m_offsets[i] >= 0.
+    double m_offsets[CHAI_FRUSTUM_NUM_PLANES];
+
+    //! Bit \e i is set if plane \e i must still be tested.
+    unsigned int m_mask;
+
+    //! View axis, pointing away from the eye.
+    cVector3d m_viewNormal;
+
+    //! Offset of the view plane; the depth of a point \e p is m_viewNormal.dot(p) + m_viewOffset.
+    double m_viewOffset;
+
+    //! Pixels per unit of length at unit depth for a perspective projection, or at any depth otherwise.
+    double m_pixelsPerUnit;
+
+    //! If \b true, the projection is a perspective projection.
+    bool m_perspective;
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Statistics of the rendering pass.
+    cRenderStatistics* m_statistics;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -21,6 +21,17 @@
 
 //---------------------------------------------------------------------------
 #include "graphics/CMacrosGL.h"
+#include <string.h>
+#include <stdlib.h>
+#if defined(_LINUX) || defined(_MACOSX)
+#include <dlfcn.h>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+//! Loader set by the application, or NULL to use the default of the platform.
+static cGLFunctionLoader s_glFunctionLoader = NULL;
+//---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -73,3 +84,154 @@ void cLookAt(const cVector3d& a_eye, const cVector3d& a_at, const cVector3d& a_u
     // Push it onto the matrix stack
     glMultMatrixd(dm);
 }
+
+
+//===========================================================================
+/*!
+    Set the function used by cGetGLFunction() to load OpenGL functions.
+    Applications which create their context through an API the default
+    loader does not know, or which want to choose the loader themselves,
+    pass the loader of this API, such as eglGetProcAddress() or
+    OSMesaGetProcAddress(), cast to cGLFunctionLoader.
+
+    \fn       void cSetGLFunctionLoader(cGLFunctionLoader a_loader)
+    \param    a_loader  Loader to use, or NULL for the default loader.
+*/
+//===========================================================================
+void cSetGLFunctionLoader(cGLFunctionLoader a_loader)
+{
+    s_glFunctionLoader = a_loader;
+}
+
+
+#if defined(_LINUX)
+//===========================================================================
+/*!
+    Find the loader of the API through which the current OpenGL context
+    was created. The symbols of EGL, OSMesa and GLX are looked up at run
+    time, so that the library neither links with nor requires any of
+    them; headless applications may use EGL or OSMesa without GLX.
+
+    \return   Return the loader, or NULL if none of these APIs is loaded.
+*/
+//===========================================================================
+static cGLFunctionLoader cFindGLFunctionLoader()
+{
+    typedef void* (*cGLCurrentContext)();
+
+    // EGL
+    cGLCurrentContext eglCurrentContext =
+        (cGLCurrentContext)dlsym(RTLD_DEFAULT, "eglGetCurrentContext");
+    if ((eglCurrentContext != NULL) && (eglCurrentContext() != NULL))
+    {
+        return ((cGLFunctionLoader)dlsym(RTLD_DEFAULT, "eglGetProcAddress"));
+    }
+
+    // OSMesa
+    cGLCurrentContext osMesaCurrentContext =
+        (cGLCurrentContext)dlsym(RTLD_DEFAULT, "OSMesaGetCurrentContext");
+    if ((osMesaCurrentContext != NULL) && (osMesaCurrentContext() != NULL))
+    {
+        return ((cGLFunctionLoader)dlsym(RTLD_DEFAULT, "OSMesaGetProcAddress"));
+    }
+
+    // GLX
+    return ((cGLFunctionLoader)dlsym(RTLD_DEFAULT, "glXGetProcAddressARB"));
+}
+#endif
+
+
+//===========================================================================
+/*!
+    Get the address of an OpenGL function from the driver. Functions of
+    OpenGL versions above 1.1 and of extensions must be loaded this way on
+    some platforms. The loader set with cSetGLFunctionLoader() is used if
+    any. Otherwise, on Linux, the loader of EGL, OSMesa or GLX is chosen
+    according to the current context, and functions exported by the
+    OpenGL library itself are found without a loader.
+
+    \fn       void* cGetGLFunction(const std::string& a_name)
+    \param    a_name  Name of the function.
+    \return   Return the address of the function, or NULL if not found.
+*/
+//===========================================================================
+void* cGetGLFunction(const std::string& a_name)
+{
+    if (s_glFunctionLoader != NULL)
+    {
+        return (s_glFunctionLoader(a_name.c_str()));
+    }
+
+#if defined(_WIN32)
+    return ((void*)wglGetProcAddress(a_name.c_str()));
+#elif defined(_LINUX)
+    void* function = NULL;
+    cGLFunctionLoader loader = cFindGLFunctionLoader();
+    if (loader != NULL)
+    {
+        function = loader(a_name.c_str());
+    }
+    if (function == NULL)
+    {
+        function = dlsym(RTLD_DEFAULT, a_name.c_str());
+    }
+    return (function);
+#elif defined(_MACOSX)
+    return (dlsym(RTLD_DEFAULT, a_name.c_str()));
+#else
+    return (NULL);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Get the version of the current OpenGL context.
+
+    \fn       int cGetGLVersion()
+    \return   Return 10 times the major version plus the minor version,
+              such as 15 for OpenGL 1.5, or 0 if no context is current.
+*/
+//===========================================================================
+int cGetGLVersion()
+{
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version == NULL) { return (0); }
+
+    int major = atoi(version);
+    const char* dot = strchr(version, '.');
+    int minor = (dot != NULL) ? atoi(dot + 1) : 0;
+
+    return (10 * major + minor);
+}
+
+
+//===========================================================================
+/*!
+    Check whether the current OpenGL context supports an extension.
+
+    \fn       bool cGetGLExtension(const char* a_name)
+    \param    a_name  Name of the extension, such as "GL_ARB_vertex_buffer_object".
+    \return   Return \b true if the extension is supported.
+*/
+//===========================================================================
+bool cGetGLExtension(const char* a_name)
+{
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (extensions == NULL) { return (false); }
+
+    // match whole names only, since some names are prefixes of others
+    size_t length = strlen(a_name);
+    const char* found = strstr(extensions, a_name);
+    while (found != NULL)
+    {
+        if (((found == extensions) || (found[-1] == ' ')) &&
+            ((found[length] == ' ') || (found[length] == '\0')))
+        {
+            return (true);
+        }
+        found = strstr(found + length, a_name);
+    }
+
+    return (false);
+}
@@ -44,6 +44,21 @@
 //! Align the current -z axis with a reference frame;  la gluLookAt.
 void cLookAt(const cVector3d& a_eye, const cVector3d& a_at, const cVector3d& a_up);
 
+//! Function returning the address of an OpenGL function from its name, such as eglGetProcAddress().
+typedef void* (*cGLFunctionLoader)(const char* a_name);
+
+//! Set the function used by cGetGLFunction(), or NULL to use the default loader of the platform.
+void cSetGLFunctionLoader(cGLFunctionLoader a_loader);
+
+//! Get the address of an OpenGL function from the driver, or NULL if not found.
+void* cGetGLFunction(const std::string& a_name);
+
+//! Get the version of the current OpenGL context, as 10 times major plus minor.
+int cGetGLVersion();
+
+//! Return \b true if the current OpenGL context supports an extension.
+bool cGetGLExtension(const char* a_name);
+
 
 //===========================================================================
 /*!
@@ -173,6 +188,26 @@ struct cMatrixGL
     }
 
 
+    //-----------------------------------------------------------------------
+    /*!
+        Set this matrix from an array of 16 values in the column-major order
+        of OpenGL, such as returned by glGetDoublev(GL_MODELVIEW_MATRIX).
+
+        \param    a_matrix  Input array.
+    */
+    //-----------------------------------------------------------------------
+    inline void set(const double* a_matrix)
+    {
+        for (int i=0; i<4; i++)
+        {
+            for (int j=0; j<4; j++)
+            {
+                m[i][j] = a_matrix[4*i+j];
+            }
+        }
+    }
+
+
     //-----------------------------------------------------------------------
     /*!
         Copy the current matrix to an external matrix passed as a parameter.
@@ -78,7 +78,7 @@ struct cMaterial
     void setShininess(GLuint a_shininess);
 
     //! Get shininess.
-    GLuint getShininess() { return (m_shininess); }
+    GLuint getShininess() const { return (m_shininess); }
 
     //! set transparency level (sets the alpha value for all color properties).
     void setTransparencyLevel(float a_levelTransparency);
@@ -0,0 +1,673 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "graphics/CMeshSimplifier.h"
+#include "graphics/CVertex.h"
+#include "graphics/CTriangle.h"
+#include "math/CMaths.h"
+#include <algorithm>
+#include <iterator>
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cVertexPositionOrder
+    \ingroup    graphics
+
+    \brief
+    cVertexPositionOrder compares the indices of two vertices by their
+    positions, so that vertices at the same position are sorted together.
+*/
+//===========================================================================
+struct cVertexPositionOrder
+{
+    //! Constructor of cVertexPositionOrder.
+    cVertexPositionOrder(const vector<cVertex>& a_vertices) : m_vertices(a_vertices) {}
+
+    //! Return \b true if the first vertex comes before the second one.
+    bool operator()(const unsigned int a_index0, const unsigned int a_index1) const
+    {
+        const cVector3d& pos0 = m_vertices[a_index0].m_localPos;
+        const cVector3d& pos1 = m_vertices[a_index1].m_localPos;
+        if (pos0.x != pos1.x) { return (pos0.x < pos1.x); }
+        if (pos0.y != pos1.y) { return (pos0.y < pos1.y); }
+        return (pos0.z < pos1.z);
+    }
+
+    //! Vertices of the mesh.
+    const vector<cVertex>& m_vertices;
+};
+
+
+//===========================================================================
+/*!
+    Add the squared distance to a plane, multiplied by a weight. The normal
+    of the plane must be of unit length.
+
+    \fn       void cQuadric::addPlane(const cVector3d& a_normal,
+                                      const double a_offset,
+                                      const double a_weight)
+    \param    a_normal  Normal of the plane.
+    \param    a_offset  Offset of the plane.
+    \param    a_weight  Weight of the plane.
+*/
+//===========================================================================
+void cQuadric::addPlane(const cVector3d& a_normal, const double a_offset, const double a_weight)
+{
+    double a = a_normal.x;
+    double b = a_normal.y;
+    double c = a_normal.z;
+    double d = a_offset;
+
+    m_q[0] += a_weight * a * a;
+    m_q[1] += a_weight * a * b;
+    m_q[2] += a_weight * a * c;
+    m_q[3] += a_weight * a * d;
+    m_q[4] += a_weight * b * b;
+    m_q[5] += a_weight * b * c;
+    m_q[6] += a_weight * b * d;
+    m_q[7] += a_weight * c * c;
+    m_q[8] += a_weight * c * d;
+    m_q[9] += a_weight * d * d;
+}
+
+
+//===========================================================================
+/*!
+    Evaluate the quadric at a point.
+
+    \fn       double cQuadric::evaluate(const cVector3d& a_point) const
+    \param    a_point  Point.
+    \return   Return the weighted sum of squared distances to the planes.
+*/
+//===========================================================================
+double cQuadric::evaluate(const cVector3d& a_point) const
+{
+    double x = a_point.x;
+    double y = a_point.y;
+    double z = a_point.z;
+
+    return (m_q[0] * x * x + 2.0 * m_q[1] * x * y + 2.0 * m_q[2] * x * z + 2.0 * m_q[3] * x +
+            m_q[4] * y * y + 2.0 * m_q[5] * y * z + 2.0 * m_q[6] * y +
+            m_q[7] * z * z + 2.0 * m_q[8] * z +
+            m_q[9]);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cMeshSimplifier.
+
+    \fn       cMeshSimplifier::cMeshSimplifier()
+*/
+//===========================================================================
+cMeshSimplifier::cMeshSimplifier()
+{
+    m_numTriangles = 0;
+    m_error = 0.0;
+}
+
+
+//===========================================================================
+/*!
+    Build simplified levels of a mesh. The first level has \e a_ratio times
+    as many triangles as the mesh, and each level \e a_ratio times as many
+    as the previous one. Fewer levels are built if no collapse is left
+    before reaching the number of triangles of a level.
+
+    \fn       void cMeshSimplifier::simplify(const vector<cVertex>& a_vertices,
+                                             const vector<cTriangle>& a_triangles,
+                                             const unsigned int a_numLevels,
+                                             const double a_ratio,
+                                             vector<cMeshLevel>& a_levels)
+    \param    a_vertices  Vertices of the mesh.
+    \param    a_triangles  Triangles of the mesh; only allocated ones are used.
+    \param    a_numLevels  Number of levels to build.
+    \param    a_ratio  Fraction of the triangles kept by each level.
+    \param    a_levels  Levels built, from the finest to the coarsest.
+*/
+//===========================================================================
+void cMeshSimplifier::simplify(const vector<cVertex>& a_vertices,
+                               const vector<cTriangle>& a_triangles,
+                               const unsigned int a_numLevels,
+                               const double a_ratio,
+                               vector<cMeshLevel>& a_levels)
+{
+    a_levels.clear();
+    initialize(a_vertices, a_triangles);
+
+    // queue the collapses of all edges
+    unsigned int numPositions = (unsigned int)m_positions.size();
+    vector<unsigned int> neighbors;
+    for (unsigned int i=0; i<numPositions; i++)
+    {
+        getNeighbors(i, neighbors);
+        for (unsigned int j=0; j<neighbors.size(); j++)
+        {
+            if (neighbors[j] > i)
+            {
+                queueCollapse(i, neighbors[j]);
+                queueCollapse(neighbors[j], i);
+            }
+        }
+    }
+
+    // collapse the cheapest edges, recording a level each time the number
+    // of triangles falls under the next target
+    double target = (double)m_numTriangles;
+    unsigned int numTriangles = m_numTriangles;
+    for (unsigned int level=0; level<a_numLevels; level++)
+    {
+        target *= a_ratio;
+
+        while ((m_numTriangles > (unsigned int)target) && (!m_collapses.empty()))
+        {
+            cCollapse next = m_collapses.top();
+            m_collapses.pop();
+
+            // skip collapses queued before either position changed
+            if (m_removed[next.m_from] || m_removed[next.m_to] ||
+                (m_versions[next.m_from] != next.m_fromVersion) ||
+                (m_versions[next.m_to] != next.m_toVersion))
+            {
+                continue;
+            }
+
+            if (!checkCollapse(next.m_from, next.m_to)) { continue; }
+
+            m_error = cMax(m_error, sqrt(cMax(next.m_cost, 0.0)));
+            collapse(next.m_from, next.m_to);
+            queueCollapses(next.m_to);
+        }
+
+        if (m_numTriangles >= numTriangles) { break; }
+        numTriangles = m_numTriangles;
+        addLevel(a_levels);
+    }
+
+    // release memory
+    m_positions.clear();
+    m_quadrics.clear();
+    m_versions.clear();
+    m_removed.clear();
+    m_positionTriangles.clear();
+    m_vertexPositions.clear();
+    m_triangleVertices.clear();
+    m_triangleRemoved.clear();
+    m_vertexMap.clear();
+    while (!m_collapses.empty()) { m_collapses.pop(); }
+}
+
+
+//===========================================================================
+/*!
+    Weld vertices at the same position, copy the allocated triangles which
+    are not degenerate, and compute the quadric of each position from the
+    planes of its triangles and of the borders and seams around it.
+
+    \fn       void cMeshSimplifier::initialize(const vector<cVertex>& a_vertices,
+                                               const vector<cTriangle>& a_triangles)
+    \param    a_vertices  Vertices of the mesh.
+    \param    a_triangles  Triangles of the mesh.
+*/
+//===========================================================================
+void cMeshSimplifier::initialize(const vector<cVertex>& a_vertices,
+                                 const vector<cTriangle>& a_triangles)
+{
+    // weld vertices
+    unsigned int numVertices = (unsigned int)a_vertices.size();
+    vector<unsigned int> order(numVertices);
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), cVertexPositionOrder(a_vertices));
+
+    m_positions.clear();
+    m_vertexPositions.resize(numVertices);
+    for (unsigned int i=0; i<numVertices; i++)
+    {
+        const cVector3d& pos = a_vertices[order[i]].m_localPos;
+        if ((i == 0) || (!pos.equals(m_positions.back(), 0.0)))
+        {
+            m_positions.push_back(pos);
+        }
+        m_vertexPositions[order[i]] = (unsigned int)m_positions.size() - 1;
+    }
+
+    unsigned int numPositions = (unsigned int)m_positions.size();
+    m_quadrics.assign(numPositions, cQuadric());
+    m_versions.assign(numPositions, 0);
+    m_removed.assign(numPositions, false);
+    m_positionTriangles.assign(numPositions, vector<unsigned int>());
+
+    // copy triangles
+    m_triangleVertices.clear();
+    unsigned int numTriangles = (unsigned int)a_triangles.size();
+    for (unsigned int i=0; i<numTriangles; i++)
+    {
+        const cTriangle& triangle = a_triangles[i];
+        if (!triangle.m_allocated) { continue; }
+
+        unsigned int v0 = triangle.m_indexVertex0;
+        unsigned int v1 = triangle.m_indexVertex1;
+        unsigned int v2 = triangle.m_indexVertex2;
+        unsigned int p0 = m_vertexPositions[v0];
+        unsigned int p1 = m_vertexPositions[v1];
+        unsigned int p2 = m_vertexPositions[v2];
+        if ((p0 == p1) || (p1 == p2) || (p2 == p0)) { continue; }
+
+        unsigned int index = (unsigned int)m_triangleVertices.size() / 3;
+        m_triangleVertices.push_back(v0);
+        m_triangleVertices.push_back(v1);
+        m_triangleVertices.push_back(v2);
+        m_positionTriangles[p0].push_back(index);
+        m_positionTriangles[p1].push_back(index);
+        m_positionTriangles[p2].push_back(index);
+
+        // plane of the triangle
+        cVector3d normal = cCross(cSub(m_positions[p1], m_positions[p0]),
+                                  cSub(m_positions[p2], m_positions[p0]));
+        double length = normal.length();
+        if (length > 0.0)
+        {
+            normal.div(length);
+            double offset = -normal.dot(m_positions[p0]);
+            m_quadrics[p0].addPlane(normal, offset, 1.0);
+            m_quadrics[p1].addPlane(normal, offset, 1.0);
+            m_quadrics[p2].addPlane(normal, offset, 1.0);
+        }
+    }
+
+    m_numTriangles = (unsigned int)m_triangleVertices.size() / 3;
+    m_triangleRemoved.assign(m_numTriangles, false);
+    m_error = 0.0;
+
+    // planes of borders and seams
+    for (unsigned int i=0; i<m_numTriangles; i++)
+    {
+        for (unsigned int j=0; j<3; j++)
+        {
+            addSeamPlanes(i, j);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    An edge lies on a border if a single triangle uses it, and on a seam if
+    the other triangle using it uses other copies of its vertices. Such
+    edges are kept in place by the plane through the edge, perpendicular
+    to the triangle.
+
+    \fn       void cMeshSimplifier::addSeamPlanes(const unsigned int a_triangle,
+                                                  const unsigned int a_corner)
+    \param    a_triangle  Triangle.
+    \param    a_corner  Corner at the start of the edge.
+*/
+//===========================================================================
+void cMeshSimplifier::addSeamPlanes(const unsigned int a_triangle, const unsigned int a_corner)
+{
+    unsigned int next = (a_corner + 1) % 3;
+    unsigned int vertex0 = m_triangleVertices[3*a_triangle + a_corner];
+    unsigned int vertex1 = m_triangleVertices[3*a_triangle + next];
+    unsigned int pos0 = m_vertexPositions[vertex0];
+    unsigned int pos1 = m_vertexPositions[vertex1];
+
+    // other triangles using the edge
+    bool seam = false;
+    unsigned int numOthers = 0;
+    const vector<unsigned int>& triangles = m_positionTriangles[pos0];
+    for (unsigned int i=0; i<triangles.size(); i++)
+    {
+        unsigned int other = triangles[i];
+        if (other == a_triangle) { continue; }
+
+        for (unsigned int j=0; j<3; j++)
+        {
+            if (getCornerPosition(other, j) == pos1)
+            {
+                numOthers++;
+                for (unsigned int k=0; k<3; k++)
+                {
+                    if ((getCornerPosition(other, k) == pos0) &&
+                        (m_triangleVertices[3*other + k] != vertex0)) { seam = true; }
+                }
+                if (m_triangleVertices[3*other + j] != vertex1) { seam = true; }
+            }
+        }
+    }
+
+    if ((numOthers == 1) && (!seam)) { return; }
+
+    // plane through the edge, perpendicular to the triangle
+    unsigned int pos2 = getCornerPosition(a_triangle, (a_corner + 2) % 3);
+    cVector3d edge = cSub(m_positions[pos1], m_positions[pos0]);
+    cVector3d normal = cCross(edge, cSub(m_positions[pos2], m_positions[pos0]));
+    cVector3d planeNormal = cCross(edge, normal);
+    double length = planeNormal.length();
+    if (length <= 0.0) { return; }
+
+    planeNormal.div(length);
+    double offset = -planeNormal.dot(m_positions[pos0]);
+    m_quadrics[pos0].addPlane(planeNormal, offset, CHAI_MESH_SIMPLIFIER_SEAM_WEIGHT);
+    m_quadrics[pos1].addPlane(planeNormal, offset, CHAI_MESH_SIMPLIFIER_SEAM_WEIGHT);
+}
+
+
+//===========================================================================
+/*!
+    Find the positions sharing a triangle with a position.
+
+    \fn       void cMeshSimplifier::getNeighbors(const unsigned int a_position,
+                                                 vector<unsigned int>& a_neighbors)
+    \param    a_position  Position.
+    \param    a_neighbors  Neighbouring positions, sorted.
+*/
+//===========================================================================
+void cMeshSimplifier::getNeighbors(const unsigned int a_position,
+                                   vector<unsigned int>& a_neighbors)
+{
+    a_neighbors.clear();
+
+    const vector<unsigned int>& triangles = m_positionTriangles[a_position];
+    for (unsigned int i=0; i<triangles.size(); i++)
+    {
+        if (m_triangleRemoved[triangles[i]]) { continue; }
+
+        for (unsigned int j=0; j<3; j++)
+        {
+            unsigned int pos = getCornerPosition(triangles[i], j);
+            if (pos != a_position) { a_neighbors.push_back(pos); }
+        }
+    }
+
+    std::sort(a_neighbors.begin(), a_neighbors.end());
+    a_neighbors.erase(std::unique(a_neighbors.begin(), a_neighbors.end()), a_neighbors.end());
+}
+
+
+//===========================================================================
+/*!
+    Queue the collapse of a position onto another, with the error of the
+    merged quadrics at the position kept.
+
+    \fn       void cMeshSimplifier::queueCollapse(const unsigned int a_from,
+                                                  const unsigned int a_to)
+    \param    a_from  Position removed.
+    \param    a_to  Position kept.
+*/
+//===========================================================================
+void cMeshSimplifier::queueCollapse(const unsigned int a_from, const unsigned int a_to)
+{
+    cQuadric quadric = m_quadrics[a_from];
+    quadric.add(m_quadrics[a_to]);
+
+    cCollapse collapse;
+    collapse.m_cost = quadric.evaluate(m_positions[a_to]);
+    collapse.m_from = a_from;
+    collapse.m_to = a_to;
+    collapse.m_fromVersion = m_versions[a_from];
+    collapse.m_toVersion = m_versions[a_to];
+    m_collapses.push(collapse);
+}
+
+
+//===========================================================================
+/*!
+    Queue the collapses of all edges of a position, in both directions,
+    after its quadric changed.
+
+    \fn       void cMeshSimplifier::queueCollapses(const unsigned int a_position)
+    \param    a_position  Position.
+*/
+//===========================================================================
+void cMeshSimplifier::queueCollapses(const unsigned int a_position)
+{
+    vector<unsigned int> neighbors;
+    getNeighbors(a_position, neighbors);
+    for (unsigned int i=0; i<neighbors.size(); i++)
+    {
+        queueCollapse(a_position, neighbors[i]);
+        queueCollapse(neighbors[i], a_position);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Check that a position can collapse onto another. Each copy of the
+    removed vertex in the triangles using the edge is replaced by the copy
+    of the other vertex in the same triangle; the copy must be the same in
+    every such triangle, and every copy used by the remaining triangles
+    must be replaced. The positions must not share neighbours other than
+    those of the triangles using the edge, and the remaining triangles
+    must not flip.
+
+    \fn       bool cMeshSimplifier::checkCollapse(const unsigned int a_from,
+                                                  const unsigned int a_to)
+    \param    a_from  Position removed.
+    \param    a_to  Position kept.
+    \return   Return \b true if the collapse is valid; m_vertexMap then
+              holds the replacement of each copy.
+*/
+//===========================================================================
+bool cMeshSimplifier::checkCollapse(const unsigned int a_from, const unsigned int a_to)
+{
+    m_vertexMap.clear();
+    unsigned int numShared = 0;
+
+    const vector<unsigned int>& triangles = m_positionTriangles[a_from];
+
+    // replacements of the copies, from the triangles using the edge
+    for (unsigned int i=0; i<triangles.size(); i++)
+    {
+        unsigned int triangle = triangles[i];
+        if (m_triangleRemoved[triangle]) { continue; }
+
+        int cornerFrom = -1;
+        int cornerTo = -1;
+        for (int j=0; j<3; j++)
+        {
+            unsigned int pos = getCornerPosition(triangle, j);
+            if (pos == a_from) { cornerFrom = j; }
+            if (pos == a_to) { cornerTo = j; }
+        }
+        if (cornerTo < 0) { continue; }
+
+        numShared++;
+        unsigned int vertexFrom = m_triangleVertices[3*triangle + cornerFrom];
+        unsigned int vertexTo = m_triangleVertices[3*triangle + cornerTo];
+
+        bool found = false;
+        for (unsigned int k=0; k<m_vertexMap.size(); k+=2)
+        {
+            if (m_vertexMap[k] == vertexFrom)
+            {
+                if (m_vertexMap[k+1] != vertexTo) { return (false); }
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            m_vertexMap.push_back(vertexFrom);
+            m_vertexMap.push_back(vertexTo);
+        }
+    }
+
+    if (numShared == 0) { return (false); }
+
+    // remaining triangles
+    for (unsigned int i=0; i<triangles.size(); i++)
+    {
+        unsigned int triangle = triangles[i];
+        if (m_triangleRemoved[triangle]) { continue; }
+
+        int cornerFrom = -1;
+        bool shared = false;
+        for (int j=0; j<3; j++)
+        {
+            unsigned int pos = getCornerPosition(triangle, j);
+            if (pos == a_from) { cornerFrom = j; }
+            if (pos == a_to) { shared = true; }
+        }
+        if (shared) { continue; }
+
+        // the copy must have a replacement
+        unsigned int vertexFrom = m_triangleVertices[3*triangle + cornerFrom];
+        bool found = false;
+        for (unsigned int k=0; k<m_vertexMap.size(); k+=2)
+        {
+            if (m_vertexMap[k] == vertexFrom) { found = true; }
+        }
+        if (!found) { return (false); }
+
+        // the triangle must not flip
+        cVector3d pos[3];
+        for (int j=0; j<3; j++)
+        {
+            pos[j] = m_positions[getCornerPosition(triangle, j)];
+        }
+        cVector3d normalBefore = cCross(cSub(pos[1], pos[0]), cSub(pos[2], pos[0]));
+        pos[cornerFrom] = m_positions[a_to];
+        cVector3d normalAfter = cCross(cSub(pos[1], pos[0]), cSub(pos[2], pos[0]));
+
+        double lengthBefore = normalBefore.length();
+        double lengthAfter = normalAfter.length();
+        if (lengthBefore > 0.0)
+        {
+            if (lengthAfter <= 0.0) { return (false); }
+            double cosine = normalBefore.dot(normalAfter) / (lengthBefore * lengthAfter);
+            if (cosine < CHAI_MESH_SIMPLIFIER_MIN_COS) { return (false); }
+        }
+    }
+
+    // the collapse must not join the surface to itself
+    vector<unsigned int> neighborsFrom;
+    vector<unsigned int> neighborsTo;
+    getNeighbors(a_from, neighborsFrom);
+    getNeighbors(a_to, neighborsTo);
+    vector<unsigned int> common;
+    std::set_intersection(neighborsFrom.begin(), neighborsFrom.end(),
+                          neighborsTo.begin(), neighborsTo.end(),
+                          std::back_inserter(common));
+    if (common.size() != numShared) { return (false); }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Collapse a position onto another. Triangles using the edge are
+    removed, and the copies of the removed vertex in the other triangles
+    are replaced as found by checkCollapse().
+
+    \fn       void cMeshSimplifier::collapse(const unsigned int a_from,
+                                             const unsigned int a_to)
+    \param    a_from  Position removed.
+    \param    a_to  Position kept.
+*/
+//===========================================================================
+void cMeshSimplifier::collapse(const unsigned int a_from, const unsigned int a_to)
+{
+    vector<unsigned int>& triangles = m_positionTriangles[a_from];
+    vector<unsigned int>& trianglesTo = m_positionTriangles[a_to];
+
+    for (unsigned int i=0; i<triangles.size(); i++)
+    {
+        unsigned int triangle = triangles[i];
+        if (m_triangleRemoved[triangle]) { continue; }
+
+        int cornerFrom = -1;
+        bool shared = false;
+        for (int j=0; j<3; j++)
+        {
+            unsigned int pos = getCornerPosition(triangle, j);
+            if (pos == a_from) { cornerFrom = j; }
+            if (pos == a_to) { shared = true; }
+        }
+
+        if (shared)
+        {
+            m_triangleRemoved[triangle] = true;
+            m_numTriangles--;
+            continue;
+        }
+
+        unsigned int& vertex = m_triangleVertices[3*triangle + cornerFrom];
+        for (unsigned int k=0; k<m_vertexMap.size(); k+=2)
+        {
+            if (m_vertexMap[k] == vertex)
+            {
+                vertex = m_vertexMap[k+1];
+                break;
+            }
+        }
+        trianglesTo.push_back(triangle);
+    }
+
+    // forget removed triangles around the position kept
+    unsigned int numKept = 0;
+    for (unsigned int i=0; i<trianglesTo.size(); i++)
+    {
+        if (!m_triangleRemoved[trianglesTo[i]])
+        {
+            trianglesTo[numKept] = trianglesTo[i];
+            numKept++;
+        }
+    }
+    trianglesTo.resize(numKept);
+    triangles.clear();
+
+    m_quadrics[a_to].add(m_quadrics[a_from]);
+    m_removed[a_from] = true;
+    m_versions[a_from]++;
+    m_versions[a_to]++;
+}
+
+
+//===========================================================================
+/*!
+    Record the remaining triangles and the error of the collapses so far
+    as a new level.
+
+    \fn       void cMeshSimplifier::addLevel(vector<cMeshLevel>& a_levels)
+    \param    a_levels  Levels built so far.
+*/
+//===========================================================================
+void cMeshSimplifier::addLevel(vector<cMeshLevel>& a_levels)
+{
+    a_levels.push_back(cMeshLevel());
+    cMeshLevel& level = a_levels.back();
+
+    level.m_indices.reserve(3 * m_numTriangles);
+    unsigned int numTriangles = (unsigned int)m_triangleRemoved.size();
+    for (unsigned int i=0; i<numTriangles; i++)
+    {
+        if (m_triangleRemoved[i]) { continue; }
+        level.m_indices.push_back(m_triangleVertices[3*i]);
+        level.m_indices.push_back(m_triangleVertices[3*i + 1]);
+        level.m_indices.push_back(m_triangleVertices[3*i + 2]);
+    }
+    level.m_error = m_error;
+}
@@ -0,0 +1,254 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CMeshSimplifierH
+#define CMeshSimplifierH
+//---------------------------------------------------------------------------
+#include "math/CVector3d.h"
+#include <vector>
+#include <queue>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+class cVertex;
+class cTriangle;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CMeshSimplifier.h
+
+    \brief
+    <b> Graphics </b> \n
+    Mesh Simplification.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Weight of the planes which keep borders and seams of a mesh in place.
+#define CHAI_MESH_SIMPLIFIER_SEAM_WEIGHT    1000.0
+
+//! Smallest cosine between the normals of a triangle before and after a collapse.
+#define CHAI_MESH_SIMPLIFIER_MIN_COS        0.2
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cQuadric
+    \ingroup    graphics
+
+    \brief
+    cQuadric is a sum of squared distances to planes, stored as a symmetric
+    4x4 matrix. Its value at a point is the error of moving the point there.
+*/
+//===========================================================================
+struct cQuadric
+{
+    //! Coefficients aa, ab, ac, ad, bb, bc, bd, cc, cd and dd.
+    double m_q[10];
+
+    //! Constructor of cQuadric. The quadric is zero.
+    cQuadric() { for (int i=0; i<10; i++) { m_q[i] = 0.0; } }
+
+    //! Add the squared distance to the plane a_normal.x + a_offset = 0, multiplied by a weight.
+    void addPlane(const cVector3d& a_normal, const double a_offset, const double a_weight);
+
+    //! Add another quadric.
+    void add(const cQuadric& a_quadric) { for (int i=0; i<10; i++) { m_q[i] += a_quadric.m_q[i]; } }
+
+    //! Evaluate the quadric at a point.
+    double evaluate(const cVector3d& a_point) const;
+};
+
+
+//===========================================================================
+/*!
+    \struct     cMeshLevel
+    \ingroup    graphics
+
+    \brief
+    cMeshLevel is a simplified level of detail of a mesh. Its triangles use
+    the vertices of the mesh itself.
+*/
+//===========================================================================
+struct cMeshLevel
+{
+    //! Indices of the vertices of the triangles, three per triangle.
+    vector<unsigned int> m_indices;
+
+    //! Estimate of the largest distance between this level and the surface of the mesh.
+    double m_error;
+};
+
+
+//===========================================================================
+/*!
+    \class      cMeshSimplifier
+    \ingroup    graphics
+
+    \brief
+    cMeshSimplifier builds a chain of simplified levels of detail of a
+    triangle mesh by quadric error edge collapse. \n
+
+    Vertices at the same position, such as the copies of a vertex on each
+    side of a texture or normal seam, are welded into one position. Each
+    collapse moves a position onto a neighbouring one, choosing among
+    all edges the collapse which adds the smallest quadric error: the sum
+    of squared distances to the planes of the original triangles merged
+    into the position. Each copy of the vertex is replaced by the copy of
+    the other vertex on the same side of the seam, so that levels only use
+    vertices of the original mesh, with their normals, colors and texture
+    coordinates. Collapses which cannot keep the two sides of a seam
+    apart, which would fold the surface, or would flip triangles, are
+    rejected, and additional planes keep borders and seams in place. \n
+
+    Levels are recorded as the number of triangles falls under successive
+    fractions of the original number.
+*/
+//===========================================================================
+class cMeshSimplifier
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cMeshSimplifier.
+    cMeshSimplifier();
+
+    //! Destructor of cMeshSimplifier.
+    ~cMeshSimplifier() {};
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build simplified levels of a mesh, each with a fraction of the triangles of the previous one.
+    void simplify(const vector<cVertex>& a_vertices,
+                  const vector<cTriangle>& a_triangles,
+                  const unsigned int a_numLevels,
+                  const double a_ratio,
+                  vector<cMeshLevel>& a_levels);
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Weld vertices into positions and compute the quadric of each position.
+    void initialize(const vector<cVertex>& a_vertices,
+                    const vector<cTriangle>& a_triangles);
+
+    //! Add the planes keeping an edge of a triangle in place, if it lies on a border or seam.
+    void addSeamPlanes(const unsigned int a_triangle, const unsigned int a_corner);
+
+    //! Find the positions sharing an edge with a position.
+    void getNeighbors(const unsigned int a_position, vector<unsigned int>& a_neighbors);
+
+    //! Queue the collapse of a position onto another.
+    void queueCollapse(const unsigned int a_from, const unsigned int a_to);
+
+    //! Queue the collapses of all edges of a position, in both directions.
+    void queueCollapses(const unsigned int a_position);
+
+    //! Check a collapse and find the vertex replacing each copy of the removed vertex.
+    bool checkCollapse(const unsigned int a_from, const unsigned int a_to);
+
+    //! Collapse a position onto another, with the vertex map found by checkCollapse().
+    void collapse(const unsigned int a_from, const unsigned int a_to);
+
+    //! Record the remaining triangles as a level.
+    void addLevel(vector<cMeshLevel>& a_levels);
+
+    //! Return the position of a corner of a triangle.
+    unsigned int getCornerPosition(const unsigned int a_triangle, const unsigned int a_corner) const
+        { return (m_vertexPositions[m_triangleVertices[3*a_triangle + a_corner]]); }
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Edge collapse waiting in the queue.
+    struct cCollapse
+    {
+        //! Error added by the collapse.
+        double m_cost;
+
+        //! Position removed.
+        unsigned int m_from;
+
+        //! Position kept.
+        unsigned int m_to;
+
+        //! Version of the removed position when the collapse was queued.
+        unsigned int m_fromVersion;
+
+        //! Version of the kept position when the collapse was queued.
+        unsigned int m_toVersion;
+
+        //! Order collapses by decreasing cost, so that the queue returns the cheapest one.
+        bool operator<(const cCollapse& a_collapse) const { return (m_cost > a_collapse.m_cost); }
+    };
+
+    //! Coordinates of each position.
+    vector<cVector3d> m_positions;
+
+    //! Quadric of each position.
+    vector<cQuadric> m_quadrics;
+
+    //! Version of each position, increased when its quadric or triangles change.
+    vector<unsigned int> m_versions;
+
+    //! If \b true, the position was removed by a collapse.
+    vector<bool> m_removed;
+
+    //! Triangles around each position, including removed ones.
+    vector<vector<unsigned int> > m_positionTriangles;
+
+    //! Position of each vertex.
+    vector<unsigned int> m_vertexPositions;
+
+    //! Vertices of each triangle, three per triangle.
+    vector<unsigned int> m_triangleVertices;
+
+    //! If \b true, the triangle was removed by a collapse.
+    vector<bool> m_triangleRemoved;
+
+    //! Number of triangles not removed.
+    unsigned int m_numTriangles;
+
+    //! Vertices replacing the copies of the removed vertex, pairs found by checkCollapse().
+    vector<unsigned int> m_vertexMap;
+
+    //! Queue of edge collapses.
+    std::priority_queue<cCollapse> m_collapses;
+
+    //! Largest error of the collapses performed so far.
+    double m_error;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
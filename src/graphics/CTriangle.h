@@ -333,18 +333,59 @@ class cTriangle
                                  cCollisionRecorder& a_recorder,
                                  cCollisionSettings& a_settings) const
     {
+        // Get the position of the triangle's vertices
+        vector<cVertex>* vertex_vector = m_parent->pVertices();
+        cVertex* vertex_array = (cVertex*) &((*vertex_vector)[0]);
+
+        return (computeCollision(vertex_array[m_indexVertex0].getPos(),
+                                 vertex_array[m_indexVertex1].getPos(),
+                                 vertex_array[m_indexVertex2].getPos(),
+                                 a_segmentPointA,
+                                 a_segmentPointB,
+                                 a_recorder,
+                                 a_settings));
+    }
+
+
+    //-----------------------------------------------------------------------
+    /*!
+        Check if a segment intersects this triangle, the position of its
+        vertices being given by the caller. This lets collision detectors
+        which store their own copy of the vertices (see cCollisionAABBFlat)
+        avoid reading them through the parent mesh. \n
+
+        If a collision occurs, this information is stored in the collision
+        recorder \e a_recorder.
+
+        \param   a_vertex0  Position of vertex 0 (in local frame).
+        \param   a_vertex1  Position of vertex 1 (in local frame).
+        \param   a_vertex2  Position of vertex 2 (in local frame).
+        \param   a_segmentPointA  Point from where collision ray starts (in local frame).
+        \param   a_segmentPointB  Direction vector of collision ray (in local frame).
+        \param   a_recorder  Stores collision events
+        \param   a_settings  Settings related to collision detection process.
+        \return  Returns \b true if a collision occured, otherwise \b false.
+    */
+    //-----------------------------------------------------------------------
+    inline bool computeCollision(const cVector3d& a_vertex0,
+                                 const cVector3d& a_vertex1,
+                                 const cVector3d& a_vertex2,
+                                 cVector3d& a_segmentPointA,
+                                 cVector3d& a_segmentPointB,
+                                 cCollisionRecorder& a_recorder,
+                                 cCollisionSettings& a_settings) const
+    {
+        // count test for profiling
+        a_recorder.m_numTriangleTests++;
+
         // temp variables
         bool hit = false;
         cVector3d collisionPoint;
         cVector3d collisionNormal;
         double collisionDistanceSq = CHAI_LARGE;
-
-        // Get the position of the triangle's vertices
-        vector<cVertex>* vertex_vector = m_parent->pVertices();
-        cVertex* vertex_array = (cVertex*) &((*vertex_vector)[0]);
-        cVector3d vertex0 = vertex_array[m_indexVertex0].getPos();
-        cVector3d vertex1 = vertex_array[m_indexVertex1].getPos();
-        cVector3d vertex2 = vertex_array[m_indexVertex2].getPos();
+        cVector3d vertex0 = a_vertex0;
+        cVector3d vertex1 = a_vertex1;
+        cVector3d vertex2 = a_vertex2;
 
         // If m_collisionRadius == 0, we search for a possible intersection between
         // the segment AB and the triangle defined by its three vertices V0, V1, V2.
@@ -0,0 +1,548 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "graphics/CVertexBuffer.h"
+#include "graphics/CVertex.h"
+#include "graphics/CTriangle.h"
+#include "graphics/CMacrosGL.h"
+#include <algorithm>
+#include <string>
+#include <stddef.h>
+//---------------------------------------------------------------------------
+//! Largest number of unmodified vertices between two ranges copied together.
+#define CHAI_VERTEX_BUFFER_MAX_GAP      64
+
+//! Largest number of modified ranges kept before the whole buffer is copied.
+#define CHAI_VERTEX_BUFFER_MAX_RANGES   1024
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// OpenGL 1.5 definitions, missing from the headers of some platforms.
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER                 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER         0x8893
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW                  0x88E4
+#endif
+#ifndef GL_DYNAMIC_DRAW
+#define GL_DYNAMIC_DRAW                 0x88E8
+#endif
+
+typedef void (APIENTRY *cGLGenBuffers)(GLsizei, GLuint*);
+typedef void (APIENTRY *cGLDeleteBuffers)(GLsizei, const GLuint*);
+typedef void (APIENTRY *cGLBindBuffer)(GLenum, GLuint);
+typedef void (APIENTRY *cGLBufferData)(GLenum, ptrdiff_t, const GLvoid*, GLenum);
+typedef void (APIENTRY *cGLBufferSubData)(GLenum, ptrdiff_t, ptrdiff_t, const GLvoid*);
+
+//! Support of vertex buffer objects: -1 if not checked yet, 0 or 1.
+static int s_vertexBufferSupport = -1;
+
+//! Entry points of vertex buffer objects.
+static cGLGenBuffers s_glGenBuffers = NULL;
+static cGLDeleteBuffers s_glDeleteBuffers = NULL;
+static cGLBindBuffer s_glBindBuffer = NULL;
+static cGLBufferData s_glBufferData = NULL;
+static cGLBufferSubData s_glBufferSubData = NULL;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Sort modified ranges of vertices by their first vertex.
+
+    \fn       static bool cCompareVertexBufferRanges(const cVertexBufferRange& a_range0,
+                                                     const cVertexBufferRange& a_range1)
+    \param    a_range0  First range.
+    \param    a_range1  Second range.
+    \return   Return \b true if the first range starts before the second one.
+*/
+//===========================================================================
+static bool cCompareVertexBufferRanges(const cVertexBufferRange& a_range0,
+                                       const cVertexBufferRange& a_range1)
+{
+    return (a_range0.m_first < a_range1.m_first);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cVertexBuffer.
+
+    \fn       cVertexBuffer::cVertexBuffer()
+*/
+//===========================================================================
+cVertexBuffer::cVertexBuffer()
+{
+    m_vertexBuffer = 0;
+    m_indexBuffer = 0;
+    m_numVertices = 0;
+    m_numTriangles = 0;
+    m_numIndices = 0;
+    m_numCopiedVertices = 0;
+    m_rebuildVertices = true;
+    m_rebuildIndices = true;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cVertexBuffer.
+
+    \fn       cVertexBuffer::~cVertexBuffer()
+*/
+//===========================================================================
+cVertexBuffer::~cVertexBuffer()
+{
+    release();
+}
+
+
+//===========================================================================
+/*!
+    Check whether the current OpenGL context supports vertex buffer
+    objects, through OpenGL 1.5 or the GL_ARB_vertex_buffer_object
+    extension, and load their entry points. The result is kept once a
+    context has been checked.
+
+    \fn       bool cVertexBuffer::isSupported()
+    \return   Return \b true if vertex buffer objects are supported.
+*/
+//===========================================================================
+bool cVertexBuffer::isSupported()
+{
+    if (s_vertexBufferSupport != -1)
+    {
+        return (s_vertexBufferSupport == 1);
+    }
+
+    // no context is current yet
+    int version = cGetGLVersion();
+    if (version == 0) { return (false); }
+
+    // entry points of the extension end with ARB
+    std::string suffix;
+    if (version < 15)
+    {
+        if (!cGetGLExtension("GL_ARB_vertex_buffer_object"))
+        {
+            s_vertexBufferSupport = 0;
+            return (false);
+        }
+        suffix = "ARB";
+    }
+
+    s_glGenBuffers = (cGLGenBuffers)cGetGLFunction("glGenBuffers" + suffix);
+    s_glDeleteBuffers = (cGLDeleteBuffers)cGetGLFunction("glDeleteBuffers" + suffix);
+    s_glBindBuffer = (cGLBindBuffer)cGetGLFunction("glBindBuffer" + suffix);
+    s_glBufferData = (cGLBufferData)cGetGLFunction("glBufferData" + suffix);
+    s_glBufferSubData = (cGLBufferSubData)cGetGLFunction("glBufferSubData" + suffix);
+
+    if ((s_glGenBuffers != NULL) && (s_glDeleteBuffers != NULL) &&
+        (s_glBindBuffer != NULL) && (s_glBufferData != NULL) &&
+        (s_glBufferSubData != NULL))
+    {
+        s_vertexBufferSupport = 1;
+    }
+    else
+    {
+        s_vertexBufferSupport = 0;
+    }
+
+    return (s_vertexBufferSupport == 1);
+}
+
+
+//===========================================================================
+/*!
+    Copy the modified vertices and triangles to the buffers, and render
+    the triangles with a single call to glDrawElements(). Vertex and
+    normal arrays are always enabled; color and texture coordinate arrays
+    only if requested. Buffers are unbound on return, so that other
+    objects may render from client memory.
+
+    If \e a_indices is given, the triangles of a simplified level of detail
+    are drawn from client memory instead, while the vertices still come
+    from the vertex buffer.
+
+    \fn       bool cVertexBuffer::render(const vector<cVertex>& a_vertices,
+                                         const vector<cTriangle>& a_triangles,
+                                         const bool a_useVertexColors,
+                                         const bool a_useTextureCoords,
+                                         const vector<unsigned int>* a_indices)
+    \param    a_vertices  Vertices to render.
+    \param    a_triangles  Triangles to render; only allocated ones are drawn.
+    \param    a_useVertexColors  If \b true, the colors of the vertices are used.
+    \param    a_useTextureCoords  If \b true, the texture coordinates of the vertices are used.
+    \param    a_indices  Indices of the triangles to draw instead, or NULL.
+    \return   Return \b false if vertex buffer objects are not supported.
+*/
+//===========================================================================
+bool cVertexBuffer::render(const vector<cVertex>& a_vertices,
+                           const vector<cTriangle>& a_triangles,
+                           const bool a_useVertexColors,
+                           const bool a_useTextureCoords,
+                           const vector<unsigned int>* a_indices)
+{
+    if (!isSupported()) { return (false); }
+
+    // create buffers
+    if (m_vertexBuffer == 0)
+    {
+        GLuint buffers[2];
+        s_glGenBuffers(2, buffers);
+        m_vertexBuffer = buffers[0];
+        m_indexBuffer = buffers[1];
+        invalidate();
+    }
+
+    // take the modifications marked so far; changes in size require the
+    // buffers to be filled again
+    unsigned int numVertices = (unsigned int)a_vertices.size();
+    m_lock.acquire();
+    bool rebuildVertices = m_rebuildVertices || (numVertices != m_numVertices);
+    bool rebuildIndices = m_rebuildIndices || ((unsigned int)a_triangles.size() != m_numTriangles);
+    m_rebuildVertices = false;
+    m_rebuildIndices = false;
+    m_copiedRanges.swap(m_modifiedRanges);
+    m_lock.release();
+
+    // copy vertices
+    m_numCopiedVertices = 0;
+    s_glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    if (rebuildVertices)
+    {
+        packVertices(a_vertices, 0, numVertices);
+        s_glBufferData(GL_ARRAY_BUFFER,
+                       (ptrdiff_t)(m_data.size() * sizeof(float)),
+                       m_data.empty() ? NULL : &m_data[0],
+                       GL_DYNAMIC_DRAW);
+        m_numVertices = numVertices;
+        m_numCopiedVertices = numVertices;
+    }
+    else if (!m_copiedRanges.empty())
+    {
+        copyModifiedRanges(a_vertices);
+    }
+    m_copiedRanges.clear();
+
+    // copy triangles
+    s_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    if (rebuildIndices)
+    {
+        buildIndices(a_triangles);
+    }
+
+    // offsets of the attributes in the vertex buffer
+    GLsizei stride = CHAI_VERTEX_BUFFER_VERTEX_SIZE * sizeof(float);
+    const GLvoid* posOffset = (const GLvoid*)0;
+    const GLvoid* normalOffset = (const GLvoid*)(3 * sizeof(float));
+    const GLvoid* colorOffset = (const GLvoid*)(6 * sizeof(float));
+    const GLvoid* texCoordOffset = (const GLvoid*)(10 * sizeof(float));
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, posOffset);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, stride, normalOffset);
+
+    if (a_useVertexColors)
+    {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_FLOAT, stride, colorOffset);
+    }
+    else
+    {
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+
+    if (a_useTextureCoords)
+    {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, stride, texCoordOffset);
+    }
+    else
+    {
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+
+    // render the triangles of a level of detail
+    if (a_indices != NULL)
+    {
+        s_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        if (!a_indices->empty())
+        {
+            glDrawElements(GL_TRIANGLES, (GLsizei)a_indices->size(),
+                           GL_UNSIGNED_INT, &(*a_indices)[0]);
+        }
+    }
+
+    // render all triangles
+    else if (m_numIndices > 0)
+    {
+        glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, (const GLvoid*)0);
+    }
+
+    s_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    s_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Mark a range of vertices as modified. The range is copied to the
+    vertex buffer by the next call to render(). Ranges are merged with the
+    previous one when they follow it.
+
+    \fn       void cVertexBuffer::markModified(const unsigned int a_first,
+                                               const unsigned int a_count)
+    \param    a_first  Index of the first modified vertex.
+    \param    a_count  Number of modified vertices.
+*/
+//===========================================================================
+void cVertexBuffer::markModified(const unsigned int a_first,
+                                 const unsigned int a_count)
+{
+    if (a_count == 0) { return; }
+
+    m_lock.acquire();
+
+    // the whole buffer is copied anyway
+    if (m_rebuildVertices)
+    {
+        m_lock.release();
+        return;
+    }
+
+    if (!m_modifiedRanges.empty())
+    {
+        cVertexBufferRange& last = m_modifiedRanges.back();
+        if ((a_first >= last.m_first) && (a_first <= last.m_first + last.m_count))
+        {
+            last.m_count = cMax(last.m_count, a_first + a_count - last.m_first);
+            m_lock.release();
+            return;
+        }
+    }
+
+    // too many ranges: copy the whole buffer instead
+    if (m_modifiedRanges.size() >= CHAI_VERTEX_BUFFER_MAX_RANGES)
+    {
+        m_rebuildVertices = true;
+        m_modifiedRanges.clear();
+    }
+    else
+    {
+        cVertexBufferRange range;
+        range.m_first = a_first;
+        range.m_count = a_count;
+        m_modifiedRanges.push_back(range);
+    }
+
+    m_lock.release();
+}
+
+
+//===========================================================================
+/*!
+    Mark the triangles as modified. The index buffer is filled again by
+    the next call to render().
+
+    \fn       void cVertexBuffer::invalidateTriangles()
+*/
+//===========================================================================
+void cVertexBuffer::invalidateTriangles()
+{
+    m_lock.acquire();
+    m_rebuildIndices = true;
+    m_lock.release();
+}
+
+
+//===========================================================================
+/*!
+    Mark all vertices and triangles as modified. Both buffers are filled
+    again by the next call to render().
+
+    \fn       void cVertexBuffer::invalidate()
+*/
+//===========================================================================
+void cVertexBuffer::invalidate()
+{
+    m_lock.acquire();
+    m_rebuildVertices = true;
+    m_rebuildIndices = true;
+    m_modifiedRanges.clear();
+    m_lock.release();
+}
+
+
+//===========================================================================
+/*!
+    Delete the buffers from the OpenGL context. They are created and
+    filled again by the next call to render().
+
+    \fn       void cVertexBuffer::release()
+*/
+//===========================================================================
+void cVertexBuffer::release()
+{
+    if ((m_vertexBuffer != 0) && (s_glDeleteBuffers != NULL))
+    {
+        GLuint buffers[2];
+        buffers[0] = m_vertexBuffer;
+        buffers[1] = m_indexBuffer;
+        s_glDeleteBuffers(2, buffers);
+    }
+
+    m_vertexBuffer = 0;
+    m_indexBuffer = 0;
+    m_numVertices = 0;
+    m_numTriangles = 0;
+    m_numIndices = 0;
+    invalidate();
+}
+
+
+//===========================================================================
+/*!
+    Pack a range of vertices into m_data, as floats: position, normal,
+    color and texture coordinate.
+
+    \fn       void cVertexBuffer::packVertices(const vector<cVertex>& a_vertices,
+                                               const unsigned int a_first,
+                                               const unsigned int a_count)
+    \param    a_vertices  Vertices.
+    \param    a_first  Index of the first vertex of the range.
+    \param    a_count  Number of vertices of the range.
+*/
+//===========================================================================
+void cVertexBuffer::packVertices(const vector<cVertex>& a_vertices,
+                                 const unsigned int a_first,
+                                 const unsigned int a_count)
+{
+    m_data.resize(CHAI_VERTEX_BUFFER_VERTEX_SIZE * a_count);
+
+    float* data = m_data.empty() ? NULL : &m_data[0];
+    for (unsigned int i=0; i<a_count; i++)
+    {
+        const cVertex& vertex = a_vertices[a_first + i];
+        const GLfloat* color = vertex.m_color.pColor();
+
+        data[0]  = (float)vertex.m_localPos.x;
+        data[1]  = (float)vertex.m_localPos.y;
+        data[2]  = (float)vertex.m_localPos.z;
+        data[3]  = (float)vertex.m_normal.x;
+        data[4]  = (float)vertex.m_normal.y;
+        data[5]  = (float)vertex.m_normal.z;
+        data[6]  = color[0];
+        data[7]  = color[1];
+        data[8]  = color[2];
+        data[9]  = color[3];
+        data[10] = (float)vertex.m_texCoord.x;
+        data[11] = (float)vertex.m_texCoord.y;
+        data += CHAI_VERTEX_BUFFER_VERTEX_SIZE;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Copy the modified ranges of vertices to the vertex buffer, which must
+    be bound. Ranges are sorted, and ranges separated by a few vertices
+    only are copied together, to limit the number of calls to the driver.
+
+    \fn       void cVertexBuffer::copyModifiedRanges(const vector<cVertex>& a_vertices)
+    \param    a_vertices  Vertices.
+*/
+//===========================================================================
+void cVertexBuffer::copyModifiedRanges(const vector<cVertex>& a_vertices)
+{
+    std::sort(m_copiedRanges.begin(), m_copiedRanges.end(), cCompareVertexBufferRanges);
+
+    unsigned int numRanges = (unsigned int)m_copiedRanges.size();
+    unsigned int i = 0;
+    while (i < numRanges)
+    {
+        // merge the following ranges which overlap or are close
+        unsigned int first = m_copiedRanges[i].m_first;
+        unsigned int last = first + m_copiedRanges[i].m_count;
+        i++;
+        while ((i < numRanges) &&
+               (m_copiedRanges[i].m_first <= last + CHAI_VERTEX_BUFFER_MAX_GAP))
+        {
+            last = cMax(last, m_copiedRanges[i].m_first + m_copiedRanges[i].m_count);
+            i++;
+        }
+
+        // ignore vertices outside the buffer
+        last = cMin(last, m_numVertices);
+        if (first >= last) { continue; }
+
+        packVertices(a_vertices, first, last - first);
+        s_glBufferSubData(GL_ARRAY_BUFFER,
+                          (ptrdiff_t)(first * CHAI_VERTEX_BUFFER_VERTEX_SIZE * sizeof(float)),
+                          (ptrdiff_t)(m_data.size() * sizeof(float)),
+                          &m_data[0]);
+        m_numCopiedVertices += last - first;
+    }
+
+}
+
+
+//===========================================================================
+/*!
+    Fill the index buffer, which must be bound, with the vertex indices of
+    the allocated triangles.
+
+    \fn       void cVertexBuffer::buildIndices(const vector<cTriangle>& a_triangles)
+    \param    a_triangles  Triangles.
+*/
+//===========================================================================
+void cVertexBuffer::buildIndices(const vector<cTriangle>& a_triangles)
+{
+    unsigned int numTriangles = (unsigned int)a_triangles.size();
+
+    m_indices.clear();
+    m_indices.reserve(3 * numTriangles);
+    for (unsigned int i=0; i<numTriangles; i++)
+    {
+        const cTriangle& triangle = a_triangles[i];
+        if (triangle.m_allocated)
+        {
+            m_indices.push_back(triangle.m_indexVertex0);
+            m_indices.push_back(triangle.m_indexVertex1);
+            m_indices.push_back(triangle.m_indexVertex2);
+        }
+    }
+
+    s_glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                   (ptrdiff_t)(m_indices.size() * sizeof(unsigned int)),
+                   m_indices.empty() ? NULL : &m_indices[0],
+                   GL_STATIC_DRAW);
+
+    m_numTriangles = numTriangles;
+    m_numIndices = (unsigned int)m_indices.size();
+}
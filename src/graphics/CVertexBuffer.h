@@ -0,0 +1,220 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CVertexBufferH
+#define CVertexBufferH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+#include "timers/CMutex.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+class cVertex;
+class cTriangle;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CVertexBuffer.h
+
+    \brief
+    <b> Graphics </b> \n
+    Vertex Buffer Objects.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Number of floats stored for each vertex by a cVertexBuffer.
+#define CHAI_VERTEX_BUFFER_VERTEX_SIZE  12
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cVertexBufferRange
+    \ingroup    graphics
+
+    \brief
+    cVertexBufferRange is a range of consecutive vertices of a
+    cVertexBuffer.
+*/
+//===========================================================================
+struct cVertexBufferRange
+{
+    //! Index of the first vertex.
+    unsigned int m_first;
+
+    //! Number of vertices.
+    unsigned int m_count;
+};
+
+
+//===========================================================================
+/*!
+    \class      cVertexBuffer
+    \ingroup    graphics
+
+    \brief
+    cVertexBuffer renders an array of vertices and triangles from OpenGL
+    vertex buffer objects. \n
+
+    Each vertex is packed into 12 floats: position, normal, color (RGBA)
+    and texture coordinate (UV). The allocated triangles are stored as
+    32-bit indices in a second buffer, and the whole array is drawn by a
+    single call to glDrawElements(). \n
+
+    Buffers are filled on the first call to render(), and filled again
+    when the number of vertices or triangles changes, or after a call to
+    invalidate(). Ranges of vertices modified in between are passed to
+    markModified(); only those ranges are copied to the graphics card by
+    the next call to render(), so that deformable objects do not copy
+    their whole array at each frame. Vertices may be marked as modified
+    by a simulation thread while the graphics thread renders. \n
+
+    Vertex buffer objects require OpenGL 1.5 or the
+    GL_ARB_vertex_buffer_object extension. When neither is available,
+    render() returns \b false and the caller falls back to another
+    rendering method. Buffers belong to the OpenGL context which was
+    current when they were created, and must be released with release()
+    before this context is destroyed or reset.
+*/
+//===========================================================================
+class cVertexBuffer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cVertexBuffer.
+    cVertexBuffer();
+
+    //! Destructor of cVertexBuffer.
+    ~cVertexBuffer();
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Return \b true if the current OpenGL context supports vertex buffer objects.
+    static bool isSupported();
+
+    //! Copy modified vertices and triangles to the buffers, and render the triangles.
+    bool render(const vector<cVertex>& a_vertices,
+                const vector<cTriangle>& a_triangles,
+                const bool a_useVertexColors,
+                const bool a_useTextureCoords,
+                const vector<unsigned int>* a_indices = NULL);
+
+    //! Mark a range of vertices as modified, to be copied by the next call to render().
+    void markModified(const unsigned int a_first, const unsigned int a_count);
+
+    //! Mark the triangles as modified, to be copied by the next call to render().
+    void invalidateTriangles();
+
+    //! Mark all vertices and triangles as modified.
+    void invalidate();
+
+    //! Delete the buffers. They are created again by the next call to render().
+    void release();
+
+    //! Get the number of vertices copied to the graphics card by the last call to render().
+    unsigned int getNumCopiedVertices() const { return (m_numCopiedVertices); }
+
+    //! Get the number of indices drawn by the last call to render().
+    unsigned int getNumIndices() const { return (m_numIndices); }
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Pack a range of vertices into m_data.
+    void packVertices(const vector<cVertex>& a_vertices,
+                      const unsigned int a_first,
+                      const unsigned int a_count);
+
+    //! Copy the modified ranges of vertices to the vertex buffer.
+    void copyModifiedRanges(const vector<cVertex>& a_vertices);
+
+    //! Fill the index buffer with the allocated triangles.
+    void buildIndices(const vector<cTriangle>& a_triangles);
+
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! OpenGL buffer holding the vertices, or 0.
+    unsigned int m_vertexBuffer;
+
+    //! OpenGL buffer holding the indices of the triangles, or 0.
+    unsigned int m_indexBuffer;
+
+    //! Number of vertices in the vertex buffer.
+    unsigned int m_numVertices;
+
+    //! Size of the array of triangles when the index buffer was filled.
+    unsigned int m_numTriangles;
+
+    //! Number of indices in the index buffer.
+    unsigned int m_numIndices;
+
+    //! If \b true, the vertex buffer is filled again by the next call to render().
+    bool m_rebuildVertices;
+
+    //! If \b true, the index buffer is filled again by the next call to render().
+    bool m_rebuildIndices;
+
+    //! Ranges of vertices modified since the last call to render().
+    vector<cVertexBufferRange> m_modifiedRanges;
+
+    //! Ranges of vertices copied by the current call to render().
+    vector<cVertexBufferRange> m_copiedRanges;
+
+    //! Lock protecting the modified ranges and flags.
+    cMutex m_lock;
+
+    //! Packed vertices, before they are copied to the graphics card.
+    vector<float> m_data;
+
+    //! Indices of the triangles, before they are copied to the graphics card.
+    vector<unsigned int> m_indices;
+
+    //! Number of vertices copied to the graphics card by the last call to render().
+    unsigned int m_numCopiedVertices;
+
+
+  private:
+
+    //! Vertex buffers cannot be copied.
+    cVertexBuffer(const cVertexBuffer&);
+
+    //! Vertex buffers cannot be assigned.
+    cVertexBuffer& operator=(const cVertexBuffer&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
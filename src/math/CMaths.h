@@ -1033,6 +1033,102 @@ inline cVector3d cProjectPointOnSegment(const cVector3d& a_point,
 }
 
 
+//===========================================================================
+/*!
+    Compute the closest point of a triangle to a point, by locating the
+    point in the regions of the vertices, edges and face of the triangle.
+
+    \param    a_point  Point that is projected.
+    \param    a_vertex0  Vertex 0 of triangle.
+    \param    a_vertex1  Vertex 1 of triangle.
+    \param    a_vertex2  Vertex 2 of triangle.
+    \param    a_weights  If not NULL, returns the barycentric coordinates
+              of the closest point with respect to the three vertices.
+    \return   Returns the closest point of the triangle to \e a_point.
+*/
+//===========================================================================
+inline cVector3d cProjectPointOnTriangle(const cVector3d& a_point,
+                                         const cVector3d& a_vertex0,
+                                         const cVector3d& a_vertex1,
+                                         const cVector3d& a_vertex2,
+                                         double* a_weights = NULL)
+{
+    double weights[3];
+    if (a_weights == NULL) { a_weights = weights; }
+
+    cVector3d edge01 = cSub(a_vertex1, a_vertex0);
+    cVector3d edge02 = cSub(a_vertex2, a_vertex0);
+
+    // region of vertex 0
+    cVector3d p0 = cSub(a_point, a_vertex0);
+    double d1 = cDot(edge01, p0);
+    double d2 = cDot(edge02, p0);
+    if ((d1 <= 0.0) && (d2 <= 0.0))
+    {
+        a_weights[0] = 1.0; a_weights[1] = 0.0; a_weights[2] = 0.0;
+        return (a_vertex0);
+    }
+
+    // region of vertex 1
+    cVector3d p1 = cSub(a_point, a_vertex1);
+    double d3 = cDot(edge01, p1);
+    double d4 = cDot(edge02, p1);
+    if ((d3 >= 0.0) && (d4 <= d3))
+    {
+        a_weights[0] = 0.0; a_weights[1] = 1.0; a_weights[2] = 0.0;
+        return (a_vertex1);
+    }
+
+    // region of edge 01
+    double vc = d1 * d4 - d3 * d2;
+    if ((vc <= 0.0) && (d1 >= 0.0) && (d3 <= 0.0))
+    {
+        double v = d1 / (d1 - d3);
+        a_weights[0] = 1.0 - v; a_weights[1] = v; a_weights[2] = 0.0;
+        return (cAdd(a_vertex0, cMul(v, edge01)));
+    }
+
+    // region of vertex 2
+    cVector3d p2 = cSub(a_point, a_vertex2);
+    double d5 = cDot(edge01, p2);
+    double d6 = cDot(edge02, p2);
+    if ((d6 >= 0.0) && (d5 <= d6))
+    {
+        a_weights[0] = 0.0; a_weights[1] = 0.0; a_weights[2] = 1.0;
+        return (a_vertex2);
+    }
+
+    // region of edge 02
+    double vb = d5 * d2 - d1 * d6;
+    if ((vb <= 0.0) && (d2 >= 0.0) && (d6 <= 0.0))
+    {
+        double w = d2 / (d2 - d6);
+        a_weights[0] = 1.0 - w; a_weights[1] = 0.0; a_weights[2] = w;
+        return (cAdd(a_vertex0, cMul(w, edge02)));
+    }
+
+    // region of edge 12
+    double va = d3 * d6 - d5 * d4;
+    if ((va <= 0.0) && ((d4 - d3) >= 0.0) && ((d5 - d6) >= 0.0))
+    {
+        double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        a_weights[0] = 0.0; a_weights[1] = 1.0 - w; a_weights[2] = w;
+        return (cAdd(a_vertex1, cMul(w, cSub(a_vertex2, a_vertex1))));
+    }
+
+    // region of the face
+    double denominator = va + vb + vc;
+    if (denominator == 0.0)
+    {
+        a_weights[0] = 1.0; a_weights[1] = 0.0; a_weights[2] = 0.0;
+        return (a_vertex0);
+    }
+    double v = vb / denominator;
+    double w = vc / denominator;
+    a_weights[0] = 1.0 - v - w; a_weights[1] = v; a_weights[2] = w;
+    return (cAdd(a_vertex0, cAdd(cMul(v, edge01), cMul(w, edge02))));
+}
+
 
 //===========================================================================
 /*!
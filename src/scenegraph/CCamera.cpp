@@ -60,6 +60,11 @@ cCamera::cCamera(cWorld* a_parentWorld)
     // disable multipass transparency rendering by default
     m_useMultipassTransparency = 0;
 
+    // disable frustum culling by default
+    m_useFrustumCulling = false;
+    m_useRenderQueue = false;
+    m_renderStatistics.reset();
+
     m_performingDisplayReset = 0;
 
     memset(m_projectionMatrix,0,sizeof(m_projectionMatrix));
@@ -317,23 +322,26 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
     // set up perspective projection
     double glAspect = ((double)a_windowWidth / (double)a_windowHeight);
 
+    // projection and view matrices, kept to extract the view frustum
+    cMatrixGL projectionMatrix;
+    cMatrixGL viewMatrix;
+
     // set the perspective up for monoscopic rendering
     if (a_imageIndex == CHAI_MONO || a_imageIndex == CHAI_STEREO_DEFAULT)
     {
         // Set up the projection matrix
         glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
 
-        gluPerspective(
+        projectionMatrix.buildPerspectiveMatrix(
                 m_fieldViewAngle,   // Field of View Angle.
                 glAspect,           // Aspect ratio of viewing volume.
                 m_distanceNear,     // Distance to Near clipping plane.
                 m_distanceFar);     // Distance to Far clipping plane.
+        projectionMatrix.glMatrixLoad();
 
 
         // Now set up the view matrix
         glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
 
         // render pose
         cVector3d lookAt = m_globalRot.getCol0();
@@ -341,9 +349,8 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
         m_globalPos.subr(lookAt, lookAtPos);
         cVector3d up = m_globalRot.getCol2();
 
-        gluLookAt( m_globalPos.x,    m_globalPos.y,   m_globalPos.z,
-                   lookAtPos.x,    lookAtPos.y,   lookAtPos.z,
-                   up.x,           up.y,          up.z );
+        viewMatrix.buildLookAtMatrix(m_globalPos, lookAtPos, up);
+        viewMatrix.glMatrixLoad();
     }
 
     // set the perspective up for stereoscopic rendering
@@ -379,13 +386,12 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
 
       // Set up the projection matrix
       glMatrixMode(GL_PROJECTION);
-      glLoadIdentity();
 
-      glFrustum(left,right,bottom,top,m_distanceNear,m_distanceFar);
+      projectionMatrix.buildFrustumMatrix(left,right,bottom,top,m_distanceNear,m_distanceFar);
+      projectionMatrix.glMatrixLoad();
 
       // Now set up the view matrix
       glMatrixMode(GL_MODELVIEW);
-      glLoadIdentity();
 
       // compute the offset we should apply to the current camera position
       cVector3d pos = cAdd(m_globalPos,offsetv);
@@ -395,10 +401,8 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
       pos.addr(lookv, lookAtPos);
 
       // set up the view matrix
-      gluLookAt(pos.x,       pos.y,       pos.z,
-                lookAtPos.x, lookAtPos.y, lookAtPos.z,
-                upv.x,       upv.y,       upv.z
-                );
+      viewMatrix.buildLookAtMatrix(pos, lookAtPos, upv);
+      viewMatrix.glMatrixLoad();
 
     }
 
@@ -416,7 +420,16 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
     }
 
     // Back up the projection matrix for future reference
-    glGetDoublev(GL_PROJECTION_MATRIX,m_projectionMatrix);
+    memcpy(m_projectionMatrix, projectionMatrix.pMatrix(), 16 * sizeof(double));
+
+    // Extract the view frustum in world coordinates from the matrices above;
+    // without culling, no plane is tested and the frustum only gathers
+    // statistics and the projected scale used for levels of detail
+    cFrustum frustum;
+    frustum.set(m_projectionMatrix, viewMatrix.pMatrix(), a_windowHeight);
+    if (!m_useFrustumCulling) frustum.m_mask = 0;
+    m_renderStatistics.reset();
+    frustum.setStatistics(&m_renderStatistics);
 
     // Set up reasonable default OpenGL state
     glEnable(GL_LIGHTING);
@@ -424,15 +437,39 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
     glDepthMask(GL_TRUE);
     glEnable(GL_DEPTH_TEST);
 
+    // optionally collect the objects once, then render them sorted by
+    // OpenGL state in each rendering pass
+    if (m_useRenderQueue)
+    {
+      m_renderQueue.clear();
+      m_renderQueue.setStatistics(&m_renderStatistics);
+      m_parentWorld->queueSceneGraph(m_renderQueue, viewMatrix, &frustum);
+      m_renderQueue.sort();
+
+      if (m_useMultipassTransparency)
+      {
+        m_renderQueue.render(CHAI_RENDER_MODE_NON_TRANSPARENT_ONLY);
+        m_renderQueue.render(CHAI_RENDER_MODE_TRANSPARENT_BACK_ONLY);
+        m_renderQueue.render(CHAI_RENDER_MODE_TRANSPARENT_FRONT_ONLY);
+      }
+      else
+      {
+        m_renderQueue.render(CHAI_RENDER_MODE_RENDER_ALL);
+      }
+
+      // restore the view matrix
+      viewMatrix.glMatrixLoad();
+    }
+
     // optionally perform multiple rendering passes for transparency
-    if (m_useMultipassTransparency) {
-      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_NON_TRANSPARENT_ONLY);
-      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_TRANSPARENT_BACK_ONLY);
-      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_TRANSPARENT_FRONT_ONLY);
+    else if (m_useMultipassTransparency) {
+      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_NON_TRANSPARENT_ONLY, &frustum);
+      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_TRANSPARENT_BACK_ONLY, &frustum);
+      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_TRANSPARENT_FRONT_ONLY, &frustum);
     }
     else
     {
-      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_RENDER_ALL);
+      m_parentWorld->renderSceneGraph(CHAI_RENDER_MODE_RENDER_ALL, &frustum);
     }        
 
     // render the 'front' 2d object layer; it will set up its own
@@ -445,6 +482,8 @@ void cCamera::renderView(const int a_windowWidth, const int a_windowHeight,
 //===========================================================================
 /*!
       Copies the opengl image buffer to a cImageLoader class structure.
+      This waits until the frame has been rendered; to record frames
+      without stalling the rendering loop, use a cFrameCapture instead.
 
       \fn         void cCamera::copyImageData(cImageLoader* a_image)
       \param      a_image  Destination image
@@ -506,6 +545,71 @@ void cCamera::enableMultipassTransparency(bool enable) {
 }
 
 
+//===========================================================================
+/*!
+      Enable or disable the culling of objects outside the view frustum.
+
+      When enabled, the planes of the view frustum are extracted from the
+      projection and modelview matrices of the camera, and each object of
+      the world is tested in its own frame against them before rendering.
+      An object whose boundary box lies outside the frustum is skipped,
+      along with all of its children; objects inside all planes spare
+      their children any further tests.
+
+      Boundary boxes enclose the boxes of children, and are only updated
+      by cGenericObject::computeBoundaryBox(). If you turn this option on,
+      call it again after moving children or vertices, or objects may be
+      culled while still on screen. Objects which never computed a boundary
+      box are always rendered. Objects kept outside the scene graph, such
+      as the bodies of ODE and GEL worlds, are culled and counted through
+      the frustum which their world passes on from render(); the boxes of
+      deformable GEL meshes must then be recomputed as they deform.
+
+      The statistics returned by getRenderStatistics() are gathered whether
+      or not culling is enabled, summed over all rendering passes.
+
+      \fn         void cCamera::setUseFrustumCulling(const bool a_useFrustumCulling)
+      \param      a_useFrustumCulling  If \b true, objects outside the view frustum are culled.
+*/
+//===========================================================================
+void cCamera::setUseFrustumCulling(const bool a_useFrustumCulling)
+{
+    m_useFrustumCulling = a_useFrustumCulling;
+}
+
+
+//===========================================================================
+/*!
+      Enable or disable the rendering of objects sorted by OpenGL state.
+
+      When enabled, the world is traversed once per frame to collect its
+      objects, with their modelview matrices, into a cRenderQueue. Meshes
+      are then rendered grouped by texture and material, opaque meshes
+      from front to back and transparent meshes from back to front, and a
+      mesh does not send again the material, texture or client arrays left
+      by the previous one. With multipass transparency, the three rendering
+      passes render the same sorted queue. Other objects, and meshes which
+      render their normals, frame, box or trees, are rendered first in the
+      order of the scene graph.
+
+      Meshes are no longer rendered after their parent, so this option
+      should not be used if an object changes the OpenGL state for its
+      children in render(). Sorted meshes rendered with display lists
+      always send their whole state.
+
+      The number of skipped materials and textures is returned by
+      getRenderStatistics().
+
+      \fn         void cCamera::setUseRenderQueue(const bool a_useRenderQueue)
+      \param      a_useRenderQueue  If \b true, objects are rendered sorted by OpenGL state.
+*/
+//===========================================================================
+void cCamera::setUseRenderQueue(const bool a_useRenderQueue)
+{
+    m_useRenderQueue = a_useRenderQueue;
+}
+
+
 //===========================================================================
 /*!
     This call automatically adjusts the front and back clipping planes to
@@ -26,6 +26,8 @@
 #include "scenegraph/CGenericObject.h"
 #include "math/CMaths.h"
 #include "files/CImageLoader.h"
+#include "graphics/CFrustum.h"
+#include "scenegraph/CRenderQueue.h"
 //---------------------------------------------------------------------------
 class cWorld;
 //---------------------------------------------------------------------------
@@ -222,6 +224,21 @@ class cCamera : public cGenericObject
     //! Enable or disable additional rendering passes for transparency (see full comment).
     virtual void enableMultipassTransparency(bool enable);
 
+    //! Enable or disable the culling of objects outside the view frustum (see full comment).
+    void setUseFrustumCulling(const bool a_useFrustumCulling);
+
+    //! Is culling of objects outside the view frustum enabled?
+    bool getUseFrustumCulling() const { return (m_useFrustumCulling); }
+
+    //! Enable or disable the rendering of objects sorted by OpenGL state (see full comment).
+    void setUseRenderQueue(const bool a_useRenderQueue);
+
+    //! Are objects rendered sorted by OpenGL state?
+    bool getUseRenderQueue() const { return (m_useRenderQueue); }
+
+    //! Get the numbers of objects and triangles rendered and culled by the last call to renderView().
+    const cRenderStatistics& getRenderStatistics() const { return (m_renderStatistics); }
+
     //! Resets textures and displays for the world associated with this camera.
     virtual void onDisplayReset(const bool a_affectChildren = true);
 
@@ -281,6 +298,18 @@ class cCamera : public cGenericObject
     //! If true, three rendering passes are performed to approximate back-front sorting (see long comment)
     bool m_useMultipassTransparency;
 
+    //! If true, objects outside the view frustum are skipped with their children.
+    bool m_useFrustumCulling;
+
+    //! Numbers of objects and triangles rendered and culled by the last call to renderView().
+    cRenderStatistics m_renderStatistics;
+
+    //! If true, objects are collected in m_renderQueue and rendered sorted by OpenGL state.
+    bool m_useRenderQueue;
+
+    //! Objects of the world, sorted by OpenGL state.
+    cRenderQueue m_renderQueue;
+
     //! Render a 2d scene within this camera's view.
     void render2dSceneGraph(cGenericObject* a_graph, int a_width, int a_height);
 
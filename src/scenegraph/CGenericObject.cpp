@@ -22,6 +22,9 @@
 //---------------------------------------------------------------------------
 #include "scenegraph/CGenericObject.h"
 #include "collisions/CGenericCollision.h"
+#include "timers/CProfiler.h"
+#include "graphics/CFrustum.h"
+#include "scenegraph/CRenderQueue.h"
 #include <float.h>
 //---------------------------------------------------------------------------
 #include <vector>
@@ -53,6 +56,9 @@ m_tag(-1), m_userData(0)
     // initialize openGL matrix with position vector and orientation matrix
     m_frameGL.set(m_globalPos, m_globalRot);
 
+    // no view frustum outside of renderSceneGraph()
+    m_renderFrustum = NULL;
+
     // custom user information
     m_objectName[0] = '\0';
 
@@ -695,6 +701,9 @@ void cGenericObject::computeGlobalPositions(const bool a_frameOnly,
 	// check if node is a ghost. If yes, then ignore call
 	if (m_ghostStatus) { return; }
 
+    // time the whole traversal, from the root only
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_GLOBAL_POSITIONS, (m_parent == NULL));
+
     // current values become previous values
     m_prevGlobalPos = m_globalPos;
     m_prevGlobalRot = m_globalRot;
@@ -1847,35 +1856,11 @@ bool cGenericObject::computeCollisionDetection(cVector3d& a_segmentPointA,
     localSegmentPointB.sub(m_localPos);
     transLocalRot.mul(localSegmentPointB);
 
-    // check for a collision with this object if:
-    // (1) it has a collision detector
-    // (2) if other settings (visible and haptic enabled) are activated
-    if ((m_collisionDetector != NULL) &&
-        (!a_settings.m_checkVisibleObjectsOnly || m_show) &&
-        (!a_settings.m_checkHapticObjectsOnly || m_hapticEnabled))
-    {
-        // adjust the first segment endpoint so that it is in the same position
-        // relative to the moving object as it was at the previous haptic iteration
-        cVector3d localSegmentPointAadjusted;
-        if (a_settings.m_adjustObjectMotion)
-        {
-            adjustCollisionSegment(localSegmentPointA, localSegmentPointAadjusted);
-        }
-        else
-        {
-            localSegmentPointAadjusted = localSegmentPointA;
-        }
-
-        // call the collision detector's collision detection function
-        if (m_collisionDetector->computeCollision(localSegmentPointAadjusted,
-                                                  localSegmentPointB,
-                                                  a_recorder,
-                                                  a_settings))
-        {
-            // record that there has been a collision
-            hit = true;
-        }
-    }
+    // check for a collision with this object
+    hit = computeLocalCollisionDetection(localSegmentPointA,
+                                         localSegmentPointB,
+                                         a_recorder,
+                                         a_settings);
 
 		// compute any other collisions. This is a virtual function that can be extended for
 		// classes that may contain other objects (sibbling) for wich collision detection may
@@ -1905,6 +1890,177 @@ bool cGenericObject::computeCollisionDetection(cVector3d& a_segmentPointA,
 }
 
 
+//===========================================================================
+/*!
+    Determine whether the given segment intersects a triangle of this object,
+    without considering its descendants. The segment is described by a start
+    point \e a_segmentPointA and end point \e a_segmentPointB, both expressed
+    in the local coordinate frame of this object. \n
+
+    This method is called by computeCollisionDetection() for each object of
+    the scene graph, and by cCollisionBroadphase for the objects whose
+    bounding boxes are crossed by the segment.
+
+    \fn     bool cGenericObject::computeLocalCollisionDetection(cVector3d& a_segmentPointA,
+                                                cVector3d& a_segmentPointB,
+                                                cCollisionRecorder& a_recorder,
+                                                cCollisionSettings& a_settings)
+    \param  a_segmentPointA  Start point of segment, in local coordinates.
+    \param  a_segmentPointB  End point of segment, in local coordinates.
+    \param  a_recorder  Stores all collision events.
+    \param  a_settings  Contains collision settings information.
+    \return Return \b true if a collision has occurred.
+*/
+//===========================================================================
+bool cGenericObject::computeLocalCollisionDetection(cVector3d& a_segmentPointA,
+                                                    cVector3d& a_segmentPointB,
+                                                    cCollisionRecorder& a_recorder,
+                                                    cCollisionSettings& a_settings)
+{
+    // check for a collision with this object if:
+    // (1) it has a collision detector
+    // (2) if other settings (visible and haptic enabled) are activated
+    if ((m_collisionDetector == NULL) ||
+        (a_settings.m_checkVisibleObjectsOnly && !m_show) ||
+        (a_settings.m_checkHapticObjectsOnly && !m_hapticEnabled))
+    {
+        return (false);
+    }
+
+    // adjust the first segment endpoint so that it is in the same position
+    // relative to the moving object as it was at the previous haptic iteration
+    cVector3d segmentPointAadjusted;
+    if (a_settings.m_adjustObjectMotion)
+    {
+        adjustCollisionSegment(a_segmentPointA, segmentPointAadjusted);
+    }
+    else
+    {
+        segmentPointAadjusted = a_segmentPointA;
+    }
+
+    // call the collision detector's collision detection function
+    return (m_collisionDetector->computeCollision(segmentPointAadjusted,
+                                                  a_segmentPointB,
+                                                  a_recorder,
+                                                  a_settings));
+}
+
+
+//===========================================================================
+/*!
+    Determine whether a batch of segments intersects this object or its
+    descendants. Segments are expressed in the coordinate frame of the
+    parent of this object. Each segment is tested with its own settings
+    and stores its collision events in its own recorder. \n
+
+    The whole batch is passed down the scene graph, so that the collision
+    detector of each object can test all segments together (see
+    cGenericCollision::computeCollisions()) rather than one at a time.
+
+    \fn     bool cGenericObject::computeCollisionDetections(vector<cCollisionSegment>& a_segments)
+    \param  a_segments  Segments to test, in the coordinate frame of the parent.
+    \return Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cGenericObject::computeCollisionDetections(vector<cCollisionSegment>& a_segments)
+{
+    // check if node is a ghost. If yes, then ignore call
+    if (m_ghostStatus) { return (false); }
+
+    // temp variable
+    bool hit = false;
+
+    // get the transpose of the local rotation matrix
+    cMatrix3d transLocalRot;
+    m_localRot.transr(transLocalRot);
+
+    // convert the segments into local coordinate frame
+    vector<cCollisionSegment> localSegments(a_segments);
+    for (unsigned int i=0; i<localSegments.size(); i++)
+    {
+        localSegments[i].m_segmentPointA.sub(m_localPos);
+        transLocalRot.mul(localSegments[i].m_segmentPointA);
+        localSegments[i].m_segmentPointB.sub(m_localPos);
+        transLocalRot.mul(localSegments[i].m_segmentPointB);
+    }
+
+    // check for collisions with this object
+    hit = computeLocalCollisionDetections(localSegments);
+
+    // compute any other collisions, one segment at a time
+    for (unsigned int i=0; i<localSegments.size(); i++)
+    {
+        cCollisionSegment& segment = localSegments[i];
+        hit = hit | computeOtherCollisionDetection(segment.m_segmentPointA,
+                                                   segment.m_segmentPointB,
+                                                   *segment.m_recorder,
+                                                   *segment.m_settings);
+    }
+
+    // check for collisions with all children of this object
+    for (unsigned int i=0; i<m_children.size(); i++)
+    {
+        hit = hit | m_children[i]->computeCollisionDetections(localSegments);
+    }
+
+    // return whether there was a collision
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Determine whether a batch of segments intersects a triangle of this
+    object, without considering its descendants. Segments are expressed in
+    the local coordinate frame of this object. Segments whose settings
+    exclude this object are skipped, and the others are passed together
+    to the collision detector.
+
+    \fn     bool cGenericObject::computeLocalCollisionDetections(vector<cCollisionSegment>& a_segments)
+    \param  a_segments  Segments to test, in local coordinates.
+    \return Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cGenericObject::computeLocalCollisionDetections(vector<cCollisionSegment>& a_segments)
+{
+    if (m_collisionDetector == NULL)
+    {
+        return (false);
+    }
+
+    // select the segments for which this object must be tested
+    vector<cCollisionSegment> segments;
+    segments.reserve(a_segments.size());
+    for (unsigned int i=0; i<a_segments.size(); i++)
+    {
+        const cCollisionSettings& settings = *a_segments[i].m_settings;
+        if ((settings.m_checkVisibleObjectsOnly && !m_show) ||
+            (settings.m_checkHapticObjectsOnly && !m_hapticEnabled))
+        {
+            continue;
+        }
+
+        segments.push_back(a_segments[i]);
+
+        // adjust the first segment endpoint for the motion of the object
+        if (settings.m_adjustObjectMotion)
+        {
+            adjustCollisionSegment(a_segments[i].m_segmentPointA,
+                                   segments.back().m_segmentPointA);
+        }
+    }
+
+    if (segments.size() == 0)
+    {
+        return (false);
+    }
+
+    // call the collision detector's batched collision detection function
+    return (m_collisionDetector->computeCollisions(segments));
+}
+
+
 //===========================================================================
 /*!
     Adjust the given segment such that it tests for intersection of the ray with
@@ -1951,14 +2107,44 @@ void cGenericObject::adjustCollisionSegment(cVector3d& a_segmentPointA,
     If you have multipass transparency disabled (see cCamera), your objects will
     only be rendered once per frame, with a_renderMode set to CHAI_RENDER_MODE_RENDER_ALL.
     This is the default, and unless you enable multipass transparency, you don't
-    ever need to care about a_renderMode.
+    ever need to care about a_renderMode. \n
 
-    \fn     void cGenericObject::renderSceneGraph(const int a_renderMode)
+    If a view frustum is given (see cCamera::setUseFrustumCulling()), it is
+    expressed in the frame of this object, and the object and its children
+    are skipped if the boundary box of the object lies outside. Boundary
+    boxes must then be kept up to date with computeBoundaryBox(). The
+    frustum is available to render() as m_renderFrustum, so that objects
+    which render objects outside the scene graph can cull them too.
+
+    \fn     void cGenericObject::renderSceneGraph(const int a_renderMode,
+                                                 const cFrustum* a_frustum)
     \param  a_renderMode  Rendering mode.
+    \param  a_frustum  View frustum in the frame of the parent, or NULL to render all objects.
 */
 //===========================================================================
-void cGenericObject::renderSceneGraph(const int a_renderMode)
+void cGenericObject::renderSceneGraph(const int a_renderMode,
+                                      const cFrustum* a_frustum)
 {
+    //-----------------------------------------------------------------------
+    // Culling
+    //-----------------------------------------------------------------------
+
+    cFrustum frustum;
+    cRenderStatistics* statistics = NULL;
+    if (a_frustum != NULL)
+    {
+        frustum.transform(*a_frustum, m_localPos, m_localRot);
+        statistics = frustum.getStatistics();
+
+        // objects without a valid boundary box are always rendered
+        bool boxValid = (fabs(cDistance(m_boundaryBoxMax, m_boundaryBoxMin)) > BOUNDARY_BOX_EPSILON);
+        if (boxValid && frustum.cullBox(m_boundaryBoxMin, m_boundaryBoxMax))
+        {
+            if (statistics != NULL) { statistics->m_numCulledObjects++; }
+            return;
+        }
+    }
+
     //-----------------------------------------------------------------------
     // Initialize rendering
     //-----------------------------------------------------------------------
@@ -1968,6 +2154,96 @@ void cGenericObject::renderSceneGraph(const int a_renderMode)
     m_frameGL.set(m_localPos, m_localRot);
     m_frameGL.glMatrixPushMultiply();
 
+    // render this object
+    renderObject(a_renderMode, statistics, (a_frustum != NULL) ? &frustum : NULL);
+
+    // render children
+    for (unsigned int i=0; i<m_children.size(); i++)
+    {
+        m_children[i]->renderSceneGraph(a_renderMode, (a_frustum != NULL) ? &frustum : NULL);
+    }
+
+    // pop current matrix
+    m_frameGL.glMatrixPop();
+
+    // restore settings
+    glDisable(GL_CULL_FACE);
+}
+
+
+//===========================================================================
+/*!
+    Add this object and its children to a render queue, with the modelview
+    matrix of each object (see cRenderQueue). Objects are culled as in
+    renderSceneGraph(), which is otherwise replaced by sorting the queue
+    and calling cRenderQueue::render() for each rendering pass.
+
+    \fn     void cGenericObject::queueSceneGraph(cRenderQueue& a_queue,
+                                                const cMatrixGL& a_modelview,
+                                                const cFrustum* a_frustum)
+    \param  a_queue  Render queue.
+    \param  a_modelview  Modelview matrix of the parent.
+    \param  a_frustum  View frustum in the frame of the parent, or NULL to add all objects.
+*/
+//===========================================================================
+void cGenericObject::queueSceneGraph(cRenderQueue& a_queue,
+                                     const cMatrixGL& a_modelview,
+                                     const cFrustum* a_frustum)
+{
+    // culling
+    cFrustum frustum;
+    if (a_frustum != NULL)
+    {
+        frustum.transform(*a_frustum, m_localPos, m_localRot);
+
+        // objects without a valid boundary box are always rendered
+        bool boxValid = (fabs(cDistance(m_boundaryBoxMax, m_boundaryBoxMin)) > BOUNDARY_BOX_EPSILON);
+        if (boxValid && frustum.cullBox(m_boundaryBoxMin, m_boundaryBoxMax))
+        {
+            cRenderStatistics* statistics = frustum.getStatistics();
+            if (statistics != NULL) { statistics->m_numCulledObjects++; }
+            return;
+        }
+    }
+
+    // compose the modelview matrix of this object with the one of its parent
+    m_frameGL.set(m_localPos, m_localRot);
+    cMatrixGL modelview = m_frameGL;
+    modelview.mul(a_modelview);
+
+    // add this object, then its children
+    a_queue.add(this, modelview, (a_frustum != NULL) ? &frustum : NULL);
+
+    for (unsigned int i=0; i<m_children.size(); i++)
+    {
+        m_children[i]->queueSceneGraph(a_queue, modelview, (a_frustum != NULL) ? &frustum : NULL);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Render this object without its children, in the current reference frame:
+    its reference frame, scenegraph tree, boundary box and collision tree if
+    enabled, and its graphical representation by calling render() after
+    setting up culling and transparency. Called by renderSceneGraph() and
+    cRenderQueue::render(). The view frustum is available to render() as
+    m_renderFrustum.
+
+    \fn     void cGenericObject::renderObject(const int a_renderMode,
+                                             cRenderStatistics* a_statistics,
+                                             const cFrustum* a_frustum)
+    \param  a_renderMode  Rendering mode (see renderSceneGraph()).
+    \param  a_statistics  Statistics updated if the object is rendered, or NULL.
+    \param  a_frustum  View frustum in the frame of this object, or NULL.
+*/
+//===========================================================================
+void cGenericObject::renderObject(const int a_renderMode,
+                                  cRenderStatistics* a_statistics,
+                                  const cFrustum* a_frustum)
+{
+    m_renderFrustum = a_frustum;
+
     // Handle rendering meta-object components, e.g. collision trees,
     // bounding boxes, scenegraph tree, etc.
     // set up useful rendering state
@@ -2140,19 +2416,16 @@ void cGenericObject::renderSceneGraph(const int a_renderMode)
             glCullFace(GL_FRONT);
             render(a_renderMode);
         }
-    }
 
-    // render children
-    for (unsigned int i=0; i<m_children.size(); i++)
-    {
-        m_children[i]->renderSceneGraph(a_renderMode);
+        // update statistics, after render() selected what to draw
+        if (a_statistics != NULL)
+        {
+            a_statistics->m_numObjects++;
+            a_statistics->m_numTriangles += getNumRenderedTriangles();
+        }
     }
 
-    // pop current matrix
-    m_frameGL.glMatrixPop();
-
-    // restore settings
-    glDisable(GL_CULL_FACE);
+    m_renderFrustum = NULL;
 }
 
 
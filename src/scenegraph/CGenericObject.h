@@ -44,6 +44,9 @@ class cTriangle;
 class cGenericCollision;
 class cGenericPointForceAlgo;
 class cMesh;
+class cFrustum;
+class cRenderQueue;
+struct cRenderStatistics;
 //---------------------------------------------------------------------------
 // TYPE DEFINITION
 //---------------------------------------------------------------------------
@@ -128,6 +131,9 @@ class cGenericObject : public cGenericType
     //! Get the global position of this object.
     inline cVector3d getGlobalPos() const { return (m_globalPos); }
 
+    //! Get the global position of this object at the previous update of the global positions.
+    inline cVector3d getPrevGlobalPos() const { return (m_prevGlobalPos); }
+
     //! Set the local rotation matrix for this object.
     inline void setRot(const cMatrix3d& a_rot)
     {
@@ -140,6 +146,9 @@ class cGenericObject : public cGenericType
     //! Get the global rotation matrix of this object.
     inline cMatrix3d getGlobalRot() const { return (m_globalRot); }
 
+    //! Get the global rotation matrix of this object at the previous update of the global positions.
+    inline cMatrix3d getPrevGlobalRot() const { return (m_prevGlobalRot); }
+
     //! Translate this object by a specified offset.
     void translate(const cVector3d& a_translation);
 
@@ -272,8 +281,22 @@ class cGenericObject : public cGenericType
     //! This function tells objects that you may modify their contents.
     virtual void unfinalize(const bool a_affectChildren = true);
 
-    //! Render the entire scene graph, starting from this object.
-    virtual void renderSceneGraph(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL);
+    //! Render the entire scene graph, starting from this object, optionally skipping objects outside a view frustum.
+    virtual void renderSceneGraph(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL,
+                                  const cFrustum* a_frustum=NULL);
+
+    //! Add this object and its children to a render queue, optionally skipping objects outside a view frustum.
+    virtual void queueSceneGraph(cRenderQueue& a_queue,
+                                 const cMatrixGL& a_modelview,
+                                 const cFrustum* a_frustum=NULL);
+
+    //! Render this object with its reference frame and trees, without its children.
+    void renderObject(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL,
+                      cRenderStatistics* a_statistics=NULL,
+                      const cFrustum* a_frustum=NULL);
+
+    //! Return \b true if a render queue may reorder this object and share OpenGL state with it (see cRenderQueue).
+    virtual bool isRenderSortable() const { return (false); }
 
 
     //-----------------------------------------------------------------------
@@ -388,6 +411,21 @@ class cGenericObject : public cGenericType
                                    cCollisionRecorder& a_recorder,
                                    cCollisionSettings& a_settings);
 
+    //! Compute collision detection with the collision detector of this object only. The segment is expressed in local coordinates.
+    bool computeLocalCollisionDetection(cVector3d& a_segmentPointA,
+                                        cVector3d& a_segmentPointB,
+                                        cCollisionRecorder& a_recorder,
+                                        cCollisionSettings& a_settings);
+
+    //! Compute collision detection for a batch of segments, each with its own recorder and settings.
+    virtual bool computeCollisionDetections(vector<cCollisionSegment>& a_segments);
+
+    //! Compute collision detection for a batch of segments with the collision detector of this object only. Segments are expressed in local coordinates.
+    bool computeLocalCollisionDetections(vector<cCollisionSegment>& a_segments);
+
+    //! Return \b true if this object implements computeOtherCollisionDetection().
+    virtual bool getUseOtherCollisionDetection() const { return (false); }
+
     //! Adjust collision segment for dynamic objects.
     virtual void adjustCollisionSegment(cVector3d& a_segmentPointA,
                                         cVector3d& a_segmentPointAadjusted);
@@ -677,6 +715,9 @@ class cGenericObject : public cGenericType
     //! Render this object in OpenGL.
     virtual void render(const int a_renderMode=CHAI_RENDER_MODE_RENDER_ALL);
 
+    //! Get the number of triangles submitted to OpenGL by render(), for rendering statistics.
+    virtual unsigned int getNumRenderedTriangles() const { return (0); }
+
     //! Update the m_globalPos and m_globalRot properties of any members of this object (e.g. all triangles).
     virtual void updateGlobalPositions(const bool a_frameOnly) {};
 
@@ -711,6 +752,9 @@ class cGenericObject : public cGenericType
 
     //! OpenGL matrix describing my position and orientation transformation.
     cMatrixGL m_frameGL;
+
+    //! View frustum in the frame of this object while renderObject() renders it, or NULL. Objects which render other objects from render() pass it on.
+    const cFrustum* m_renderFrustum;
 };
 
 
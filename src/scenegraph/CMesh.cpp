@@ -26,8 +26,10 @@
 #include "collisions/CGenericCollision.h"
 #include "collisions/CCollisionBrute.h"
 #include "collisions/CCollisionAABB.h"
+#include "collisions/CCollisionAABBFlat.h"
 #include "collisions/CCollisionSpheres.h"
 #include "files/CMeshLoader.h"
+#include "scenegraph/CRenderQueue.h"
 #include <algorithm>
 #include <set>
 //---------------------------------------------------------------------------
@@ -75,6 +77,13 @@ cMesh::cMesh(cWorld* a_world)
 
     // Vertex array disabled by default
     m_useVertexArrays = false;
+
+    // Vertex buffer objects disabled by default
+    m_useBufferObjects = false;
+
+    // No levels of detail by default
+    m_levelOfDetailTolerance = 1.0;
+    m_renderedLevel = 0;
 }
 
 
@@ -637,6 +646,12 @@ unsigned int cMesh::newTriangle(const unsigned int a_indexVertex0, const unsigne
     m_vertices[a_indexVertex0].m_nTriangles++;
     */
 
+    // triangles of the vertex buffer objects have changed
+    m_vertexBuffer.invalidateTriangles();
+
+    // levels of detail no longer match the triangles
+    deleteLevelsOfDetail(false);
+
     // return the index at which I inserted this triangle in my triangle array
     return (index);
 }
@@ -697,6 +712,12 @@ bool cMesh::removeTriangle(const unsigned int a_index)
     // add triangle to free list
     m_freeTriangles.push_back(a_index);
 
+    // triangles of the vertex buffer objects have changed
+    m_vertexBuffer.invalidateTriangles();
+
+    // levels of detail no longer match the triangles
+    deleteLevelsOfDetail(false);
+
     // return success
     return (true);
 }
@@ -720,6 +741,9 @@ void cMesh::clear()
     // clear free lists
     m_freeTriangles.clear();
     m_freeVertices.clear();
+
+    // clear levels of detail
+    deleteLevelsOfDetail(false);
 }
 
 
@@ -989,7 +1013,7 @@ void cMesh::setVertexColor(const cColorf& a_color, const bool a_affectChildren)
     \param     a_offset Translation to apply to each vertex
     \param     a_affectChildren  If \b true, children are also modified.
     \param     a_updateCollisionDetector  If \b true, this mesh's collision detector is
-                re-initialized
+                refitted
 */
 //===========================================================================
 void cMesh::offsetVertices(const cVector3d& a_offset, const bool a_affectChildren,
@@ -1020,8 +1044,8 @@ void cMesh::offsetVertices(const cVector3d& a_offset, const bool a_affectChildre
         }
     }
 
-    if (a_updateCollisionDetector && m_collisionDetector)
-        m_collisionDetector->initialize();
+    if (a_updateCollisionDetector)
+        refitCollisionDetector(false);
 }
 
 
@@ -1034,7 +1058,7 @@ void cMesh::offsetVertices(const cVector3d& a_offset, const bool a_affectChildre
     \param     a_extrudeDistance Distance to move each vertex
     \param     a_affectChildren  If \b true, children are also modified.
     \param     a_updateCollisionDetector  If \b true, this mesh's collision detector is
-              re-initialized
+              refitted
 */
 //===========================================================================
 void cMesh::extrude(const double a_extrudeDistance, const bool a_affectChildren,
@@ -1066,8 +1090,8 @@ void cMesh::extrude(const double a_extrudeDistance, const bool a_affectChildren,
         }
     }
 
-    if (a_updateCollisionDetector && m_collisionDetector)
-        m_collisionDetector->initialize();
+    if (a_updateCollisionDetector)
+        refitCollisionDetector(false);
 }
 
 
@@ -1378,6 +1402,7 @@ void cMesh::updateBoundaryBox()
 /*!
      Resize the current mesh by scaling all my vertex positions.  If you want
      to move vertices along their normals, use the extrude() function.
+     The collision detector of the mesh is refitted to the new positions.
 
      \fn        void cMesh::scaleObject(const cVector3d& a_scaleFactors)
      \param     a_scaleFactors   x,y,z scale factors.
@@ -1397,6 +1422,9 @@ void cMesh::scaleObject(const cVector3d& a_scaleFactors)
 
     m_boundaryBoxMax.elementMul(a_scaleFactors);
     m_boundaryBoxMin.elementMul(a_scaleFactors);
+
+    // update collision tree
+    refitCollisionDetector(false);
 }
 
 
@@ -1694,19 +1722,26 @@ void cMesh::createTriangleNeighborList(bool a_affectChildren)
 
 //===========================================================================
 /*!
-     Set up an AABB collision detector for this mesh and (optionally) its children
+     Set up an AABB collision detector for this mesh and (optionally) its children.
+     The flat tree (cCollisionAABBFlat) stores its nodes and a copy of the
+     vertices in compact arrays, which is faster on large meshes; like the
+     other trees, it is updated with refitCollisionDetector() whenever the
+     vertices of the mesh are modified.
 
      \fn       void cMesh::createAABBCollisionDetector(double a_radius,
                                         bool a_affectChildren,
-                                        bool a_useNeighbors)
+                                        bool a_useNeighbors,
+                                        bool a_useFlatTree)
 	 \param	   a_radius  Bounding radius.
      \param    a_affectChildren   Create collision detectors for children?
      \param    a_useNeighbors     Create neighbor lists?
+     \param    a_useFlatTree      Use the flat tree layout?
 */
 //===========================================================================
 void cMesh::createAABBCollisionDetector(double a_radius,
                                         bool a_affectChildren,
-                                        bool a_useNeighbors)
+                                        bool a_useNeighbors,
+                                        bool a_useFlatTree)
 {
     // delete previous collision detector
     if (m_collisionDetector != NULL)
@@ -1716,10 +1751,20 @@ void cMesh::createAABBCollisionDetector(double a_radius,
     }
 
     // create AABB collision detector
-    cCollisionAABB* collisionDetectorAABB =
-                         new cCollisionAABB(pTriangles(), a_useNeighbors);
-    collisionDetectorAABB->initialize(a_radius);
-    m_collisionDetector = collisionDetectorAABB;
+    if (a_useFlatTree)
+    {
+        cCollisionAABBFlat* collisionDetectorAABB =
+                             new cCollisionAABBFlat(pTriangles(), a_useNeighbors);
+        collisionDetectorAABB->initialize(a_radius);
+        m_collisionDetector = collisionDetectorAABB;
+    }
+    else
+    {
+        cCollisionAABB* collisionDetectorAABB =
+                             new cCollisionAABB(pTriangles(), a_useNeighbors);
+        collisionDetectorAABB->initialize(a_radius);
+        m_collisionDetector = collisionDetectorAABB;
+    }
 
     // create neighbor lists
     if (a_useNeighbors)
@@ -1740,7 +1785,8 @@ void cMesh::createAABBCollisionDetector(double a_radius,
             {
                 nextMesh->createAABBCollisionDetector(a_radius,
                                                       a_affectChildren,
-                                                      a_useNeighbors);
+                                                      a_useNeighbors,
+                                                      a_useFlatTree);
             }
         }
     }
@@ -1801,6 +1847,42 @@ void cMesh::createSphereTreeCollisionDetector(double a_radius,
 }
 
 
+//===========================================================================
+/*!
+     Update the collision detector of this mesh after its vertices have been
+     moved. Collision trees are refitted in place when the detector supports
+     it, and are otherwise rebuilt.
+
+     \fn     void cMesh::refitCollisionDetector(const bool a_affectChildren)
+     \param    a_affectChildren   Update collision detectors of children?
+*/
+//===========================================================================
+void cMesh::refitCollisionDetector(const bool a_affectChildren)
+{
+    if (m_collisionDetector != NULL)
+    {
+        if (!m_collisionDetector->refit())
+        {
+            m_collisionDetector->initialize();
+        }
+    }
+
+    // update children if required
+    if (a_affectChildren)
+    {
+        for (unsigned int i=0; i<m_children.size(); i++)
+        {
+            cGenericObject *nextObject = m_children[i];
+            cMesh *nextMesh = dynamic_cast<cMesh*>(nextObject);
+            if (nextMesh)
+            {
+                nextMesh->refitCollisionDetector(a_affectChildren);
+            }
+        }
+    }
+}
+
+
 //===========================================================================
 /*!
      Render this mesh in OpenGL.  This method actually just prepares some
@@ -1837,15 +1919,70 @@ void cMesh::render(const int a_renderMode)
         return;
     }
 
+    // select the level of detail from the size of the mesh on screen
+    m_renderedLevel = selectLevelOfDetail();
+
     // render triangle mesh
     renderMesh(a_renderMode);
 }
 
 
+//===========================================================================
+/*!
+     This enables the use of vertex buffer objects for mesh rendering.
+     Vertices and triangles are copied once to the graphics card, and the
+     whole mesh is drawn with a single call (see cVertexBuffer). Display
+     lists and vertex arrays are then ignored. If the OpenGL context does
+     not support vertex buffer objects, the mesh is rendered as if this
+     option was disabled.
+
+     As with display lists, changes to vertex positions, normals, colors
+     or texture coordinates do not take effect until they are copied again.
+     Call markVerticesModified() with the range of modified vertices to
+     copy only those, or invalidateDisplayList() to copy the whole mesh.
+     Triangles and the number of vertices are checked at each rendering.
+
+     \fn       void cMesh::useBufferObjects(const bool a_useBufferObjects,
+                                         const bool a_affectChildren)
+     \param    a_useBufferObjects  If \b true, this mesh will be rendered with vertex buffer objects
+     \param    a_affectChildren  If \b true, then children also modified.
+*/
+//===========================================================================
+void cMesh::useBufferObjects(const bool a_useBufferObjects, const bool a_affectChildren)
+{
+    // vertices may have changed while buffers were not used
+    if (a_useBufferObjects && !m_useBufferObjects)
+    {
+        m_vertexBuffer.invalidate();
+    }
+
+    // update changes to object
+    m_useBufferObjects = a_useBufferObjects;
+
+    // propagate changes to children
+    if (a_affectChildren)
+    {
+        unsigned int i, numItems;
+        numItems = m_children.size();
+        for (i=0; i<numItems; i++)
+        {
+            cGenericObject *nextObject = m_children[i];
+
+            cMesh *nextMesh = dynamic_cast<cMesh*>(nextObject);
+            if (nextMesh)
+            {
+                nextMesh->useBufferObjects(a_useBufferObjects, a_affectChildren);
+            }
+        }
+    }
+}
+
+
 //===========================================================================
 /*!
      Invalidate any existing display lists.  You should call this on if you're using
      display lists and you modify mesh options, vertex positions, etc.
+     Vertex buffer objects are filled again on the next rendering.
 
      \fn       void cMesh::invalidateDisplayList(const bool a_affectChildren=true)
      \param    a_affectChildren  If \b true all children are updated
@@ -1860,6 +1997,9 @@ void cMesh::invalidateDisplayList(const bool a_affectChildren)
         m_displayList = -1;
     }
 
+    // Copy all vertices and triangles to my vertex buffer objects
+    m_vertexBuffer.invalidate();
+
     // Propagate the operation to my children
     if (a_affectChildren)
     {
@@ -1996,12 +2136,32 @@ void cMesh::renderMesh(const int a_renderMode)
     // we are not currently creating a display list
     bool creating_display_list = false;
 
+    // vertex buffer objects replace display lists and vertex arrays
+    bool use_buffer_objects = (m_useBufferObjects && cVertexBuffer::isSupported());
+
+    // triangles of the simplified level of detail, if one is rendered
+    const vector<unsigned int>* level_indices = NULL;
+    if ((m_renderedLevel > 0) && (m_renderedLevel <= m_levels.size()))
+    {
+        level_indices = &m_levels[m_renderedLevel-1].m_indices;
+    }
+
+    // render queue holding the OpenGL state left by the previous mesh, if
+    // any; display lists record and restore the whole state themselves
+    cRenderQueue* queue = cRenderQueue::getCurrent();
+    if ((queue != NULL) && (m_useDisplayList) && (!use_buffer_objects) && (level_indices == NULL))
+    {
+        queue->invalidateState();
+        queue = NULL;
+    }
+
 
     //-----------------------------------------------------------------------
     // DISPLAY LIST
     //-----------------------------------------------------------------------
-    // Should we render with a display list?
-    if (m_useDisplayList)
+    // Should we render with a display list? Display lists hold the full
+    // resolution mesh only
+    if ((m_useDisplayList) && (!use_buffer_objects) && (level_indices == NULL))
     {
         // If the display list doesn't exist, create it
         if (m_displayList == -1)
@@ -2035,10 +2195,13 @@ void cMesh::renderMesh(const int a_renderMode)
     // RENDERING WITH VERTEX ARRAYS OR CLASSIC OPENGL CALLS
     //-----------------------------------------------------------------------
 
-    glDisableClientState(GL_COLOR_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-    glDisableClientState(GL_INDEX_ARRAY);
-    glDisableClientState(GL_EDGE_FLAG_ARRAY);
+    if ((queue == NULL) || (!queue->getClientStatesDisabled()))
+    {
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_INDEX_ARRAY);
+        glDisableClientState(GL_EDGE_FLAG_ARRAY);
+    }
 
     if (m_useVertexArrays)
     {
@@ -2051,7 +2214,10 @@ void cMesh::renderMesh(const int a_renderMode)
     /////////////////////////////////////////////////////////////////////////
     if (m_useMaterialProperty)
     {
-        m_material.render();
+        if ((queue == NULL) || (queue->setMaterial(&m_material)))
+        {
+            m_material.render();
+        }
     }
 
 
@@ -2060,6 +2226,9 @@ void cMesh::renderMesh(const int a_renderMode)
     /////////////////////////////////////////////////////////////////////////
     if (m_useVertexColors)
     {
+        // vertex colors replace the ambient and diffuse material colors
+        if (queue != NULL) { queue->invalidateMaterial(); }
+
         // Clear the effects of material properties...
         if (!m_useMaterialProperty)
         {
@@ -2089,6 +2258,7 @@ void cMesh::renderMesh(const int a_renderMode)
     // material properties (otherwise they're invisible)...
     if ((!m_useVertexColors) && (!m_useMaterialProperty))
     {
+        if (queue != NULL) { queue->invalidateMaterial(); }
         glEnable(GL_COLOR_MATERIAL);
         glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
         glColor4f(1,1,1,1);
@@ -2104,14 +2274,58 @@ void cMesh::renderMesh(const int a_renderMode)
         {
             glEnableClientState(GL_TEXTURE_COORD_ARRAY);
         }
-        m_texture->render();
+        if ((queue == NULL) || (queue->setTexture(m_texture)))
+        {
+            m_texture->render();
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////
+    // RENDER TRIANGLES WITH VERTEX BUFFER OBJECTS
+    /////////////////////////////////////////////////////////////////////////
+    if (use_buffer_objects)
+    {
+        // copy modified vertices and triangles, then draw all triangles at once
+        m_vertexBuffer.render(*pVertices(), m_triangles,
+                              m_useVertexColors, m_useTextureMapping,
+                              level_indices);
     }
 
+    /////////////////////////////////////////////////////////////////////////
+    // RENDER TRIANGLES OF A SIMPLIFIED LEVEL OF DETAIL
+    /////////////////////////////////////////////////////////////////////////
+    else if (level_indices != NULL)
+    {
+        // Where does our vertex array live?
+        vector<cVertex>* vertex_vector = pVertices();
+
+        // variables
+        unsigned int i;
+        unsigned int numItems = (unsigned int)level_indices->size();
+
+        // begin rendering triangles
+        glBegin(GL_TRIANGLES);
+
+        // render the vertices of all triangles of the level
+        for(i=0; i<numItems; i++)
+        {
+            cVertex* v = &(*vertex_vector)[(*level_indices)[i]];
+
+            glNormal3dv(&v->m_normal.x);
+            if (m_useVertexColors) { glColor4fv(v->m_color.pColor()); }
+            if (m_useTextureMapping) { glTexCoord2dv(&v->m_texCoord.x); }
+            glVertex3dv(&v->m_localPos.x);
+        }
+
+        // finalize rendering list of triangles
+        glEnd();
+    }
 
     /////////////////////////////////////////////////////////////////////////
     // RENDER TRIANGLES WITH VERTEX ARRAYS
     /////////////////////////////////////////////////////////////////////////
-    if (m_useVertexArrays)
+    else if (m_useVertexArrays)
     {
         // Where does our vertex array live?
         vector<cVertex>* vertex_vector = pVertices();
@@ -2284,6 +2498,7 @@ void cMesh::renderMesh(const int a_renderMode)
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_COLOR_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    if (queue != NULL) { queue->setClientStatesDisabled(true); }
 
     // If we've gotten this far and we're using a display list for rendering,
     // we must be capturing it right now...
@@ -2299,6 +2514,207 @@ void cMesh::renderMesh(const int a_renderMode)
 }
 
 
+//===========================================================================
+/*!
+    Get the number of triangles submitted to OpenGL by render(). With
+    vertex buffer objects, only allocated triangles are drawn. With levels
+    of detail, only the triangles of the level rendered last are counted.
+
+    \fn     unsigned int cMesh::getNumRenderedTriangles() const
+    \return Return the number of triangles.
+*/
+//===========================================================================
+unsigned int cMesh::getNumRenderedTriangles() const
+{
+    if ((m_renderedLevel > 0) && (m_renderedLevel <= m_levels.size()))
+    {
+        return ((unsigned int)m_levels[m_renderedLevel-1].m_indices.size() / 3);
+    }
+    if (m_useBufferObjects && (m_vertexBuffer.getNumIndices() > 0))
+    {
+        return (m_vertexBuffer.getNumIndices() / 3);
+    }
+    return ((unsigned int)m_triangles.size());
+}
+
+
+//===========================================================================
+/*!
+    A mesh may be reordered by a render queue, and share its material and
+    texture with the previous mesh, unless it also renders its normals,
+    reference frame, boundary box or trees (see cRenderQueue).
+
+    \fn     bool cMesh::isRenderSortable() const
+    \return Return \b true if the mesh only renders its triangles.
+*/
+//===========================================================================
+bool cMesh::isRenderSortable() const
+{
+    return ((!m_showNormals) && (!m_showFrame) && (!m_showBox) &&
+            (!m_showTree) && (!m_showCollisionTree));
+}
+
+
+//===========================================================================
+/*!
+     Build a chain of simplified levels of detail of this mesh, by quadric
+     error edge collapse (see cMeshSimplifier). Each level has \e a_ratio
+     times as many triangles as the previous one, and only uses vertices of
+     this mesh, so that texture coordinates, normals and colors, including
+     their seams, are preserved, and changes to the vertices apply to all
+     levels.
+
+     Levels only affect rendering: the collision detector keeps using the
+     full resolution triangles. render() selects the coarsest level whose
+     error, projected on screen, is at most the tolerance set by
+     setLevelOfDetailTolerance(); the boundary box of the mesh must then be
+     kept up to date with computeBoundaryBox(). Levels are deleted when
+     triangles are added or removed.
+
+     \fn       void cMesh::createLevelsOfDetail(const unsigned int a_numLevels,
+                                               const double a_ratio,
+                                               const bool a_affectChildren)
+     \param    a_numLevels  Number of simplified levels.
+     \param    a_ratio  Fraction of the triangles kept by each level.
+     \param    a_affectChildren  If \b true, then children also modified.
+*/
+//===========================================================================
+void cMesh::createLevelsOfDetail(const unsigned int a_numLevels,
+                                 const double a_ratio,
+                                 const bool a_affectChildren)
+{
+    // build levels
+    cMeshSimplifier simplifier;
+    simplifier.simplify(*pVertices(), m_triangles, a_numLevels, a_ratio, m_levels);
+    m_renderedLevel = 0;
+
+    // propagate changes to children
+    if (a_affectChildren)
+    {
+        unsigned int i, numItems;
+        numItems = m_children.size();
+        for (i=0; i<numItems; i++)
+        {
+            cGenericObject *nextObject = m_children[i];
+
+            cMesh *nextMesh = dynamic_cast<cMesh*>(nextObject);
+            if (nextMesh)
+            {
+                nextMesh->createLevelsOfDetail(a_numLevels, a_ratio, a_affectChildren);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+     Delete the simplified levels of detail of this mesh, which is then
+     always rendered at full resolution.
+
+     \fn       void cMesh::deleteLevelsOfDetail(const bool a_affectChildren)
+     \param    a_affectChildren  If \b true, then children also modified.
+*/
+//===========================================================================
+void cMesh::deleteLevelsOfDetail(const bool a_affectChildren)
+{
+    m_levels.clear();
+    m_renderedLevel = 0;
+
+    // propagate changes to children
+    if (a_affectChildren)
+    {
+        unsigned int i, numItems;
+        numItems = m_children.size();
+        for (i=0; i<numItems; i++)
+        {
+            cGenericObject *nextObject = m_children[i];
+
+            cMesh *nextMesh = dynamic_cast<cMesh*>(nextObject);
+            if (nextMesh)
+            {
+                nextMesh->deleteLevelsOfDetail(a_affectChildren);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+     Set the largest error of the levels of detail rendered, measured in
+     pixels on screen. The default tolerance of one pixel renders levels
+     which are hardly distinguishable from the full resolution mesh; zero
+     always renders the full resolution mesh.
+
+     \fn       void cMesh::setLevelOfDetailTolerance(const double a_pixels,
+                                                    const bool a_affectChildren)
+     \param    a_pixels  Largest error, in pixels.
+     \param    a_affectChildren  If \b true, then children also modified.
+*/
+//===========================================================================
+void cMesh::setLevelOfDetailTolerance(const double a_pixels, const bool a_affectChildren)
+{
+    m_levelOfDetailTolerance = a_pixels;
+
+    // propagate changes to children
+    if (a_affectChildren)
+    {
+        unsigned int i, numItems;
+        numItems = m_children.size();
+        for (i=0; i<numItems; i++)
+        {
+            cGenericObject *nextObject = m_children[i];
+
+            cMesh *nextMesh = dynamic_cast<cMesh*>(nextObject);
+            if (nextMesh)
+            {
+                nextMesh->setLevelOfDetailTolerance(a_pixels, a_affectChildren);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+     Select the level of detail to render. The error of each level is
+     projected on screen at the point of the bounding sphere of the mesh
+     closest to the eye, using the view axis and projected scale held by
+     the frustum of the rendering pass (see renderObject()), which the
+     camera computes once per frame. Without a frustum, the full
+     resolution mesh is rendered.
+
+     \fn       unsigned int cMesh::selectLevelOfDetail() const
+     \return   Return the coarsest level whose error is within tolerance,
+               or 0 for the full resolution mesh.
+*/
+//===========================================================================
+unsigned int cMesh::selectLevelOfDetail() const
+{
+    if (m_levels.empty() || (m_levelOfDetailTolerance <= 0.0) ||
+        (m_renderFrustum == NULL)) { return (0); }
+
+    // pixels per unit of length at the closest point of the bounding sphere
+    cVector3d center = getBoundaryCenter();
+    double radius = 0.5 * cDistance(m_boundaryBoxMin, m_boundaryBoxMax);
+    double distance = m_renderFrustum->getDepth(center) - radius;
+    if (m_renderFrustum->m_perspective && (distance <= 0.0)) { return (0); }
+    double pixels = m_renderFrustum->getPixelsPerUnit(distance);
+    if (pixels <= 0.0) { return (0); }
+
+    // coarsest level within tolerance
+    unsigned int level = 0;
+    while ((level < m_levels.size()) &&
+           (m_levels[level].m_error * pixels <= m_levelOfDetailTolerance))
+    {
+        level++;
+    }
+
+    return (level);
+}
+
+
 //===========================================================================
 /*!
     Users can call this function when it's necessary to re-initialize the OpenGL
@@ -2312,6 +2728,7 @@ void cMesh::renderMesh(const int a_renderMode)
 void cMesh::onDisplayReset(const bool a_affectChildren)
 {
     invalidateDisplayList();
+    m_vertexBuffer.release();
     if (m_texture != NULL) m_texture->markForUpdate();
 
     // Use the superclass method to call the same function on the rest of the
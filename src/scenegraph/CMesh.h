@@ -32,6 +32,8 @@
 #include "graphics/CMaterial.h"
 #include "graphics/CTexture2D.h"
 #include "graphics/CColor.h"
+#include "graphics/CVertexBuffer.h"
+#include "graphics/CMeshSimplifier.h"
 #include <vector>
 #include <list>
 //---------------------------------------------------------------------------
@@ -177,6 +179,18 @@ class cMesh : public cGenericObject
     //! Enable or disable the use vertex arrays for rendering, optionally propagating the operation to my children.
     void useVertexArrays(const bool a_useVertexArrays, const bool a_affectChildren=true);
 
+    //! Enable or disable the use of vertex buffer objects for rendering, optionally propagating the operation to my children.
+    void useBufferObjects(const bool a_useBufferObjects, const bool a_affectChildren=true);
+
+    //! Ask whether I'm currently rendering with vertex buffer objects, when supported.
+    bool getBufferObjectsEnabled() const { return m_useBufferObjects; }
+
+    //! Mark a range of my vertices as modified, so that only they are copied to the vertex buffer objects.
+    void markVerticesModified(const unsigned int a_first, const unsigned int a_count) { m_vertexBuffer.markModified(a_first, a_count); }
+
+    //! Access my vertex buffer objects.
+    cVertexBuffer* getVertexBuffer() { return (&m_vertexBuffer); }
+
     //! Ask whether I'm currently rendering with a display list.
     bool getDisplayListEnabled() const { return m_useDisplayList; }
 
@@ -198,6 +212,37 @@ class cMesh : public cGenericObject
     //! Re-initializes textures and display lists.
     virtual void onDisplayReset(const bool a_affectChildren = true);
 
+    //! Return \b true if a render queue may reorder this mesh and share OpenGL state with it.
+    virtual bool isRenderSortable() const;
+
+
+    //-----------------------------------------------------------------------
+    // METHODS - LEVELS OF DETAIL:
+    //-----------------------------------------------------------------------
+
+    //! Build simplified levels of detail for rendering, optionally propagating the operation to my children.
+    void createLevelsOfDetail(const unsigned int a_numLevels=4,
+                              const double a_ratio=0.5,
+                              const bool a_affectChildren=true);
+
+    //! Delete my levels of detail, optionally propagating the operation to my children.
+    void deleteLevelsOfDetail(const bool a_affectChildren=true);
+
+    //! Get the number of simplified levels of detail.
+    unsigned int getNumLevelsOfDetail() const { return ((unsigned int)m_levels.size()); }
+
+    //! Access a simplified level of detail, from 1 (the finest) to getNumLevelsOfDetail().
+    const cMeshLevel& getLevelOfDetail(const unsigned int a_level) const { return (m_levels[a_level-1]); }
+
+    //! Set the largest error on screen, in pixels, of the levels of detail rendered, optionally propagating the operation to my children.
+    void setLevelOfDetailTolerance(const double a_pixels, const bool a_affectChildren=true);
+
+    //! Get the largest error on screen, in pixels, of the levels of detail rendered.
+    double getLevelOfDetailTolerance() const { return (m_levelOfDetailTolerance); }
+
+    //! Get the level of detail rendered last, 0 being the full resolution mesh.
+    unsigned int getRenderedLevelOfDetail() const { return (m_renderedLevel); }
+
 
     //-----------------------------------------------------------------------
     // METHODS - COLLISION DETECTION:
@@ -207,11 +252,15 @@ class cMesh : public cGenericObject
     virtual void createBruteForceCollisionDetector(bool a_affectChildren, bool a_useNeighbors);
 
     //! Set up an AABB collision detector for this mesh and (optionally) its children.
-    virtual void createAABBCollisionDetector(double a_radius, bool a_affectChildren, bool a_useNeighbors);
+    virtual void createAABBCollisionDetector(double a_radius, bool a_affectChildren, bool a_useNeighbors,
+                                             bool a_useFlatTree = false);
 
     //! Set up a sphere tree collision detector for this mesh and (optionally) its children.
     virtual void createSphereTreeCollisionDetector(double a_radius, bool a_affectChildren, bool a_useNeighbors);
 
+    //! Update the collision detector of this mesh and (optionally) its children after vertices have moved.
+    void refitCollisionDetector(const bool a_affectChildren=false);
+
     //! Create a lists for neighbor triangles for each triangle of the mesh.
     void createTriangleNeighborList(bool a_affectChildren);
 
@@ -267,6 +316,9 @@ class cMesh : public cGenericObject
     //! Render the mesh itself.
     virtual void render(const int a_renderMode=0);
 
+    //! Get the number of triangles submitted to OpenGL by render(), for rendering statistics.
+    virtual unsigned int getNumRenderedTriangles() const;
+
     //! Draw a small line for each vertex normal.
     virtual void renderNormals(const bool a_trianglesOnly=true);
 
@@ -276,6 +328,9 @@ class cMesh : public cGenericObject
     //! Update my boundary box dimensions based on my vertices.
     virtual void updateBoundaryBox();
 
+    //! Select the level of detail to render from the view frustum of the rendering pass.
+    unsigned int selectLevelOfDetail() const;
+
 
     //-----------------------------------------------------------------------
     // MEMBERS - DISPLAY PROPERTIES:
@@ -305,6 +360,21 @@ class cMesh : public cGenericObject
     //! The openGL display list used to draw this mesh, if display lists are enabled.
     int m_displayList;
 
+    //! Should we use vertex buffer objects to render this mesh?
+    bool m_useBufferObjects;
+
+    //! The vertex buffer objects used to draw this mesh, if they are enabled.
+    cVertexBuffer m_vertexBuffer;
+
+    //! Simplified levels of detail, from the finest to the coarsest.
+    vector<cMeshLevel> m_levels;
+
+    //! Largest error on screen, in pixels, of the levels of detail rendered.
+    double m_levelOfDetailTolerance;
+
+    //! Level of detail rendered last, 0 being the full resolution mesh.
+    unsigned int m_renderedLevel;
+
 
     //-----------------------------------------------------------------------
     // MEMBERS - ARRAYS:
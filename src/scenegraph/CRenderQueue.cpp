@@ -0,0 +1,356 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "scenegraph/CRenderQueue.h"
+#include "scenegraph/CGenericObject.h"
+//---------------------------------------------------------------------------
+#include <algorithm>
+#include <functional>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Queue rendering a sorted mesh
+cRenderQueue* cRenderQueue::m_current = NULL;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Compare the OpenGL properties of two materials, in an arbitrary but
+    consistent order. A missing material comes first.
+
+    \fn       static int cCompareMaterials(const cMaterial* a_material0,
+                                           const cMaterial* a_material1)
+    \param    a_material0  First material, or NULL.
+    \param    a_material1  Second material, or NULL.
+    \return   Return -1, 0 or 1 if the first material comes before, with
+              or after the second one.
+*/
+//===========================================================================
+static int cCompareMaterials(const cMaterial* a_material0,
+                             const cMaterial* a_material1)
+{
+    if (a_material0 == a_material1) { return (0); }
+    if (a_material0 == NULL) { return (-1); }
+    if (a_material1 == NULL) { return (1); }
+
+    const float* colors0[4] = { a_material0->m_ambient.pColor(),
+                                a_material0->m_diffuse.pColor(),
+                                a_material0->m_specular.pColor(),
+                                a_material0->m_emission.pColor() };
+    const float* colors1[4] = { a_material1->m_ambient.pColor(),
+                                a_material1->m_diffuse.pColor(),
+                                a_material1->m_specular.pColor(),
+                                a_material1->m_emission.pColor() };
+
+    for (int i=0; i<4; i++)
+    {
+        for (int j=0; j<4; j++)
+        {
+            if (colors0[i][j] < colors1[i][j]) { return (-1); }
+            if (colors0[i][j] > colors1[i][j]) { return (1); }
+        }
+    }
+
+    if (a_material0->getShininess() < a_material1->getShininess()) { return (-1); }
+    if (a_material0->getShininess() > a_material1->getShininess()) { return (1); }
+
+    return (0);
+}
+
+
+//===========================================================================
+/*!
+    \struct     cRenderQueueOrder
+    \ingroup    scenegraph
+
+    \brief
+    cRenderQueueOrder compares the indices of two objects of a render
+    queue by the order in which they are rendered.
+*/
+//===========================================================================
+struct cRenderQueueOrder
+{
+    //! Constructor of cRenderQueueOrder.
+    cRenderQueueOrder(const vector<cRenderQueueItem>& a_items) : m_items(a_items) {}
+
+    //! Return \b true if the first object is rendered before the second one.
+    bool operator()(const unsigned int a_index0, const unsigned int a_index1) const
+    {
+        const cRenderQueueItem& item0 = m_items[a_index0];
+        const cRenderQueueItem& item1 = m_items[a_index1];
+
+        if (item0.m_group != item1.m_group) { return (item0.m_group < item1.m_group); }
+
+        // opaque meshes: by texture, by material, then from front to back
+        if (item0.m_group == CHAI_RENDER_QUEUE_OPAQUE)
+        {
+            if (item0.m_texture != item1.m_texture)
+            {
+                return (std::less<cTexture2D*>()(item0.m_texture, item1.m_texture));
+            }
+
+            int material = cCompareMaterials(item0.m_material, item1.m_material);
+            if (material != 0) { return (material < 0); }
+
+            if (item0.m_depth != item1.m_depth) { return (item0.m_depth < item1.m_depth); }
+        }
+
+        // transparent meshes: from back to front
+        else if (item0.m_group == CHAI_RENDER_QUEUE_TRANSPARENT)
+        {
+            if (item0.m_depth != item1.m_depth) { return (item0.m_depth > item1.m_depth); }
+        }
+
+        // otherwise, keep the order of the scene graph
+        return (item0.m_order < item1.m_order);
+    }
+
+    //! Objects of the render queue.
+    const vector<cRenderQueueItem>& m_items;
+};
+
+
+//===========================================================================
+/*!
+    Constructor of cRenderQueue.
+
+    \fn       cRenderQueue::cRenderQueue()
+*/
+//===========================================================================
+cRenderQueue::cRenderQueue()
+{
+    m_statistics = NULL;
+    m_currentMaterial = NULL;
+    m_currentTexture = NULL;
+    m_clientStatesDisabled = false;
+}
+
+
+//===========================================================================
+/*!
+    Remove all objects from the queue. Memory is kept for the next frame.
+
+    \fn       void cRenderQueue::clear()
+*/
+//===========================================================================
+void cRenderQueue::clear()
+{
+    m_items.clear();
+    m_sortedItems.clear();
+}
+
+
+//===========================================================================
+/*!
+    Add an object to the queue. Objects which are not sortable (see
+    cGenericObject::isRenderSortable()) keep the order in which they are
+    added. The depth of sortable meshes is measured at the center of their
+    boundary box; hidden sortable meshes render nothing and are not added.
+    The view frustum is passed on to the object when it is rendered.
+
+    \fn       void cRenderQueue::add(cGenericObject* a_object,
+                                     const cMatrixGL& a_modelview,
+                                     const cFrustum* a_frustum)
+    \param    a_object  Object to render.
+    \param    a_modelview  Modelview matrix of the object.
+    \param    a_frustum  View frustum in the frame of the object, or NULL.
+*/
+//===========================================================================
+void cRenderQueue::add(cGenericObject* a_object, const cMatrixGL& a_modelview,
+                       const cFrustum* a_frustum)
+{
+    cRenderQueueItem item;
+    item.m_object = a_object;
+    item.m_modelview = a_modelview;
+    item.m_useFrustum = (a_frustum != NULL);
+    if (a_frustum != NULL)
+    {
+        item.m_frustum = *a_frustum;
+    }
+    item.m_group = CHAI_RENDER_QUEUE_UNSORTED;
+    item.m_texture = NULL;
+    item.m_material = NULL;
+    item.m_depth = 0.0;
+    item.m_order = (unsigned int)m_items.size();
+
+    if (a_object->isRenderSortable())
+    {
+        if (!a_object->getShowEnabled()) { return; }
+
+        item.m_group = a_object->getUseTransparency() ? CHAI_RENDER_QUEUE_TRANSPARENT :
+                                                        CHAI_RENDER_QUEUE_OPAQUE;
+
+        if (a_object->getUseTexture())
+        {
+            item.m_texture = a_object->getTexture();
+        }
+
+        if (a_object->getUseMaterial())
+        {
+            item.m_material = &a_object->m_material;
+        }
+
+        // the view axis is the negative z axis of eye coordinates
+        cVector3d center = a_object->getBoundaryCenter();
+        const double* m = a_modelview.pMatrix();
+        item.m_depth = -(m[2] * center.x + m[6] * center.y + m[10] * center.z + m[14]);
+    }
+
+    m_items.push_back(item);
+}
+
+
+//===========================================================================
+/*!
+    Sort the objects of the queue in the order they are rendered: objects
+    which are not sortable first, then opaque meshes, then transparent
+    meshes (see cRenderQueue).
+
+    \fn       void cRenderQueue::sort()
+*/
+//===========================================================================
+void cRenderQueue::sort()
+{
+    unsigned int numItems = (unsigned int)m_items.size();
+    m_sortedItems.resize(numItems);
+    for (unsigned int i=0; i<numItems; i++)
+    {
+        m_sortedItems[i] = i;
+    }
+
+    std::sort(m_sortedItems.begin(), m_sortedItems.end(), cRenderQueueOrder(m_items));
+}
+
+
+//===========================================================================
+/*!
+    Render the sorted objects of the queue, each one after loading its
+    modelview matrix. Opaque meshes are skipped by the transparent passes,
+    and transparent meshes by the opaque pass, since they would render
+    nothing. The modelview matrix must be restored by the caller.
+
+    \fn       void cRenderQueue::render(const int a_renderMode)
+    \param    a_renderMode  Rendering mode (see cGenericObject).
+*/
+//===========================================================================
+void cRenderQueue::render(const int a_renderMode)
+{
+    invalidateState();
+
+    unsigned int numItems = (unsigned int)m_sortedItems.size();
+    for (unsigned int i=0; i<numItems; i++)
+    {
+        cRenderQueueItem& item = m_items[m_sortedItems[i]];
+
+        if ((item.m_group == CHAI_RENDER_QUEUE_OPAQUE) &&
+            ((a_renderMode == CHAI_RENDER_MODE_TRANSPARENT_BACK_ONLY) ||
+             (a_renderMode == CHAI_RENDER_MODE_TRANSPARENT_FRONT_ONLY)))
+        {
+            continue;
+        }
+
+        if ((item.m_group == CHAI_RENDER_QUEUE_TRANSPARENT) &&
+            (a_renderMode == CHAI_RENDER_MODE_NON_TRANSPARENT_ONLY))
+        {
+            continue;
+        }
+
+        // only sorted meshes share OpenGL state with the previous object
+        bool sorted = (item.m_group != CHAI_RENDER_QUEUE_UNSORTED);
+
+        item.m_modelview.glMatrixLoad();
+        m_current = sorted ? this : NULL;
+        item.m_object->renderObject(a_renderMode, m_statistics,
+                                    item.m_useFrustum ? &item.m_frustum : NULL);
+        m_current = NULL;
+
+        // restore settings
+        glDisable(GL_CULL_FACE);
+
+        if (!sorted)
+        {
+            invalidateState();
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Called by a mesh before sending its material to OpenGL. The material
+    need not be sent if its properties equal those of the current material.
+
+    \fn       bool cRenderQueue::setMaterial(const cMaterial* a_material)
+    \param    a_material  Material of the mesh.
+    \return   Return \b true if the material must be sent to OpenGL.
+*/
+//===========================================================================
+bool cRenderQueue::setMaterial(const cMaterial* a_material)
+{
+    if ((m_currentMaterial != NULL) &&
+        (cCompareMaterials(m_currentMaterial, a_material) == 0))
+    {
+        if (m_statistics != NULL) { m_statistics->m_numSkippedMaterials++; }
+        return (false);
+    }
+
+    m_currentMaterial = a_material;
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Called by a mesh before binding its texture. The texture need not be
+    bound again if it is the current texture, since meshes without
+    texture leave texture parameters and bindings unchanged.
+
+    \fn       bool cRenderQueue::setTexture(cTexture2D* a_texture)
+    \param    a_texture  Texture of the mesh.
+    \return   Return \b true if the texture must be bound.
+*/
+//===========================================================================
+bool cRenderQueue::setTexture(cTexture2D* a_texture)
+{
+    if ((m_currentTexture != NULL) && (m_currentTexture == a_texture))
+    {
+        if (m_statistics != NULL) { m_statistics->m_numSkippedTextures++; }
+        return (false);
+    }
+
+    m_currentTexture = a_texture;
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Forget the current material, texture and client arrays, after an
+    object which is not sorted changed the OpenGL state.
+
+    \fn       void cRenderQueue::invalidateState()
+*/
+//===========================================================================
+void cRenderQueue::invalidateState()
+{
+    m_currentMaterial = NULL;
+    m_currentTexture = NULL;
+    m_clientStatesDisabled = false;
+}
@@ -0,0 +1,223 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CRenderQueueH
+#define CRenderQueueH
+//---------------------------------------------------------------------------
+#include "graphics/CMacrosGL.h"
+#include "graphics/CFrustum.h"
+#include <vector>
+//---------------------------------------------------------------------------
+using std::vector;
+//---------------------------------------------------------------------------
+class cGenericObject;
+class cMaterial;
+class cTexture2D;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CRenderQueue.h
+
+    \brief
+    <b> Scenegraph </b> \n
+    Sorted Rendering of Scene Graphs.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Group of the objects rendered first, in the order of the scene graph.
+#define CHAI_RENDER_QUEUE_UNSORTED      0
+
+//! Group of the opaque meshes, sorted by texture, material and from front to back.
+#define CHAI_RENDER_QUEUE_OPAQUE        1
+
+//! Group of the transparent meshes, sorted from back to front.
+#define CHAI_RENDER_QUEUE_TRANSPARENT   2
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cRenderQueueItem
+    \ingroup    scenegraph
+
+    \brief
+    cRenderQueueItem is an object of the scene graph waiting in a
+    cRenderQueue, with its modelview matrix and the keys by which it is
+    sorted.
+*/
+//===========================================================================
+struct cRenderQueueItem
+{
+    //! Object to render.
+    cGenericObject* m_object;
+
+    //! Modelview matrix of the object, from its frame to eye coordinates.
+    cMatrixGL m_modelview;
+
+    //! View frustum in the frame of the object, if m_useFrustum is \b true.
+    cFrustum m_frustum;
+
+    //! If \b true, the object was culled against m_frustum.
+    bool m_useFrustum;
+
+    //! Group of the object (CHAI_RENDER_QUEUE_UNSORTED, _OPAQUE or _TRANSPARENT).
+    int m_group;
+
+    //! Texture of the mesh, or NULL if texture mapping is disabled.
+    cTexture2D* m_texture;
+
+    //! Material of the mesh, or NULL if material properties are disabled.
+    const cMaterial* m_material;
+
+    //! Distance from the eye to the center of the boundary box of the object, along the view axis.
+    double m_depth;
+
+    //! Position of the object in the scene graph traversal.
+    unsigned int m_order;
+};
+
+
+//===========================================================================
+/*!
+    \class      cRenderQueue
+    \ingroup    scenegraph
+
+    \brief
+    cRenderQueue renders the objects of a scene graph sorted by OpenGL
+    state rather than in the order of the scene graph. \n
+
+    Objects are added with their modelview matrix by a traversal of the
+    scene graph (see cGenericObject::queueSceneGraph()), then sorted once
+    by sort() and rendered by one call to render() per rendering pass. \n
+
+    Meshes whose rendering only depends on their own state (see
+    cGenericObject::isRenderSortable()) are reordered: opaque meshes are
+    grouped by texture and material, and from front to back within a
+    group; transparent meshes are rendered last, from back to front. All
+    other objects, such as the world and its light sources, are rendered
+    first in the order of the scene graph. \n
+
+    While a sorted mesh is rendered, the queue is current (see
+    getCurrent()) and remembers the material and texture last sent to
+    OpenGL, so that a mesh sharing them with the previous one does not
+    send them again. The queue forgets them after rendering any other
+    object.
+*/
+//===========================================================================
+class cRenderQueue
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cRenderQueue.
+    cRenderQueue();
+
+    //! Destructor of cRenderQueue.
+    ~cRenderQueue() {};
+
+
+	//-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Remove all objects from the queue.
+    void clear();
+
+    //! Add an object to the queue, given its modelview matrix.
+    void add(cGenericObject* a_object, const cMatrixGL& a_modelview,
+             const cFrustum* a_frustum=NULL);
+
+    //! Sort the objects of the queue.
+    void sort();
+
+    //! Render the objects of the queue for a rendering pass.
+    void render(const int a_renderMode);
+
+    //! Get the number of objects in the queue.
+    unsigned int getNumItems() const { return ((unsigned int)m_items.size()); }
+
+    //! Get the statistics updated by render(), or NULL.
+    cRenderStatistics* getStatistics() const { return (m_statistics); }
+
+    //! Set the statistics updated by render(), or NULL.
+    void setStatistics(cRenderStatistics* a_statistics) { m_statistics = a_statistics; }
+
+
+	//-----------------------------------------------------------------------
+    // METHODS - OPENGL STATE:
+    //-----------------------------------------------------------------------
+
+    //! Get the queue rendering a sorted mesh, or NULL.
+    static cRenderQueue* getCurrent() { return (m_current); }
+
+    //! Return \b true if a material must be sent to OpenGL, and remember it as current.
+    bool setMaterial(const cMaterial* a_material);
+
+    //! Return \b true if a texture must be bound, and remember it as current.
+    bool setTexture(cTexture2D* a_texture);
+
+    //! Forget the current material, after OpenGL material properties were changed.
+    void invalidateMaterial() { m_currentMaterial = NULL; }
+
+    //! Return \b true if client arrays were left disabled by the previous mesh.
+    bool getClientStatesDisabled() const { return (m_clientStatesDisabled); }
+
+    //! Record whether client arrays were left disabled.
+    void setClientStatesDisabled(const bool a_disabled) { m_clientStatesDisabled = a_disabled; }
+
+    //! Forget all current OpenGL state.
+    void invalidateState();
+
+
+  protected:
+
+	//-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Objects of the queue, in the order they were added.
+    vector<cRenderQueueItem> m_items;
+
+    //! Indices of the objects of the queue, in the order they are rendered.
+    vector<unsigned int> m_sortedItems;
+
+    //! Statistics of the rendering passes.
+    cRenderStatistics* m_statistics;
+
+    //! Material last sent to OpenGL, or NULL.
+    const cMaterial* m_currentMaterial;
+
+    //! Texture last bound, or NULL.
+    cTexture2D* m_currentTexture;
+
+    //! If \b true, client arrays were left disabled by the previous mesh.
+    bool m_clientStatesDisabled;
+
+    //! Queue rendering a sorted mesh, or NULL.
+    static cRenderQueue* m_current;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -49,6 +49,10 @@ cWorld::cWorld()
     m_performingDisplayReset = 0;
 
     memset(m_worldModelView,0,sizeof(m_worldModelView));
+
+    // collision detection visits every object by default
+    m_useCollisionBroadphase = false;
+    m_updateCollisionBroadphase = true;
 }
 
 
@@ -405,14 +409,34 @@ bool cWorld::computeCollisionDetection(cVector3d& a_segmentPointA,
     cVector3d segmentPointA = a_segmentPointA;
     cVector3d segmentPointB = a_segmentPointB;
 
-    // check for collisions with all children of this world
-    unsigned int nChildren = m_children.size();
-    for (unsigned int i=0; i<nChildren; i++)
+    if (m_useCollisionBroadphase)
+    {
+        // only check for collisions with the objects whose bounding boxes
+        // are crossed by the segment. The broadphase is refitted to the
+        // global positions computed since the previous call.
+        m_collisionBroadphaseLock.acquire();
+        if (m_updateCollisionBroadphase)
+        {
+            m_updateCollisionBroadphase = false;
+            m_collisionBroadphase.update(this);
+        }
+        hit = m_collisionBroadphase.computeCollision(a_segmentPointA,
+                                                     a_segmentPointB,
+                                                     a_recorder,
+                                                     a_settings);
+        m_collisionBroadphaseLock.release();
+    }
+    else
     {
-        hit = hit | m_children[i]->computeCollisionDetection(a_segmentPointA,
-                                                       a_segmentPointB,
-                                                       a_recorder,
-                                                       a_settings);
+        // check for collisions with all children of this world
+        unsigned int nChildren = m_children.size();
+        for (unsigned int i=0; i<nChildren; i++)
+        {
+            hit = hit | m_children[i]->computeCollisionDetection(a_segmentPointA,
+                                                           a_segmentPointB,
+                                                           a_recorder,
+                                                           a_settings);
+        }
     }
 
     // restore values.
@@ -424,6 +448,102 @@ bool cWorld::computeCollisionDetection(cVector3d& a_segmentPointA,
 }
 
 
+//===========================================================================
+/*!
+    Determine whether a batch of segments intersects any object of this
+    world. Each segment is tested with its own settings and stores its
+    collision events in its own recorder. Objects receive all the segments
+    that may hit them at once, so that their collision detectors can
+    amortize the traversal of their trees over the batch, for instance
+    when selecting many pixels or computing the contacts of several points
+    of a tool.
+
+    \fn     bool cWorld::computeCollisionDetections(vector<cCollisionSegment>& a_segments)
+    \param  a_segments  Segments to test, in world coordinates.
+    \return Return \b true if any segment has collided.
+*/
+//===========================================================================
+bool cWorld::computeCollisionDetections(vector<cCollisionSegment>& a_segments)
+{
+    // temp variable
+    bool hit = false;
+
+    if (m_useCollisionBroadphase)
+    {
+        m_collisionBroadphaseLock.acquire();
+        if (m_updateCollisionBroadphase)
+        {
+            m_updateCollisionBroadphase = false;
+            m_collisionBroadphase.update(this);
+        }
+        hit = m_collisionBroadphase.computeCollisions(a_segments);
+        m_collisionBroadphaseLock.release();
+    }
+    else
+    {
+        // check for collisions with all children of this world
+        unsigned int nChildren = m_children.size();
+        for (unsigned int i=0; i<nChildren; i++)
+        {
+            hit = hit | m_children[i]->computeCollisionDetections(a_segments);
+        }
+    }
+
+    // return whether there was a collision between the segments and this world
+    return (hit);
+}
+
+
+//===========================================================================
+/*!
+    Enable or disable the scene-level broadphase. When enabled,
+    computeCollisionDetection() only calls the collision detectors of the
+    objects whose bounding boxes are crossed by the segment, instead of
+    visiting every object of the world. \n
+
+    The broadphase relies on the global positions of the objects, so
+    computeGlobalPositions() must be called on the world each time objects
+    are moved, added or removed, as is done at every iteration of the haptic
+    loop and by cCamera::select(). The broadphase is then refitted (or
+    rebuilt) by the next call to computeCollisionDetection().
+
+    \fn     void cWorld::setUseCollisionBroadphase(const bool a_useCollisionBroadphase)
+    \param  a_useCollisionBroadphase  If \b true, the broadphase is used.
+*/
+//===========================================================================
+void cWorld::setUseCollisionBroadphase(const bool a_useCollisionBroadphase)
+{
+    m_collisionBroadphaseLock.acquire();
+    m_useCollisionBroadphase = a_useCollisionBroadphase;
+    m_updateCollisionBroadphase = true;
+    if (!m_useCollisionBroadphase)
+    {
+        m_collisionBroadphase.clear();
+    }
+    m_collisionBroadphaseLock.release();
+}
+
+
+//===========================================================================
+/*!
+    Called by computeGlobalPositions() once the position of the world has
+    been updated. The broadphase is marked so that it gets updated by the next
+    collision query, once the global positions of all objects are known.
+    The graphics and haptics threads both compute global positions, so the
+    mark is set under the lock of the broadphase.
+
+    \fn     void cWorld::updateGlobalPositions(const bool a_frameOnly)
+    \param  a_frameOnly  If \b true then only the global frame is computed.
+*/
+//===========================================================================
+void cWorld::updateGlobalPositions(const bool /*a_frameOnly*/)
+{
+    m_collisionBroadphaseLock.acquire();
+    m_updateCollisionBroadphase = true;
+    m_collisionBroadphaseLock.release();
+}
+
+
 //===========================================================================
 /*!
     Called by the user or by the viewport when the world needs to have
@@ -28,6 +28,8 @@
 #include "graphics/CTriangle.h"
 #include "graphics/CTexture2D.h"
 #include "graphics/CColor.h"
+#include "collisions/CCollisionBroadphase.h"
+#include "timers/CMutex.h"
 #include <vector>
 //---------------------------------------------------------------------------
 class cLight;
@@ -115,6 +117,18 @@ class cWorld : public cGenericObject
                                            cCollisionRecorder& a_recorder,
                                            cCollisionSettings& a_settings);
 
+    //! Compute collision detection between a batch of segments and all objects in this world.
+    virtual bool computeCollisionDetections(vector<cCollisionSegment>& a_segments);
+
+    //! Enable or disable the scene-level broadphase for collision detection.
+    void setUseCollisionBroadphase(const bool a_useCollisionBroadphase);
+
+    //! Is the scene-level broadphase used for collision detection?
+    bool getUseCollisionBroadphase() const { return (m_useCollisionBroadphase); }
+
+    //! Get the scene-level broadphase of this world.
+    cCollisionBroadphase* getCollisionBroadphase() { return (&m_collisionBroadphase); }
+
     //! Render OpenGL lights.
     virtual void render(const int a_renderMode=0);
 
@@ -146,6 +160,9 @@ protected:
     //! Remove a light source from this world.
     bool removeLightSource(cLight* a_light);
 
+    //! Mark the broadphase for update when the global positions are recomputed.
+    virtual void updateGlobalPositions(const bool a_frameOnly);
+
 
     //-----------------------------------------------------------------------
     // MEMBERS:
@@ -165,6 +182,18 @@ protected:
     
     //! Some apps may have multiple cameras, which would cause recursion when resetting the display.
     bool m_performingDisplayReset;
+
+    //! Scene-level broadphase over the objects of this world.
+    cCollisionBroadphase m_collisionBroadphase;
+
+    //! If \b true, collision detection is performed through the broadphase.
+    bool m_useCollisionBroadphase;
+
+    //! If \b true, the global positions have changed since the broadphase was last updated.
+    bool m_updateCollisionBroadphase;
+
+    //! Lock held while the broadphase is updated or queried, or marked for update.
+    cMutex m_collisionBroadphaseLock;
 };
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,543 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+
+//---------------------------------------------------------------------------
+#include "CHapticLoop.h"
+#include "CProfiler.h"
+#if defined(_LINUX) || defined(_MACOSX)
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#endif
+#if defined(_MACOSX)
+#include <mach/mach_time.h>
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cHapticLoop. By default, the loop runs at 1 kHz under
+    the SCHED_FIFO policy with priority 80, on any processor, without
+    locking memory.
+
+    \fn		cHapticLoop::cHapticLoop()
+*/
+//===========================================================================
+cHapticLoop::cHapticLoop()
+{
+    m_function = NULL;
+    m_data = NULL;
+
+    // default settings
+    m_frequency = 1000.0;
+    m_policy = CHAI_HAPTIC_LOOP_POLICY_FIFO;
+    m_priority = 80;
+    m_processor = -1;
+    m_lockMemory = false;
+    m_spinTime = 0.00005;
+    m_histogramBinWidth = 0.00001;
+
+    // loop is not running
+    m_running = false;
+    m_quit = false;
+    m_resetStatistics = false;
+    m_memoryLocked = false;
+
+    for (unsigned int i=0; i<3; i++)
+    {
+        clearStatistics(m_statistics[i]);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cHapticLoop. Stops the loop if it is running.
+
+    \fn		cHapticLoop::~cHapticLoop()
+*/
+//===========================================================================
+cHapticLoop::~cHapticLoop()
+{
+    stop();
+}
+
+
+//===========================================================================
+/*!
+    Set the rate at which the loop function is executed.
+
+    \fn		void cHapticLoop::setFrequency(const double a_frequency)
+    \param  a_frequency  Rate of the loop in Hz. Must be positive.
+*/
+//===========================================================================
+void cHapticLoop::setFrequency(const double a_frequency)
+{
+    if (a_frequency > 0.0)
+    {
+        m_frequency = a_frequency;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Set the scheduling policy of the thread of the loop. On Windows, the
+    real-time policies select the time critical thread priority, and the
+    priority value is ignored.
+
+    \fn		void cHapticLoop::setPolicy(const CHapticLoopPolicy a_policy,
+            const int a_priority)
+    \param  a_policy  Scheduling policy.
+    \param  a_priority  Priority of the thread under a real-time policy.
+*/
+//===========================================================================
+void cHapticLoop::setPolicy(const CHapticLoopPolicy a_policy, const int a_priority)
+{
+    m_policy = a_policy;
+    m_priority = a_priority;
+}
+
+
+//===========================================================================
+/*!
+    Set the width of the bins of the jitter and duration histograms.
+
+    \fn		void cHapticLoop::setHistogramBinWidth(const double a_binWidth)
+    \param  a_binWidth  Width of a bin in seconds. Must be positive.
+*/
+//===========================================================================
+void cHapticLoop::setHistogramBinWidth(const double a_binWidth)
+{
+    if (a_binWidth > 0.0)
+    {
+        m_histogramBinWidth = a_binWidth;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Create the thread of the loop, which executes the function once per
+    period until stop() is called. If requested, the memory of the process
+    is locked first.
+
+    \fn		bool cHapticLoop::start(cHapticLoopFunction a_function, void* a_data)
+    \param  a_function  Function to execute at every tick.
+    \param  a_data  User data passed to the function.
+    \return Return \b true if the loop was started.
+*/
+//===========================================================================
+bool cHapticLoop::start(cHapticLoopFunction a_function, void* a_data)
+{
+    if ((m_running) || (a_function == NULL))
+    {
+        return (false);
+    }
+
+    m_function = a_function;
+    m_data = a_data;
+    m_quit = false;
+    m_resetStatistics = false;
+
+    // lock memory to avoid page faults in the loop
+    m_memoryLocked = false;
+
+#if defined(_LINUX) || defined(_MACOSX)
+    if (m_lockMemory)
+    {
+        m_memoryLocked = (mlockall(MCL_CURRENT | MCL_FUTURE) == 0);
+    }
+#endif
+
+    // clear the statistics of a previous run
+    for (unsigned int i=0; i<3; i++)
+    {
+        clearStatistics(m_statistics[i]);
+    }
+
+    // create thread
+    m_running = true;
+
+#if defined(_WIN32)
+    m_thread = CreateThread(0, 0, loopFunction, this, 0, NULL);
+    if (m_thread == NULL)
+    {
+        m_running = false;
+    }
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    if (pthread_create(&m_thread, 0, loopFunction, this) != 0)
+    {
+        m_running = false;
+    }
+
+    if ((!m_running) && (m_memoryLocked))
+    {
+        munlockall();
+        m_memoryLocked = false;
+    }
+#endif
+
+    return (m_running);
+}
+
+
+//===========================================================================
+/*!
+    Stop the loop and wait for its thread to terminate. Memory locked by
+    start() is unlocked.
+
+    \fn		void cHapticLoop::stop()
+*/
+//===========================================================================
+void cHapticLoop::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    m_quit = true;
+
+#if defined(_WIN32)
+    WaitForSingleObject(m_thread, INFINITE);
+    CloseHandle(m_thread);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    pthread_join(m_thread, NULL);
+
+    if (m_memoryLocked)
+    {
+        munlockall();
+        m_memoryLocked = false;
+    }
+#endif
+
+    m_running = false;
+}
+
+
+//===========================================================================
+/*!
+    Return the latest statistics published by the loop. This function
+    never waits for the loop. Since the statistics are exchanged through a
+    cTripleBuffer, it must always be called by the same thread.
+
+    \fn		cHapticLoopStatistics cHapticLoop::getStatistics()
+    \return Return a copy of the statistics.
+*/
+//===========================================================================
+cHapticLoopStatistics cHapticLoop::getStatistics()
+{
+    m_statisticsBuffer.update();
+    return (m_statistics[m_statisticsBuffer.getReadIndex()]);
+}
+
+
+//===========================================================================
+/*!
+    Main loop of the thread. Each tick waits for its deadline, executes
+    the loop function, and updates and publishes the statistics. The next
+    deadline is one period later; if the tick ended more than a period
+    after it, the missed ticks are skipped, and the next tick starts
+    immediately.
+
+    \fn		void cHapticLoop::run()
+*/
+//===========================================================================
+void cHapticLoop::run()
+{
+    bool realTime = applyScheduling();
+    double period = 1.0 / m_frequency;
+
+    cHapticLoopStatistics statistics;
+    clearStatistics(statistics);
+    statistics.m_realTime = realTime;
+    statistics.m_memoryLocked = m_memoryLocked;
+
+    double deadline = getClockSeconds();
+    double rateStart = deadline;
+    unsigned int rateTicks = 0;
+
+    while (!m_quit)
+    {
+        // execute tick
+        waitUntil(deadline);
+        double start = getClockSeconds();
+        {
+            cProfilerScope profilerScope(CHAI_PROFILER_STAGE_TICK);
+            m_function(m_data);
+        }
+        double end = getClockSeconds();
+
+        if (m_resetStatistics)
+        {
+            m_resetStatistics = false;
+            clearStatistics(statistics);
+            statistics.m_realTime = realTime;
+            statistics.m_memoryLocked = m_memoryLocked;
+            rateStart = start;
+            rateTicks = 0;
+        }
+
+        // jitter and duration
+        double jitter = start - deadline;
+        double duration = end - start;
+
+        statistics.m_numTicks++;
+        statistics.m_meanJitter += (jitter - statistics.m_meanJitter) / (double)statistics.m_numTicks;
+        statistics.m_meanDuration += (duration - statistics.m_meanDuration) / (double)statistics.m_numTicks;
+        if (jitter > statistics.m_maxJitter) { statistics.m_maxJitter = jitter; }
+        if (duration > statistics.m_maxDuration) { statistics.m_maxDuration = duration; }
+
+        unsigned int jitterBin = CHAI_HAPTIC_LOOP_HISTOGRAM_SIZE - 1;
+        if (jitter < m_histogramBinWidth * (double)jitterBin)
+        {
+            jitterBin = (jitter > 0.0) ? (unsigned int)(jitter / m_histogramBinWidth) : 0;
+        }
+        statistics.m_jitterHistogram[jitterBin]++;
+
+        unsigned int durationBin = CHAI_HAPTIC_LOOP_HISTOGRAM_SIZE - 1;
+        if (duration < m_histogramBinWidth * (double)durationBin)
+        {
+            durationBin = (duration > 0.0) ? (unsigned int)(duration / m_histogramBinWidth) : 0;
+        }
+        statistics.m_durationHistogram[durationBin]++;
+
+        // next deadline
+        deadline += period;
+        if (end > deadline)
+        {
+            statistics.m_numOverruns++;
+            if (end > deadline + period)
+            {
+                unsigned int numMissedTicks = (unsigned int)((end - deadline) / period);
+                statistics.m_numMissedTicks += numMissedTicks;
+                deadline += (double)numMissedTicks * period;
+            }
+        }
+
+        // rate over the last second
+        rateTicks++;
+        if (end - rateStart >= 1.0)
+        {
+            statistics.m_rate = (double)rateTicks / (end - rateStart);
+            rateStart = end;
+            rateTicks = 0;
+        }
+
+        // publish statistics
+        m_statistics[m_statisticsBuffer.getWriteIndex()] = statistics;
+        m_statisticsBuffer.publish();
+    }
+}
+
+
+//===========================================================================
+/*!
+    Apply the scheduling policy, the priority and the processor affinity
+    to the calling thread. Processor affinity is not supported on Mac OS X.
+
+    \fn		bool cHapticLoop::applyScheduling()
+    \return Return \b true if the thread now runs under a real-time policy.
+*/
+//===========================================================================
+bool cHapticLoop::applyScheduling()
+{
+    bool realTime = false;
+
+#if defined(_WIN32)
+    if (m_policy != CHAI_HAPTIC_LOOP_POLICY_NORMAL)
+    {
+        realTime = (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0);
+    }
+
+    if (m_processor >= 0)
+    {
+        SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR)1) << m_processor);
+    }
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    if (m_policy != CHAI_HAPTIC_LOOP_POLICY_NORMAL)
+    {
+        struct sched_param sp;
+        memset(&sp, 0, sizeof(struct sched_param));
+        sp.sched_priority = m_priority;
+
+        int policy = (m_policy == CHAI_HAPTIC_LOOP_POLICY_RR) ? SCHED_RR : SCHED_FIFO;
+        realTime = (pthread_setschedparam(pthread_self(), policy, &sp) == 0);
+    }
+#endif
+
+#if defined(_LINUX)
+    if (m_processor >= 0)
+    {
+        cpu_set_t processors;
+        CPU_ZERO(&processors);
+        CPU_SET(m_processor, &processors);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &processors);
+    }
+#endif
+
+    return (realTime);
+}
+
+
+//===========================================================================
+/*!
+    Wait until the clock reaches a given time. The thread sleeps until
+    the spin time before it, and then spins, since waking up from a sleep
+    takes longer than the required accuracy. On Linux, the sleep uses an
+    absolute deadline, so that it is not lengthened by preemption.
+
+    \fn		void cHapticLoop::waitUntil(const double a_time)
+    \param  a_time  Time to wait for, as returned by getClockSeconds().
+*/
+//===========================================================================
+void cHapticLoop::waitUntil(const double a_time)
+{
+    double wakeTime = a_time - m_spinTime;
+
+#if defined(_WIN32)
+    while (getClockSeconds() < wakeTime)
+    {
+        Sleep(0);
+    }
+#endif
+
+#if defined(_LINUX)
+    if (wakeTime > getClockSeconds())
+    {
+        struct timespec wake;
+        wake.tv_sec = (time_t)wakeTime;
+        wake.tv_nsec = (long)((wakeTime - (double)wake.tv_sec) * 1e9);
+        if (wake.tv_nsec > 999999999) { wake.tv_nsec = 999999999; }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {}
+    }
+#endif
+
+#if defined(_MACOSX)
+    double sleepTime = wakeTime - getClockSeconds();
+    if (sleepTime > 0.0)
+    {
+        struct timespec sleep;
+        sleep.tv_sec = (time_t)sleepTime;
+        sleep.tv_nsec = (long)((sleepTime - (double)sleep.tv_sec) * 1e9);
+        nanosleep(&sleep, NULL);
+    }
+#endif
+
+    // spin for the remaining time
+    while (getClockSeconds() < a_time) {}
+}
+
+
+//===========================================================================
+/*!
+    Clear statistics.
+
+    \fn		void cHapticLoop::clearStatistics(cHapticLoopStatistics& a_statistics)
+    \param  a_statistics  Statistics to clear.
+*/
+//===========================================================================
+void cHapticLoop::clearStatistics(cHapticLoopStatistics& a_statistics)
+{
+    a_statistics.m_numTicks = 0;
+    a_statistics.m_numOverruns = 0;
+    a_statistics.m_numMissedTicks = 0;
+    a_statistics.m_rate = 0.0;
+    a_statistics.m_meanJitter = 0.0;
+    a_statistics.m_maxJitter = 0.0;
+    a_statistics.m_meanDuration = 0.0;
+    a_statistics.m_maxDuration = 0.0;
+    a_statistics.m_histogramBinWidth = m_histogramBinWidth;
+    for (unsigned int i=0; i<CHAI_HAPTIC_LOOP_HISTOGRAM_SIZE; i++)
+    {
+        a_statistics.m_jitterHistogram[i] = 0;
+        a_statistics.m_durationHistogram[i] = 0;
+    }
+    a_statistics.m_realTime = false;
+    a_statistics.m_memoryLocked = false;
+}
+
+
+//===========================================================================
+/*!
+    Return the time of a monotonic clock, which is not affected by
+    changes of the system time.
+
+    \fn		double cHapticLoop::getClockSeconds()
+    \return Return the time in seconds, from an arbitrary origin.
+*/
+//===========================================================================
+double cHapticLoop::getClockSeconds()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return ((double)counter.QuadPart / (double)frequency.QuadPart);
+#endif
+
+#if defined(_LINUX)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec + 1e-9 * (double)now.tv_nsec);
+#endif
+
+#if defined(_MACOSX)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0)
+    {
+        mach_timebase_info(&timebase);
+    }
+    return (1e-9 * (double)mach_absolute_time() * (double)timebase.numer / (double)timebase.denom);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Entry point of the thread of the loop.
+
+    \param  a_loop  Loop owning the thread.
+*/
+//===========================================================================
+#if defined(_WIN32)
+DWORD WINAPI cHapticLoop::loopFunction(LPVOID a_loop)
+{
+    ((cHapticLoop*)a_loop)->run();
+    return (0);
+}
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+void* cHapticLoop::loopFunction(void* a_loop)
+{
+    ((cHapticLoop*)a_loop)->run();
+    return (NULL);
+}
+#endif
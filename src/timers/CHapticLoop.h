@@ -0,0 +1,307 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+
+//---------------------------------------------------------------------------
+#ifndef CHapticLoopH
+#define CHapticLoopH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+#include "timers/CTripleBuffer.h"
+//---------------------------------------------------------------------------
+//! Number of bins of the jitter and duration histograms of a cHapticLoop.
+#define CHAI_HAPTIC_LOOP_HISTOGRAM_SIZE 100
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CHapticLoop.h
+
+    \brief
+    <b> Timers </b> \n
+    Fixed Rate Haptic Loop.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Function executed by a cHapticLoop at every tick.
+typedef void (*cHapticLoopFunction)(void* a_data);
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+/*!
+    Defines the scheduling policy of the thread of a cHapticLoop.
+*/
+//---------------------------------------------------------------------------
+enum CHapticLoopPolicy
+{
+    CHAI_HAPTIC_LOOP_POLICY_NORMAL,
+    CHAI_HAPTIC_LOOP_POLICY_FIFO,
+    CHAI_HAPTIC_LOOP_POLICY_RR
+};
+
+
+//===========================================================================
+/*!
+    \struct     cHapticLoopStatistics
+    \ingroup    timers
+
+    \brief
+    cHapticLoopStatistics reports the timing of the ticks of a cHapticLoop.
+    Times are expressed in seconds.
+*/
+//===========================================================================
+struct cHapticLoopStatistics
+{
+    //! Number of ticks executed.
+    unsigned int m_numTicks;
+
+    //! Number of ticks which ended after the deadline of the next tick.
+    unsigned int m_numOverruns;
+
+    //! Number of ticks skipped to recover from overruns longer than a period.
+    unsigned int m_numMissedTicks;
+
+    //! Rate of the loop in Hz, measured over the last second.
+    double m_rate;
+
+    //! Mean delay between the deadline and the start of a tick.
+    double m_meanJitter;
+
+    //! Maximum delay between the deadline and the start of a tick.
+    double m_maxJitter;
+
+    //! Mean execution time of the loop function.
+    double m_meanDuration;
+
+    //! Maximum execution time of the loop function.
+    double m_maxDuration;
+
+    //! Width of the bins of the histograms.
+    double m_histogramBinWidth;
+
+    //! Number of ticks per jitter bin. The last bin also counts all larger jitters.
+    unsigned int m_jitterHistogram[CHAI_HAPTIC_LOOP_HISTOGRAM_SIZE];
+
+    //! Number of ticks per duration bin. The last bin also counts all longer durations.
+    unsigned int m_durationHistogram[CHAI_HAPTIC_LOOP_HISTOGRAM_SIZE];
+
+    //! If \b true, the thread runs with the requested real-time scheduling policy.
+    bool m_realTime;
+
+    //! If \b true, the memory of the process is locked.
+    bool m_memoryLocked;
+};
+
+
+//===========================================================================
+/*!
+    \class      cHapticLoop
+    \ingroup    timers
+
+    \brief
+    cHapticLoop executes a function at a fixed rate in a dedicated thread,
+    typically the haptics rendering loop at 1 kHz or more. \n
+
+    The thread may run under a real-time scheduling policy, on a given
+    processor, with the memory of the process locked. Each tick starts at
+    an absolute deadline: the thread sleeps until shortly before it, and
+    spins for the remaining time. Deadlines do not drift when a tick is
+    late; after an overrun of more than one period the missed ticks are
+    skipped. \n
+
+    The jitter (delay between deadline and start) and the duration of
+    every tick are accumulated in a cHapticLoopStatistics, which the loop
+    publishes through a cTripleBuffer, so that reading the statistics
+    never delays the loop. Real-time policies, affinity and memory locking
+    are requests: when the system denies them, for lack of privileges for
+    instance, the loop runs with normal scheduling, and the statistics
+    report it.
+*/
+//===========================================================================
+class cHapticLoop
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cHapticLoop.
+    cHapticLoop();
+
+    //! Destructor of cHapticLoop. Stops the loop.
+    ~cHapticLoop();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS - SETTINGS:
+    //-----------------------------------------------------------------------
+
+    //! Set the rate of the loop in Hz. Takes effect at the next call to start().
+    void setFrequency(const double a_frequency);
+
+    //! Get the rate of the loop in Hz.
+    double getFrequency() const { return (m_frequency); }
+
+    //! Set the scheduling policy and priority (1 to 99) of the thread. Takes effect at the next call to start().
+    void setPolicy(const CHapticLoopPolicy a_policy, const int a_priority);
+
+    //! Get the scheduling policy of the thread.
+    CHapticLoopPolicy getPolicy() const { return (m_policy); }
+
+    //! Set the processor on which the thread runs, or -1 for any. Takes effect at the next call to start().
+    void setProcessor(const int a_processor) { m_processor = a_processor; }
+
+    //! Get the processor on which the thread runs, or -1 for any.
+    int getProcessor() const { return (m_processor); }
+
+    //! If \b true, lock all current and future memory of the process when the loop starts.
+    void setLockMemory(const bool a_lockMemory) { m_lockMemory = a_lockMemory; }
+
+    //! Set the time spent spinning before each deadline, in seconds.
+    void setSpinTime(const double a_spinTime) { m_spinTime = a_spinTime; }
+
+    //! Set the width of the bins of the histograms, in seconds. Takes effect at the next call to start().
+    void setHistogramBinWidth(const double a_binWidth);
+
+
+    //-----------------------------------------------------------------------
+    // METHODS - LOOP CONTROL:
+    //-----------------------------------------------------------------------
+
+    //! Start executing a function at the rate of the loop.
+    bool start(cHapticLoopFunction a_function, void* a_data);
+
+    //! Stop the loop, and wait for the current tick to complete. Must not be called by the loop function.
+    void stop();
+
+    //! Return \b true if the loop is running.
+    bool isRunning() const { return (m_running); }
+
+    //! Get the latest statistics published by the loop. Must be called by a single thread only.
+    cHapticLoopStatistics getStatistics();
+
+    //! Clear the statistics at the next tick of the loop.
+    void resetStatistics() { m_resetStatistics = true; }
+
+    //! Return the time of a monotonic clock, in seconds.
+    static double getClockSeconds();
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Main loop of the thread.
+    void run();
+
+    //! Apply the scheduling policy and the affinity to the calling thread.
+    bool applyScheduling();
+
+    //! Sleep and spin until the clock reaches a given time.
+    void waitUntil(const double a_time);
+
+    //! Clear statistics.
+    void clearStatistics(cHapticLoopStatistics& a_statistics);
+
+#if defined(_WIN32)
+    //! Entry point of the thread.
+    static DWORD WINAPI loopFunction(LPVOID a_loop);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Entry point of the thread.
+    static void* loopFunction(void* a_loop);
+#endif
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Function executed at every tick.
+    cHapticLoopFunction m_function;
+
+    //! User data passed to the function.
+    void* m_data;
+
+    //! Rate of the loop in Hz.
+    double m_frequency;
+
+    //! Scheduling policy of the thread.
+    CHapticLoopPolicy m_policy;
+
+    //! Scheduling priority of the thread.
+    int m_priority;
+
+    //! Processor on which the thread runs, or -1 for any.
+    int m_processor;
+
+    //! If \b true, the memory of the process is locked when the loop starts.
+    bool m_lockMemory;
+
+    //! Time spent spinning before each deadline, in seconds.
+    double m_spinTime;
+
+    //! Width of the bins of the histograms, in seconds.
+    double m_histogramBinWidth;
+
+    //! If \b true, the loop is running.
+    volatile bool m_running;
+
+    //! If \b true, the loop terminates.
+    volatile bool m_quit;
+
+    //! If \b true, the loop clears its statistics at the next tick.
+    volatile bool m_resetStatistics;
+
+    //! If \b true, the memory of the process was locked by start().
+    bool m_memoryLocked;
+
+    //! Statistics exchanged between the loop and the thread reading them.
+    cHapticLoopStatistics m_statistics[3];
+
+    //! Indices of the statistics owned by the loop and by the reader.
+    cTripleBuffer m_statisticsBuffer;
+
+#if defined(_WIN32)
+    //! Thread handle.
+    HANDLE m_thread;
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Thread handle.
+    pthread_t m_thread;
+#endif
+
+  private:
+
+    //! Loops cannot be copied.
+    cHapticLoop(const cHapticLoop&);
+
+    //! Loops cannot be assigned.
+    cHapticLoop& operator=(const cHapticLoop&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CMutex.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cMutex.
+
+    \fn		cMutex::cMutex()
+*/
+//===========================================================================
+cMutex::cMutex()
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(&m_mutex);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_init(&m_mutex, NULL);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cMutex.
+
+    \fn		cMutex::~cMutex()
+*/
+//===========================================================================
+cMutex::~cMutex()
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(&m_mutex);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_destroy(&m_mutex);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Acquire the lock. If the lock is held by another thread, the calling
+    thread blocks until it is released.
+
+    \fn		void cMutex::acquire()
+*/
+//===========================================================================
+void cMutex::acquire()
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&m_mutex);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_lock(&m_mutex);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Try to acquire the lock without blocking.
+
+    \fn		bool cMutex::tryAcquire()
+    \return Return \b true if the lock has been acquired, otherwise \b false.
+*/
+//===========================================================================
+bool cMutex::tryAcquire()
+{
+#if defined(_WIN32)
+    return (TryEnterCriticalSection(&m_mutex) != 0);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    return (pthread_mutex_trylock(&m_mutex) == 0);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Release the lock.
+
+    \fn		void cMutex::release()
+*/
+//===========================================================================
+void cMutex::release()
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&m_mutex);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_unlock(&m_mutex);
+#endif
+}
@@ -0,0 +1,103 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CMutexH
+#define CMutexH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CMutex.h
+
+    \brief
+    <b> Timers </b> \n
+    Mutual Exclusion.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cMutex
+    \ingroup    timers
+
+    \brief
+    cMutex provides a simple mutual exclusion lock to protect data that
+    is shared between the graphics and haptics threads.
+*/
+//===========================================================================
+class cMutex
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cMutex.
+    cMutex();
+
+    //! Destructor of cMutex.
+    ~cMutex();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Acquire the lock. Blocks until the lock is available.
+    void acquire();
+
+    //! Try to acquire the lock. Returns \b true if the lock was acquired.
+    bool tryAcquire();
+
+    //! Release the lock.
+    void release();
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+#if defined(_WIN32)
+    //! Critical section handle.
+    CRITICAL_SECTION m_mutex;
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Mutex handle.
+    pthread_mutex_t m_mutex;
+#endif
+
+  private:
+
+    //! Mutexes cannot be copied.
+    cMutex(const cMutex&);
+
+    //! Mutexes cannot be assigned.
+    cMutex& operator=(const cMutex&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,554 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+
+//---------------------------------------------------------------------------
+#include "CProfiler.h"
+#include "CMutex.h"
+#include "math/CMaths.h"
+#include <algorithm>
+#include <stdio.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cProfilerThreadBuffer
+    \brief      Ring buffer of the events recorded by a thread.
+*/
+//===========================================================================
+struct cProfilerThreadBuffer
+{
+    //! Events, indexed by their number modulo CHAI_PROFILER_BUFFER_SIZE.
+    cProfilerEvent m_events[CHAI_PROFILER_BUFFER_SIZE];
+
+    //! Number of events recorded by the thread. Written by the thread only.
+    volatile unsigned int m_numEvents;
+
+    //! Number of events discarded by cProfiler::clear(). Written by the reader only.
+    unsigned int m_numClearedEvents;
+
+    //! Index of the thread.
+    unsigned int m_thread;
+};
+
+//---------------------------------------------------------------------------
+volatile bool cProfiler::s_enabled = false;
+
+//! Lock protecting the list of thread buffers and the initialization of the profiler.
+static cMutex s_profilerLock;
+
+//! Ring buffers of all threads which have recorded events.
+static std::vector<cProfilerThreadBuffer*> s_threadBuffers;
+
+//! If \b true, the thread local storage and the clock reference have been set up.
+static bool s_profilerInitialized = false;
+
+#if defined(_WIN32)
+//! Thread local storage index of the ring buffer of each thread.
+static DWORD s_threadBufferKey;
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+//! Thread local storage key of the ring buffer of each thread.
+static pthread_key_t s_threadBufferKey;
+#endif
+
+//! Ticks when the profiler was first enabled.
+static cProfilerTicks s_referenceTicks = 0;
+
+//! Clock time when the profiler was first enabled.
+static double s_referenceTime = 0.0;
+
+//! Names of the stages.
+static const char* s_stageNames[CHAI_PROFILER_NUM_STAGES] =
+{
+    "tick",
+    "computeGlobalPositions",
+    "updatePose",
+    "potentialFields",
+    "proxyConstraint0",
+    "proxyConstraint1",
+    "proxyConstraint2",
+    "applyForces"
+};
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Full memory barrier, which orders the writes of an event and of the
+    number of events of a ring buffer.
+*/
+//===========================================================================
+static inline void cProfilerMemoryBarrier()
+{
+#if defined(_WIN32)
+    MemoryBarrier();
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    __sync_synchronize();
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Return the ring buffer of the calling thread, and create it on the
+    first call from that thread.
+*/
+//===========================================================================
+static cProfilerThreadBuffer* cProfilerGetThreadBuffer()
+{
+    cProfilerThreadBuffer* buffer = NULL;
+
+#if defined(_WIN32)
+    buffer = (cProfilerThreadBuffer*)TlsGetValue(s_threadBufferKey);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    buffer = (cProfilerThreadBuffer*)pthread_getspecific(s_threadBufferKey);
+#endif
+
+    if (buffer != NULL)
+    {
+        return (buffer);
+    }
+
+    // first event of this thread
+    buffer = new cProfilerThreadBuffer;
+    buffer->m_numEvents = 0;
+    buffer->m_numClearedEvents = 0;
+
+    s_profilerLock.acquire();
+    buffer->m_thread = (unsigned int)s_threadBuffers.size();
+    s_threadBuffers.push_back(buffer);
+    s_profilerLock.release();
+
+#if defined(_WIN32)
+    TlsSetValue(s_threadBufferKey, buffer);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    pthread_setspecific(s_threadBufferKey, buffer);
+#endif
+
+    return (buffer);
+}
+
+
+//===========================================================================
+/*!
+    Compare the start times of two events.
+*/
+//===========================================================================
+static bool cProfilerEarlierEvent(const cProfilerEvent& a_event0, const cProfilerEvent& a_event1)
+{
+    return (a_event0.m_start < a_event1.m_start);
+}
+
+
+//===========================================================================
+/*!
+    Enable or disable the recording of events. Events recorded while the
+    profiler was enabled are kept when it is disabled.
+
+    \fn		void cProfiler::setEnabled(const bool a_enabled)
+    \param  a_enabled  If \b true, events are recorded.
+*/
+//===========================================================================
+void cProfiler::setEnabled(const bool a_enabled)
+{
+    s_profilerLock.acquire();
+    if ((a_enabled) && (!s_profilerInitialized))
+    {
+        bool initialized = false;
+
+#if defined(_WIN32)
+        s_threadBufferKey = TlsAlloc();
+        initialized = (s_threadBufferKey != TLS_OUT_OF_INDEXES);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+        initialized = (pthread_key_create(&s_threadBufferKey, NULL) == 0);
+#endif
+
+        s_referenceTime = cHapticLoop::getClockSeconds();
+        s_referenceTicks = getTicks();
+        s_profilerInitialized = initialized;
+    }
+    s_enabled = a_enabled && s_profilerInitialized;
+    s_profilerLock.release();
+}
+
+
+//===========================================================================
+/*!
+    Record an event in the ring buffer of the calling thread, overwriting
+    the oldest event when the buffer is full. This function never locks,
+    except for the first event of a thread, which allocates its buffer.
+
+    \fn		void cProfiler::record(const CProfilerStage a_stage,
+            const cProfilerTicks a_start, const cProfilerTicks a_end,
+            const unsigned int a_numNodeTests,
+            const unsigned int a_numTriangleTests)
+    \param  a_stage  Stage.
+    \param  a_start  Time at which the stage started, as returned by getTicks().
+    \param  a_end  Time at which the stage ended, as returned by getTicks().
+    \param  a_numNodeTests  Number of nodes of collision trees tested by the stage.
+    \param  a_numTriangleTests  Number of triangles tested by the stage.
+*/
+//===========================================================================
+void cProfiler::record(const CProfilerStage a_stage,
+                       const cProfilerTicks a_start,
+                       const cProfilerTicks a_end,
+                       const unsigned int a_numNodeTests,
+                       const unsigned int a_numTriangleTests)
+{
+    if (!s_profilerInitialized)
+    {
+        return;
+    }
+
+    cProfilerThreadBuffer* buffer = cProfilerGetThreadBuffer();
+    unsigned int index = buffer->m_numEvents;
+
+    cProfilerEvent& event = buffer->m_events[index & (CHAI_PROFILER_BUFFER_SIZE - 1)];
+    event.m_start = a_start;
+    event.m_end = a_end;
+    event.m_stage = (unsigned int)a_stage;
+    event.m_numNodeTests = a_numNodeTests;
+    event.m_numTriangleTests = a_numTriangleTests;
+    event.m_thread = buffer->m_thread;
+
+    // the event must be complete before the reader sees it
+    cProfilerMemoryBarrier();
+    buffer->m_numEvents = index + 1;
+}
+
+
+//===========================================================================
+/*!
+    Discard the events recorded so far by all threads. The ring buffers
+    are not modified, so that the recording threads are not disturbed.
+
+    \fn		void cProfiler::clear()
+*/
+//===========================================================================
+void cProfiler::clear()
+{
+    s_profilerLock.acquire();
+    for (unsigned int i=0; i<s_threadBuffers.size(); i++)
+    {
+        s_threadBuffers[i]->m_numClearedEvents = s_threadBuffers[i]->m_numEvents;
+    }
+    s_profilerLock.release();
+}
+
+
+//===========================================================================
+/*!
+    Copy the events recorded by all threads. Since the recording threads
+    are not stopped, the events which may have been overwritten during the
+    copy are dropped.
+
+    \fn		void cProfiler::getEvents(std::vector<cProfilerEvent>& a_events)
+    \param  a_events  Returns the events, sorted by start time.
+*/
+//===========================================================================
+void cProfiler::getEvents(std::vector<cProfilerEvent>& a_events)
+{
+    a_events.clear();
+
+    s_profilerLock.acquire();
+    std::vector<cProfilerThreadBuffer*> buffers = s_threadBuffers;
+    s_profilerLock.release();
+
+    for (unsigned int i=0; i<buffers.size(); i++)
+    {
+        cProfilerThreadBuffer* buffer = buffers[i];
+
+        // copy the events still held in the ring buffer
+        unsigned int end = buffer->m_numEvents;
+        cProfilerMemoryBarrier();
+        unsigned int first = buffer->m_numClearedEvents;
+        if (end - first > CHAI_PROFILER_BUFFER_SIZE)
+        {
+            first = end - CHAI_PROFILER_BUFFER_SIZE;
+        }
+
+        unsigned int base = (unsigned int)a_events.size();
+        for (unsigned int j=first; j!=end; j++)
+        {
+            a_events.push_back(buffer->m_events[j & (CHAI_PROFILER_BUFFER_SIZE - 1)]);
+        }
+
+        // drop the events which the thread may have overwritten meanwhile
+        cProfilerMemoryBarrier();
+        unsigned int last = buffer->m_numEvents;
+        if (last - first >= CHAI_PROFILER_BUFFER_SIZE)
+        {
+            unsigned int numDropped = cMin(last - first - CHAI_PROFILER_BUFFER_SIZE + 1, end - first);
+            a_events.erase(a_events.begin() + base, a_events.begin() + base + numDropped);
+        }
+    }
+
+    std::sort(a_events.begin(), a_events.end(), cProfilerEarlierEvent);
+}
+
+
+//===========================================================================
+/*!
+    Return the duration of a tick of getTicks(). The frequency of the time
+    stamp counter is measured against a monotonic clock since the profiler
+    was first enabled; the time stamp counter is assumed to be invariant
+    and synchronized between processors.
+
+    \fn		double cProfiler::getSecondsPerTick()
+    \return Return the duration of a tick in seconds.
+*/
+//===========================================================================
+double cProfiler::getSecondsPerTick()
+{
+#if defined(CHAI_PROFILER_USE_TSC)
+    // wait until the interval is long enough to be measured accurately
+    double elapsedTime = cHapticLoop::getClockSeconds() - s_referenceTime;
+    while (elapsedTime < 0.01)
+    {
+        elapsedTime = cHapticLoop::getClockSeconds() - s_referenceTime;
+    }
+    cProfilerTicks elapsedTicks = getTicks() - s_referenceTicks;
+
+    return (elapsedTime / (double)elapsedTicks);
+#else
+    return (1e-9);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Compute the median, 99th percentile and maximum of the duration of
+    each stage, and the mean and maximum numbers of tests, over the events
+    held in the ring buffers.
+
+    \fn		void cProfiler::getStatistics(std::vector<cProfilerStageStatistics>& a_statistics)
+    \param  a_statistics  Returns the statistics, indexed by stage.
+*/
+//===========================================================================
+void cProfiler::getStatistics(std::vector<cProfilerStageStatistics>& a_statistics)
+{
+    a_statistics.resize(CHAI_PROFILER_NUM_STAGES);
+    for (unsigned int i=0; i<CHAI_PROFILER_NUM_STAGES; i++)
+    {
+        cProfilerStageStatistics& statistics = a_statistics[i];
+        statistics.m_numEvents = 0;
+        statistics.m_p50 = 0.0;
+        statistics.m_p99 = 0.0;
+        statistics.m_max = 0.0;
+        statistics.m_meanNodeTests = 0.0;
+        statistics.m_maxNodeTests = 0;
+        statistics.m_meanTriangleTests = 0.0;
+        statistics.m_maxTriangleTests = 0;
+    }
+
+    if (!s_profilerInitialized)
+    {
+        return;
+    }
+
+    std::vector<cProfilerEvent> events;
+    getEvents(events);
+    double secondsPerTick = getSecondsPerTick();
+
+    // gather durations and counts per stage
+    std::vector<double> durations[CHAI_PROFILER_NUM_STAGES];
+    for (unsigned int i=0; i<events.size(); i++)
+    {
+        const cProfilerEvent& event = events[i];
+        cProfilerStageStatistics& statistics = a_statistics[event.m_stage];
+        durations[event.m_stage].push_back(secondsPerTick * (double)(event.m_end - event.m_start));
+        statistics.m_numEvents++;
+        statistics.m_meanNodeTests += (double)event.m_numNodeTests;
+        statistics.m_meanTriangleTests += (double)event.m_numTriangleTests;
+        statistics.m_maxNodeTests = cMax(statistics.m_maxNodeTests, event.m_numNodeTests);
+        statistics.m_maxTriangleTests = cMax(statistics.m_maxTriangleTests, event.m_numTriangleTests);
+    }
+
+    // percentiles by nearest rank
+    for (unsigned int i=0; i<CHAI_PROFILER_NUM_STAGES; i++)
+    {
+        cProfilerStageStatistics& statistics = a_statistics[i];
+        unsigned int n = statistics.m_numEvents;
+        if (n == 0) { continue; }
+
+        std::sort(durations[i].begin(), durations[i].end());
+        statistics.m_p50 = durations[i][(n + 1) / 2 - 1];
+        statistics.m_p99 = durations[i][(99 * n + 99) / 100 - 1];
+        statistics.m_max = durations[i][n - 1];
+        statistics.m_meanNodeTests /= (double)n;
+        statistics.m_meanTriangleTests /= (double)n;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Format the statistics of each stage which has recorded events as one
+    line of text, with durations in microseconds.
+
+    \fn		void cProfiler::getReport(std::vector<std::string>& a_lines)
+    \param  a_lines  Returns the lines of the report.
+*/
+//===========================================================================
+void cProfiler::getReport(std::vector<std::string>& a_lines)
+{
+    a_lines.clear();
+
+    std::vector<cProfilerStageStatistics> statistics;
+    getStatistics(statistics);
+
+    char buffer[256];
+    for (unsigned int i=0; i<CHAI_PROFILER_NUM_STAGES; i++)
+    {
+        if (statistics[i].m_numEvents == 0) { continue; }
+
+        sprintf(buffer, "%s:  p50 %.1f us,  p99 %.1f us,  max %.1f us,  %.0f nodes,  %.0f triangles",
+                s_stageNames[i],
+                1e6 * statistics[i].m_p50,
+                1e6 * statistics[i].m_p99,
+                1e6 * statistics[i].m_max,
+                statistics[i].m_meanNodeTests,
+                statistics[i].m_meanTriangleTests);
+        a_lines.push_back(buffer);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Save the events held in the ring buffers in a CSV file, one event per
+    line. Times are expressed in microseconds, from the time the profiler
+    was first enabled.
+
+    \fn		bool cProfiler::saveCSV(const std::string& a_filename)
+    \param  a_filename  Name of the file.
+    \return Return \b true if the file was written.
+*/
+//===========================================================================
+bool cProfiler::saveCSV(const std::string& a_filename)
+{
+    if (!s_profilerInitialized)
+    {
+        return (false);
+    }
+
+    FILE* file = fopen(a_filename.c_str(), "w");
+    if (file == NULL)
+    {
+        return (false);
+    }
+
+    std::vector<cProfilerEvent> events;
+    getEvents(events);
+    double secondsPerTick = getSecondsPerTick();
+
+    fprintf(file, "thread,stage,start_us,duration_us,node_tests,triangle_tests\n");
+    for (unsigned int i=0; i<events.size(); i++)
+    {
+        const cProfilerEvent& event = events[i];
+        fprintf(file, "%u,%s,%.3f,%.3f,%u,%u\n",
+                event.m_thread,
+                s_stageNames[event.m_stage],
+                1e6 * secondsPerTick * (double)(event.m_start - s_referenceTicks),
+                1e6 * secondsPerTick * (double)(event.m_end - event.m_start),
+                event.m_numNodeTests,
+                event.m_numTriangleTests);
+    }
+
+    fclose(file);
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Save the events held in the ring buffers as complete events of the
+    trace event format, which can be loaded in the Chrome tracing viewer
+    (chrome://tracing). Each thread appears as a separate track.
+
+    \fn		bool cProfiler::saveChromeTrace(const std::string& a_filename)
+    \param  a_filename  Name of the file.
+    \return Return \b true if the file was written.
+*/
+//===========================================================================
+bool cProfiler::saveChromeTrace(const std::string& a_filename)
+{
+    if (!s_profilerInitialized)
+    {
+        return (false);
+    }
+
+    FILE* file = fopen(a_filename.c_str(), "w");
+    if (file == NULL)
+    {
+        return (false);
+    }
+
+    std::vector<cProfilerEvent> events;
+    getEvents(events);
+    double secondsPerTick = getSecondsPerTick();
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (unsigned int i=0; i<events.size(); i++)
+    {
+        const cProfilerEvent& event = events[i];
+        fprintf(file, "{\"name\":\"%s\",\"cat\":\"haptics\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+                      "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"nodes\":%u,\"triangles\":%u}}%s\n",
+                s_stageNames[event.m_stage],
+                event.m_thread,
+                1e6 * secondsPerTick * (double)(event.m_start - s_referenceTicks),
+                1e6 * secondsPerTick * (double)(event.m_end - event.m_start),
+                event.m_numNodeTests,
+                event.m_numTriangleTests,
+                (i + 1 < events.size()) ? "," : "");
+    }
+    fprintf(file, "]}\n");
+
+    fclose(file);
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Return the name of a stage, as used in reports and files.
+
+    \fn		const char* cProfiler::getStageName(const CProfilerStage a_stage)
+    \param  a_stage  Stage.
+    \return Return the name of the stage.
+*/
+//===========================================================================
+const char* cProfiler::getStageName(const CProfilerStage a_stage)
+{
+    if ((unsigned int)a_stage >= CHAI_PROFILER_NUM_STAGES)
+    {
+        return ("");
+    }
+    return (s_stageNames[a_stage]);
+}
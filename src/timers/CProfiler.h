@@ -0,0 +1,329 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+
+//---------------------------------------------------------------------------
+#ifndef CProfilerH
+#define CProfilerH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+#include "timers/CHapticLoop.h"
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+//---------------------------------------------------------------------------
+//! Number of events kept by each thread. Must be a power of two.
+#define CHAI_PROFILER_BUFFER_SIZE 16384
+
+//! Defined when events are time stamped with the time stamp counter of the processor.
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || \
+    (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
+#define CHAI_PROFILER_USE_TSC
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CProfiler.h
+
+    \brief
+    <b> Timers </b> \n
+    Haptic Pipeline Profiler.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Time stamp of a cProfiler event, in processor ticks.
+#if defined(_MSC_VER)
+typedef unsigned __int64 cProfilerTicks;
+#else
+typedef unsigned long long cProfilerTicks;
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+/*!
+    Defines the stages of the haptic pipeline timed by the cProfiler.
+*/
+//---------------------------------------------------------------------------
+enum CProfilerStage
+{
+    CHAI_PROFILER_STAGE_TICK,
+    CHAI_PROFILER_STAGE_GLOBAL_POSITIONS,
+    CHAI_PROFILER_STAGE_UPDATE_POSE,
+    CHAI_PROFILER_STAGE_POTENTIAL_FIELDS,
+    CHAI_PROFILER_STAGE_PROXY_CONSTRAINT_0,
+    CHAI_PROFILER_STAGE_PROXY_CONSTRAINT_1,
+    CHAI_PROFILER_STAGE_PROXY_CONSTRAINT_2,
+    CHAI_PROFILER_STAGE_APPLY_FORCES,
+    CHAI_PROFILER_NUM_STAGES
+};
+
+
+//===========================================================================
+/*!
+    \struct     cProfilerEvent
+    \ingroup    timers
+
+    \brief
+    cProfilerEvent records one execution of a stage of the haptic pipeline.
+*/
+//===========================================================================
+struct cProfilerEvent
+{
+    //! Time at which the stage started.
+    cProfilerTicks m_start;
+
+    //! Time at which the stage ended.
+    cProfilerTicks m_end;
+
+    //! Stage.
+    unsigned int m_stage;
+
+    //! Number of nodes of collision trees tested by the stage.
+    unsigned int m_numNodeTests;
+
+    //! Number of triangles tested by the stage.
+    unsigned int m_numTriangleTests;
+
+    //! Index of the thread which executed the stage.
+    unsigned int m_thread;
+};
+
+
+//===========================================================================
+/*!
+    \struct     cProfilerStageStatistics
+    \ingroup    timers
+
+    \brief
+    cProfilerStageStatistics summarizes the recent events of a stage.
+    Times are expressed in seconds.
+*/
+//===========================================================================
+struct cProfilerStageStatistics
+{
+    //! Number of events.
+    unsigned int m_numEvents;
+
+    //! Median duration.
+    double m_p50;
+
+    //! 99th percentile of the duration.
+    double m_p99;
+
+    //! Maximum duration.
+    double m_max;
+
+    //! Mean number of nodes of collision trees tested per event.
+    double m_meanNodeTests;
+
+    //! Maximum number of nodes of collision trees tested by an event.
+    unsigned int m_maxNodeTests;
+
+    //! Mean number of triangles tested per event.
+    double m_meanTriangleTests;
+
+    //! Maximum number of triangles tested by an event.
+    unsigned int m_maxTriangleTests;
+};
+
+
+//===========================================================================
+/*!
+    \class      cProfiler
+    \ingroup    timers
+
+    \brief
+    cProfiler records the duration of the stages of the haptic pipeline,
+    and the number of tree nodes and triangles they test. \n
+
+    Stages are timed by cProfilerScope objects placed in the library.
+    While the profiler is disabled, which is the default, a scope only
+    tests a flag. Once enabled, events are time stamped with the time
+    stamp counter of the processor where available, and stored in a ring
+    buffer owned by the recording thread, so that recording neither locks
+    nor allocates memory. Each thread keeps its last
+    CHAI_PROFILER_BUFFER_SIZE events. \n
+
+    The functions which read the events (getStatistics(), getReport(),
+    saveCSV(), saveChromeTrace() and clear()) never delay the recording
+    threads, but must all be called by the same thread, typically the
+    graphics thread.
+*/
+//===========================================================================
+class cProfiler
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // METHODS - RECORDING:
+    //-----------------------------------------------------------------------
+
+    //! Enable or disable the recording of events.
+    static void setEnabled(const bool a_enabled);
+
+    //! Return \b true if events are being recorded.
+    static bool isEnabled() { return (s_enabled); }
+
+    //! Record an event for the calling thread.
+    static void record(const CProfilerStage a_stage,
+                       const cProfilerTicks a_start,
+                       const cProfilerTicks a_end,
+                       const unsigned int a_numNodeTests = 0,
+                       const unsigned int a_numTriangleTests = 0);
+
+    //! Read the time stamp counter of the processor, or a monotonic clock in nanoseconds.
+    static inline cProfilerTicks getTicks()
+    {
+#if defined(CHAI_PROFILER_USE_TSC) && defined(_MSC_VER)
+        return (__rdtsc());
+#elif defined(CHAI_PROFILER_USE_TSC)
+        unsigned int low, high;
+        __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+        return (((cProfilerTicks)high << 32) | low);
+#else
+        return ((cProfilerTicks)(1e9 * cHapticLoop::getClockSeconds()));
+#endif
+    }
+
+
+    //-----------------------------------------------------------------------
+    // METHODS - REPORTS:
+    //-----------------------------------------------------------------------
+
+    //! Discard the events recorded so far.
+    static void clear();
+
+    //! Compute the statistics of each stage over the recorded events.
+    static void getStatistics(std::vector<cProfilerStageStatistics>& a_statistics);
+
+    //! Format the statistics of each stage as lines of text, for display in cLabel objects.
+    static void getReport(std::vector<std::string>& a_lines);
+
+    //! Save the recorded events in a CSV file.
+    static bool saveCSV(const std::string& a_filename);
+
+    //! Save the recorded events in the trace event format of the Chrome tracing viewer.
+    static bool saveChromeTrace(const std::string& a_filename);
+
+    //! Get the name of a stage.
+    static const char* getStageName(const CProfilerStage a_stage);
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Copy the events recorded by all threads, sorted by start time.
+    static void getEvents(std::vector<cProfilerEvent>& a_events);
+
+    //! Get the duration of a processor tick in seconds.
+    static double getSecondsPerTick();
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! If \b true, events are recorded.
+    static volatile bool s_enabled;
+};
+
+
+//===========================================================================
+/*!
+    \class      cProfilerScope
+    \ingroup    timers
+
+    \brief
+    cProfilerScope times a stage of the haptic pipeline, from its
+    construction to its destruction, and records it with the cProfiler.
+*/
+//===========================================================================
+class cProfilerScope
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cProfilerScope. Starts timing a stage if the profiler is enabled and \e a_enabled is \b true.
+    cProfilerScope(const CProfilerStage a_stage, const bool a_enabled = true)
+    {
+        m_stage = a_stage;
+        m_enabled = a_enabled && cProfiler::isEnabled();
+        m_numNodeTests = 0;
+        m_numTriangleTests = 0;
+        m_start = m_enabled ? cProfiler::getTicks() : 0;
+    }
+
+    //! Destructor of cProfilerScope. Records the stage.
+    ~cProfilerScope()
+    {
+        if (m_enabled)
+        {
+            cProfiler::record(m_stage, m_start, cProfiler::getTicks(),
+                              m_numNodeTests, m_numTriangleTests);
+        }
+    }
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Add tests to the counts of the stage.
+    void addTests(const unsigned int a_numNodeTests, const unsigned int a_numTriangleTests)
+    {
+        m_numNodeTests += a_numNodeTests;
+        m_numTriangleTests += a_numTriangleTests;
+    }
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Time at which the stage started.
+    cProfilerTicks m_start;
+
+    //! Stage being timed.
+    CProfilerStage m_stage;
+
+    //! If \b true, the stage is recorded.
+    bool m_enabled;
+
+    //! Number of nodes of collision trees tested by the stage.
+    unsigned int m_numNodeTests;
+
+    //! Number of triangles tested by the stage.
+    unsigned int m_numTriangleTests;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -120,11 +120,11 @@ void cThread::setPriority(CThreadPriority a_level)
 
     switch (m_priorityLevel)
     {
-        CHAI_THREAD_PRIORITY_GRAPHICS:
+        case CHAI_THREAD_PRIORITY_GRAPHICS:
         sp.sched_priority = 5;
         break;
 
-        CHAI_THREAD_PRIORITY_HAPTICS:
+        case CHAI_THREAD_PRIORITY_HAPTICS:
         sp.sched_priority = 10;
         break;
     }
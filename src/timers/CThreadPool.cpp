@@ -0,0 +1,377 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CThreadPool.h"
+#include "CMutex.h"
+#if defined(_LINUX) || defined(_MACOSX)
+#include <unistd.h>
+#endif
+//---------------------------------------------------------------------------
+//! Lock protecting the creation of the default thread pool.
+static cMutex s_defaultThreadPoolLock;
+
+//! Thread pool shared by the library.
+static cThreadPool* s_defaultThreadPool = NULL;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cThreadPool.
+
+    \fn		cThreadPool::cThreadPool(const unsigned int a_numThreads)
+    \param  a_numThreads  Number of worker threads.
+*/
+//===========================================================================
+cThreadPool::cThreadPool(const unsigned int a_numThreads)
+{
+    m_quit = false;
+
+#if defined(_WIN32)
+    InitializeCriticalSection(&m_lock);
+    m_workSemaphore = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+    for (unsigned int i=0; i<a_numThreads; i++)
+    {
+        HANDLE thread = CreateThread(0, 0, workerFunction, this, 0, NULL);
+        if (thread != NULL)
+        {
+            m_threads.push_back(thread);
+        }
+    }
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_init(&m_lock, NULL);
+    pthread_cond_init(&m_workCondition, NULL);
+    pthread_cond_init(&m_doneCondition, NULL);
+    for (unsigned int i=0; i<a_numThreads; i++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, workerFunction, this) == 0)
+        {
+            m_threads.push_back(thread);
+        }
+    }
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cThreadPool. Waits for the worker threads to terminate.
+    No job may be running when the pool is destroyed.
+
+    \fn		cThreadPool::~cThreadPool()
+*/
+//===========================================================================
+cThreadPool::~cThreadPool()
+{
+    lock();
+    m_quit = true;
+    unlock();
+
+#if defined(_WIN32)
+    ReleaseSemaphore(m_workSemaphore, (LONG)m_threads.size(), NULL);
+    for (unsigned int i=0; i<m_threads.size(); i++)
+    {
+        WaitForSingleObject(m_threads[i], INFINITE);
+        CloseHandle(m_threads[i]);
+    }
+    CloseHandle(m_workSemaphore);
+    DeleteCriticalSection(&m_lock);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_lock(&m_lock);
+    pthread_cond_broadcast(&m_workCondition);
+    pthread_mutex_unlock(&m_lock);
+    for (unsigned int i=0; i<m_threads.size(); i++)
+    {
+        pthread_join(m_threads[i], NULL);
+    }
+    pthread_cond_destroy(&m_doneCondition);
+    pthread_cond_destroy(&m_workCondition);
+    pthread_mutex_destroy(&m_lock);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Execute a function once for each task index from 0 to a_numTasks-1,
+    and return when all tasks have completed. Tasks are executed in any
+    order, by the worker threads and by the calling thread.
+
+    \fn		void cThreadPool::run(cThreadPoolFunction a_function, void* a_data,
+            const unsigned int a_numTasks)
+    \param  a_function  Function to execute.
+    \param  a_data  User data passed to the function.
+    \param  a_numTasks  Number of tasks.
+*/
+//===========================================================================
+void cThreadPool::run(cThreadPoolFunction a_function, void* a_data,
+                      const unsigned int a_numTasks)
+{
+    // execute the tasks directly if there is nothing to share
+    if ((m_threads.size() == 0) || (a_numTasks < 2))
+    {
+        for (unsigned int i=0; i<a_numTasks; i++)
+        {
+            a_function(a_data, i);
+        }
+        return;
+    }
+
+    // submit job
+    cThreadPoolJob job;
+    job.m_function = a_function;
+    job.m_data = a_data;
+    job.m_numTasks = a_numTasks;
+    job.m_nextTask = 0;
+    job.m_numTasksDone = 0;
+
+#if defined(_WIN32)
+    job.m_doneEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+#endif
+
+    lock();
+    m_jobs.push_back(&job);
+
+#if defined(_WIN32)
+    unsigned int numWakes = a_numTasks - 1;
+    if (numWakes > m_threads.size()) { numWakes = (unsigned int)m_threads.size(); }
+    ReleaseSemaphore(m_workSemaphore, (LONG)numWakes, NULL);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_cond_broadcast(&m_workCondition);
+#endif
+
+    // execute tasks of our own job until none is left
+    while (job.m_nextTask < job.m_numTasks)
+    {
+        unsigned int task = job.m_nextTask++;
+        if (job.m_nextTask == job.m_numTasks)
+        {
+            m_jobs.remove(&job);
+        }
+        execute(&job, task);
+    }
+
+    // wait for the tasks executed by the worker threads
+#if defined(_WIN32)
+    bool done = (job.m_numTasksDone == job.m_numTasks);
+    unlock();
+    if (!done)
+    {
+        WaitForSingleObject(job.m_doneEvent, INFINITE);
+    }
+    CloseHandle(job.m_doneEvent);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    while (job.m_numTasksDone < job.m_numTasks)
+    {
+        pthread_cond_wait(&m_doneCondition, &m_lock);
+    }
+    unlock();
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Execute a task of a job. The lock of the pool is released while the
+    task is running.
+
+    \fn		void cThreadPool::execute(cThreadPoolJob* a_job, const unsigned int a_task)
+    \param  a_job  Job of the task.
+    \param  a_task  Index of the task.
+*/
+//===========================================================================
+void cThreadPool::execute(cThreadPoolJob* a_job, const unsigned int a_task)
+{
+    unlock();
+    a_job->m_function(a_job->m_data, a_task);
+    lock();
+
+    // signal the thread waiting for the job once its last task has completed
+    a_job->m_numTasksDone++;
+    if (a_job->m_numTasksDone == a_job->m_numTasks)
+    {
+#if defined(_WIN32)
+        SetEvent(a_job->m_doneEvent);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+        pthread_cond_broadcast(&m_doneCondition);
+#endif
+    }
+}
+
+
+//===========================================================================
+/*!
+    Main loop of the worker threads.
+
+    \fn		void cThreadPool::work()
+*/
+//===========================================================================
+void cThreadPool::work()
+{
+    lock();
+    while (!m_quit)
+    {
+        // wait for a job
+        if (m_jobs.empty())
+        {
+#if defined(_WIN32)
+            unlock();
+            WaitForSingleObject(m_workSemaphore, INFINITE);
+            lock();
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+            pthread_cond_wait(&m_workCondition, &m_lock);
+#endif
+            continue;
+        }
+
+        // execute the next task of the oldest job
+        cThreadPoolJob* job = m_jobs.front();
+        unsigned int task = job->m_nextTask++;
+        if (job->m_nextTask == job->m_numTasks)
+        {
+            m_jobs.pop_front();
+        }
+        execute(job, task);
+    }
+    unlock();
+}
+
+
+//===========================================================================
+/*!
+    Acquire the lock of the pool.
+
+    \fn		void cThreadPool::lock()
+*/
+//===========================================================================
+void cThreadPool::lock()
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&m_lock);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_lock(&m_lock);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Release the lock of the pool.
+
+    \fn		void cThreadPool::unlock()
+*/
+//===========================================================================
+void cThreadPool::unlock()
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&m_lock);
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    pthread_mutex_unlock(&m_lock);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Entry point of the worker threads.
+
+    \param  a_pool  Pool owning the thread.
+*/
+//===========================================================================
+#if defined(_WIN32)
+DWORD WINAPI cThreadPool::workerFunction(LPVOID a_pool)
+{
+    ((cThreadPool*)a_pool)->work();
+    return (0);
+}
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+void* cThreadPool::workerFunction(void* a_pool)
+{
+    ((cThreadPool*)a_pool)->work();
+    return (NULL);
+}
+#endif
+
+
+//===========================================================================
+/*!
+    Return the number of processors available on the system.
+
+    \fn		unsigned int cThreadPool::getNumProcessors()
+    \return Return the number of processors, at least 1.
+*/
+//===========================================================================
+unsigned int cThreadPool::getNumProcessors()
+{
+    int numProcessors = 1;
+
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    numProcessors = (int)info.dwNumberOfProcessors;
+#endif
+
+#if defined (_LINUX) || defined (_MACOSX)
+    numProcessors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return ((numProcessors > 1) ? (unsigned int)numProcessors : 1);
+}
+
+
+//===========================================================================
+/*!
+    Return a thread pool shared by the library. The pool is created on
+    first use, with one worker thread less than the number of processors,
+    since the calling thread also executes tasks.
+
+    \fn		cThreadPool* cThreadPool::getDefaultThreadPool()
+    \return Return a pointer to the default thread pool.
+*/
+//===========================================================================
+cThreadPool* cThreadPool::getDefaultThreadPool()
+{
+    s_defaultThreadPoolLock.acquire();
+    if (s_defaultThreadPool == NULL)
+    {
+        s_defaultThreadPool = new cThreadPool(getNumProcessors() - 1);
+    }
+    s_defaultThreadPoolLock.release();
+
+    return (s_defaultThreadPool);
+}
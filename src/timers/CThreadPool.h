@@ -0,0 +1,199 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CThreadPoolH
+#define CThreadPoolH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+#include <list>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CThreadPool.h
+
+    \brief
+    <b> Timers </b> \n
+    Thread Pool.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! Function executed by a cThreadPool for each task of a job.
+typedef void (*cThreadPoolFunction)(void* a_data, unsigned int a_task);
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \struct     cThreadPoolJob
+    \ingroup    timers
+
+    \brief
+    cThreadPoolJob describes a set of tasks submitted to a cThreadPool.
+*/
+//===========================================================================
+struct cThreadPoolJob
+{
+    //! Function executed for each task.
+    cThreadPoolFunction m_function;
+
+    //! User data passed to the function.
+    void* m_data;
+
+    //! Number of tasks of the job.
+    unsigned int m_numTasks;
+
+    //! Index of the next task to be executed.
+    unsigned int m_nextTask;
+
+    //! Number of tasks which have completed.
+    unsigned int m_numTasksDone;
+
+#if defined(_WIN32)
+    //! Event signaled when all tasks have completed.
+    HANDLE m_doneEvent;
+#endif
+};
+
+
+//===========================================================================
+/*!
+    \class      cThreadPool
+    \ingroup    timers
+
+    \brief
+    cThreadPool owns a set of worker threads which execute the tasks of
+    jobs submitted by run(). \n
+
+    The thread calling run() executes tasks of its own job while waiting
+    for the workers, so that run() may be called from several threads at
+    once, and from within a task, without blocking the pool. A pool with
+    no worker threads executes all tasks on the calling thread.
+*/
+//===========================================================================
+class cThreadPool
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cThreadPool.
+    cThreadPool(const unsigned int a_numThreads);
+
+    //! Destructor of cThreadPool.
+    ~cThreadPool();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Execute a function for tasks 0 to a_numTasks-1 and wait until all of them have completed.
+    void run(cThreadPoolFunction a_function, void* a_data, const unsigned int a_numTasks);
+
+    //! Get the number of worker threads of the pool.
+    unsigned int getNumThreads() const { return ((unsigned int)m_threads.size()); }
+
+    //! Get the number of processors available on the system.
+    static unsigned int getNumProcessors();
+
+    //! Get a pool shared by the library, with one worker thread less than the number of processors.
+    static cThreadPool* getDefaultThreadPool();
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Execute tasks of the pending jobs until the pool is destroyed.
+    void work();
+
+    //! Execute a task of a job. The lock must be held, and is held again on return.
+    void execute(cThreadPoolJob* a_job, const unsigned int a_task);
+
+    //! Acquire the lock of the pool.
+    void lock();
+
+    //! Release the lock of the pool.
+    void unlock();
+
+#if defined(_WIN32)
+    //! Entry point of the worker threads.
+    static DWORD WINAPI workerFunction(LPVOID a_pool);
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Entry point of the worker threads.
+    static void* workerFunction(void* a_pool);
+#endif
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Jobs which have tasks waiting to be executed.
+    std::list<cThreadPoolJob*> m_jobs;
+
+    //! If \b true, the worker threads terminate.
+    bool m_quit;
+
+#if defined(_WIN32)
+    //! Worker thread handles.
+    std::vector<HANDLE> m_threads;
+
+    //! Lock protecting the list of jobs.
+    CRITICAL_SECTION m_lock;
+
+    //! Semaphore released when jobs are submitted.
+    HANDLE m_workSemaphore;
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Worker thread handles.
+    std::vector<pthread_t> m_threads;
+
+    //! Lock protecting the list of jobs.
+    pthread_mutex_t m_lock;
+
+    //! Condition signaled when jobs are submitted.
+    pthread_cond_t m_workCondition;
+
+    //! Condition signaled when jobs complete.
+    pthread_cond_t m_doneCondition;
+#endif
+
+  private:
+
+    //! Pools cannot be copied.
+    cThreadPool(const cThreadPool&);
+
+    //! Pools cannot be assigned.
+    cThreadPool& operator=(const cThreadPool&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,117 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+
+//---------------------------------------------------------------------------
+#include "CTripleBuffer.h"
+//---------------------------------------------------------------------------
+//! Flag of the shared index set when the buffer in transit holds data not yet read.
+#define CHAI_TRIPLE_BUFFER_NEW_DATA 4
+
+//! Mask of the shared index giving the index of the buffer in transit.
+#define CHAI_TRIPLE_BUFFER_INDEX_MASK 3
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cTripleBuffer. Buffer 0 is owned by the writer, buffer 2
+    by the reader, and buffer 1 is in transit. Until the first call to
+    publish(), the reader reads buffer 2.
+
+    \fn		cTripleBuffer::cTripleBuffer()
+*/
+//===========================================================================
+cTripleBuffer::cTripleBuffer()
+{
+    m_writeIndex = 0;
+    m_sharedIndex = 1;
+    m_readIndex = 2;
+}
+
+
+//===========================================================================
+/*!
+    Exchange the buffer filled by the writer with the buffer in transit,
+    and flag it as holding new data. The writer then owns the buffer
+    previously in transit, which is either the oldest data or a buffer
+    released by the reader.
+
+    \fn		void cTripleBuffer::publish()
+*/
+//===========================================================================
+void cTripleBuffer::publish()
+{
+    unsigned int previous = exchange(m_writeIndex | CHAI_TRIPLE_BUFFER_NEW_DATA);
+    m_writeIndex = previous & CHAI_TRIPLE_BUFFER_INDEX_MASK;
+}
+
+
+//===========================================================================
+/*!
+    If the buffer in transit holds new data, exchange it with the buffer
+    of the reader. Otherwise the reader keeps its current buffer.
+
+    \fn		bool cTripleBuffer::update()
+    \return Return \b true if the reader now owns data not read before.
+*/
+//===========================================================================
+bool cTripleBuffer::update()
+{
+    // only the writer sets the flag, so it cannot be cleared behind our back
+    if ((m_sharedIndex & CHAI_TRIPLE_BUFFER_NEW_DATA) == 0)
+    {
+        return (false);
+    }
+
+    unsigned int previous = exchange(m_readIndex);
+    m_readIndex = previous & CHAI_TRIPLE_BUFFER_INDEX_MASK;
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Atomically replace the shared index. The exchange is a full memory
+    barrier, so that the content of a buffer is visible to the other
+    thread before its index is.
+
+    \fn		unsigned int cTripleBuffer::exchange(const unsigned int a_value)
+    \param  a_value  New value of the shared index.
+    \return Return the previous value of the shared index.
+*/
+//===========================================================================
+unsigned int cTripleBuffer::exchange(const unsigned int a_value)
+{
+#if defined(_WIN32)
+    return ((unsigned int)InterlockedExchange(&m_sharedIndex, (LONG)a_value));
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    // __sync_lock_test_and_set() is only an acquire barrier
+    unsigned int previous;
+    do
+    {
+        previous = m_sharedIndex;
+    }
+    while (__sync_val_compare_and_swap(&m_sharedIndex, previous, a_value) != previous);
+
+    return (previous);
+#endif
+}
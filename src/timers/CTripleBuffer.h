@@ -0,0 +1,129 @@
+//===========================================================================
+/*
+    This file is part of the CHAI 3D visualization and haptics libraries.
+    Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License("GPL") version 2
+    as published by the Free Software Foundation.
+
+    For using the CHAI 3D libraries with software that can not be combined
+    with the GNU GPL, and for taking advantage of the additional benefits
+    of our support services, please contact CHAI 3D about acquiring a
+    Professional Edition License.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0 $Rev: 251 $
+*/
+//===========================================================================
+
+
+//---------------------------------------------------------------------------
+#ifndef CTripleBufferH
+#define CTripleBufferH
+//---------------------------------------------------------------------------
+#include "extras/CGlobals.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CTripleBuffer.h
+
+    \brief
+    <b> Timers </b> \n
+    Wait-Free Triple Buffer.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cTripleBuffer
+    \ingroup    timers
+
+    \brief
+    cTripleBuffer exchanges the indices of three buffers between a single
+    writer thread and a single reader thread, without locks. \n
+
+    The writer fills the buffer at getWriteIndex() and calls publish().
+    The reader calls update() and reads the buffer at getReadIndex(),
+    which always holds the latest complete data published by the writer.
+    Neither thread ever waits for the other: the writer may publish any
+    number of times between two updates of the reader, in which case the
+    older data is dropped. The buffers themselves are owned by the user,
+    typically as an array of three elements.
+*/
+//===========================================================================
+class cTripleBuffer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cTripleBuffer.
+    cTripleBuffer();
+
+    //! Destructor of cTripleBuffer.
+    ~cTripleBuffer() {};
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Get the index of the buffer to be filled by the writer.
+    unsigned int getWriteIndex() const { return (m_writeIndex); }
+
+    //! Make the buffer filled by the writer available to the reader. Called by the writer only.
+    void publish();
+
+    //! Take the latest published buffer, if any. Returns \b true if new data is available. Called by the reader only.
+    bool update();
+
+    //! Get the index of the buffer to be read by the reader.
+    unsigned int getReadIndex() const { return (m_readIndex); }
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Atomically replace the shared index and return its previous value.
+    unsigned int exchange(const unsigned int a_value);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Index of the buffer owned by the writer.
+    unsigned int m_writeIndex;
+
+    //! Index of the buffer owned by the reader.
+    unsigned int m_readIndex;
+
+#if defined(_WIN32)
+    //! Index of the buffer in transit, and flag set when it holds data not yet read.
+    volatile LONG m_sharedIndex;
+#endif
+
+#if defined(_LINUX) || defined(_MACOSX)
+    //! Index of the buffer in transit, and flag set when it holds data not yet read.
+    volatile unsigned int m_sharedIndex;
+#endif
+
+  private:
+
+    //! Triple buffers cannot be copied.
+    cTripleBuffer(const cTripleBuffer&);
+
+    //! Triple buffers cannot be assigned.
+    cTripleBuffer& operator=(const cTripleBuffer&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
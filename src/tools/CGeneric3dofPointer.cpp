@@ -22,6 +22,8 @@
 //---------------------------------------------------------------------------
 #include "tools/CGeneric3dofPointer.h"
 #include "graphics/CTriangle.h"
+#include "timers/CProfiler.h"
+#include "graphics/CFrustum.h"
 //---------------------------------------------------------------------------
 
 //==========================================================================
@@ -90,17 +92,18 @@ cGeneric3dofPointer::cGeneric3dofPointer(cWorld* a_world)
     materialDevice.m_diffuse.set(0.8, 0.8, 0.8);
     materialDevice.m_specular.set(1.0, 1.0, 1.0);
 
-    // Sphere representing the device
+    // Sphere representing the device. The spheres are not children of the
+    // tool: render() draws them at the poses of the published state
     m_deviceSphere = new cShapeSphere(0.019);
     m_deviceSphere->m_material = materialDevice;
     m_deviceSphere->setHapticEnabled(false);
-    addChild(m_deviceSphere);
+    m_deviceSphere->setParent(this);
 
     // Sphere representing the proxy
     m_proxySphere = new cShapeSphere(0.020);
     m_proxySphere->setHapticEnabled(false);
     m_proxySphere->m_material = m_materialProxy;
-    addChild(m_proxySphere);
+    m_proxySphere->setParent(this);
 
     // Mesh representing the device
     m_deviceMesh = new cMesh(m_world);
@@ -134,6 +137,14 @@ cGeneric3dofPointer::cGeneric3dofPointer(cWorld* a_world)
     m_lastComputedGlobalForce.zero();
     m_deviceLocalVel.zero();
     m_deviceGlobalVel.zero();
+    m_deviceLocalRot.identity();
+    m_deviceGlobalRot.identity();
+    m_userSwitch0 = false;
+
+    // publish an initial state, and hand it over to the graphics thread
+    m_numPublishedStates = 0;
+    publishState();
+    m_stateBuffer.update();
 }
 
 
@@ -146,6 +157,10 @@ cGeneric3dofPointer::cGeneric3dofPointer(cWorld* a_world)
 //===========================================================================
 cGeneric3dofPointer::~cGeneric3dofPointer()
 {
+    // delete the spheres, and the meshes attached to them
+    delete m_deviceSphere;
+    delete m_proxySphere;
+
     // check if device is available
     if (m_device == NULL) { return; }
 
@@ -304,6 +319,7 @@ void cGeneric3dofPointer::setWorkspaceScaleFactor(const double& a_workspaceScale
 //===========================================================================
 void cGeneric3dofPointer::updatePose()
 {
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_UPDATE_POSE);
     cVector3d pos, vel;
 
     // check if device is available
@@ -360,6 +376,77 @@ void cGeneric3dofPointer::computeInteractionForces()
 
     // copy result
     m_lastComputedGlobalForce.copyfrom(force);
+
+    // make the new state of the tool available to the graphics thread
+    publishState();
+}
+
+
+//===========================================================================
+/*!
+    Copy the current device, proxy, contact and force state of the tool
+    into the state owned by the haptics thread, and make it available to
+    the graphics thread. This function is called once per update by
+    computeInteractionForces(), and must only be called by the thread
+    which updates the tool.
+
+    \fn       void cGeneric3dofPointer::publishState()
+*/
+//===========================================================================
+void cGeneric3dofPointer::publishState()
+{
+    cGeneric3dofPointerState& state = m_states[m_stateBuffer.getWriteIndex()];
+
+    // device
+    state.m_deviceLocalPos = m_deviceLocalPos;
+    state.m_deviceGlobalPos = m_deviceGlobalPos;
+    state.m_deviceLocalRot = m_deviceLocalRot;
+    state.m_userSwitch0 = m_userSwitch0;
+
+    // proxy, in global and in local coordinates
+    cMatrix3d tRot;
+    state.m_proxyGlobalPos = m_proxyPointForceModel->getProxyGlobalPosition();
+    state.m_proxyGlobalPos.subr(m_globalPos, state.m_proxyLocalPos);
+    m_globalRot.transr(tRot);
+    tRot.mul(state.m_proxyLocalPos);
+
+    // forces
+    state.m_globalForce = m_lastComputedGlobalForce;
+    state.m_normalForce = m_proxyPointForceModel->getNormalForce();
+
+    // contacts
+    state.m_numContacts = (unsigned int)m_proxyPointForceModel->getNumContacts();
+    if (state.m_numContacts > 0)
+    {
+        state.m_contactObject = m_proxyPointForceModel->m_contactPoint0->m_object;
+    }
+    else
+    {
+        state.m_contactObject = NULL;
+    }
+
+    state.m_index = m_numPublishedStates;
+    m_numPublishedStates++;
+
+    m_stateBuffer.publish();
+}
+
+
+//===========================================================================
+/*!
+    Return the latest state published by the haptics thread. The state
+    remains valid, and unchanged, until the next call to this function.
+    This function never waits for the haptics thread, and must only be
+    called by the graphics thread.
+
+    \fn       const cGeneric3dofPointerState& cGeneric3dofPointer::getState()
+    \return   Return the latest published state of the tool.
+*/
+//===========================================================================
+const cGeneric3dofPointerState& cGeneric3dofPointer::getState()
+{
+    m_stateBuffer.update();
+    return (m_states[m_stateBuffer.getReadIndex()]);
 }
 
 
@@ -372,6 +459,8 @@ void cGeneric3dofPointer::computeInteractionForces()
 //===========================================================================
 void cGeneric3dofPointer::applyForces()
 {
+    cProfilerScope profilerScope(CHAI_PROFILER_STAGE_APPLY_FORCES);
+
     // check if device is available
     if (m_device == NULL)
     {
@@ -406,7 +495,8 @@ void cGeneric3dofPointer::applyForces()
 
 //==========================================================================
 /*!
-    Render the current tool in OpenGL.
+    Render the current tool in OpenGL. The spheres representing the device
+    and the proxy are drawn at the poses of the latest published state.
 
     \fn       void cGeneric3dofPointer::render(const int a_renderMode=0)
     \param    a_renderMode  rendering mode; see cGenericObject.cpp.
@@ -414,29 +504,13 @@ void cGeneric3dofPointer::applyForces()
 //===========================================================================
 void cGeneric3dofPointer::render(const int a_renderMode)
 {
-    // If multipass transparency is enabled, only render on a single
-    // pass...
-    if (a_renderMode != CHAI_RENDER_MODE_NON_TRANSPARENT_ONLY && a_renderMode != CHAI_RENDER_MODE_RENDER_ALL)
-    return;
-
-    // compute local position of proxy
-    cVector3d proxyLocalPos;
-    cMatrix3d tRot;
-    proxyLocalPos = m_proxyPointForceModel->getProxyGlobalPosition();
-    proxyLocalPos.sub(m_globalPos);
-    m_globalRot.transr(tRot);
-    tRot.mul(proxyLocalPos);
-
-    // update position information of graphic entity for the device
-    m_deviceSphere->setPos(m_deviceLocalPos);
-    m_deviceSphere->setRot(m_deviceLocalRot);
-
-    // update position information of graphic entity for the proxy
-    m_proxySphere->setPos(proxyLocalPos);
-    m_proxySphere->setRot(m_deviceLocalRot);
+    // read the latest state published by the haptics thread
+    const cGeneric3dofPointerState& state = getState();
+    const cVector3d& deviceLocalPos = state.m_deviceLocalPos;
+    const cVector3d& proxyLocalPos = state.m_proxyLocalPos;
 
     // Button 0 determines the color of the proxy
-    if (m_userSwitch0)
+    if (state.m_userSwitch0)
     {
         m_proxySphere->m_material = m_materialProxyButtonPressed;
     }
@@ -445,6 +519,15 @@ void cGeneric3dofPointer::render(const int a_renderMode)
         m_proxySphere->m_material = m_materialProxy;
     }
 
+    // render the spheres at every pass, since they may be transparent
+    renderSphere(m_deviceSphere, deviceLocalPos, state.m_deviceLocalRot, a_renderMode);
+    renderSphere(m_proxySphere, proxyLocalPos, state.m_deviceLocalRot, a_renderMode);
+
+    // If multipass transparency is enabled, only render the line on a
+    // single pass...
+    if (a_renderMode != CHAI_RENDER_MODE_NON_TRANSPARENT_ONLY && a_renderMode != CHAI_RENDER_MODE_RENDER_ALL)
+    return;
+
     // if proxy and device sphere are enabled, draw
     if ((m_proxySphere->getShowEnabled()) && (m_deviceSphere->getShowEnabled()))
     {
@@ -452,7 +535,7 @@ void cGeneric3dofPointer::render(const int a_renderMode)
         glLineWidth(1.0);
         glColor4fv(m_colorLine.pColor());
         glBegin(GL_LINES);
-            glVertex3d(m_deviceLocalPos.x, m_deviceLocalPos.y, m_deviceLocalPos.z);
+            glVertex3d(deviceLocalPos.x, deviceLocalPos.y, deviceLocalPos.z);
             glVertex3d(proxyLocalPos.x, proxyLocalPos.y, proxyLocalPos.z);
         glEnd();
         glEnable(GL_LIGHTING);
@@ -460,6 +543,46 @@ void cGeneric3dofPointer::render(const int a_renderMode)
 }
 
 
+//==========================================================================
+/*!
+    Render a sphere representing the device or the proxy, and the objects
+    attached to it, at a given pose in the frame of the tool. The sphere
+    is culled against the view frustum of the tool, if any.
+
+    \fn       void cGeneric3dofPointer::renderSphere(cShapeSphere* a_sphere,
+                                                   const cVector3d& a_pos,
+                                                   const cMatrix3d& a_rot,
+                                                   const int a_renderMode)
+    \param    a_sphere  Sphere to be rendered.
+    \param    a_pos  Position of the sphere in the frame of the tool.
+    \param    a_rot  Orientation of the sphere in the frame of the tool.
+    \param    a_renderMode  rendering mode; see cGenericObject.cpp.
+*/
+//===========================================================================
+void cGeneric3dofPointer::renderSphere(cShapeSphere* a_sphere,
+                                       const cVector3d& a_pos,
+                                       const cMatrix3d& a_rot,
+                                       const int a_renderMode)
+{
+    cMatrixGL frame;
+    frame.set(a_pos, a_rot);
+    frame.glMatrixPushMultiply();
+
+    if (m_renderFrustum != NULL)
+    {
+        cFrustum frustum;
+        frustum.transform(*m_renderFrustum, a_pos, a_rot);
+        a_sphere->renderSceneGraph(a_renderMode, &frustum);
+    }
+    else
+    {
+        a_sphere->renderSceneGraph(a_renderMode, NULL);
+    }
+
+    frame.glMatrixPop();
+}
+
+
 //==========================================================================
 /*!
     Set the radius of the proxy. The value passed as parameter corresponds
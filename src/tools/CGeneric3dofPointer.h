@@ -29,6 +29,7 @@
 #include "scenegraph/CMesh.h"
 #include "forces/CProxyPointForceAlgo.h"
 #include "forces/CPotentialFieldForceAlgo.h"
+#include "timers/CTripleBuffer.h"
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -41,6 +42,54 @@
 */
 //===========================================================================
 
+//===========================================================================
+/*!
+    \struct     cGeneric3dofPointerState
+    \ingroup    tools
+
+    \brief
+    cGeneric3dofPointerState is a snapshot of the state of a
+    cGeneric3dofPointer, published by the haptics thread once per update
+    and read by the graphics thread.
+*/
+//===========================================================================
+struct cGeneric3dofPointerState
+{
+    //! Position of device in device local coordinate system.
+    cVector3d m_deviceLocalPos;
+
+    //! Position of device in world global coordinate system.
+    cVector3d m_deviceGlobalPos;
+
+    //! Orientation of wrist in local coordinates of device.
+    cMatrix3d m_deviceLocalRot;
+
+    //! Position of proxy in device local coordinate system.
+    cVector3d m_proxyLocalPos;
+
+    //! Position of proxy in world global coordinate system.
+    cVector3d m_proxyGlobalPos;
+
+    //! Force computed for the tool, in the world coordinate system.
+    cVector3d m_globalForce;
+
+    //! Normal component of the force computed by the proxy, in the world coordinate system.
+    cVector3d m_normalForce;
+
+    //! Number of contacts between the proxy and the environment (0, 1, 2 or 3).
+    unsigned int m_numContacts;
+
+    //! Object touched by the proxy, or \b NULL if there is no contact.
+    cGenericObject* m_contactObject;
+
+    //! Status of user switch 0.
+    bool m_userSwitch0;
+
+    //! Number of states published before this one.
+    unsigned int m_index;
+};
+
+
 //===========================================================================
 /*!
     \class      cGeneric3dofPointer
@@ -52,7 +101,17 @@
     device pose. \n
 
     This class provides i/o with haptic devices and a basic graphical 
-    representation of a tool.
+    representation of a tool. \n
+
+    Every call to computeInteractionForces() publishes a snapshot of the
+    device, proxy, contact and force state of the tool through a
+    cTripleBuffer. The graphics thread reads the latest snapshot with
+    getState(), and render() draws the tool from it, so that neither
+    thread reads data being modified by the other, and neither waits for
+    the other. The spheres representing the device and the proxy are
+    owned by the tool but are not its children: render() draws them at
+    the poses of the snapshot, so that their poses are never modified
+    while the haptics thread computes the global positions of the tool.
 */
 //===========================================================================
 class cGeneric3dofPointer : public cGenericTool
@@ -122,6 +181,12 @@ class cGeneric3dofPointer : public cGenericTool
     //! Read orientation of haptic device in local coordinates.
     virtual cMatrix3d getDeviceLocalRot() { return (m_deviceLocalRot); }
 
+    //! Publish the current state of the tool to the graphics thread. Called by computeInteractionForces().
+    void publishState();
+
+    //! Get the latest state published by the haptics thread. Called by the graphics thread only.
+    const cGeneric3dofPointerState& getState();
+
 
     //-----------------------------------------------------------------------
     // METHODS - WORKSPACE SETTINGS
@@ -244,7 +309,7 @@ class cGeneric3dofPointer : public cGenericTool
     //! Radius of sphere representing position of pointer.
     double m_displayRadius;
 
-    //! Last status of user switch 0. This value is used by the graphical rendering function.
+    //! Last status of user switch 0. This value is published to the graphical rendering function.
     bool m_userSwitch0;
 
     //! This flag records whether the user has enabled forces.
@@ -259,6 +324,24 @@ class cGeneric3dofPointer : public cGenericTool
         with this variable.
     */
     bool m_waitForSmallForce;
+
+    //! States of the tool exchanged between the haptics and graphics threads.
+    cGeneric3dofPointerState m_states[3];
+
+    //! Indices of the states owned by the haptics and graphics threads.
+    cTripleBuffer m_stateBuffer;
+
+    //! Number of states published so far.
+    unsigned int m_numPublishedStates;
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Render a sphere and its attached objects at a given pose in the frame of the tool.
+    void renderSphere(cShapeSphere* a_sphere, const cVector3d& a_pos,
+                      const cMatrix3d& a_rot, const int a_renderMode);
 };
 
 //---------------------------------------------------------------------------